@@ -0,0 +1,127 @@
+/**************************************************************************
+ *
+ * Copyright 2013 VMware, Inc.
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL VMWARE AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+/**
+ * \file u_box_filter.h
+ *
+ * 2x2 box filter kernels for the most common 8-bit mipmap formats.
+ *
+ * These average four bytes per component at once by holding the
+ * components in 16-bit lanes of a 64-bit integer, which gives the same
+ * (a + b + c + d) / 4 result as the scalar code without needing any
+ * particular instruction set.  They only handle the case where the
+ * source row is at least twice as wide as the destination row.
+ *
+ * This header is shared by the gallium mipmap fallback and by Mesa's
+ * software mipmap generation, so it only depends on the C library.
+ */
+
+#ifndef U_BOX_FILTER_H
+#define U_BOX_FILTER_H
+
+#include <stdint.h>
+#include <string.h>
+
+
+#define U_BOX_FILTER_LANE_MASK 0x00ff00ff00ff00ffULL
+
+
+/**
+ * Average 2x2 blocks of 4-byte pixels (RGBA8 and its swizzles).
+ */
+static INLINE void
+util_box_filter_row_4ub(const uint8_t *rowA, const uint8_t *rowB,
+                        unsigned dstWidth, uint8_t *dst)
+{
+   const uint64_t mask = U_BOX_FILTER_LANE_MASK;
+   unsigned i;
+
+   for (i = 0; i < dstWidth; i++) {
+      uint64_t a, b, lo, hi;
+      uint32_t texel;
+
+      /* two horizontally adjacent pixels from each row */
+      memcpy(&a, rowA + i * 8, 8);
+      memcpy(&b, rowB + i * 8, 8);
+
+      /* even and odd bytes, summed vertically: 9 bits per lane */
+      lo = (a & mask) + (b & mask);
+      hi = ((a >> 8) & mask) + ((b >> 8) & mask);
+
+      /* add the two pixels together: 10 bits per lane */
+      lo += lo >> 32;
+      hi += hi >> 32;
+
+      texel = (uint32_t) (((lo >> 2) & 0x00ff00ff) |
+                          (((hi >> 2) & 0x00ff00ff) << 8));
+      memcpy(dst + i * 4, &texel, 4);
+   }
+}
+
+
+/**
+ * Average 2x2 blocks of 1-byte pixels (R8, L8, A8, I8).
+ */
+static INLINE void
+util_box_filter_row_1ub(const uint8_t *rowA, const uint8_t *rowB,
+                        unsigned dstWidth, uint8_t *dst)
+{
+   const uint64_t mask = U_BOX_FILTER_LANE_MASK;
+   const uint16_t one = 1;
+   /* Where the low byte of each lane lands when stored: the even bytes
+    * on little endian machines, the odd ones on big endian machines.
+    */
+   const unsigned first = *(const uint8_t *) &one ? 0 : 1;
+   unsigned i;
+
+   for (i = 0; i + 4 <= dstWidth; i += 4) {
+      uint64_t a, b, sum;
+      uint8_t bytes[8];
+
+      memcpy(&a, rowA + i * 2, 8);
+      memcpy(&b, rowB + i * 2, 8);
+
+      /* the odd bytes are the right-hand pixel of each pair */
+      sum = (a & mask) + (b & mask) +
+            ((a >> 8) & mask) + ((b >> 8) & mask);
+      sum = (sum >> 2) & mask;
+
+      memcpy(bytes, &sum, 8);
+      dst[i + 0] = bytes[first + 0];
+      dst[i + 1] = bytes[first + 2];
+      dst[i + 2] = bytes[first + 4];
+      dst[i + 3] = bytes[first + 6];
+   }
+
+   for (; i < dstWidth; i++) {
+      dst[i] = (rowA[i * 2] + rowA[i * 2 + 1] +
+                rowB[i * 2] + rowB[i * 2 + 1]) >> 2;
+   }
+}
+
+
+#endif /* U_BOX_FILTER_H */
@@ -27,6 +27,7 @@
 
 
 #include "util/u_debug.h"
+#include "util/u_inlines.h"
 #include "util/u_math.h"
 #include "util/u_format.h"
 #include "util/u_draw.h"
@@ -123,3 +124,66 @@ util_draw_max_index(
 
    return max_index + 1;
 }
+
+
+/**
+ * Turn an indirect draw into a direct one by reading its parameters from
+ * the indirect buffer.
+ * \return FALSE if the buffer couldn't be mapped
+ */
+boolean
+util_draw_indirect_read(struct pipe_context *pipe,
+                        const struct pipe_draw_info *info_in,
+                        struct pipe_draw_info *info)
+{
+   struct pipe_transfer *transfer;
+   const uint32_t *params;
+   const unsigned num_params = info_in->indexed ? 5 : 4;
+
+   assert(info_in->indirect);
+   assert(!info_in->count_from_stream_output);
+
+   params = (const uint32_t *)
+      pipe_buffer_map_range(pipe, info_in->indirect,
+                            info_in->indirect_offset,
+                            num_params * sizeof(uint32_t),
+                            PIPE_TRANSFER_READ,
+                            &transfer);
+   if (!params) {
+      debug_printf("%s: failed to map indirect buffer\n", __FUNCTION__);
+      return FALSE;
+   }
+
+   *info = *info_in;
+   info->indirect = NULL;
+   info->count = params[0];
+   info->instance_count = params[1];
+   info->start = params[2];
+   if (info_in->indexed) {
+      info->index_bias = (int) params[3];
+      info->start_instance = params[4];
+   }
+   else {
+      info->start_instance = params[3];
+      info->min_index = info->start;
+      info->max_index = info->start + info->count - 1;
+   }
+
+   pipe_buffer_unmap(pipe, transfer);
+   return TRUE;
+}
+
+
+/**
+ * Execute an indirect draw by reading its parameters on the CPU.  Meant for
+ * drivers whose vertex processing happens on the CPU anyway.
+ */
+void
+util_draw_indirect(struct pipe_context *pipe,
+                   const struct pipe_draw_info *info_in)
+{
+   struct pipe_draw_info info;
+
+   if (util_draw_indirect_read(pipe, info_in, &info) && info.count)
+      pipe->draw_vbo(pipe, &info);
+}
@@ -150,6 +150,17 @@ util_draw_max_index(
       const struct pipe_draw_info *info);
 
 
+boolean
+util_draw_indirect_read(struct pipe_context *pipe,
+                        const struct pipe_draw_info *info_in,
+                        struct pipe_draw_info *info);
+
+
+void
+util_draw_indirect(struct pipe_context *pipe,
+                   const struct pipe_draw_info *info);
+
+
 #ifdef __cplusplus
 }
 #endif
@@ -49,6 +49,7 @@
 #include "util/u_math.h"
 #include "util/u_texture.h"
 #include "util/u_half.h"
+#include "util/u_box_filter.h"
 #include "util/u_surface.h"
 
 #include "cso_cache/cso_context.h"
@@ -180,7 +181,13 @@ do_row(enum dtype datatype, uint comps, int srcWidth,
    assert(srcWidth == dstWidth || srcWidth == 2 * dstWidth);
    */
 
-   if (datatype == DTYPE_UBYTE && comps == 4) {
+   if (datatype == DTYPE_UBYTE && comps == 4 && k0 == 1) {
+      util_box_filter_row_4ub(srcRowA, srcRowB, dstWidth, dstRow);
+   }
+   else if (datatype == DTYPE_UBYTE && comps == 1 && k0 == 1) {
+      util_box_filter_row_1ub(srcRowA, srcRowB, dstWidth, dstRow);
+   }
+   else if (datatype == DTYPE_UBYTE && comps == 4) {
       uint i, j, k;
       const ubyte(*rowA)[4] = (const ubyte(*)[4]) srcRowA;
       const ubyte(*rowB)[4] = (const ubyte(*)[4]) srcRowB;
@@ -87,6 +87,7 @@
 
 #include "util/u_vbuf.h"
 
+#include "util/u_draw.h"
 #include "util/u_dump.h"
 #include "util/u_format.h"
 #include "util/u_inlines.h"
@@ -1178,6 +1179,15 @@ void u_vbuf_draw_vbo(struct u_vbuf *mgr, const struct pipe_draw_info *info)
       return;
    }
 
+   if (info->indirect) {
+      /* The fallbacks below need to know the vertex range. */
+      struct pipe_draw_info direct;
+
+      if (util_draw_indirect_read(pipe, info, &direct) && direct.count)
+         u_vbuf_draw_vbo(mgr, &direct);
+      return;
+   }
+
    if (info->indexed) {
       /* See if anything needs to be done for per-vertex attribs. */
       if (u_vbuf_need_minmax_index(mgr)) {
@@ -151,6 +151,9 @@ static int etna_screen_get_param( struct pipe_screen *screen, enum pipe_cap para
     case PIPE_CAP_MAX_TEXEL_OFFSET:
             return 7;
     case PIPE_CAP_TEXTURE_BORDER_COLOR_QUIRK:
+    case PIPE_CAP_BUFFER_MAP_PERSISTENT_COHERENT:
+    case PIPE_CAP_DRAW_INDIRECT:
+    case PIPE_CAP_USER_VERTEX_BUFFERS_IN_PLACE:
             return 0;
 
     /* Render targets. */
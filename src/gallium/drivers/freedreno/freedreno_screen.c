@@ -210,6 +210,9 @@ fd_screen_get_param(struct pipe_screen *pscreen, enum pipe_cap param)
 	case PIPE_CAP_USER_INDEX_BUFFERS:
 	case PIPE_CAP_QUERY_PIPELINE_STATISTICS:
 	case PIPE_CAP_TEXTURE_BORDER_COLOR_QUIRK:
+	case PIPE_CAP_BUFFER_MAP_PERSISTENT_COHERENT:
+	case PIPE_CAP_DRAW_INDIRECT:
+	case PIPE_CAP_USER_VERTEX_BUFFERS_IN_PLACE:
 		return 0;
 
 	/* Stream output. */
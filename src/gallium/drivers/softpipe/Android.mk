@@ -26,6 +26,7 @@ LOCAL_PATH := $(call my-dir)
 # from Makefile
 C_SOURCES = \
 	sp_fs_exec.c \
+	sp_bin.c \
 	sp_clear.c \
 	sp_fence.c \
 	sp_flush.c \
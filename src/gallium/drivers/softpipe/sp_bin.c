@@ -0,0 +1,697 @@
+/**************************************************************************
+ *
+ * Copyright 2013 VMware, Inc.
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL VMWARE AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+/**
+ * \brief  Binned, multi-threaded triangle rasterization.
+ *
+ * Triangles are only binned for draws whose primitives reach setup as
+ * filled triangles; everything else goes straight to sp_setup.c as
+ * before.  The bins are flushed at the end of every draw (or earlier if
+ * too much vertex data piles up), so all the state a worker needs is
+ * constant while it runs and can simply be copied from the context.
+ *
+ * Each worker rasterizes a tile by running the regular sp_setup_tri()
+ * code with the cliprect narrowed to that tile.  Since tiles are aligned
+ * to the quad and span chunk boundaries, every pixel sees the same quads,
+ * in the same order, as without binning.
+ *
+ * The results are not bit-identical to the serial path, though: the
+ * tile caches are written back to the surfaces around every binned draw,
+ * so colors are rounded to the surface format between draws, while the
+ * serial path may keep blending into the unrounded float tiles.  This is
+ * why binning is only enabled on request.
+ */
+
+#include "pipe/p_defines.h"
+#include "os/os_thread.h"
+#include "tgsi/tgsi_exec.h"
+#include "util/u_math.h"
+#include "util/u_memory.h"
+
+#include "sp_bin.h"
+#include "sp_context.h"
+#include "sp_quad_pipe.h"
+#include "sp_setup.h"
+#include "sp_state.h"
+#include "sp_tex_sample.h"
+#include "sp_tex_tile_cache.h"
+#include "sp_tile_cache.h"
+
+
+/**
+ * Draws with fewer triangles than this are rasterized on the calling
+ * thread, where waking up the workers would cost more than it saves.
+ */
+#define SP_BIN_MIN_TRIS 128
+
+/** Max amount of recorded vertex data (in floats) before flushing */
+#define SP_BIN_MAX_FLOATS (4 * 1024 * 1024)
+
+
+/**
+ * The triangles touching one tile, in submission order.
+ * Each entry is a triangle index shifted left by one, with the low bit
+ * set if this is the first bin the triangle was put in.
+ */
+struct sp_bin
+{
+   unsigned *tris;
+   unsigned count;
+   unsigned size;
+};
+
+
+struct sp_bin_worker
+{
+   struct sp_bin_context *bin;
+
+   pipe_thread thread;
+   pipe_semaphore work_ready;
+   pipe_semaphore work_done;
+
+   /**
+    * Copy of the context state, refreshed before each flush, with the
+    * pieces below substituted for the ones the context owns.
+    */
+   struct softpipe_context sp;
+
+   struct setup_context *setup;
+   struct tgsi_exec_machine *fs_machine;
+   struct sp_tgsi_sampler *fs_sampler;
+   struct softpipe_tile_cache *cbuf_cache[PIPE_MAX_COLOR_BUFS];
+   struct softpipe_tile_cache *zsbuf_cache;
+   struct softpipe_tex_tile_cache *tex_cache[PIPE_MAX_SHADER_SAMPLER_VIEWS];
+   struct quad_stage *shade;
+   struct quad_stage *depth_test;
+   struct quad_stage *blend;
+   struct quad_stage *pstipple;
+};
+
+
+struct sp_bin_context
+{
+   struct softpipe_context *softpipe;
+
+   /** Used to replay small batches on the calling thread */
+   struct setup_context *setup;
+
+   /** Recorded triangles, three vertices of vertex_size floats each */
+   float *verts;
+   unsigned num_floats;
+   unsigned max_floats;
+   unsigned num_tris;
+   unsigned vertex_size;
+
+   struct sp_bin *bins;
+   unsigned num_bins;
+   unsigned tiles_x, tiles_y;
+
+   /** The context's cliprect at the time of the flush */
+   struct pipe_scissor_state cliprect;
+
+   pipe_mutex mutex;
+   unsigned next_tile;  /**< protected by mutex */
+
+   boolean exit_flag;
+   unsigned num_threads;
+   struct sp_bin_worker workers[SP_MAX_THREADS];
+};
+
+
+/**
+ * Return the tile column/row containing coordinate x, clamped to
+ * [0, max_tile].  NaNs end up in tile 0.
+ */
+static INLINE unsigned
+tile_coord(float x, unsigned max_tile)
+{
+   if (!(x > 0.0f))
+      return 0;
+   if (x >= (float) (max_tile * TILE_SIZE))
+      return max_tile;
+   return (unsigned) x / TILE_SIZE;
+}
+
+
+static boolean
+bin_add(struct sp_bin *b, unsigned entry)
+{
+   if (b->count == b->size) {
+      unsigned size = b->size ? b->size * 2 : 64;
+      unsigned *tris = REALLOC(b->tris, b->size * sizeof(unsigned),
+                               size * sizeof(unsigned));
+      if (!tris)
+         return FALSE;
+      b->tris = tris;
+      b->size = size;
+   }
+
+   b->tris[b->count++] = entry;
+   return TRUE;
+}
+
+
+/**
+ * Rasterize the triangle right away on the calling thread.
+ */
+static void
+draw_tri(struct softpipe_context *sp,
+         const float (*v0)[4],
+         const float (*v1)[4],
+         const float (*v2)[4])
+{
+   struct sp_bin_context *bin = sp->bin;
+   boolean binning = sp->binning;
+
+   sp->binning = FALSE;
+   sp_setup_prepare(bin->setup);
+   sp_setup_tri(bin->setup, v0, v1, v2);
+   sp->binning = binning;
+}
+
+
+/**
+ * Record a triangle and put it in the bins of all the tiles its bounding
+ * box touches.  Called by sp_setup_tri() while binning.
+ */
+void
+sp_bin_tri(struct softpipe_context *sp,
+           const float (*v0)[4],
+           const float (*v1)[4],
+           const float (*v2)[4])
+{
+   struct sp_bin_context *bin = sp->bin;
+   const unsigned vsize = bin->vertex_size;
+   const float minx = MIN3(v0[0][0], v1[0][0], v2[0][0]) - 1.0f;
+   const float maxx = MAX3(v0[0][0], v1[0][0], v2[0][0]) + 1.0f;
+   const float miny = MIN3(v0[0][1], v1[0][1], v2[0][1]) - 1.0f;
+   const float maxy = MAX3(v0[0][1], v1[0][1], v2[0][1]) + 1.0f;
+   unsigned tx0, tx1, ty0, ty1, tx, ty;
+   unsigned added = 0;
+   float *v;
+
+   if (bin->num_floats + 3 * vsize > SP_BIN_MAX_FLOATS)
+      sp_bin_flush(sp);
+
+   if (bin->num_floats + 3 * vsize > bin->max_floats) {
+      unsigned max_floats = MAX2(bin->max_floats * 2, 64 * 1024);
+      float *verts;
+
+      max_floats = MIN2(max_floats, SP_BIN_MAX_FLOATS);
+      verts = REALLOC(bin->verts, bin->max_floats * sizeof(float),
+                      max_floats * sizeof(float));
+      if (!verts) {
+         sp_bin_flush(sp);
+         draw_tri(sp, v0, v1, v2);
+         return;
+      }
+      bin->verts = verts;
+      bin->max_floats = max_floats;
+   }
+
+   v = bin->verts + bin->num_floats;
+   memcpy(v, v0, vsize * sizeof(float));
+   memcpy(v + vsize, v1, vsize * sizeof(float));
+   memcpy(v + 2 * vsize, v2, vsize * sizeof(float));
+
+   /* Triangles entirely outside the framebuffer still go in an edge
+    * tile, so that they are counted like any other triangle.
+    */
+   tx0 = tile_coord(minx, bin->tiles_x - 1);
+   tx1 = tile_coord(maxx, bin->tiles_x - 1);
+   ty0 = tile_coord(miny, bin->tiles_y - 1);
+   ty1 = tile_coord(maxy, bin->tiles_y - 1);
+
+   for (ty = ty0; ty <= ty1; ty++) {
+      for (tx = tx0; tx <= tx1; tx++) {
+         struct sp_bin *b = &bin->bins[ty * bin->tiles_x + tx];
+
+         if (!bin_add(b, (bin->num_tris << 1) | (added == 0))) {
+            /* take the triangle back out of the bins it already went in
+             * and draw it once the others are done
+             */
+            for (ty = ty0; added; ty++) {
+               for (tx = tx0; tx <= tx1 && added; tx++, added--)
+                  bin->bins[ty * bin->tiles_x + tx].count--;
+            }
+            sp_bin_flush(sp);
+            draw_tri(sp, v0, v1, v2);
+            return;
+         }
+         added++;
+      }
+   }
+
+   bin->num_floats += 3 * vsize;
+   bin->num_tris++;
+}
+
+
+/**
+ * Return the index of the next non-empty bin, or -1 when there are none
+ * left.
+ */
+static int
+next_tile(struct sp_bin_context *bin)
+{
+   int tile = -1;
+
+   pipe_mutex_lock(bin->mutex);
+   while (bin->next_tile < bin->tiles_x * bin->tiles_y) {
+      unsigned i = bin->next_tile++;
+      if (bin->bins[i].count) {
+         tile = i;
+         break;
+      }
+   }
+   pipe_mutex_unlock(bin->mutex);
+
+   return tile;
+}
+
+
+static void
+rasterize_bins(struct sp_bin_worker *worker)
+{
+   struct sp_bin_context *bin = worker->bin;
+   struct softpipe_context *sp = &worker->sp;
+   const unsigned vsize = bin->vertex_size;
+   int tile;
+   unsigned i;
+
+   while ((tile = next_tile(bin)) >= 0) {
+      const struct sp_bin *b = &bin->bins[tile];
+      const unsigned x = (tile % bin->tiles_x) * TILE_SIZE;
+      const unsigned y = (tile / bin->tiles_x) * TILE_SIZE;
+
+      sp->cliprect.minx = MAX2(bin->cliprect.minx, x);
+      sp->cliprect.miny = MAX2(bin->cliprect.miny, y);
+      sp->cliprect.maxx = MIN2(bin->cliprect.maxx, x + TILE_SIZE);
+      sp->cliprect.maxy = MIN2(bin->cliprect.maxy, y + TILE_SIZE);
+
+      for (i = 0; i < b->count; i++) {
+         const float *v = bin->verts + (b->tris[i] >> 1) * 3 * vsize;
+         uint64_t c_primitives = sp->pipeline_statistics.c_primitives;
+
+         sp_setup_tri(worker->setup,
+                      (const float (*)[4]) v,
+                      (const float (*)[4]) (v + vsize),
+                      (const float (*)[4]) (v + 2 * vsize));
+
+         /* only count the triangle once */
+         if (!(b->tris[i] & 1))
+            sp->pipeline_statistics.c_primitives = c_primitives;
+      }
+   }
+
+   for (i = 0; i < sp->framebuffer.nr_cbufs; i++)
+      sp_flush_tile_cache(worker->cbuf_cache[i]);
+   if (sp->framebuffer.zsbuf)
+      sp_flush_tile_cache(worker->zsbuf_cache);
+}
+
+
+static PIPE_THREAD_ROUTINE( thread_function, init_data )
+{
+   struct sp_bin_worker *worker = (struct sp_bin_worker *) init_data;
+   struct sp_bin_context *bin = worker->bin;
+
+   while (1) {
+      pipe_semaphore_wait(&worker->work_ready);
+
+      if (bin->exit_flag)
+         break;
+
+      rasterize_bins(worker);
+
+      pipe_semaphore_signal(&worker->work_done);
+   }
+
+   return NULL;
+}
+
+
+/**
+ * Point the workers at the current state and surfaces.
+ * \return FALSE if we ran out of memory, in which case the caller
+ * should rasterize the triangles itself.
+ */
+static boolean
+prepare_workers(struct softpipe_context *sp)
+{
+   struct sp_bin_context *bin = sp->bin;
+   const struct sp_tgsi_sampler *fs_sampler =
+      sp->tgsi.sampler[PIPE_SHADER_FRAGMENT];
+   unsigned t, i;
+
+   /* Allocate any missing texture caches first, so that failing leaves
+    * nothing half set up.
+    */
+   for (t = 0; t < bin->num_threads; t++) {
+      struct sp_bin_worker *worker = &bin->workers[t];
+
+      for (i = 0; i < PIPE_MAX_SHADER_SAMPLER_VIEWS; i++) {
+         if (fs_sampler->sp_sview[i].cache && !worker->tex_cache[i]) {
+            worker->tex_cache[i] = sp_create_tex_tile_cache(&sp->pipe);
+            if (!worker->tex_cache[i])
+               return FALSE;
+         }
+      }
+   }
+
+   for (t = 0; t < bin->num_threads; t++) {
+      struct sp_bin_worker *worker = &bin->workers[t];
+      struct softpipe_context *wsp = &worker->sp;
+
+      /* Each worker samples through its own texture caches */
+      *worker->fs_sampler = *fs_sampler;
+      for (i = 0; i < PIPE_MAX_SHADER_SAMPLER_VIEWS; i++) {
+         struct sp_sampler_view *sview = &worker->fs_sampler->sp_sview[i];
+
+         if (sview->cache) {
+            sp_tex_tile_cache_set_sampler_view(worker->tex_cache[i],
+                                               sp->sampler_views[PIPE_SHADER_FRAGMENT][i]);
+            sview->cache = worker->tex_cache[i];
+         }
+      }
+
+      *wsp = *sp;
+      wsp->binning = FALSE;
+      wsp->dirty = 0;
+      wsp->occlusion_count = 0;
+      memset(&wsp->pipeline_statistics, 0, sizeof(wsp->pipeline_statistics));
+
+      wsp->fs_machine = worker->fs_machine;
+      wsp->tgsi.sampler[PIPE_SHADER_FRAGMENT] = worker->fs_sampler;
+      memcpy(wsp->tex_cache[PIPE_SHADER_FRAGMENT], worker->tex_cache,
+             sizeof(worker->tex_cache));
+
+      for (i = 0; i < PIPE_MAX_COLOR_BUFS; i++) {
+         wsp->cbuf_cache[i] = worker->cbuf_cache[i];
+         sp_tile_cache_set_surface(worker->cbuf_cache[i],
+                                   i < sp->framebuffer.nr_cbufs ?
+                                   sp->framebuffer.cbufs[i] : NULL);
+      }
+      wsp->zsbuf_cache = worker->zsbuf_cache;
+      sp_tile_cache_set_surface(worker->zsbuf_cache, sp->framebuffer.zsbuf);
+
+      wsp->quad.shade = worker->shade;
+      wsp->quad.depth_test = worker->depth_test;
+      wsp->quad.blend = worker->blend;
+      wsp->quad.pstipple = worker->pstipple;
+      sp_build_quad_pipeline(wsp);
+
+      sp->fs_variant->prepare(sp->fs_variant, worker->fs_machine,
+                              (struct tgsi_sampler *) worker->fs_sampler);
+
+      sp_setup_prepare(worker->setup);
+   }
+
+   return TRUE;
+}
+
+
+/**
+ * Add the workers' query counters to the context's, and drop their
+ * references to the surfaces and textures so nothing stale is left in
+ * their caches by the next flush.
+ */
+static void
+finish_workers(struct softpipe_context *sp)
+{
+   struct sp_bin_context *bin = sp->bin;
+   unsigned t, i;
+
+   for (t = 0; t < bin->num_threads; t++) {
+      struct sp_bin_worker *worker = &bin->workers[t];
+
+      sp->occlusion_count += worker->sp.occlusion_count;
+      sp->pipeline_statistics.c_primitives +=
+         worker->sp.pipeline_statistics.c_primitives;
+      sp->pipeline_statistics.ps_invocations +=
+         worker->sp.pipeline_statistics.ps_invocations;
+
+      for (i = 0; i < PIPE_MAX_COLOR_BUFS; i++)
+         sp_tile_cache_set_surface(worker->cbuf_cache[i], NULL);
+      sp_tile_cache_set_surface(worker->zsbuf_cache, NULL);
+
+      for (i = 0; i < PIPE_MAX_SHADER_SAMPLER_VIEWS; i++) {
+         if (worker->tex_cache[i])
+            sp_tex_tile_cache_set_sampler_view(worker->tex_cache[i], NULL);
+      }
+   }
+}
+
+
+/**
+ * Rasterize all the binned triangles.
+ */
+void
+sp_bin_flush(struct softpipe_context *sp)
+{
+   struct sp_bin_context *bin = sp->bin;
+   unsigned i;
+
+   if (!bin->num_tris)
+      return;
+
+   if (bin->num_tris < SP_BIN_MIN_TRIS || !prepare_workers(sp)) {
+      const unsigned vsize = bin->vertex_size;
+      const float *v = bin->verts;
+      boolean binning = sp->binning;
+
+      sp->binning = FALSE;
+      sp_setup_prepare(bin->setup);
+      for (i = 0; i < bin->num_tris; i++, v += 3 * vsize) {
+         sp_setup_tri(bin->setup,
+                      (const float (*)[4]) v,
+                      (const float (*)[4]) (v + vsize),
+                      (const float (*)[4]) (v + 2 * vsize));
+      }
+      sp->binning = binning;
+   }
+   else {
+      /* The workers read and write the surfaces directly */
+      for (i = 0; i < sp->framebuffer.nr_cbufs; i++)
+         sp_flush_tile_cache(sp->cbuf_cache[i]);
+      if (sp->framebuffer.zsbuf)
+         sp_flush_tile_cache(sp->zsbuf_cache);
+
+      bin->cliprect = sp->cliprect;
+      bin->next_tile = 0;
+
+      for (i = 0; i < bin->num_threads; i++)
+         pipe_semaphore_signal(&bin->workers[i].work_ready);
+      for (i = 0; i < bin->num_threads; i++)
+         pipe_semaphore_wait(&bin->workers[i].work_done);
+
+      finish_workers(sp);
+   }
+
+   for (i = 0; i < bin->tiles_x * bin->tiles_y; i++)
+      bin->bins[i].count = 0;
+   bin->num_floats = 0;
+   bin->num_tris = 0;
+}
+
+
+/**
+ * Called at the start of a draw, after the derived state is up to date,
+ * to decide whether its triangles get binned.
+ */
+void
+sp_bin_begin(struct softpipe_context *sp)
+{
+   struct sp_bin_context *bin = sp->bin;
+   unsigned tiles_x, tiles_y, i;
+
+   sp->binning = FALSE;
+
+   if (!bin ||
+       sp->no_rast ||
+       sp->rasterizer->rasterizer_discard ||
+       sp->reduced_api_prim != PIPE_PRIM_TRIANGLES ||
+       sp->rasterizer->fill_front != PIPE_POLYGON_MODE_FILL ||
+       sp->rasterizer->fill_back != PIPE_POLYGON_MODE_FILL ||
+       !sp->framebuffer.width || !sp->framebuffer.height)
+      return;
+
+   tiles_x = align(sp->framebuffer.width, TILE_SIZE) / TILE_SIZE;
+   tiles_y = align(sp->framebuffer.height, TILE_SIZE) / TILE_SIZE;
+
+   if (tiles_x * tiles_y > bin->num_bins) {
+      struct sp_bin *bins = CALLOC(tiles_x * tiles_y, sizeof(struct sp_bin));
+      if (!bins)
+         return;
+
+      for (i = 0; i < bin->num_bins; i++)
+         FREE(bin->bins[i].tris);
+      FREE(bin->bins);
+      bin->bins = bins;
+      bin->num_bins = tiles_x * tiles_y;
+   }
+
+   bin->tiles_x = tiles_x;
+   bin->tiles_y = tiles_y;
+   bin->vertex_size = softpipe_get_vbuf_vertex_info(sp)->size;
+
+   sp->binning = TRUE;
+}
+
+
+/**
+ * Called at the end of a draw, after draw_flush().
+ */
+void
+sp_bin_end(struct softpipe_context *sp)
+{
+   if (sp->binning) {
+      sp_bin_flush(sp);
+      sp->binning = FALSE;
+   }
+}
+
+
+struct sp_bin_context *
+sp_bin_create(struct softpipe_context *sp, unsigned num_threads)
+{
+   struct sp_bin_context *bin = CALLOC_STRUCT(sp_bin_context);
+   unsigned t, i;
+
+   if (!bin)
+      return NULL;
+
+   bin->softpipe = sp;
+   pipe_mutex_init(bin->mutex);
+
+   bin->setup = sp_setup_create_context(sp);
+   if (!bin->setup)
+      goto fail;
+
+   for (t = 0; t < num_threads; t++) {
+      struct sp_bin_worker *worker = &bin->workers[t];
+      struct softpipe_context *wsp = &worker->sp;
+
+      worker->bin = bin;
+      worker->setup = sp_setup_create_context(wsp);
+      worker->fs_machine = tgsi_exec_machine_create();
+      worker->fs_sampler = sp_create_tgsi_sampler();
+      for (i = 0; i < PIPE_MAX_COLOR_BUFS; i++)
+         worker->cbuf_cache[i] = sp_create_tile_cache(&sp->pipe);
+      worker->zsbuf_cache = sp_create_tile_cache(&sp->pipe);
+      worker->shade = sp_quad_shade_stage(wsp);
+      worker->depth_test = sp_quad_depth_test_stage(wsp);
+      worker->blend = sp_quad_blend_stage(wsp);
+      worker->pstipple = sp_quad_polygon_stipple_stage(wsp);
+
+      if (!worker->setup || !worker->fs_machine || !worker->fs_sampler ||
+          !worker->zsbuf_cache || !worker->shade || !worker->depth_test ||
+          !worker->blend || !worker->pstipple)
+         goto fail;
+      for (i = 0; i < PIPE_MAX_COLOR_BUFS; i++) {
+         if (!worker->cbuf_cache[i])
+            goto fail;
+      }
+
+      /* A worker only ever touches one tile at a time */
+      for (i = 0; i < PIPE_MAX_COLOR_BUFS; i++)
+         worker->cbuf_cache[i]->max_entries = 1;
+      worker->zsbuf_cache->max_entries = 1;
+
+      pipe_semaphore_init(&worker->work_ready, 0);
+      pipe_semaphore_init(&worker->work_done, 0);
+      worker->thread = pipe_thread_create(thread_function, worker);
+      if (!worker->thread) {
+         pipe_semaphore_destroy(&worker->work_ready);
+         pipe_semaphore_destroy(&worker->work_done);
+         break;
+      }
+      bin->num_threads++;
+   }
+
+   /* Without any worker, draws take the regular path */
+   if (!bin->num_threads)
+      goto fail;
+
+   return bin;
+
+fail:
+   sp_bin_destroy(bin);
+   return NULL;
+}
+
+
+void
+sp_bin_destroy(struct sp_bin_context *bin)
+{
+   unsigned t, i;
+
+   /* Set exit_flag and wake up each thread so it leaves its main loop */
+   bin->exit_flag = TRUE;
+   for (t = 0; t < bin->num_threads; t++)
+      pipe_semaphore_signal(&bin->workers[t].work_ready);
+
+   for (t = 0; t < bin->num_threads; t++) {
+      pipe_thread_wait(bin->workers[t].thread);
+      pipe_semaphore_destroy(&bin->workers[t].work_ready);
+      pipe_semaphore_destroy(&bin->workers[t].work_done);
+   }
+
+   for (t = 0; t < SP_MAX_THREADS; t++) {
+      struct sp_bin_worker *worker = &bin->workers[t];
+
+      if (worker->setup)
+         sp_setup_destroy_context(worker->setup);
+      if (worker->fs_machine)
+         tgsi_exec_machine_destroy(worker->fs_machine);
+      FREE(worker->fs_sampler);
+      for (i = 0; i < PIPE_MAX_COLOR_BUFS; i++)
+         sp_destroy_tile_cache(worker->cbuf_cache[i]);
+      sp_destroy_tile_cache(worker->zsbuf_cache);
+      for (i = 0; i < PIPE_MAX_SHADER_SAMPLER_VIEWS; i++)
+         sp_destroy_tex_tile_cache(worker->tex_cache[i]);
+      if (worker->shade)
+         worker->shade->destroy(worker->shade);
+      if (worker->depth_test)
+         worker->depth_test->destroy(worker->depth_test);
+      if (worker->blend)
+         worker->blend->destroy(worker->blend);
+      if (worker->pstipple)
+         worker->pstipple->destroy(worker->pstipple);
+   }
+
+   for (i = 0; i < bin->num_bins; i++)
+      FREE(bin->bins[i].tris);
+   FREE(bin->bins);
+   FREE(bin->verts);
+
+   if (bin->setup)
+      sp_setup_destroy_context(bin->setup);
+   pipe_mutex_destroy(bin->mutex);
+
+   FREE(bin);
+}
@@ -0,0 +1,77 @@
+/**************************************************************************
+ *
+ * Copyright 2013 VMware, Inc.
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL VMWARE AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+/**
+ * \brief  Binned, multi-threaded triangle rasterization.
+ *
+ * When enabled with SOFTPIPE_NUM_THREADS, the triangles of a draw are
+ * recorded and sorted into bins, one per TILE_SIZE x TILE_SIZE block of
+ * the framebuffer.  At the end of the draw the bins are handed to a pool
+ * of worker threads, each of which rasterizes whole tiles with its own
+ * copy of the quad pipeline, shader machine and tile caches.  Colors are
+ * rounded to the surface format after every binned draw, so blending
+ * across draws may differ slightly from the serial path.
+ */
+
+#ifndef SP_BIN_H
+#define SP_BIN_H
+
+
+#include "pipe/p_compiler.h"
+
+
+/** Max number of rasterization threads */
+#define SP_MAX_THREADS 8
+
+
+struct softpipe_context;
+struct sp_bin_context;
+
+
+struct sp_bin_context *
+sp_bin_create(struct softpipe_context *sp, unsigned num_threads);
+
+void
+sp_bin_destroy(struct sp_bin_context *bin);
+
+void
+sp_bin_begin(struct softpipe_context *sp);
+
+void
+sp_bin_tri(struct softpipe_context *sp,
+           const float (*v0)[4],
+           const float (*v1)[4],
+           const float (*v2)[4]);
+
+void
+sp_bin_flush(struct softpipe_context *sp);
+
+void
+sp_bin_end(struct softpipe_context *sp);
+
+
+#endif /* SP_BIN_H */
@@ -40,6 +40,7 @@
 #include "tgsi/tgsi_exec.h"
 #include "vl/vl_decoder.h"
 #include "vl/vl_video_buffer.h"
+#include "sp_bin.h"
 #include "sp_clear.h"
 #include "sp_context.h"
 #include "sp_flush.h"
@@ -60,6 +61,9 @@ softpipe_destroy( struct pipe_context *pipe )
    struct softpipe_context *softpipe = softpipe_context( pipe );
    uint i, sh;
 
+   if (softpipe->bin)
+      sp_bin_destroy(softpipe->bin);
+
 #if DO_PSTIPPLE_IN_HELPER_MODULE
    if (softpipe->pstipple.sampler)
       pipe->delete_sampler_state(pipe, softpipe->pstipple.sampler);
@@ -192,6 +196,7 @@ softpipe_create_context( struct pipe_screen *screen,
    struct softpipe_screen *sp_screen = softpipe_screen(screen);
    struct softpipe_context *softpipe = CALLOC_STRUCT(softpipe_context);
    uint i, sh;
+   long num_threads;
 
    util_init_math();
 
@@ -289,6 +294,12 @@ softpipe_create_context( struct pipe_screen *screen,
    draw_set_rasterize_stage(softpipe->draw, softpipe->vbuf);
    draw_set_render(softpipe->draw, softpipe->vbuf_backend);
 
+   num_threads = debug_get_num_option("SOFTPIPE_NUM_THREADS", 0);
+   if (num_threads) {
+      softpipe->bin = sp_bin_create(softpipe,
+                                    MIN2(num_threads, SP_MAX_THREADS));
+   }
+
    softpipe->blitter = util_blitter_create(&softpipe->pipe);
    if (!softpipe->blitter) {
       goto fail;
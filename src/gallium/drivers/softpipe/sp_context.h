@@ -55,6 +55,7 @@ struct sp_fragment_shader;
 struct sp_vertex_shader;
 struct sp_velems_state;
 struct sp_so_state;
+struct sp_bin_context;
 
 struct softpipe_context {
    struct pipe_context pipe;  /**< base class */
@@ -176,6 +177,10 @@ struct softpipe_context {
 
    struct blitter_context *blitter;
 
+   /** Binned rasterization, NULL if not enabled */
+   struct sp_bin_context *bin;
+   boolean binning;  /**< are triangles currently being binned? */
+
    boolean dirty_render_cache;
 
    struct softpipe_tile_cache *cbuf_cache[PIPE_MAX_COLOR_BUFS];
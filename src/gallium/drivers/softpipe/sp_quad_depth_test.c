@@ -785,9 +785,15 @@ depth_test_quads_fallback(struct quad_stage *qs,
 
       data.ps = qs->softpipe->framebuffer.zsbuf;
       data.format = data.ps->format;
-      data.tile = sp_get_cached_tile(qs->softpipe->zsbuf_cache, 
-                                     quads[0]->input.x0, 
-                                     quads[0]->input.y0);
+      if (qs->softpipe->depth_stencil->stencil[0].enabled ||
+          qs->softpipe->depth_stencil->depth.writemask)
+         data.tile = sp_get_cached_tile(qs->softpipe->zsbuf_cache,
+                                        quads[0]->input.x0,
+                                        quads[0]->input.y0);
+      else
+         data.tile = sp_get_cached_tile_ro(qs->softpipe->zsbuf_cache,
+                                           quads[0]->input.x0,
+                                           quads[0]->input.y0);
 
       for (i = 0; i < nr; i++) {
          get_depth_stencil_values(&data, quads[i]);
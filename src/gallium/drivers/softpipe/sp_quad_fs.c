@@ -63,28 +63,6 @@ quad_shade_stage(struct quad_stage *qs)
 }
 
 
-/**
- * Execute fragment shader for the four fragments in the quad.
- * \return TRUE if quad is alive, FALSE if all four pixels are killed
- */
-static INLINE boolean
-shade_quad(struct quad_stage *qs, struct quad_header *quad)
-{
-   struct softpipe_context *softpipe = qs->softpipe;
-   struct tgsi_exec_machine *machine = softpipe->fs_machine;
-
-   if (softpipe->active_statistics_queries) {
-      softpipe->pipeline_statistics.ps_invocations +=
-         util_bitcount(quad->inout.mask);         
-   }
-
-   /* run shader */
-   machine->flatshade_color = softpipe->rasterizer->flatshade ? TRUE : FALSE;
-   return softpipe->fs_variant->run( softpipe->fs_variant, machine, quad );
-}
-
-
-
 static void
 coverage_quad(struct quad_stage *qs, struct quad_header *quad)
 {
@@ -115,13 +93,25 @@ shade_quads(struct quad_stage *qs,
 {
    struct softpipe_context *softpipe = qs->softpipe;
    struct tgsi_exec_machine *machine = softpipe->fs_machine;
+   const struct sp_fragment_shader_variant *var = softpipe->fs_variant;
    unsigned i, nr_quads = 0;
 
+   /* All the quads come from the same span of the same primitive, so
+    * the per-primitive machine state is only set up once per batch.
+    */
    tgsi_exec_set_constant_buffers(machine, PIPE_MAX_CONSTANT_BUFFERS,
                          softpipe->mapped_constants[PIPE_SHADER_FRAGMENT],
                          softpipe->const_buffer_size[PIPE_SHADER_FRAGMENT]);
 
    machine->InterpCoefs = quads[0]->coef;
+   machine->flatshade_color = softpipe->rasterizer->flatshade ? TRUE : FALSE;
+
+   if (softpipe->active_statistics_queries) {
+      for (i = 0; i < nr; i++) {
+         softpipe->pipeline_statistics.ps_invocations +=
+            util_bitcount(quads[i]->inout.mask);
+      }
+   }
 
    for (i = 0; i < nr; i++) {
       /* Only omit this quad from the output list if all the fragments
@@ -133,7 +123,7 @@ shade_quads(struct quad_stage *qs,
        * Z values in each pass.  If interpolation starts with different quads
        * we can get different Z values for the same (x,y).
        */
-      if (!shade_quad(qs, quads[i]) && i > 0)
+      if (!var->run(var, machine, quads[i]) && i > 0)
          continue; /* quad totally culled/killed */
 
       if (/*do_coverage*/ 0)
@@ -32,6 +32,7 @@
  * \author  Brian Paul
  */
 
+#include "sp_bin.h"
 #include "sp_context.h"
 #include "sp_quad.h"
 #include "sp_quad_pipe.h"
@@ -62,10 +63,13 @@ struct edge {
 
 /**
  * Max number of quads (2x2 pixel blocks) to process per batch.
- * This can't be arbitrarily increased since we depend on some 32-bit
- * bitmasks (two bits per quad).
+ * Each batch covers a horizontal span of SPAN_WIDTH pixels, which must
+ * divide the tile size so that a batch never straddles two tiles.
+ * This can't be arbitrarily increased since we depend on some 64-bit
+ * bitmasks (one bit per pixel of a row, with room for shifting).
  */
 #define MAX_QUADS 16
+#define SPAN_WIDTH (2 * MAX_QUADS)
 
 
 /**
@@ -187,7 +191,7 @@ block(int x)
 static INLINE int
 block_x(int x)
 {
-   return x & ~(16-1);
+   return x & ~(SPAN_WIDTH-1);
 }
 
 
@@ -197,7 +201,7 @@ block_x(int x)
 static void
 flush_spans(struct setup_context *setup)
 {
-   const int step = MAX_QUADS;
+   const int step = SPAN_WIDTH;
    const int xleft0 = setup->span.left[0];
    const int xleft1 = setup->span.left[1];
    const int xright0 = setup->span.right[0];
@@ -208,7 +212,7 @@ flush_spans(struct setup_context *setup)
    const int maxright = MAX2(xright0, xright1);
    int x;
 
-   /* process quads in horizontal chunks of 16 */
+   /* process quads in horizontal chunks of SPAN_WIDTH pixels */
    for (x = minleft; x < maxright; x += step) {
       unsigned skip_left0 = CLAMP(xleft0 - x, 0, step);
       unsigned skip_left1 = CLAMP(xleft1 - x, 0, step);
@@ -217,20 +221,21 @@ flush_spans(struct setup_context *setup)
       unsigned lx = x;
       unsigned q = 0;
 
-      unsigned skipmask_left0 = (1U << skip_left0) - 1U;
-      unsigned skipmask_left1 = (1U << skip_left1) - 1U;
+      uint64_t skipmask_left0 = (1ULL << skip_left0) - 1ULL;
+      uint64_t skipmask_left1 = (1ULL << skip_left1) - 1ULL;
 
-      /* These calculations fail when step == 32 and skip_right == 0.
+      /* step - skip_right is at most SPAN_WIDTH (32), which is always a
+       * valid shift count for these 64-bit masks.
        */
-      unsigned skipmask_right0 = ~0U << (unsigned)(step - skip_right0);
-      unsigned skipmask_right1 = ~0U << (unsigned)(step - skip_right1);
+      uint64_t skipmask_right0 = ~0ULL << (unsigned)(step - skip_right0);
+      uint64_t skipmask_right1 = ~0ULL << (unsigned)(step - skip_right1);
 
-      unsigned mask0 = ~skipmask_left0 & ~skipmask_right0;
-      unsigned mask1 = ~skipmask_left1 & ~skipmask_right1;
+      uint64_t mask0 = ~skipmask_left0 & ~skipmask_right0;
+      uint64_t mask1 = ~skipmask_left1 & ~skipmask_right1;
 
       if (mask0 | mask1) {
          do {
-            unsigned quadmask = (mask0 & 3) | ((mask1 & 3) << 2);
+            unsigned quadmask = (unsigned) ((mask0 & 3) | ((mask1 & 3) << 2));
             if (quadmask) {
                setup->quad[q].input.x0 = lx;
                setup->quad[q].input.y0 = setup->span.y;
@@ -816,6 +821,11 @@ sp_setup_tri(struct setup_context *setup,
 
    if (setup->softpipe->no_rast || setup->softpipe->rasterizer->rasterizer_discard)
       return;
+
+   if (setup->softpipe->binning) {
+      sp_bin_tri(setup->softpipe, v0, v1, v2);
+      return;
+   }
    
    det = calc_det(v0, v1, v2);
    /*
@@ -1087,6 +1097,10 @@ sp_setup_line(struct setup_context *setup,
    if (setup->softpipe->no_rast || setup->softpipe->rasterizer->rasterizer_discard)
       return;
 
+   /* draw any binned triangles first */
+   if (setup->softpipe->binning)
+      sp_bin_flush(setup->softpipe);
+
    if (dx == 0 && dy == 0)
       return;
 
@@ -1220,6 +1234,10 @@ sp_setup_point(struct setup_context *setup,
    if (setup->softpipe->no_rast || setup->softpipe->rasterizer->rasterizer_discard)
       return;
 
+   /* draw any binned triangles first */
+   if (setup->softpipe->binning)
+      sp_bin_flush(setup->softpipe);
+
    assert(setup->softpipe->reduced_prim == PIPE_PRIM_POINTS);
 
    /* For points, all interpolants are constant-valued.
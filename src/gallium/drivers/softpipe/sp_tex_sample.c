@@ -575,11 +575,34 @@ compute_lambda_vert(const struct sp_sampler_view *sview,
 
 
 
+/**
+ * Get a texel pointer straight from the texture's storage, for views
+ * with sp_sampler_view::direct set.
+ */
+static INLINE const float *
+get_texel_direct(const struct sp_sampler_view *sp_sview,
+                 union tex_tile_address addr, int x, int y)
+{
+   const struct softpipe_resource *spr =
+      softpipe_resource(sp_sview->base.texture);
+   const unsigned level = addr.bits.level;
+   const unsigned layer = addr.bits.face + addr.bits.z;
+   const ubyte *row = (const ubyte *) spr->data + spr->level_offset[level] +
+      (layer * u_minify(spr->base.height0, level) + y) * spr->stride[level];
+
+   return (const float *) row + x * 4;
+}
+
+
 static INLINE const float *
 get_texel_2d_no_border(const struct sp_sampler_view *sp_sview,
                        union tex_tile_address addr, int x, int y)
 {
    const struct softpipe_tex_cached_tile *tile;
+
+   if (sp_sview->direct)
+      return get_texel_direct(sp_sview, addr, x, y);
+
    addr.bits.x = x / TILE_SIZE;
    addr.bits.y = y / TILE_SIZE;
    y %= TILE_SIZE;
@@ -722,6 +745,14 @@ get_texel_quad_2d_no_border_single_tile(const struct sp_sampler_view *sp_sview,
 {
     const struct softpipe_tex_cached_tile *tile;
 
+   if (sp_sview->direct) {
+      out[0] = get_texel_direct(sp_sview, addr, x, y);
+      out[1] = out[0] + 4;
+      out[2] = get_texel_direct(sp_sview, addr, x, y + 1);
+      out[3] = out[2] + 4;
+      return;
+   }
+
    addr.bits.x = x / TILE_SIZE;
    addr.bits.y = y / TILE_SIZE;
    y %= TILE_SIZE;
@@ -777,6 +808,11 @@ get_texel_3d_no_border(const struct sp_sampler_view *sp_sview,
 {
    const struct softpipe_tex_cached_tile *tile;
 
+   if (sp_sview->direct) {
+      addr.bits.z = z;
+      return get_texel_direct(sp_sview, addr, x, y);
+   }
+
    addr.bits.x = x / TILE_SIZE;
    addr.bits.y = y / TILE_SIZE;
    addr.bits.z = z;
@@ -3078,6 +3114,13 @@ softpipe_create_sampler_view(struct pipe_context *pipe,
 
       sview->xpot = util_logbase2( resource->width0 );
       sview->ypot = util_logbase2( resource->height0 );
+
+      sview->direct = spr->data && !spr->dt &&
+                      resource->target != PIPE_BUFFER &&
+                      (view->format == PIPE_FORMAT_R32G32B32A32_FLOAT ||
+                       view->format == PIPE_FORMAT_R32G32B32A32_UINT ||
+                       view->format == PIPE_FORMAT_R32G32B32A32_SINT) &&
+                      util_format_get_blocksize(resource->format) == 16;
    }
 
    return (struct pipe_sampler_view *) sview;
@@ -103,6 +103,11 @@ struct sp_sampler_view
    boolean need_swizzle;
    boolean pot2d;
 
+   /* Texels are stored as four 32-bit floats/ints, just like in the
+    * texture tile cache, so they can be read in place:
+    */
+   boolean direct;
+
    filter_func get_samples;
 
    /* this is just abusing the sampler_view object as local storage */
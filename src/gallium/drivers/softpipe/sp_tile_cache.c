@@ -32,8 +32,10 @@
  *    Brian Paul
  */
 
+#include "util/u_debug.h"
 #include "util/u_inlines.h"
 #include "util/u_format.h"
+#include "util/u_math.h"
 #include "util/u_memory.h"
 #include "util/u_tile.h"
 #include "sp_tile_cache.h"
@@ -43,15 +45,27 @@ sp_alloc_tile(struct softpipe_tile_cache *tc);
 
 
 /**
- * Return the position in the cache for the tile that contains win pos (x,y).
- * We currently use a direct mapped cache so this is like a hack key.
- * At some point we should investige something more sophisticated, like
- * a LRU replacement policy.
+ * Return the position in the cache for the tile at the given address.
+ * When the whole surface fits in the cache every tile has its own entry,
+ * otherwise this is like a hash key.
  */
-#define CACHE_POS(x, y) \
-   (((x) + (y) * 5) % NUM_ENTRIES)
+static INLINE uint
+cache_pos(const struct softpipe_tile_cache *tc, union tile_address addr)
+{
+   if (tc->direct &&
+       addr.bits.x < tc->tiles_x &&
+       addr.bits.y < tc->tiles_y)
+      return addr.bits.y * tc->tiles_x + addr.bits.x;
+
+   return (addr.bits.x + addr.bits.y * 5) % tc->num_entries;
+}
+
 
 
+/** Size of the dirty_flags bitmap for the given number of entries */
+#define DIRTY_FLAGS_SIZE(num_entries) \
+   (((num_entries) + 31) / 32 * sizeof(uint))
+
 
 /**
  * Is the tile at (x,y) in cleared state?
@@ -99,7 +113,22 @@ sp_create_tile_cache( struct pipe_context *pipe )
    tc = CALLOC_STRUCT( softpipe_tile_cache );
    if (tc) {
       tc->pipe = pipe;
-      for (pos = 0; pos < Elements(tc->tile_addrs); pos++) {
+      tc->max_entries =
+         MAX2(debug_get_num_option("SOFTPIPE_TILE_CACHE_MB",
+                                   TILE_CACHE_DEFAULT_MB), 1) *
+         1024 * 1024 / sizeof(struct softpipe_cached_tile);
+      tc->num_entries = NUM_ENTRIES;
+      tc->tile_addrs = MALLOC(NUM_ENTRIES * sizeof(union tile_address));
+      tc->entries = CALLOC(NUM_ENTRIES, sizeof(struct softpipe_cached_tile *));
+      tc->dirty_flags = CALLOC(1, DIRTY_FLAGS_SIZE(NUM_ENTRIES));
+      if (!tc->tile_addrs || !tc->entries || !tc->dirty_flags) {
+         FREE(tc->tile_addrs);
+         FREE(tc->entries);
+         FREE(tc->dirty_flags);
+         FREE(tc);
+         return NULL;
+      }
+      for (pos = 0; pos < tc->num_entries; pos++) {
          tc->tile_addrs[pos].bits.invalid = 1;
       }
       tc->last_tile_addr.bits.invalid = 1;
@@ -110,6 +139,9 @@ sp_create_tile_cache( struct pipe_context *pipe )
       tc->tile = MALLOC_STRUCT( softpipe_cached_tile );
       if (!tc->tile)
       {
+         FREE(tc->tile_addrs);
+         FREE(tc->entries);
+         FREE(tc->dirty_flags);
          FREE(tc);
          return NULL;
       }
@@ -134,10 +166,13 @@ sp_destroy_tile_cache(struct softpipe_tile_cache *tc)
    if (tc) {
       uint pos;
 
-      for (pos = 0; pos < Elements(tc->entries); pos++) {
+      for (pos = 0; pos < tc->num_entries; pos++) {
          /*assert(tc->entries[pos].x < 0);*/
          FREE( tc->entries[pos] );
       }
+      FREE( tc->entries );
+      FREE( tc->tile_addrs );
+      FREE( tc->dirty_flags );
       FREE( tc->tile );
 
       if (tc->transfer) {
@@ -149,6 +184,63 @@ sp_destroy_tile_cache(struct softpipe_tile_cache *tc)
 }
 
 
+/**
+ * Size the cache for a surface of the given size, keeping the tiles
+ * already allocated where possible.
+ */
+static void
+sp_tile_cache_resize(struct softpipe_tile_cache *tc,
+                     unsigned width, unsigned height)
+{
+   const unsigned tiles_x = align(width, TILE_SIZE) / TILE_SIZE;
+   const unsigned tiles_y = align(height, TILE_SIZE) / TILE_SIZE;
+   const unsigned num_tiles = MAX2(tiles_x * tiles_y, 1);
+   const unsigned num_entries = MIN2(num_tiles, tc->max_entries);
+   uint pos;
+
+   if (num_entries != tc->num_entries) {
+      union tile_address *tile_addrs =
+         MALLOC(num_entries * sizeof(union tile_address));
+      struct softpipe_cached_tile **entries =
+         CALLOC(num_entries, sizeof(struct softpipe_cached_tile *));
+      uint *dirty_flags = CALLOC(1, DIRTY_FLAGS_SIZE(num_entries));
+
+      if (tile_addrs && entries && dirty_flags) {
+         for (pos = 0; pos < tc->num_entries; pos++) {
+            if (pos < num_entries)
+               entries[pos] = tc->entries[pos];
+            else
+               FREE(tc->entries[pos]);
+         }
+
+         FREE(tc->tile_addrs);
+         FREE(tc->entries);
+         FREE(tc->dirty_flags);
+         tc->tile_addrs = tile_addrs;
+         tc->entries = entries;
+         tc->dirty_flags = dirty_flags;
+         tc->num_entries = num_entries;
+      }
+      else {
+         /* keep hashing into the entries we have */
+         FREE(tile_addrs);
+         FREE(entries);
+         FREE(dirty_flags);
+      }
+   }
+
+   for (pos = 0; pos < tc->num_entries; pos++) {
+      tc->tile_addrs[pos].bits.invalid = 1;
+   }
+   memset(tc->dirty_flags, 0, DIRTY_FLAGS_SIZE(tc->num_entries));
+   tc->last_tile_addr.bits.invalid = 1;
+
+   tc->tiles_x = tiles_x;
+   tc->tiles_y = tiles_y;
+   tc->direct = num_tiles <= tc->num_entries;
+}
+
+
 /**
  * Specify the surface to cache.
  */
@@ -170,6 +262,8 @@ sp_tile_cache_set_surface(struct softpipe_tile_cache *tc,
    tc->surface = ps;
 
    if (ps) {
+      sp_tile_cache_resize(tc, ps->width, ps->height);
+
       if (ps->texture->target != PIPE_BUFFER) {
          tc->transfer_map = pipe_transfer_map(pipe, ps->texture,
                                               ps->u.tex.level, ps->u.tex.first_layer,
@@ -368,10 +462,24 @@ sp_tile_cache_flush_clear(struct softpipe_tile_cache *tc)
 #endif
 }
 
+/**
+ * Was the tile in the given entry modified since it was fetched?
+ */
+static INLINE uint
+is_dirty(const struct softpipe_tile_cache *tc, unsigned pos)
+{
+   return tc->dirty_flags[pos / 32] & (1 << (pos % 32));
+}
+
+
+/**
+ * Write the tile in the given entry back to the surface if it was
+ * modified, and mark the entry as empty.
+ */
 static void
 sp_flush_tile(struct softpipe_tile_cache* tc, unsigned pos)
 {
-   if (!tc->tile_addrs[pos].bits.invalid) {
+   if (!tc->tile_addrs[pos].bits.invalid && is_dirty(tc, pos)) {
       if (tc->depth_stencil) {
          pipe_put_tile_raw(tc->transfer, tc->transfer_map,
                            tc->tile_addrs[pos].bits.x * TILE_SIZE,
@@ -403,8 +511,9 @@ sp_flush_tile(struct softpipe_tile_cache* tc, unsigned pos)
                                       (float *) tc->entries[pos]->data.color);
          }
       }
-      tc->tile_addrs[pos].bits.invalid = 1;  /* mark as empty */
    }
+   tc->tile_addrs[pos].bits.invalid = 1;  /* mark as empty */
+   tc->dirty_flags[pos / 32] &= ~(1 << (pos % 32));
 }
 
 /**
@@ -419,7 +528,7 @@ sp_flush_tile_cache(struct softpipe_tile_cache *tc)
 
    if (pt) {
       /* caching a drawing transfer */
-      for (pos = 0; pos < Elements(tc->entries); pos++) {
+      for (pos = 0; pos < tc->num_entries; pos++) {
          struct softpipe_cached_tile *tile = tc->entries[pos];
          if (!tile)
          {
@@ -452,7 +561,7 @@ sp_alloc_tile(struct softpipe_tile_cache *tc)
       if (!tc->tile)
       {
          unsigned pos;
-         for (pos = 0; pos < Elements(tc->entries); ++pos) {
+         for (pos = 0; pos < tc->num_entries; ++pos) {
             if (!tc->entries[pos])
                continue;
 
@@ -485,8 +594,7 @@ sp_find_cached_tile(struct softpipe_tile_cache *tc,
 {
    struct pipe_transfer *pt = tc->transfer;
    /* cache pos/entry: */
-   const int pos = CACHE_POS(addr.bits.x,
-                             addr.bits.y);
+   const uint pos = cache_pos(tc, addr);
    struct softpipe_cached_tile *tile = tc->entries[pos];
 
    if (!tile) {
@@ -497,40 +605,8 @@ sp_find_cached_tile(struct softpipe_tile_cache *tc,
    if (addr.value != tc->tile_addrs[pos].value) {
 
       assert(pt->resource);
-      if (tc->tile_addrs[pos].bits.invalid == 0) {
-         /* put dirty tile back in framebuffer */
-         if (tc->depth_stencil) {
-            pipe_put_tile_raw(pt, tc->transfer_map,
-                              tc->tile_addrs[pos].bits.x * TILE_SIZE,
-                              tc->tile_addrs[pos].bits.y * TILE_SIZE,
-                              TILE_SIZE, TILE_SIZE,
-                              tile->data.depth32, 0/*STRIDE*/);
-         }
-         else {
-            if (util_format_is_pure_uint(tc->surface->format)) {
-               pipe_put_tile_ui_format(pt, tc->transfer_map,
-                                      tc->tile_addrs[pos].bits.x * TILE_SIZE,
-                                      tc->tile_addrs[pos].bits.y * TILE_SIZE,
-                                      TILE_SIZE, TILE_SIZE,
-                                      tc->surface->format,
-                                      (unsigned *) tile->data.colorui128);
-            } else if (util_format_is_pure_sint(tc->surface->format)) {
-               pipe_put_tile_i_format(pt, tc->transfer_map,
-                                      tc->tile_addrs[pos].bits.x * TILE_SIZE,
-                                      tc->tile_addrs[pos].bits.y * TILE_SIZE,
-                                      TILE_SIZE, TILE_SIZE,
-                                      tc->surface->format,
-                                      (int *) tile->data.colori128);
-            } else {
-               pipe_put_tile_rgba_format(pt, tc->transfer_map,
-                                         tc->tile_addrs[pos].bits.x * TILE_SIZE,
-                                         tc->tile_addrs[pos].bits.y * TILE_SIZE,
-                                         TILE_SIZE, TILE_SIZE,
-                                         tc->surface->format,
-                                         (float *) tile->data.color);
-            }
-         }
-      }
+      /* put dirty tile back in framebuffer */
+      sp_flush_tile(tc, pos);
 
       tc->tile_addrs[pos] = addr;
 
@@ -543,6 +619,8 @@ sp_find_cached_tile(struct softpipe_tile_cache *tc,
             clear_tile_rgba(tile, pt->resource->format, &tc->clear_color);
          }
          clear_clear_flag(tc->clear_flags, addr);
+         /* the clear only happens when the tile is written back */
+         tc->dirty_flags[pos / 32] |= 1 << (pos % 32);
       }
       else {
          /* get new tile data from transfer */
@@ -582,6 +660,7 @@ sp_find_cached_tile(struct softpipe_tile_cache *tc,
 
    tc->last_tile = tile;
    tc->last_tile_addr = addr;
+   tc->last_pos = pos;
    return tile;
 }
 
@@ -608,8 +687,9 @@ sp_tile_cache_clear(struct softpipe_tile_cache *tc,
    /* set flags to indicate all the tiles are cleared */
    memset(tc->clear_flags, 255, sizeof(tc->clear_flags));
 
-   for (pos = 0; pos < Elements(tc->tile_addrs); pos++) {
+   for (pos = 0; pos < tc->num_entries; pos++) {
       tc->tile_addrs[pos].bits.invalid = 1;
    }
+   memset(tc->dirty_flags, 0, DIRTY_FLAGS_SIZE(tc->num_entries));
    tc->last_tile_addr.bits.invalid = 1;
 }
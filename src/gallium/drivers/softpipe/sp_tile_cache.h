@@ -75,8 +75,14 @@ struct softpipe_cached_tile
    } data;
 };
 
+/** Number of cache entries when no surface is bound */
 #define NUM_ENTRIES 50
 
+/** Default memory budget for the tiles of one cache, in megabytes.
+ * SOFTPIPE_TILE_CACHE_MB overrides it.
+ */
+#define TILE_CACHE_DEFAULT_MB 64
+
 
 struct softpipe_tile_cache
 {
@@ -85,8 +91,19 @@ struct softpipe_tile_cache
    struct pipe_transfer *transfer;
    void *transfer_map;
 
-   union tile_address tile_addrs[NUM_ENTRIES];
-   struct softpipe_cached_tile *entries[NUM_ENTRIES];
+   /**
+    * The cache has one entry per surface tile (direct mapped) when the
+    * surface has no more than max_entries tiles.  Otherwise tiles are
+    * hashed into max_entries entries.  Tiles are allocated on first use.
+    */
+   unsigned max_entries;
+   unsigned num_entries;
+   boolean direct;
+   unsigned tiles_x, tiles_y;  /**< surface size in tiles */
+   union tile_address *tile_addrs;
+   struct softpipe_cached_tile **entries;
+   uint *dirty_flags;  /**< bit per entry, set if it must be written back */
+
    uint clear_flags[(MAX_WIDTH / TILE_SIZE) * (MAX_HEIGHT / TILE_SIZE) / 32];
    union pipe_color_union clear_color; /**< for color bufs */
    uint64_t clear_val;        /**< for z+stencil */
@@ -96,6 +113,7 @@ struct softpipe_tile_cache
 
    union tile_address last_tile_addr;
    struct softpipe_cached_tile *last_tile;  /**< most recently retrieved tile */
+   unsigned last_pos;                       /**< entry of last_tile */
 };
 
 
@@ -138,11 +156,13 @@ tile_address( unsigned x,
    return addr;
 }
 
-/* Quickly retrieve tile if it matches last lookup.
+/* Quickly retrieve tile if it matches last lookup.  The tile is only
+ * read, so it isn't written back to the surface unless someone else
+ * modifies it.
  */
 static INLINE struct softpipe_cached_tile *
-sp_get_cached_tile(struct softpipe_tile_cache *tc, 
-                   int x, int y )
+sp_get_cached_tile_ro(struct softpipe_tile_cache *tc,
+                      int x, int y )
 {
    union tile_address addr = tile_address( x, y );
 
@@ -152,6 +172,18 @@ sp_get_cached_tile(struct softpipe_tile_cache *tc,
    return sp_find_cached_tile( tc, addr );
 }
 
+/* Like sp_get_cached_tile_ro(), for tiles that may be modified.
+ */
+static INLINE struct softpipe_cached_tile *
+sp_get_cached_tile(struct softpipe_tile_cache *tc, 
+                   int x, int y )
+{
+   struct softpipe_cached_tile *tile = sp_get_cached_tile_ro(tc, x, y);
+
+   tc->dirty_flags[tc->last_pos / 32] |= 1 << (tc->last_pos % 32);
+   return tile;
+}
+
 
 
 
@@ -284,8 +284,29 @@ enum pipe_transfer_usage {
     * - D3D10 DDI's D3D10_DDI_MAP_WRITE_DISCARD flag
     * - D3D10's D3D10_MAP_WRITE_DISCARD flag.
     */
-   PIPE_TRANSFER_DISCARD_WHOLE_RESOURCE = (1 << 12)
+   PIPE_TRANSFER_DISCARD_WHOLE_RESOURCE = (1 << 12),
 
+   /**
+    * Allows the resource to be used for rendering while mapped.
+    * Only valid for buffers, and only if PIPE_CAP_BUFFER_MAP_PERSISTENT_COHERENT
+    * is advertised.
+    *
+    * If COHERENT is not set, the written ranges must be flushed with
+    * transfer_flush_region for the device to see what the CPU has written.
+    *
+    * This is equivalent to:
+    * - OpenGL's ARB_buffer_storage MAP_PERSISTENT_BIT
+    */
+   PIPE_TRANSFER_PERSISTENT = (1 << 13),
+
+   /**
+    * If PERSISTENT is set, this ensures any writes done by the device are
+    * immediately visible to the CPU and vice versa.
+    *
+    * This is equivalent to:
+    * - OpenGL's ARB_buffer_storage MAP_COHERENT_BIT
+    */
+   PIPE_TRANSFER_COHERENT = (1 << 14)
 };
 
 /**
@@ -507,7 +528,10 @@ enum pipe_cap {
    PIPE_CAP_PREFER_BLIT_BASED_TEXTURE_TRANSFER = 80,
    PIPE_CAP_QUERY_PIPELINE_STATISTICS = 81,
    PIPE_CAP_TEXTURE_BORDER_COLOR_QUIRK = 82,
-   PIPE_CAP_MAX_VERTEX_BUFFERS = 83
+   PIPE_CAP_MAX_VERTEX_BUFFERS = 83,
+   PIPE_CAP_BUFFER_MAP_PERSISTENT_COHERENT = 84,
+   PIPE_CAP_DRAW_INDIRECT = 85,
+   PIPE_CAP_USER_VERTEX_BUFFERS_IN_PLACE = 86
 };
 
 #define PIPE_QUIRK_TEXTURE_BORDER_COLOR_SWIZZLE_NV50 (1 << 0)
@@ -556,6 +556,16 @@ struct pipe_draw_info
     * be set via set_vertex_buffers manually.
     */
    struct pipe_stream_output_target *count_from_stream_output;
+
+   /**
+    * Indirect draw parameters resource.  If not NULL, count, instance_count,
+    * start, index_bias (indexed drawing only) and start_instance are taken
+    * from this buffer instead, as consecutive 32-bit values in that order
+    * (the layout of GL_ARB_draw_indirect's commands).  min_index and
+    * max_index are not known for indirect draws.
+    */
+   struct pipe_resource *indirect;
+   unsigned indirect_offset; /**< must be 4 byte aligned */
 };
 
 
@@ -74,7 +74,7 @@ glcpp_warning (YYLTYPE *locp, glcpp_parser_t *parser, const char *fmt, ...)
  * preprocessing directives or in GLSL code).
  */
 static char *
-remove_line_continuations(glcpp_parser_t *ctx, const char *shader)
+remove_line_continuations(void *ctx, const char *shader)
 {
 	char *clean = ralloc_strdup(ctx, "");
 	const char *backslash, *newline, *search_start;
@@ -132,22 +132,195 @@ remove_line_continuations(glcpp_parser_t *ctx, const char *shader)
 	return clean;
 }
 
+/* Find the text following the last preprocessing directive of the shader.
+ *
+ * Returns the start of the line after the last directive, the whole shader
+ * if it has no directives, or NULL if a multi-line comment is still open at
+ * the end of the last directive.
+ */
+static const char *
+find_directive_free_tail(const char *shader)
+{
+	const char *tail = shader;
+	const char *p = shader;
+	bool in_comment = false;
+	bool tail_in_comment = false;
+
+	while (*p != '\0') {
+		bool directive = false;
+
+		if (!in_comment) {
+			const char *q = p;
+
+			while (*q == ' ' || *q == '\t')
+				q++;
+
+			directive = (*q == '#');
+		}
+
+		/* Scan to the end of the line, tracking comments. */
+		while (*p != '\0' && *p != '\n') {
+			if (in_comment) {
+				if (p[0] == '*' && p[1] == '/') {
+					in_comment = false;
+					p++;
+				}
+			} else if (p[0] == '/' && p[1] == '/') {
+				while (p[1] != '\0' && p[1] != '\n')
+					p++;
+			} else if (p[0] == '/' && p[1] == '*') {
+				in_comment = true;
+				p++;
+			}
+			p++;
+		}
+
+		if (*p == '\n')
+			p++;
+
+		if (directive) {
+			tail = p;
+			tail_in_comment = in_comment;
+		}
+	}
+
+	return tail_in_comment ? NULL : tail;
+}
+
+/* Append text without preprocessing directives to the parser output.
+ *
+ * The text is copied verbatim, followed by the newline the lexer emits at
+ * the end of its input.  That only matches what the lexer and parser would
+ * produce if there is nothing for them to rewrite, so this returns false,
+ * leaving the text to the full preprocessor, if it refers to any macro,
+ * contains a comment or a '#', or has whitespace other than single spaces
+ * between tokens and newlines.
+ */
+static bool
+append_directive_free_text(glcpp_parser_t *parser, const char *text)
+{
+	const char *p = text;
+	char name[128];
+
+	while (*p != '\0') {
+		if (*p == ' ') {
+			if (p == text || p[-1] == '\n' || p[-1] == ' ' ||
+			    p[1] == '\n' || p[1] == '\0')
+				return false;
+			p++;
+		} else if (*p == '\n') {
+			p++;
+		} else if (isspace((unsigned char) *p) || *p == '#' ||
+			   (p[0] == '/' && (p[1] == '/' || p[1] == '*'))) {
+			return false;
+		} else if (isalpha((unsigned char) *p) || *p == '_') {
+			const char *start = p;
+			size_t len;
+
+			while (isalnum((unsigned char) *p) || *p == '_')
+				p++;
+
+			len = p - start;
+			if (len >= sizeof(name))
+				return false;
+
+			memcpy(name, start, len);
+			name[len] = '\0';
+
+			if (strcmp(name, "__LINE__") == 0 ||
+			    strcmp(name, "__FILE__") == 0 ||
+			    hash_table_find(parser->defines, name) != NULL)
+				return false;
+		} else if (isdigit((unsigned char) *p)) {
+			/* Skip whole numbers so that suffixes and exponents
+			 * are not mistaken for identifiers.
+			 */
+			while (isalnum((unsigned char) *p) || *p == '_' || *p == '.')
+				p++;
+		} else {
+			p++;
+		}
+	}
+
+	ralloc_asprintf_rewrite_tail(&parser->output, &parser->output_length,
+				     "%s\n", text);
+
+	return true;
+}
+
+/* Preprocess a shader whose directives are all at the top.
+ *
+ * Generated shaders often consist of a few #defines followed by a large
+ * body that uses none of them.  Only the part up to the last directive is
+ * run through the lexer and parser; the remainder is copied to the output
+ * as long as the lexer would leave it unchanged.  Returns NULL if the shader
+ * needs the full preprocessor.
+ */
+static glcpp_parser_t *
+preprocess_directive_free_tail(void *mem_ctx, const char *shader,
+			       const struct gl_extensions *extensions, int api)
+{
+	const char *tail = find_directive_free_tail(shader);
+	glcpp_parser_t *parser;
+
+	if (tail == NULL || *tail == '\0')
+		return NULL;
+
+	parser = glcpp_parser_create (extensions, api);
+
+	if (tail != shader) {
+		glcpp_lex_set_source_string (parser,
+					     ralloc_strndup(mem_ctx, shader,
+							    tail - shader));
+		glcpp_parser_parse (parser);
+
+		/* The lexer emits an additional newline at the end of its
+		 * input, which has to be dropped to keep the line numbers of
+		 * the remaining text.
+		 */
+		if (parser->skip_stack || parser->output_length < 2 ||
+		    strcmp(&parser->output[parser->output_length - 2],
+			   "\n\n") != 0)
+			goto fail;
+
+		parser->output[--parser->output_length] = '\0';
+	}
+
+	if (!append_directive_free_text(parser, tail))
+		goto fail;
+
+	return parser;
+
+fail:
+	glcpp_parser_destroy (parser);
+	return NULL;
+}
+
 int
 glcpp_preprocess(void *ralloc_ctx, const char **shader, char **info_log,
 	   const struct gl_extensions *extensions, struct gl_context *gl_ctx)
 {
 	int errors;
-	glcpp_parser_t *parser = glcpp_parser_create (extensions, gl_ctx->API);
+	void *mem_ctx = ralloc_context(NULL);
+	const char *source = *shader;
+	glcpp_parser_t *parser;
 
 	if (! gl_ctx->Const.DisableGLSLLineContinuations)
-		*shader = remove_line_continuations(parser, *shader);
+		source = remove_line_continuations(mem_ctx, source);
+
+	parser = preprocess_directive_free_tail(mem_ctx, source, extensions,
+						gl_ctx->API);
+	if (parser == NULL) {
+		parser = glcpp_parser_create (extensions, gl_ctx->API);
 
-	glcpp_lex_set_source_string (parser, *shader);
+		glcpp_lex_set_source_string (parser, source);
 
-	glcpp_parser_parse (parser);
+		glcpp_parser_parse (parser);
 
-	if (parser->skip_stack)
-		glcpp_error (&parser->skip_stack->loc, parser, "Unterminated #if\n");
+		if (parser->skip_stack)
+			glcpp_error (&parser->skip_stack->loc, parser,
+				     "Unterminated #if\n");
+	}
 
 	ralloc_strcat(info_log, parser->info_log);
 
@@ -156,5 +329,6 @@ glcpp_preprocess(void *ralloc_ctx, const char **shader, char **info_log,
 
 	errors = parser->error;
 	glcpp_parser_destroy (parser);
+	ralloc_free(mem_ctx);
 	return errors;
 }
@@ -592,28 +592,57 @@ glsl_type::get_instance(unsigned base_type, unsigned rows, unsigned columns)
 }
 
 
+/**
+ * Key of the array type table
+ *
+ * The base type pointer is used rather than its name, because the name of
+ * the base type may not be unique across shaders.  For example, two shaders
+ * may have different record types named 'foo'.
+ */
+struct array_key {
+   const glsl_type *base;
+   unsigned array_size;
+};
+
+
+static int
+array_key_compare(const void *a, const void *b)
+{
+   const array_key *const key1 = (const array_key *) a;
+   const array_key *const key2 = (const array_key *) b;
+
+   return key1->base != key2->base || key1->array_size != key2->array_size;
+}
+
+
+static unsigned
+array_key_hash(const void *a)
+{
+   const array_key *const key = (const array_key *) a;
+
+   return hash_table_pointer_hash(key->base) * 31 + key->array_size;
+}
+
+
 const glsl_type *
 glsl_type::get_array_instance(const glsl_type *base, unsigned array_size)
 {
 
    if (array_types == NULL) {
-      array_types = hash_table_ctor(64, hash_table_string_hash,
-				    hash_table_string_compare);
+      array_types = hash_table_ctor(64, array_key_hash, array_key_compare);
    }
 
-   /* Generate a name using the base type pointer in the key.  This is
-    * done because the name of the base type may not be unique across
-    * shaders.  For example, two shaders may have different record types
-    * named 'foo'.
-    */
-   char key[128];
-   snprintf(key, sizeof(key), "%p[%u]", (void *) base, array_size);
+   array_key key;
+   key.base = base;
+   key.array_size = array_size;
 
-   const glsl_type *t = (glsl_type *) hash_table_find(array_types, key);
+   const glsl_type *t = (glsl_type *) hash_table_find(array_types, &key);
    if (t == NULL) {
       t = new glsl_type(base, array_size);
 
-      hash_table_insert(array_types, (void *) t, ralloc_strdup(mem_ctx, key));
+      array_key *stored_key = ralloc(mem_ctx, array_key);
+      *stored_key = key;
+      hash_table_insert(array_types, (void *) t, stored_key);
    }
 
    assert(t->base_type == GLSL_TYPE_ARRAY);
@@ -661,20 +690,14 @@ unsigned
 glsl_type::record_key_hash(const void *a)
 {
    const glsl_type *const key = (glsl_type *) a;
-   char hash_key[128];
-   unsigned size = 0;
-
-   size = snprintf(hash_key, sizeof(hash_key), "%08x", key->length);
+   unsigned hash = hash_table_string_hash(key->name) ^ key->length;
 
    for (unsigned i = 0; i < key->length; i++) {
-      if (size >= sizeof(hash_key))
-	 break;
-
-      size += snprintf(& hash_key[size], sizeof(hash_key) - size,
-		       "%p", (void *) key->fields.structure[i].type);
+      hash = hash * 31
+         + hash_table_pointer_hash(key->fields.structure[i].type);
    }
 
-   return hash_table_string_hash(& hash_key);
+   return hash;
 }
 
 
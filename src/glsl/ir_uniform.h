@@ -99,6 +99,12 @@ struct gl_uniform_storage {
     */
    bool initialized;
 
+   /**
+    * Bitmask of the shader stages (1 << gl_shader_type) that use this
+    * uniform.
+    */
+   unsigned active_shader_mask;
+
    /**
     * Base sampler index
     *
@@ -268,8 +268,9 @@ public:
       memset(this->targets, 0, sizeof(this->targets));
    }
 
-   void start_shader()
+   void start_shader(gl_shader_type shader_type)
    {
+      this->shader_type = shader_type;
       this->shader_samplers_used = 0;
       this->shader_shadow_samplers = 0;
    }
@@ -354,6 +355,8 @@ private:
       if (!found)
 	 return;
 
+      this->uniforms[id].active_shader_mask |= 1 << this->shader_type;
+
       /* If there is already storage associated with this uniform, it means
        * that it was set while processing an earlier shader stage.  For
        * example, we may be processing the uniform in the fragment shader, but
@@ -460,6 +463,11 @@ public:
 
    gl_texture_index targets[MAX_SAMPLERS];
 
+   /**
+    * Current shader stage.
+    */
+   gl_shader_type shader_type;
+
    /**
     * Mask of samplers used by the current shader stage.
     */
@@ -708,7 +716,7 @@ link_assign_uniform_locations(struct gl_shader_program *prog)
 
       /* Reset various per-shader target counts.
        */
-      parcel.start_shader();
+      parcel.start_shader((gl_shader_type) i);
 
       foreach_list(node, prog->_LinkedShaders[i]->ir) {
 	 ir_variable *const var = ((ir_instruction *) node)->as_variable();
@@ -1766,8 +1766,10 @@ link_shaders(struct gl_context *ctx, struct gl_shader_program *prog)
       }
 
       unsigned max_unroll = ctx->ShaderCompilerOptions[i].MaxUnrollIterations;
+      bool no_loops = ctx->ShaderCompilerOptions[i].EmitNoLoops;
 
-      while (do_common_optimization(prog->_LinkedShaders[i]->ir, true, false, max_unroll))
+      while (do_common_optimization(prog->_LinkedShaders[i]->ir, true, false,
+                                    max_unroll, no_loops))
 	 ;
    }
 
@@ -27,11 +27,13 @@
 
 class loop_unroll_visitor : public ir_hierarchical_visitor {
 public:
-   loop_unroll_visitor(loop_state *state, unsigned max_iterations)
+   loop_unroll_visitor(loop_state *state, unsigned max_iterations,
+                       bool emit_no_loops)
    {
       this->state = state;
       this->progress = false;
       this->max_iterations = max_iterations;
+      this->emit_no_loops = emit_no_loops;
    }
 
    virtual ir_visitor_status visit_leave(ir_loop *ir);
@@ -40,6 +42,9 @@ public:
 
    bool progress;
    unsigned max_iterations;
+
+   /** Unroll regardless of size, since the backend can't emit loops */
+   bool emit_no_loops;
 };
 
 
@@ -75,6 +80,27 @@ public:
       return visit_continue;
    }
 
+   virtual ir_visitor_status visit_enter(ir_if *ir)
+   {
+      nodes++;
+      return visit_continue;
+   }
+
+   virtual ir_visitor_status visit_enter(ir_texture *ir)
+   {
+      /* Texture lookups expand to far more code than ALU operations in most
+       * backends, so weigh them accordingly.
+       */
+      nodes += 4;
+      return visit_continue;
+   }
+
+   virtual ir_visitor_status visit_enter(ir_call *ir)
+   {
+      nodes += 4;
+      return visit_continue;
+   }
+
    virtual ir_visitor_status visit_enter(ir_loop *ir)
    {
       fail = true;
@@ -106,15 +132,22 @@ loop_unroll_visitor::visit_leave(ir_loop *ir)
       return visit_continue;
 
    /* Don't try to unroll loops that have zillions of iterations either.
+    * Loops with a tiny body may run past max_iterations, since unrolling them
+    * costs less code than a longer loop with a big body.
     */
-   if (iterations > (int) max_iterations)
+   if (iterations > (int) max_iterations * 4 && !emit_no_loops)
       return visit_continue;
 
-   /* Don't try to unroll nested loops and loops with a huge body.
+   /* Don't try to unroll nested loops and loops with a huge body.  The
+    * limit is on the size of the unrolled code rather than on the iteration
+    * count alone.
     */
    loop_unroll_count count(&ir->body_instructions);
 
-   if (count.fail || count.nodes * iterations > (int)max_iterations * 5)
+   if (count.fail)
+      return visit_continue;
+
+   if (count.nodes * iterations > (int)max_iterations * 8 && !emit_no_loops)
       return visit_continue;
 
    if (ls->num_loop_jumps > 1)
@@ -243,9 +276,10 @@ loop_unroll_visitor::visit_leave(ir_loop *ir)
 
 
 bool
-unroll_loops(exec_list *instructions, loop_state *ls, unsigned max_iterations)
+unroll_loops(exec_list *instructions, loop_state *ls, unsigned max_iterations,
+             bool emit_no_loops)
 {
-   loop_unroll_visitor v(ls, max_iterations);
+   loop_unroll_visitor v(ls, max_iterations, emit_no_loops);
 
    v.run(instructions);
 
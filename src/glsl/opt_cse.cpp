@@ -0,0 +1,835 @@
+/*
+ * Copyright © 2013 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file opt_cse.cpp
+ *
+ * Global common subexpression elimination over the structured IR.
+ *
+ * Because the IR has no unstructured control flow, the nesting of
+ * if-statements and loops is the dominator tree: an expression computed
+ * earlier in an enclosing block dominates everything that comes after it
+ * in that block, including the bodies of nested ifs and loops.  So instead
+ * of building SSA form, we walk the tree in order keeping a scoped table
+ * of available expressions (value numbering on the expression structure).
+ * Entries are dropped when leaving the block that computed them, and any
+ * write to a variable kills the entries that read it.  The table is hashed
+ * on the expression structure, and the entries are also indexed by the
+ * variables they read, so that neither lookups nor kills scan the whole
+ * table.
+ *
+ * When an expression is found a second time, the first occurrence is
+ * moved into a new temporary just before the statement that contained
+ * it, and both occurrences are replaced with reads of that temporary.
+ * Copy propagation and dead code elimination clean up afterwards.
+ */
+
+#include "ir.h"
+#include "ir_visitor.h"
+#include "ir_optimization.h"
+#include "glsl_types.h"
+#include "main/hash_table.h"
+
+namespace {
+
+static bool debug = false;
+
+class ae_entry;
+
+/**
+ * Link from a variable to an available expression that reads it.
+ */
+class ae_ref : public exec_node
+{
+public:
+   ae_ref(ae_entry *entry, ir_variable *var, ae_ref *next)
+      : entry(entry), var(var), next(next)
+   {
+   }
+
+   ae_entry *entry;
+
+   ir_variable *var;
+
+   /** Next reference of the same entry, to another variable. */
+   ae_ref *next;
+};
+
+/**
+ * An available expression.
+ */
+class ae_entry : public exec_node
+{
+public:
+   ae_entry(ir_instruction *base_ir, ir_rvalue **val, unsigned depth,
+            unsigned index)
+      : base_ir(base_ir), val(val), expr(*val), var(NULL), depth(depth),
+        index(index), hash(0), parent(NULL), refs(NULL), live(true)
+   {
+      assert(base_ir);
+      assert(val);
+   }
+
+   /** Statement before which the temporary gets assigned. */
+   ir_instruction *base_ir;
+
+   /** Slot holding the first occurrence of the expression. */
+   ir_rvalue **val;
+
+   /** The expression itself, which stays valid after it has been moved. */
+   ir_rvalue *expr;
+
+   /** Temporary holding the value, once the expression has been reused. */
+   ir_variable *var;
+
+   /** Block nesting depth at which the expression was computed. */
+   unsigned depth;
+
+   /** Order in which the entries were created. */
+   unsigned index;
+
+   /** Hash of expr, as stored in the table. */
+   uint32_t hash;
+
+   /**
+    * Entry of the expression that \c val was an operand of.  Its hash
+    * changes when this one is replaced by a temporary.
+    */
+   ae_entry *parent;
+
+   /** References from the variables read by expr. */
+   ae_ref *refs;
+
+   /** Whether the entry is still in the table. */
+   bool live;
+};
+
+class cse_visitor : public ir_hierarchical_visitor {
+public:
+   cse_visitor()
+   {
+      progress = false;
+      depth = 0;
+      num_entries = 0;
+      mem_ctx = ralloc_context(NULL);
+      ae = new(mem_ctx) exec_list;
+      exprs = _mesa_hash_table_create(mem_ctx, expr_equals);
+      vars = _mesa_hash_table_create(mem_ctx, _mesa_key_pointer_equal);
+   }
+
+   ~cse_visitor()
+   {
+      ralloc_free(mem_ctx);
+   }
+
+   virtual ir_visitor_status visit_enter(ir_function_signature *);
+   virtual ir_visitor_status visit_enter(ir_assignment *);
+   virtual ir_visitor_status visit_enter(ir_if *);
+   virtual ir_visitor_status visit_enter(ir_loop *);
+   virtual ir_visitor_status visit_enter(ir_call *);
+   virtual ir_visitor_status visit_enter(ir_return *);
+   virtual ir_visitor_status visit_enter(ir_discard *);
+
+   static bool expr_equals(const void *a, const void *b);
+
+   void process(ir_rvalue **rvalue);
+   ae_entry *find(ir_rvalue *ir);
+   void add(ir_rvalue **rvalue, unsigned first_operand);
+   void add_refs(ae_entry *entry, ir_rvalue *ir);
+   void rehash(ae_entry *entry);
+   void move_operands(ir_rvalue **slot, ir_instruction *from,
+                      ir_instruction *to);
+   void reuse(ae_entry *entry, ir_rvalue **rvalue);
+   void remove(ae_entry *entry);
+   void kill(ir_variable *var);
+   void kill_all();
+   void leave_block(unsigned depth);
+   void visit_block(exec_list *instructions);
+
+   /**
+    * List of ae_entry: expressions whose values are available, in the
+    * order they were found, and so also by increasing depth.
+    */
+   exec_list *ae;
+
+   /** Table of the available expressions, mapping them to their ae_entry. */
+   hash_table *exprs;
+
+   /** Table mapping variables to lists of ae_ref for the entries reading them. */
+   hash_table *vars;
+
+   unsigned depth;
+
+   unsigned num_entries;
+
+   bool progress;
+
+   void *mem_ctx;
+};
+
+/**
+ * Collects the variables written anywhere inside a loop body, so that
+ * expressions reading them aren't considered available at the loop head.
+ */
+class loop_kill_visitor : public ir_hierarchical_visitor {
+public:
+   loop_kill_visitor(cse_visitor *cse)
+      : cse(cse), found_call(false)
+   {
+   }
+
+   virtual ir_visitor_status visit_enter(ir_assignment *ir)
+   {
+      cse->kill(ir->lhs->variable_referenced());
+      return visit_continue_with_parent;
+   }
+
+   virtual ir_visitor_status visit_enter(ir_loop *ir)
+   {
+      if (ir->counter)
+         cse->kill(ir->counter);
+      return visit_continue;
+   }
+
+   virtual ir_visitor_status visit_enter(ir_call *)
+   {
+      found_call = true;
+      return visit_continue_with_parent;
+   }
+
+   cse_visitor *cse;
+   bool found_call;
+};
+
+} /* unnamed namespace */
+
+/**
+ * Returns whether the rvalue tree is free of side effects and only reads
+ * variables and constants, so that two copies of it always compute the
+ * same value when none of the variables have been written in between.
+ */
+static bool
+is_cse_candidate(ir_rvalue *ir)
+{
+   switch (ir->ir_type) {
+   case ir_type_constant:
+   case ir_type_dereference_variable:
+      return true;
+
+   case ir_type_swizzle:
+      return is_cse_candidate(((ir_swizzle *) ir)->val);
+
+   case ir_type_dereference_record:
+      return is_cse_candidate(((ir_dereference_record *) ir)->record);
+
+   case ir_type_dereference_array: {
+      ir_dereference_array *deref = (ir_dereference_array *) ir;
+      return is_cse_candidate(deref->array) &&
+         is_cse_candidate(deref->array_index);
+   }
+
+   case ir_type_expression: {
+      ir_expression *expr = (ir_expression *) ir;
+      for (unsigned i = 0; i < expr->get_num_operands(); i++) {
+         if (!is_cse_candidate(expr->operands[i]))
+            return false;
+      }
+      return true;
+   }
+
+   default:
+      return false;
+   }
+}
+
+/**
+ * Returns whether two candidate rvalue trees compute the same value.
+ */
+static bool
+equals(ir_rvalue *a, ir_rvalue *b)
+{
+   if (a == b)
+      return true;
+
+   if (a->ir_type != b->ir_type || a->type != b->type)
+      return false;
+
+   switch (a->ir_type) {
+   case ir_type_constant:
+      return ((ir_constant *) a)->has_value((ir_constant *) b);
+
+   case ir_type_dereference_variable:
+      return ((ir_dereference_variable *) a)->var ==
+         ((ir_dereference_variable *) b)->var;
+
+   case ir_type_swizzle: {
+      ir_swizzle *sa = (ir_swizzle *) a;
+      ir_swizzle *sb = (ir_swizzle *) b;
+      return sa->mask.num_components == sb->mask.num_components &&
+         sa->mask.x == sb->mask.x &&
+         sa->mask.y == sb->mask.y &&
+         sa->mask.z == sb->mask.z &&
+         sa->mask.w == sb->mask.w &&
+         equals(sa->val, sb->val);
+   }
+
+   case ir_type_dereference_record: {
+      ir_dereference_record *ra = (ir_dereference_record *) a;
+      ir_dereference_record *rb = (ir_dereference_record *) b;
+      return strcmp(ra->field, rb->field) == 0 &&
+         equals(ra->record, rb->record);
+   }
+
+   case ir_type_dereference_array: {
+      ir_dereference_array *da = (ir_dereference_array *) a;
+      ir_dereference_array *db = (ir_dereference_array *) b;
+      return equals(da->array, db->array) &&
+         equals(da->array_index, db->array_index);
+   }
+
+   case ir_type_expression: {
+      ir_expression *ea = (ir_expression *) a;
+      ir_expression *eb = (ir_expression *) b;
+      if (ea->operation != eb->operation)
+         return false;
+      for (unsigned i = 0; i < ea->get_num_operands(); i++) {
+         if (!equals(ea->operands[i], eb->operands[i]))
+            return false;
+      }
+      return true;
+   }
+
+   default:
+      return false;
+   }
+}
+
+static uint32_t
+hash_combine(uint32_t hash, uint32_t value)
+{
+   return (hash ^ value) * 0x01000193;
+}
+
+/**
+ * Hashes a candidate rvalue tree, so that trees for which equals() is true
+ * get the same hash.
+ */
+static uint32_t
+hash_rvalue(ir_rvalue *ir)
+{
+   uint32_t hash = hash_combine(2166136261ul, ir->ir_type);
+
+   hash = hash_combine(hash, _mesa_hash_pointer(ir->type));
+
+   switch (ir->ir_type) {
+   case ir_type_dereference_variable:
+      return hash_combine(hash, _mesa_hash_pointer(
+                             ((ir_dereference_variable *) ir)->var));
+
+   case ir_type_swizzle: {
+      ir_swizzle *swiz = (ir_swizzle *) ir;
+      hash = hash_combine(hash, swiz->mask.x | swiz->mask.y << 2 |
+                          swiz->mask.z << 4 | swiz->mask.w << 6 |
+                          swiz->mask.num_components << 8);
+      return hash_combine(hash, hash_rvalue(swiz->val));
+   }
+
+   case ir_type_dereference_record: {
+      ir_dereference_record *deref = (ir_dereference_record *) ir;
+      hash = hash_combine(hash, _mesa_hash_string(deref->field));
+      return hash_combine(hash, hash_rvalue(deref->record));
+   }
+
+   case ir_type_dereference_array: {
+      ir_dereference_array *deref = (ir_dereference_array *) ir;
+      hash = hash_combine(hash, hash_rvalue(deref->array));
+      return hash_combine(hash, hash_rvalue(deref->array_index));
+   }
+
+   case ir_type_expression: {
+      ir_expression *expr = (ir_expression *) ir;
+      hash = hash_combine(hash, expr->operation);
+      for (unsigned i = 0; i < expr->get_num_operands(); i++)
+         hash = hash_combine(hash, hash_rvalue(expr->operands[i]));
+      return hash;
+   }
+
+   default:
+      /* Constants are compared by value, which isn't worth hashing. */
+      return hash;
+   }
+}
+
+/**
+ * Returns whether the candidate rvalue tree reads any variable.
+ *
+ * Purely constant expressions are left for constant folding.
+ */
+static bool
+reads_variable(ir_rvalue *ir)
+{
+   switch (ir->ir_type) {
+   case ir_type_dereference_variable:
+      return true;
+
+   case ir_type_swizzle:
+      return reads_variable(((ir_swizzle *) ir)->val);
+
+   case ir_type_expression: {
+      ir_expression *expr = (ir_expression *) ir;
+      for (unsigned i = 0; i < expr->get_num_operands(); i++) {
+         if (reads_variable(expr->operands[i]))
+            return true;
+      }
+      return false;
+   }
+
+   default:
+      /* Array and record dereferences always bottom out in a variable. */
+      return ir->ir_type == ir_type_dereference_array ||
+         ir->ir_type == ir_type_dereference_record;
+   }
+}
+
+bool
+cse_visitor::expr_equals(const void *a, const void *b)
+{
+   return equals((ir_rvalue *) a, (ir_rvalue *) b);
+}
+
+ae_entry *
+cse_visitor::find(ir_rvalue *ir)
+{
+   hash_entry *e = _mesa_hash_table_search(this->exprs, hash_rvalue(ir), ir);
+
+   return e ? (ae_entry *) e->data : NULL;
+}
+
+/**
+ * Links \c entry to the variables read by \c ir, once per variable.
+ */
+void
+cse_visitor::add_refs(ae_entry *entry, ir_rvalue *ir)
+{
+   switch (ir->ir_type) {
+   case ir_type_dereference_variable: {
+      ir_variable *var = ((ir_dereference_variable *) ir)->var;
+      const uint32_t hash = _mesa_hash_pointer(var);
+      exec_list *list;
+
+      for (ae_ref *ref = entry->refs; ref; ref = ref->next) {
+         if (ref->var == var)
+            return;
+      }
+
+      hash_entry *e = _mesa_hash_table_search(this->vars, hash, var);
+      if (e) {
+         list = (exec_list *) e->data;
+      } else {
+         list = new(this->mem_ctx) exec_list;
+         _mesa_hash_table_insert(this->vars, hash, var, list);
+      }
+
+      entry->refs = new(this->mem_ctx) ae_ref(entry, var, entry->refs);
+      list->push_tail(entry->refs);
+      return;
+   }
+
+   case ir_type_swizzle:
+      add_refs(entry, ((ir_swizzle *) ir)->val);
+      return;
+
+   case ir_type_dereference_record:
+      add_refs(entry, ((ir_dereference_record *) ir)->record);
+      return;
+
+   case ir_type_dereference_array:
+      add_refs(entry, ((ir_dereference_array *) ir)->array);
+      add_refs(entry, ((ir_dereference_array *) ir)->array_index);
+      return;
+
+   case ir_type_expression: {
+      ir_expression *expr = (ir_expression *) ir;
+      for (unsigned i = 0; i < expr->get_num_operands(); i++)
+         add_refs(entry, expr->operands[i]);
+      return;
+   }
+
+   default:
+      return;
+   }
+}
+
+/**
+ * Makes the expression in \c *rvalue available.  The entries from
+ * \c first_operand on were added for its operands.
+ */
+void
+cse_visitor::add(ir_rvalue **rvalue, unsigned first_operand)
+{
+   ae_entry *entry = new(this->mem_ctx) ae_entry(this->base_ir, rvalue,
+                                                 this->depth,
+                                                 this->num_entries++);
+
+   entry->hash = hash_rvalue(entry->expr);
+   _mesa_hash_table_insert(this->exprs, entry->hash, entry->expr, entry);
+   add_refs(entry, entry->expr);
+
+   for (exec_node *n = this->ae->get_tail(); n; n = n->get_prev()) {
+      ae_entry *operand = (ae_entry *) n;
+
+      if (n->is_head_sentinel() || operand->index < first_operand)
+         break;
+      if (operand->parent == NULL && operand->var == NULL)
+         operand->parent = entry;
+   }
+
+   this->ae->push_tail(entry);
+}
+
+/**
+ * Updates the hash of an entry whose expression has changed.
+ */
+void
+cse_visitor::rehash(ae_entry *entry)
+{
+   hash_entry *e = _mesa_hash_table_search(this->exprs, entry->hash,
+                                           entry->expr);
+   assert(e && e->data == entry);
+   _mesa_hash_table_remove(this->exprs, e);
+
+   entry->hash = hash_rvalue(entry->expr);
+   if (_mesa_hash_table_search(this->exprs, entry->hash, entry->expr)) {
+      /* Now the same as another entry, which is enough. */
+      entry->live = false;
+      entry->remove();
+      for (ae_ref *ref = entry->refs; ref; ref = ref->next)
+         ref->remove();
+      return;
+   }
+
+   _mesa_hash_table_insert(this->exprs, entry->hash, entry->expr, entry);
+}
+
+/**
+ * Moves the entries for the parts of \c *slot that are assigned before
+ * \c from to be assigned before \c to instead.
+ */
+void
+cse_visitor::move_operands(ir_rvalue **slot, ir_instruction *from,
+                           ir_instruction *to)
+{
+   ir_rvalue *ir = *slot;
+
+   switch (ir->ir_type) {
+   case ir_type_swizzle:
+      move_operands(&((ir_swizzle *) ir)->val, from, to);
+      return;
+
+   case ir_type_dereference_array:
+      move_operands(&((ir_dereference_array *) ir)->array_index, from, to);
+      return;
+
+   case ir_type_expression: {
+      ir_expression *expr = (ir_expression *) ir;
+      ae_entry *entry = find(expr);
+
+      if (entry && entry->val == slot && entry->base_ir == from)
+         entry->base_ir = to;
+      for (unsigned i = 0; i < expr->get_num_operands(); i++)
+         move_operands(&expr->operands[i], from, to);
+      return;
+   }
+
+   default:
+      return;
+   }
+}
+
+/**
+ * Replaces \c *rvalue with a read of the temporary holding \c entry's value,
+ * creating the temporary first if this is the first reuse.
+ */
+void
+cse_visitor::reuse(ae_entry *entry, ir_rvalue **rvalue)
+{
+   void *ir_mem_ctx = ralloc_parent(entry->base_ir);
+
+   if (entry->var == NULL) {
+      ir_variable *var = new(ir_mem_ctx) ir_variable(entry->expr->type,
+                                                     "cse",
+                                                     ir_var_temporary);
+      ir_assignment *assign =
+         new(ir_mem_ctx) ir_assignment(new(ir_mem_ctx)
+                                       ir_dereference_variable(var),
+                                       entry->expr, NULL);
+
+      entry->base_ir->insert_before(var);
+      entry->base_ir->insert_before(assign);
+      *entry->val = new(ir_mem_ctx) ir_dereference_variable(var);
+
+      /* The expressions containing the old occurrence now read the
+       * temporary instead.
+       */
+      for (ae_entry *p = entry->parent; p; p = p->parent) {
+         if (p->live)
+            rehash(p);
+      }
+      entry->parent = NULL;
+
+      /* Subexpressions of the moved expression are now computed by the new
+       * assignment, so their own temporaries have to go in front of it.
+       */
+      move_operands(&assign->rhs, entry->base_ir, assign);
+
+      entry->base_ir = assign;
+      entry->val = &assign->rhs;
+      entry->var = var;
+   }
+
+   if (debug) {
+      printf("CSE: replacing ");
+      (*rvalue)->print();
+      printf(" with %s@%p\n", entry->var->name, (void *) entry->var);
+   }
+
+   *rvalue = new(ir_mem_ctx) ir_dereference_variable(entry->var);
+   this->progress = true;
+}
+
+/**
+ * Looks for an available expression matching \c *rvalue.  If there isn't
+ * one, descends into the operands and then makes \c *rvalue available.
+ */
+void
+cse_visitor::process(ir_rvalue **rvalue)
+{
+   ir_rvalue *ir = *rvalue;
+
+   if (ir == NULL)
+      return;
+
+   switch (ir->ir_type) {
+   case ir_type_swizzle:
+      process(&((ir_swizzle *) ir)->val);
+      return;
+
+   case ir_type_dereference_array:
+      process(&((ir_dereference_array *) ir)->array_index);
+      return;
+
+   case ir_type_expression:
+      break;
+
+   default:
+      return;
+   }
+
+   ir_expression *expr = (ir_expression *) ir;
+
+   if (!is_cse_candidate(expr) || !reads_variable(expr)) {
+      for (unsigned i = 0; i < expr->get_num_operands(); i++)
+         process(&expr->operands[i]);
+      return;
+   }
+
+   ae_entry *entry = find(expr);
+   if (entry) {
+      reuse(entry, rvalue);
+      return;
+   }
+
+   const unsigned first_operand = this->num_entries;
+   for (unsigned i = 0; i < expr->get_num_operands(); i++)
+      process(&expr->operands[i]);
+
+   /* Rewriting the operands may have turned this into a match. */
+   entry = find(expr);
+   if (entry) {
+      reuse(entry, rvalue);
+      return;
+   }
+
+   add(rvalue, first_operand);
+}
+
+void
+cse_visitor::remove(ae_entry *entry)
+{
+   hash_entry *e = _mesa_hash_table_search(this->exprs, entry->hash,
+                                           entry->expr);
+   assert(e && e->data == entry);
+   _mesa_hash_table_remove(this->exprs, e);
+
+   for (ae_ref *ref = entry->refs; ref; ref = ref->next)
+      ref->remove();
+
+   entry->live = false;
+   entry->remove();
+}
+
+void
+cse_visitor::kill(ir_variable *var)
+{
+   assert(var != NULL);
+
+   hash_entry *e = _mesa_hash_table_search(this->vars,
+                                           _mesa_hash_pointer(var), var);
+   if (e == NULL)
+      return;
+
+   exec_list *list = (exec_list *) e->data;
+   while (!list->is_empty())
+      remove(((ae_ref *) list->get_head())->entry);
+}
+
+void
+cse_visitor::kill_all()
+{
+   while (!this->ae->is_empty())
+      remove((ae_entry *) this->ae->get_tail());
+}
+
+/**
+ * Drops the expressions computed in blocks nested deeper than \c depth.
+ */
+void
+cse_visitor::leave_block(unsigned depth)
+{
+   while (!this->ae->is_empty() &&
+          ((ae_entry *) this->ae->get_tail())->depth > depth)
+      remove((ae_entry *) this->ae->get_tail());
+
+   this->depth = depth;
+}
+
+void
+cse_visitor::visit_block(exec_list *instructions)
+{
+   unsigned orig_depth = this->depth;
+
+   this->depth++;
+   visit_list_elements(this, instructions);
+   leave_block(orig_depth);
+}
+
+ir_visitor_status
+cse_visitor::visit_enter(ir_function_signature *ir)
+{
+   /* Treat entry into a function signature as a completely separate
+    * block.  Any instructions at global scope will be shuffled into
+    * main() at link time, so they're irrelevant to us.
+    */
+   kill_all();
+   visit_block(&ir->body);
+   kill_all();
+
+   return visit_continue_with_parent;
+}
+
+ir_visitor_status
+cse_visitor::visit_enter(ir_assignment *ir)
+{
+   process(&ir->rhs);
+   process(&ir->condition);
+
+   kill(ir->lhs->variable_referenced());
+
+   return visit_continue_with_parent;
+}
+
+ir_visitor_status
+cse_visitor::visit_enter(ir_if *ir)
+{
+   process(&ir->condition);
+
+   /* Whatever is available before the if dominates both branches.  Writes
+    * inside a branch kill entries immediately, so anything still available
+    * once both branches are done is valid after the if as well.
+    */
+   visit_block(&ir->then_instructions);
+   visit_block(&ir->else_instructions);
+
+   return visit_continue_with_parent;
+}
+
+ir_visitor_status
+cse_visitor::visit_enter(ir_loop *ir)
+{
+   /* On the way around the back edge the loop body may have changed any
+    * of the variables it writes, so those can't be relied upon at the top
+    * of the body.
+    */
+   loop_kill_visitor lkv(this);
+
+   if (ir->counter)
+      kill(ir->counter);
+   visit_list_elements(&lkv, &ir->body_instructions);
+   if (lkv.found_call)
+      kill_all();
+
+   visit_block(&ir->body_instructions);
+
+   return visit_continue_with_parent;
+}
+
+ir_visitor_status
+cse_visitor::visit_enter(ir_call *)
+{
+   /* We don't know the side effects of the call, and the parameter list
+    * isn't a set of rvalue slots we can rewrite in place.  Kill everything.
+    */
+   kill_all();
+
+   return visit_continue_with_parent;
+}
+
+ir_visitor_status
+cse_visitor::visit_enter(ir_return *ir)
+{
+   process(&ir->value);
+
+   return visit_continue_with_parent;
+}
+
+ir_visitor_status
+cse_visitor::visit_enter(ir_discard *ir)
+{
+   process(&ir->condition);
+
+   return visit_continue_with_parent;
+}
+
+/**
+ * Does a common subexpression elimination pass on the code present in the
+ * instruction stream.
+ */
+bool
+do_cse(exec_list *instructions)
+{
+   cse_visitor v;
+
+   visit_list_elements(&v, instructions);
+
+   return v.progress;
+}
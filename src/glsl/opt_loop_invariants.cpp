@@ -0,0 +1,220 @@
+/*
+ * Copyright © 2013 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+/**
+ * \file opt_loop_invariants.cpp
+ *
+ * Moves expressions whose value cannot change between loop iterations out
+ * of the loop.
+ *
+ * An expression is loop invariant if it only reads constants and variables
+ * that are not assigned anywhere in the loop body, including nested loops.
+ * Such expressions are computed once into a temporary before the loop, and
+ * the loop reads the temporary instead.  Since expressions have no side
+ * effects, it does not matter if the loop ends up running zero times.
+ *
+ * Loops containing function calls are left alone, as calls may write to
+ * global variables and out parameters.  Texture lookups are never moved,
+ * since their implicit derivatives depend on the control flow around them.
+ */
+
+#include "ir.h"
+#include "ir_visitor.h"
+#include "ir_rvalue_visitor.h"
+#include "ir_optimization.h"
+#include "glsl_types.h"
+#include "program/hash_table.h"
+
+namespace {
+
+/**
+ * Collects the variables assigned anywhere in a loop body.
+ */
+class loop_written_visitor : public ir_hierarchical_visitor {
+public:
+   loop_written_visitor(hash_table *written)
+      : written(written), has_call(false)
+   {
+   }
+
+   virtual ir_visitor_status visit_leave(ir_assignment *ir)
+   {
+      ir_variable *var = ir->lhs->variable_referenced();
+      if (var != NULL && hash_table_find(this->written, var) == NULL)
+         hash_table_insert(this->written, var, var);
+      return visit_continue;
+   }
+
+   virtual ir_visitor_status visit_enter(ir_call *ir)
+   {
+      this->has_call = true;
+      return visit_stop;
+   }
+
+   hash_table *written;
+   bool has_call;
+};
+
+/**
+ * Determines whether an rvalue only reads variables outside of \c written.
+ */
+class invariant_check_visitor : public ir_hierarchical_visitor {
+public:
+   invariant_check_visitor(hash_table *written)
+      : written(written), invariant(true), reads_variable(false)
+   {
+   }
+
+   virtual ir_visitor_status visit(ir_dereference_variable *ir)
+   {
+      this->reads_variable = true;
+      if (hash_table_find(this->written, ir->var) != NULL) {
+         this->invariant = false;
+         return visit_stop;
+      }
+      return visit_continue;
+   }
+
+   virtual ir_visitor_status visit_enter(ir_texture *ir)
+   {
+      this->invariant = false;
+      return visit_stop;
+   }
+
+   virtual ir_visitor_status visit_enter(ir_call *ir)
+   {
+      this->invariant = false;
+      return visit_stop;
+   }
+
+   hash_table *written;
+   bool invariant;
+   bool reads_variable;
+};
+
+/**
+ * Replaces the invariant expressions of a single loop.
+ *
+ * Expressions are handled bottom-up, so once the operands of an expression
+ * have been moved out, the expression itself is found to be invariant and
+ * follows them.  Tree grafting later merges the resulting chain of
+ * temporaries back into single expressions.
+ */
+class loop_hoist_visitor : public ir_rvalue_visitor {
+public:
+   loop_hoist_visitor(ir_loop *loop, hash_table *written)
+      : loop(loop), written(written), progress(false)
+   {
+   }
+
+   void handle_rvalue(ir_rvalue **rvalue);
+
+   ir_loop *loop;
+   hash_table *written;
+   bool progress;
+};
+
+class ir_loop_invariants_visitor : public ir_hierarchical_visitor {
+public:
+   ir_loop_invariants_visitor()
+      : progress(false)
+   {
+   }
+
+   virtual ir_visitor_status visit_leave(ir_loop *ir);
+
+   bool progress;
+};
+
+} /* unnamed namespace */
+
+void
+loop_hoist_visitor::handle_rvalue(ir_rvalue **rvalue)
+{
+   if (*rvalue == NULL)
+      return;
+
+   ir_expression *expr = (*rvalue)->as_expression();
+   if (expr == NULL)
+      return;
+
+   invariant_check_visitor check(this->written);
+   expr->accept(&check);
+
+   /* Expressions of constants are left to constant folding. */
+   if (!check.invariant || !check.reads_variable)
+      return;
+
+   void *mem_ctx = ralloc_parent(this->loop);
+   ir_variable *var = new(mem_ctx) ir_variable(expr->type, "licm",
+                                               ir_var_temporary);
+   this->loop->insert_before(var);
+   this->loop->insert_before(new(mem_ctx) ir_assignment(
+                                new(mem_ctx) ir_dereference_variable(var),
+                                expr, NULL));
+
+   *rvalue = new(mem_ctx) ir_dereference_variable(var);
+   this->progress = true;
+}
+
+ir_visitor_status
+ir_loop_invariants_visitor::visit_leave(ir_loop *ir)
+{
+   hash_table *written = hash_table_ctor(0, hash_table_pointer_hash,
+                                         hash_table_pointer_compare);
+
+   loop_written_visitor w(written);
+   w.run(&ir->body_instructions);
+
+   if (!w.has_call) {
+      if (ir->counter != NULL)
+         hash_table_insert(written, ir->counter, ir->counter);
+
+      loop_hoist_visitor v(ir, written);
+      v.run(&ir->body_instructions);
+
+      if (v.progress)
+         this->progress = true;
+   }
+
+   hash_table_dtor(written);
+
+   return visit_continue;
+}
+
+/**
+ * Moves loop invariant expressions in front of the loops containing them.
+ *
+ * Inner loops are processed first, so an expression that does not depend on
+ * any of the enclosing loops ends up in front of the outermost one.
+ */
+bool
+do_loop_invariants(exec_list *instructions)
+{
+   ir_loop_invariants_visitor v;
+
+   v.run(instructions);
+
+   return v.progress;
+}
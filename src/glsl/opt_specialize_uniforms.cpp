@@ -0,0 +1,115 @@
+/*
+ * Copyright © 2013 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file opt_specialize_uniforms.cpp
+ *
+ * Replaces reads of selected uniforms with constants holding their current
+ * values.
+ *
+ * This is meant for drivers that build shader variants for a particular
+ * set of uniform values, typically "mode" flags that select between
+ * branches of an ubershader.  Once the uniforms are constants, constant
+ * propagation, if simplification and loop unrolling can reduce the shader
+ * to straight-line code.  The caller is responsible for running those
+ * passes and for only using the result while the uniforms hold the values
+ * it was specialized for.
+ */
+
+#include "ir.h"
+#include "ir_rvalue_visitor.h"
+#include "ir_optimization.h"
+#include "glsl_types.h"
+
+namespace {
+
+class ir_specialize_uniforms_visitor : public ir_rvalue_visitor {
+public:
+   ir_specialize_uniforms_visitor(unsigned count, const char *const *names,
+                                  const ir_constant_data *values)
+      : count(count), names(names), values(values)
+   {
+      this->progress = false;
+   }
+
+   void handle_rvalue(ir_rvalue **rvalue);
+
+   unsigned count;
+   const char *const *names;
+   const ir_constant_data *values;
+
+   bool progress;
+};
+
+} /* unnamed namespace */
+
+void
+ir_specialize_uniforms_visitor::handle_rvalue(ir_rvalue **rvalue)
+{
+   if (*rvalue == NULL)
+      return;
+
+   ir_dereference_variable *deref = (*rvalue)->as_dereference_variable();
+   if (deref == NULL || deref->var->mode != ir_var_uniform)
+      return;
+
+   ir_variable *var = deref->var;
+
+   /* Only plain scalars and vectors can be replaced by a single constant. */
+   if (!var->type->is_scalar() && !var->type->is_vector())
+      return;
+
+   for (unsigned i = 0; i < this->count; i++) {
+      if (strcmp(var->name, this->names[i]) == 0) {
+         ir_constant_data data = this->values[i];
+
+         if (var->type->is_boolean()) {
+            for (unsigned c = 0; c < var->type->components(); c++)
+               data.b[c] = this->values[i].u[c] != 0;
+         }
+
+         *rvalue = new(ralloc_parent(deref)) ir_constant(var->type, &data);
+         this->progress = true;
+         return;
+      }
+   }
+}
+
+/**
+ * Replaces reads of the uniforms named in \c names with the corresponding
+ * \c values.
+ *
+ * Boolean values are taken from the \c u field, any non-zero value meaning
+ * true, since that is how uniform storage holds them.
+ */
+bool
+do_specialize_uniforms(exec_list *instructions, unsigned count,
+                       const char *const *names,
+                       const ir_constant_data *values)
+{
+   ir_specialize_uniforms_visitor v(count, names, values);
+
+   visit_list_elements(&v, instructions);
+
+   return v.progress;
+}
@@ -64,7 +64,8 @@ do_optimization(struct exec_list *ir, const char *optimization)
 
    if (sscanf(optimization, "do_common_optimization ( %d , %d ) ",
               &int_0, &int_1) == 2) {
-      return do_common_optimization(ir, int_0 != 0, false, int_1);
+      return do_common_optimization(ir, int_0 != 0, false, int_1,
+                                    false);
    } else if (strcmp(optimization, "do_algebraic") == 0) {
       return do_algebraic(ir);
    } else if (strcmp(optimization, "do_constant_folding") == 0) {
@@ -79,6 +80,8 @@ do_optimization(struct exec_list *ir, const char *optimization)
       return do_copy_propagation_elements(ir);
    } else if (strcmp(optimization, "do_constant_propagation") == 0) {
       return do_constant_propagation(ir);
+   } else if (strcmp(optimization, "do_cse") == 0) {
+      return do_cse(ir);
    } else if (strcmp(optimization, "do_dead_code") == 0) {
       return do_dead_code(ir, false);
    } else if (strcmp(optimization, "do_dead_code_local") == 0) {
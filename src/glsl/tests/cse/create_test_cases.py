@@ -0,0 +1,166 @@
+# coding=utf-8
+#
+# Copyright © 2013 Intel Corporation
+#
+# Permission is hereby granted, free of charge, to any person obtaining a
+# copy of this software and associated documentation files (the "Software"),
+# to deal in the Software without restriction, including without limitation
+# the rights to use, copy, modify, merge, publish, distribute, sublicense,
+# and/or sell copies of the Software, and to permit persons to whom the
+# Software is furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice (including the next
+# paragraph) shall be included in all copies or substantial portions of the
+# Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+# THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+# FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+# DEALINGS IN THE SOFTWARE.
+
+import os
+import os.path
+import sys
+
+sys.path.insert(0, os.path.join(os.path.dirname(__file__), '..')) # For access to sexps.py, which is in parent dir
+from sexps import *
+
+def make_test_case(body, functions = ()):
+    """Create a test case consisting of a main function with the given
+    body, after the given other functions.
+
+    The variables a, b and c are float inputs, x and y are float
+    outputs.
+    """
+    check_sexp(body)
+    declarations = [['declare', ['in'], 'float', name]
+                    for name in ('a', 'b', 'c')] + \
+                   [['declare', ['out'], 'float', name]
+                    for name in ('x', 'y')]
+    return declarations + list(functions) + \
+        [['function', 'main', ['signature', 'void', ['parameters'], body]]]
+
+def var(name):
+    return ['var_ref', name]
+
+def add(a, b):
+    """Create the expression a + b."""
+    return ['expression', 'float', '+', a, b]
+
+def mul(a, b):
+    """Create the expression a * b."""
+    return ['expression', 'float', '*', a, b]
+
+def assign_x(var_name, value):
+    """Create a statement that assigns <value> to the variable
+    <var_name>.  The assignment uses the mask (x).
+    """
+    check_sexp(value)
+    return [['assign', ['x'], var(var_name), value]]
+
+def declare_temp(var_type, var_name):
+    """Create a declaration of the form
+
+    (declare (temporary) <var_type> <var_name)
+    """
+    return [['declare', ['temporary'], var_type, var_name]]
+
+def call(name):
+    """Create a call to a void function without parameters."""
+    return [['call', name, []]]
+
+def function(name, body):
+    """Create a void function without parameters."""
+    check_sexp(body)
+    return ['function', name, ['signature', 'void', ['parameters'], body]]
+
+def create_test_case(doc_string, input_sexp, expected_sexp, test_name):
+    """Create a test case that verifies that do_cse transforms the given
+    code in the expected way.
+    """
+    doc_lines = [line.strip() for line in doc_string.splitlines()]
+    doc_string = ''.join('# {0}\n'.format(line) for line in doc_lines if line != '')
+    check_sexp(input_sexp)
+    check_sexp(expected_sexp)
+    input_str = sexp_to_string(sort_decls(input_sexp))
+    expected_output = sexp_to_string(sort_decls(expected_sexp))
+
+    args = ['../../glsl_test', 'optpass', '--quiet', '--input-ir', 'do_cse']
+    test_file = '{0}.opt_test'.format(test_name)
+    with open(test_file, 'w') as f:
+        f.write('#!/bin/bash\n#\n# This file was generated by create_test_cases.py.\n#\n')
+        f.write(doc_string)
+        f.write('{0} <<EOF\n'.format(' '.join(args)))
+        f.write('{0}\nEOF\n'.format(input_str))
+    os.chmod(test_file, 0774)
+    expected_file = '{0}.opt_test.expected'.format(test_name)
+    with open(expected_file, 'w') as f:
+        f.write('{0}\n'.format(expected_output))
+
+def test_cse_hit():
+    doc_string = """Test that an expression computed twice is computed once
+    into a temporary, which both uses read.
+    """
+    input_sexp = make_test_case(
+        assign_x('x', add(var('a'), var('b'))) +
+        assign_x('y', mul(add(var('a'), var('b')), var('c')))
+        )
+    expected_sexp = make_test_case(
+        declare_temp('float', 'cse') +
+        assign_x('cse', add(var('a'), var('b'))) +
+        assign_x('x', var('cse')) +
+        assign_x('y', mul(var('cse'), var('c')))
+        )
+    create_test_case(doc_string, input_sexp, expected_sexp, 'cse_hit')
+
+def test_cse_nested_hit():
+    doc_string = """Test that reusing an expression whose operand was already
+    reused finds it after the operand is replaced by its temporary.
+    """
+    input_sexp = make_test_case(
+        assign_x('x', mul(add(var('a'), var('b')), var('c'))) +
+        assign_x('y', add(var('a'), var('b'))) +
+        assign_x('x', mul(add(var('a'), var('b')), var('c')))
+        )
+    expected_sexp = make_test_case(
+        declare_temp('float', 'cse') +
+        assign_x('cse', add(var('a'), var('b'))) +
+        declare_temp('float', 'cse@2') +
+        assign_x('cse@2', mul(var('cse'), var('c'))) +
+        assign_x('x', var('cse@2')) +
+        assign_x('y', var('cse')) +
+        assign_x('x', var('cse@2'))
+        )
+    create_test_case(doc_string, input_sexp, expected_sexp, 'cse_nested_hit')
+
+def test_cse_kill_assignment():
+    doc_string = """Test that an expression isn't reused after one of the
+    variables it reads has been assigned.
+    """
+    input_sexp = make_test_case(
+        assign_x('x', add(var('a'), var('b'))) +
+        assign_x('a', var('c')) +
+        assign_x('y', add(var('a'), var('b')))
+        )
+    create_test_case(doc_string, input_sexp, input_sexp, 'cse_kill_assignment')
+
+def test_cse_kill_call():
+    doc_string = """Test that an expression isn't reused across a function
+    call, which may have written any of the variables it reads.
+    """
+    input_sexp = make_test_case(
+        assign_x('x', add(var('a'), var('b'))) +
+        call('f') +
+        assign_x('y', add(var('a'), var('b'))),
+        [function('f', [])]
+        )
+    create_test_case(doc_string, input_sexp, input_sexp, 'cse_kill_call')
+
+if __name__ == '__main__':
+    test_cse_hit()
+    test_cse_nested_hit()
+    test_cse_kill_assignment()
+    test_cse_kill_call()
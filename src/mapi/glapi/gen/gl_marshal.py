@@ -0,0 +1,606 @@
+#!/usr/bin/env python
+
+# Copyright (C) 2012 Intel Corporation
+#
+# Permission is hereby granted, free of charge, to any person obtaining a
+# copy of this software and associated documentation files (the "Software"),
+# to deal in the Software without restriction, including without limitation
+# the rights to use, copy, modify, merge, publish, distribute, sublicense,
+# and/or sell copies of the Software, and to permit persons to whom the
+# Software is furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice (including the next
+# paragraph) shall be included in all copies or substantial portions of the
+# Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+# THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+# FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+# IN THE SOFTWARE.
+
+# This script generates the file marshal_generated.c, which contains the
+# functions used by the threaded dispatch of main/glthread.c: one marshal
+# function per GL entry point, which runs on the application thread, and one
+# unmarshal function per asynchronous command, which runs on the driver
+# thread.
+
+import license
+import gl_XML, glX_XML
+from glX_proto_size import glx_enum_function
+import sys, getopt
+
+
+header = """/**
+ * \\file marshal_generated.c
+ * Marshal and unmarshal functions for the threaded dispatch.
+ */
+
+#include <string.h>
+#include "main/glthread.h"
+#include "main/dispatch.h"
+"""
+
+
+# Functions that read the enabled vertex arrays.  They run synchronously
+# while one of the arrays of the bound vertex array object points to client
+# memory, since the application may change that memory as soon as the call
+# returns.
+draw_functions = set([
+    'ArrayElement',
+    'DrawArrays',
+    'DrawArraysIndirect',
+    'DrawArraysInstancedARB',
+    'DrawArraysInstancedBaseInstance',
+    'DrawElements',
+    'DrawElementsBaseVertex',
+    'DrawElementsIndirect',
+    'DrawElementsInstancedARB',
+    'DrawElementsInstancedBaseInstance',
+    'DrawElementsInstancedBaseVertex',
+    'DrawElementsInstancedBaseVertexBaseInstance',
+    'DrawRangeElements',
+    'DrawRangeElementsBaseVertex',
+    'DrawTransformFeedback',
+    'DrawTransformFeedbackInstanced',
+    'DrawTransformFeedbackStream',
+    'DrawTransformFeedbackStreamInstanced',
+    'MultiDrawArrays',
+    'MultiDrawArraysIndirect',
+    'MultiDrawElementsBaseVertex',
+    'MultiDrawElementsEXT',
+    'MultiDrawElementsIndirect',
+])
+
+# Functions whose pointer arguments are kept by the GL as vertex array
+# pointers, or are always offsets into a buffer object.  The pointers are
+# queued as they are.
+value_pointer_functions = set([
+    'ColorPointer',
+    'ColorPointerEXT',
+    'DrawArraysIndirect',
+    'DrawElementsIndirect',
+    'EdgeFlagPointer',
+    'EdgeFlagPointerEXT',
+    'FogCoordPointer',
+    'IndexPointer',
+    'IndexPointerEXT',
+    'InterleavedArrays',
+    'MultiDrawArraysIndirect',
+    'MultiDrawElementsIndirect',
+    'NormalPointer',
+    'NormalPointerEXT',
+    'PointSizePointerOES',
+    'SecondaryColorPointer',
+    'TexCoordPointer',
+    'TexCoordPointerEXT',
+    'VertexAttribIPointer',
+    'VertexAttribPointer',
+    'VertexAttribPointerNV',
+    'VertexPointer',
+    'VertexPointerEXT',
+])
+
+# Pointer arguments that are an offset into a buffer object when the
+# condition holds, and are copied from client memory otherwise.
+buffer_pointers = {
+    'CompressedTexImage1D': ('data', '_mesa_glthread_has_unpack_buffer(ctx)'),
+    'CompressedTexImage2D': ('data', '_mesa_glthread_has_unpack_buffer(ctx)'),
+    'CompressedTexImage3D': ('data', '_mesa_glthread_has_unpack_buffer(ctx)'),
+    'CompressedTexSubImage1D': ('data', '_mesa_glthread_has_unpack_buffer(ctx)'),
+    'CompressedTexSubImage2D': ('data', '_mesa_glthread_has_unpack_buffer(ctx)'),
+    'CompressedTexSubImage3D': ('data', '_mesa_glthread_has_unpack_buffer(ctx)'),
+    'DrawElements': ('indices', '_mesa_glthread_has_element_buffer(ctx)'),
+    'DrawElementsBaseVertex': ('indices', '_mesa_glthread_has_element_buffer(ctx)'),
+    'DrawElementsInstancedARB': ('indices', '_mesa_glthread_has_element_buffer(ctx)'),
+    'DrawElementsInstancedBaseInstance': ('indices', '_mesa_glthread_has_element_buffer(ctx)'),
+    'DrawElementsInstancedBaseVertex': ('indices', '_mesa_glthread_has_element_buffer(ctx)'),
+    'DrawElementsInstancedBaseVertexBaseInstance': ('indices', '_mesa_glthread_has_element_buffer(ctx)'),
+    'DrawRangeElements': ('indices', '_mesa_glthread_has_element_buffer(ctx)'),
+    'DrawRangeElementsBaseVertex': ('indices', '_mesa_glthread_has_element_buffer(ctx)'),
+    'PixelMapfv': ('values', '_mesa_glthread_has_unpack_buffer(ctx)'),
+    'PixelMapuiv': ('values', '_mesa_glthread_has_unpack_buffer(ctx)'),
+    'PixelMapusv': ('values', '_mesa_glthread_has_unpack_buffer(ctx)'),
+}
+
+# Conditions, other than the ones above, under which a call runs
+# synchronously.  The index pointers of MultiDrawElements are only copied
+# when they are offsets, so the data they point to stays where it is.
+sync_conditions = {
+    'MultiDrawElementsBaseVertex': '!_mesa_glthread_has_element_buffer(ctx)',
+    'MultiDrawElementsEXT': '!_mesa_glthread_has_element_buffer(ctx)',
+}
+
+# Pointer arguments whose number of elements is another argument, but
+# which have no count attribute in the XML.
+pointer_counters = {
+    'MultiDrawArrays': {'first': 'primcount', 'count': 'primcount'},
+    'MultiDrawElementsBaseVertex': {'count': 'primcount',
+                                    'indices': 'primcount',
+                                    'basevertex': 'primcount'},
+    'MultiDrawElementsEXT': {'count': 'primcount', 'indices': 'primcount'},
+}
+
+# Pointer arguments whose number of elements is computed by a helper of
+# glthread.h rather than given by the XML, with {0} standing for the prefix
+# of the other arguments.  The helpers return 0 for invalid arguments.
+pointer_count_functions = {
+    'DrawElements': {'indices': '_mesa_glthread_index_data_size({0}type, {0}count)'},
+    'DrawElementsBaseVertex': {'indices': '_mesa_glthread_index_data_size({0}type, {0}count)'},
+    'DrawElementsInstancedARB': {'indices': '_mesa_glthread_index_data_size({0}type, {0}count)'},
+    'DrawElementsInstancedBaseInstance': {'indices': '_mesa_glthread_index_data_size({0}type, {0}count)'},
+    'DrawElementsInstancedBaseVertex': {'indices': '_mesa_glthread_index_data_size({0}type, {0}count)'},
+    'DrawElementsInstancedBaseVertexBaseInstance': {'indices': '_mesa_glthread_index_data_size({0}type, {0}count)'},
+    'DrawRangeElements': {'indices': '_mesa_glthread_index_data_size({0}type, {0}count)'},
+    'DrawRangeElementsBaseVertex': {'indices': '_mesa_glthread_index_data_size({0}type, {0}count)'},
+    'Map1d': {'points': '_mesa_glthread_map1_count({0}target, {0}stride, {0}order)'},
+    'Map1f': {'points': '_mesa_glthread_map1_count({0}target, {0}stride, {0}order)'},
+    'Map2d': {'points': '_mesa_glthread_map2_count({0}target, {0}ustride, {0}uorder, {0}vstride, {0}vorder)'},
+    'Map2f': {'points': '_mesa_glthread_map2_count({0}target, {0}ustride, {0}uorder, {0}vstride, {0}vorder)'},
+}
+
+# Code run on the application thread before a call is queued or executed.
+# It tracks the bindings that decide how later calls are marshalled.
+pre_hooks = {
+    'BindBuffer': '_mesa_glthread_BindBuffer(ctx, target, buffer);',
+    'ClientActiveTexture': '_mesa_glthread_ClientActiveTexture(ctx, texture);',
+    'ColorPointer': '_mesa_glthread_AttribPointer(ctx, VERT_ATTRIB_COLOR0, pointer);',
+    'ColorPointerEXT': '_mesa_glthread_AttribPointer(ctx, VERT_ATTRIB_COLOR0, pointer);',
+    'DeleteVertexArrays': '_mesa_glthread_DeleteVertexArrays(ctx, n, arrays);',
+    'EdgeFlagPointer': '_mesa_glthread_AttribPointer(ctx, VERT_ATTRIB_EDGEFLAG, pointer);',
+    'EdgeFlagPointerEXT': '_mesa_glthread_AttribPointer(ctx, VERT_ATTRIB_EDGEFLAG, pointer);',
+    'FogCoordPointer': '_mesa_glthread_AttribPointer(ctx, VERT_ATTRIB_FOG, pointer);',
+    'IndexPointer': '_mesa_glthread_AttribPointer(ctx, VERT_ATTRIB_COLOR_INDEX, pointer);',
+    'IndexPointerEXT': '_mesa_glthread_AttribPointer(ctx, VERT_ATTRIB_COLOR_INDEX, pointer);',
+    'InterleavedArrays': '_mesa_glthread_InterleavedArrays(ctx, format, pointer);',
+    'NormalPointer': '_mesa_glthread_AttribPointer(ctx, VERT_ATTRIB_NORMAL, pointer);',
+    'NormalPointerEXT': '_mesa_glthread_AttribPointer(ctx, VERT_ATTRIB_NORMAL, pointer);',
+    'PointSizePointerOES': '_mesa_glthread_AttribPointer(ctx, VERT_ATTRIB_POINT_SIZE, pointer);',
+    'SecondaryColorPointer': '_mesa_glthread_AttribPointer(ctx, VERT_ATTRIB_COLOR1, pointer);',
+    'TexCoordPointer': '_mesa_glthread_TexCoordPointer(ctx, pointer);',
+    'TexCoordPointerEXT': '_mesa_glthread_TexCoordPointer(ctx, pointer);',
+    'VertexAttribIPointer': '_mesa_glthread_GenericAttribPointer(ctx, index, pointer);',
+    'VertexAttribPointer': '_mesa_glthread_GenericAttribPointer(ctx, index, pointer);',
+    'VertexPointer': '_mesa_glthread_AttribPointer(ctx, VERT_ATTRIB_POS, pointer);',
+    'VertexPointerEXT': '_mesa_glthread_AttribPointer(ctx, VERT_ATTRIB_POS, pointer);',
+}
+
+# Code run on the application thread after a call has been queued or
+# executed.
+post_hooks = {
+    'BindVertexArray': '_mesa_glthread_BindVertexArray(ctx, array);',
+    'BindVertexArrayAPPLE': '_mesa_glthread_BindVertexArray(ctx, array);',
+    'DeleteBuffers': '_mesa_glthread_restore_client_state(ctx);',
+    'Finish': '_mesa_glthread_finish(ctx);',
+    'Flush': '_mesa_glthread_flush_batch(ctx);',
+    'PopClientAttrib': '_mesa_glthread_restore_client_state(ctx);',
+}
+
+
+def get_size_function(f, api):
+    """Return the glx_enum_function that gives the number of elements read
+    through the variable_param argument of f, or None if the XML doesn't
+    know it for every enum."""
+    ef = glx_enum_function(f.name, api.enums_by_name)
+    if len(ef.enums) == 0 or not ef.is_set() or ef.count.has_key(-1):
+        return None
+    return ef
+
+
+def get_counter(f, p):
+    """Return the argument that gives the number of elements of pointer
+    argument p, or None."""
+    return pointer_counters.get(f.name, {}).get(p.name, p.counter)
+
+
+def get_count_function(f, p):
+    return pointer_count_functions.get(f.name, {}).get(p.name)
+
+
+def pointer_kind(f, p, api):
+    """Determine how pointer argument p of f is marshalled.
+
+    'fixed' data has a constant number of elements and is stored in the
+    command structure, 'variable' data is appended to it, a 'value' pointer
+    is queued as it is and a 'buffer' pointer is queued as it is when it's
+    a buffer object offset and appended like 'variable' data otherwise.
+    None means that the call can't be queued."""
+    if f.name in value_pointer_functions:
+        return 'value'
+    if f.name in buffer_pointers and buffer_pointers[f.name][0] == p.name:
+        return 'buffer'
+    if p.is_output or p.is_image() or not p.type_string().startswith('const'):
+        return None
+    if get_count_function(f, p) or get_counter(f, p):
+        return 'variable'
+    if p.count_parameter_list:
+        if get_size_function(f, api):
+            return 'variable'
+        return None
+    if p.count:
+        return 'fixed'
+    return None
+
+
+def is_async(f, api):
+    """Determine whether a function can be queued for the driver thread.
+
+    Functions qualify if they don't return a value and if each of their
+    pointer arguments is stored by the GL or points to input data whose
+    size is known, so that it can be copied into the command.  That leaves
+    the getters, whose pointers are outputs or not const, and the calls
+    whose data size is unknown, such as image uploads."""
+    if f.return_type != 'void':
+        return False
+    for p in f.parameterIterator():
+        if p.is_pointer() and not pointer_kind(f, p, api):
+            return False
+    return True
+
+
+def element_size(p):
+    """Return the size of an element of pointer argument p."""
+    if p.type_string().count('*') > 1:
+        return 'sizeof(*{0})'.format(p.name)
+    return str(p.size())
+
+
+def size_expression(f, p, prefix):
+    """Return a C expression for the size in bytes of the data behind
+    pointer argument p, reading the other arguments as prefix + name."""
+    factors = []
+    count_function = get_count_function(f, p)
+    if count_function:
+        factors.append(count_function.format(prefix))
+    else:
+        if p.count_parameter_list:
+            args = ', '.join([prefix + n for n in p.count_parameter_list])
+            factors.append('_mesa_marshal_{0}_size({1})'.format(f.name, args))
+        if get_counter(f, p):
+            factors.append('(size_t) {0}{1}'.format(prefix, get_counter(f, p)))
+    if element_size(p) != '1':
+        factors.append(element_size(p))
+    return ' * '.join(factors)
+
+
+class PrintCode(gl_XML.gl_print_base):
+
+    def __init__(self):
+        gl_XML.gl_print_base.__init__(self)
+
+        self.name = 'gl_marshal.py'
+        self.license = license.bsd_license_template % (
+            'Copyright (C) 2013 Intel Corporation',
+            'Intel Corporation')
+
+    def printRealHeader(self):
+        print header
+
+    def printRealFooter(self):
+        pass
+
+    def get_pointer_params(self, f, kinds):
+        return [p for p in f.parameterIterator()
+                if p.is_pointer() and pointer_kind(f, p, self.api) in kinds]
+
+    def print_async_struct(self, f):
+        print 'struct marshal_cmd_{0}'.format(f.name)
+        print '{'
+        print '   struct marshal_cmd_base cmd_base;'
+        for p in f.parameterIterator():
+            if p.is_padding:
+                continue
+            kind = p.is_pointer() and pointer_kind(f, p, self.api)
+            if not kind or kind == 'value' or kind == 'buffer':
+                print '   {0} {1};'.format(p.type_string(), p.name)
+            elif kind == 'fixed':
+                print '   {0} {1}[{2}];'.format(p.get_base_type_string(),
+                                                p.name, p.count)
+        for p in self.get_pointer_params(f, ['buffer']):
+            print '   bool {0}_copied;'.format(p.name)
+        for p in self.get_pointer_params(f, ['variable', 'buffer']):
+            if pointer_kind(f, p, self.api) == 'buffer':
+                print '   /* Followed by the data of {0} unless it is a buffer offset, padded to 8 bytes */'.format(p.name)
+            else:
+                print '   /* Followed by the data of {0}, padded to 8 bytes */'.format(p.name)
+        print '};'
+        print
+
+    def print_unmarshal(self, f):
+        print 'static inline void'
+        print '_mesa_unmarshal_{0}(struct gl_context *ctx, const struct marshal_cmd_{0} *cmd)'.format(f.name)
+        print '{'
+        copied_params = self.get_pointer_params(f, ['variable', 'buffer'])
+        data = '(const char *) cmd + ALIGN(sizeof(*cmd), 8)'
+        for p in copied_params:
+            if pointer_kind(f, p, self.api) == 'buffer':
+                # Its size isn't known here, so it has to come last.
+                assert p == copied_params[-1]
+                print '   {0} {1} = cmd->{1}_copied ? ({0}) ({2}) : cmd->{1};'.format(
+                    p.type_string(), p.name, data)
+            else:
+                print '   {0} {1} = ({0}) ({2});'.format(p.type_string(),
+                                                        p.name, data)
+                data = '(const char *) {0} + ALIGN({1}, 8)'.format(
+                    p.name, size_expression(f, p, 'cmd->'))
+        args = []
+        for p in f.parameterIterator():
+            if p.is_padding:
+                continue
+            if p in copied_params:
+                args.append(p.name)
+            else:
+                args.append('cmd->' + p.name)
+        print '   CALL_{0}(ctx->CurrentDispatch, ({1}));'.format(
+            f.name, ', '.join(args))
+        print '}'
+        print
+
+    def print_size_function(self, f, ef):
+        # Enum values are used rather than names, since not every name in
+        # the XML is defined by the GL headers.
+        print 'static GLint'
+        print '_mesa_marshal_{0}_size(GLenum e)'.format(f.name)
+        print '{'
+        print '   switch (e) {'
+        for count in sorted(ef.count):
+            for value in sorted(ef.count[count]):
+                names = sorted(ef.enums[value], key=lambda e: e.priority())
+                print '   case 0x{0:04x}: /* GL_{1} */'.format(value,
+                                                           names[0].name)
+            print '      return {0};'.format(count)
+        print '   default:'
+        print '      return 0;'
+        print '   }'
+        print '}'
+        print
+
+    def print_sync_call(self, f, indent):
+        print indent + '_mesa_glthread_finish(ctx);'
+        print indent + '_glapi_set_dispatch(ctx->CurrentDispatch);'
+        call = 'CALL_{0}(ctx->CurrentDispatch, ({1}))'.format(
+            f.name, f.get_called_parameter_string())
+        if f.return_type != 'void':
+            print indent + 'result = {0};'.format(call)
+        else:
+            print indent + '{0};'.format(call)
+        print indent + '_glapi_set_dispatch(ctx->MarshalExec);'
+        if f.name in post_hooks:
+            print indent + post_hooks[f.name]
+
+    def print_copy_checks(self, f, params, indent):
+        """Print the checks that send a call with the pointer arguments
+        params to the synchronous path, and add the size of their data to
+        cmd_size."""
+        conds = ['{0} == NULL'.format(p.name) for p in params]
+        for p in params:
+            if get_counter(f, p) and not get_count_function(f, p):
+                cond = '{0} < 0 || {0} > MARSHAL_MAX_CMD_SIZE'.format(
+                    get_counter(f, p))
+                if cond not in conds:
+                    conds.append(cond)
+        if conds:
+            print indent + 'if ({0})'.format(
+                (' ||\n' + indent + '    ').join(conds))
+            print indent + '   goto sync;'
+        copied_params = [p for p in params
+                         if pointer_kind(f, p, self.api) != 'fixed']
+        for p in copied_params:
+            print indent + '{0}_size = {1};'.format(p.name,
+                                                    size_expression(f, p, ''))
+            print indent + 'cmd_size += ALIGN({0}_size, 8);'.format(p.name)
+        if copied_params:
+            conds = ['{0}_size == 0'.format(p.name) for p in copied_params
+                     if p.count_parameter_list or get_count_function(f, p)
+                     or pointer_kind(f, p, self.api) == 'buffer']
+            conds.append('cmd_size > MARSHAL_MAX_CMD_SIZE')
+            print indent + 'if ({0})'.format(' || '.join(conds))
+            print indent + '   goto sync;'
+
+    def print_async_marshal(self, f):
+        print 'static void GLAPIENTRY'
+        print '_mesa_marshal_{0}({1})'.format(f.name, f.get_parameter_string())
+        print '{'
+        print '   GET_CURRENT_CONTEXT(ctx);'
+        fixed_params = self.get_pointer_params(f, ['fixed'])
+        variable_params = self.get_pointer_params(f, ['variable'])
+        value_params = self.get_pointer_params(f, ['value'])
+        buffer_params = self.get_pointer_params(f, ['buffer'])
+        copied_params = variable_params + buffer_params
+        if copied_params:
+            print '   size_t cmd_size = ALIGN(sizeof(struct marshal_cmd_{0}), 8);'.format(f.name)
+            for p in variable_params:
+                print '   size_t {0}_size;'.format(p.name)
+            for p in buffer_params:
+                print '   size_t {0}_size = 0;'.format(p.name)
+            print '   char *variable_data;'
+        print '   struct marshal_cmd_{0} *cmd;'.format(f.name)
+        print
+
+        if f.name in pre_hooks:
+            print '   ' + pre_hooks[f.name]
+            print
+
+        # Calls that source client arrays, or with a NULL pointer, a
+        # negative count, more data than a command can hold or an enum the
+        # XML knows no size for are left to the driver.
+        conds = []
+        if f.name in draw_functions:
+            conds.append('_mesa_glthread_has_user_arrays(ctx)')
+        if f.name in sync_conditions:
+            conds.append(sync_conditions[f.name])
+        if conds:
+            print '   if ({0})'.format(' ||\n       '.join(conds))
+            print '      goto sync;'
+        self.print_copy_checks(f, fixed_params + variable_params, '   ')
+        for p in buffer_params:
+            print '   if (!{0}) {{'.format(buffer_pointers[f.name][1])
+            self.print_copy_checks(f, [p], '      ')
+            print '   }'
+        has_sync = conds or fixed_params or copied_params
+        if has_sync:
+            print
+
+        if copied_params:
+            size = 'cmd_size'
+        else:
+            size = 'sizeof(*cmd)'
+        print '   cmd = _mesa_glthread_allocate_command(ctx, DISPATCH_CMD_{0},'.format(f.name)
+        print '                                         {0});'.format(size)
+        for p in f.parameterIterator():
+            if p.is_padding or (p.is_pointer() and p not in value_params):
+                continue
+            print '   cmd->{0} = {0};'.format(p.name)
+        for p in fixed_params:
+            print '   memcpy(cmd->{0}, {0}, sizeof(cmd->{0}));'.format(p.name)
+        for p in buffer_params:
+            print '   cmd->{0} = {0};'.format(p.name)
+            print '   cmd->{0}_copied = {0}_size != 0;'.format(p.name)
+        if copied_params:
+            print '   variable_data = (char *) cmd + ALIGN(sizeof(*cmd), 8);'
+            for p in copied_params:
+                if p in buffer_params:
+                    print '   if ({0}_size != 0)'.format(p.name)
+                    print '      memcpy(variable_data, {0}, {0}_size);'.format(p.name)
+                else:
+                    print '   memcpy(variable_data, {0}, {0}_size);'.format(p.name)
+                if p != copied_params[-1]:
+                    print '   variable_data += ALIGN({0}_size, 8);'.format(p.name)
+        if f.name in post_hooks:
+            print '   ' + post_hooks[f.name]
+        if has_sync:
+            print '   return;'
+            print
+            print 'sync:'
+            self.print_sync_call(f, '   ')
+        print '}'
+        print
+
+    def print_sync_marshal(self, f):
+        print 'static {0} GLAPIENTRY'.format(f.return_type)
+        print '_mesa_marshal_{0}({1})'.format(f.name, f.get_parameter_string())
+        print '{'
+        print '   GET_CURRENT_CONTEXT(ctx);'
+        if f.return_type != 'void':
+            print '   {0} result;'.format(f.return_type)
+        if f.name in pre_hooks:
+            print '   ' + pre_hooks[f.name]
+        self.print_sync_call(f, '   ')
+        if f.return_type != 'void':
+            print '   return result;'
+        print '}'
+        print
+
+    def printBody(self, api):
+        self.api = api
+        functions = sorted(api.functionIterateByOffset(), key=lambda f: f.name)
+        names = set([f.name for f in functions])
+        for table in [draw_functions, value_pointer_functions,
+                      buffer_pointers, sync_conditions, pointer_counters,
+                      pointer_count_functions, pre_hooks, post_hooks]:
+            for name in table:
+                if name not in names:
+                    raise Exception('Unknown function {0!r}'.format(name))
+
+        async_functions = [f for f in functions if is_async(f, api)]
+
+        print 'enum marshal_dispatch_cmd_id'
+        print '{'
+        for f in async_functions:
+            print '   DISPATCH_CMD_{0},'.format(f.name)
+        print '   NUM_DISPATCH_CMD'
+        print '};'
+        print
+
+        for f in async_functions:
+            for p in f.parameterIterator():
+                if (p.is_pointer() and p.count_parameter_list and
+                    not get_count_function(f, p)):
+                    self.print_size_function(f, get_size_function(f, api))
+                    break
+
+        for f in functions:
+            if f in async_functions:
+                self.print_async_struct(f)
+                self.print_unmarshal(f)
+                self.print_async_marshal(f)
+            else:
+                self.print_sync_marshal(f)
+
+        print 'size_t'
+        print '_mesa_unmarshal_dispatch_cmd(struct gl_context *ctx, const void *cmd)'
+        print '{'
+        print '   const struct marshal_cmd_base *cmd_base = cmd;'
+        print
+        print '   switch (cmd_base->cmd_id) {'
+        for f in async_functions:
+            print '   case DISPATCH_CMD_{0}:'.format(f.name)
+            print '      _mesa_unmarshal_{0}(ctx, cmd);'.format(f.name)
+            print '      break;'
+        print '   default:'
+        print '      assert(!"Invalid command id");'
+        print '      break;'
+        print '   }'
+        print
+        print '   return cmd_base->cmd_size;'
+        print '}'
+        print
+        print
+        print 'struct _glapi_table *'
+        print '_mesa_create_marshal_table(void)'
+        print '{'
+        print '   struct _glapi_table *table = _mesa_alloc_dispatch_table();'
+        print
+        print '   if (table == NULL)'
+        print '      return NULL;'
+        print
+        for f in functions:
+            print '   SET_{0}(table, _mesa_marshal_{0});'.format(f.name)
+        print
+        print '   return table;'
+        print '}'
+
+
+def show_usage():
+    print "Usage: %s [-f input_file_name]" % sys.argv[0]
+    sys.exit(1)
+
+
+if __name__ == '__main__':
+    file_name = "gl_and_es_API.xml"
+
+    try:
+        (args, trail) = getopt.getopt(sys.argv[1:], "m:f:")
+    except Exception,e:
+        show_usage()
+
+    for (arg,val) in args:
+        if arg == "-f":
+            file_name = val
+
+    printer = PrintCode()
+
+    api = gl_XML.parse_GL_API(file_name, glX_XML.glx_item_factory())
+    printer.Print(api)
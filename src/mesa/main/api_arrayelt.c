@@ -1443,7 +1443,7 @@ void _ae_destroy_context( struct gl_context *ctx )
 static void check_vbo( AEcontext *actx,
 		       struct gl_buffer_object *vbo )
 {
-   if (_mesa_is_bufferobj(vbo) && !_mesa_bufferobj_mapped(vbo)) {
+   if (_mesa_is_bufferobj(vbo) && !_mesa_check_disallowed_mapping(vbo)) {
       GLuint i;
       for (i = 0; i < actx->nr_vbos; i++)
 	 if (actx->vbo[i] == vbo)
@@ -24,6 +24,7 @@
  */
 
 #include <stdbool.h>
+#include <stdint.h>
 #include "glheader.h"
 #include "api_validate.h"
 #include "bufferobj.h"
@@ -737,3 +738,205 @@ _mesa_validate_DrawTransformFeedback(struct gl_context *ctx,
 
    return GL_TRUE;
 }
+
+
+/**
+ * Common error checking for the glDraw*Indirect() family.  \p size is the
+ * number of bytes of draw commands that will be read starting at
+ * \p indirect.
+ */
+static GLboolean
+valid_draw_indirect(struct gl_context *ctx,
+                    GLenum mode, const GLvoid *indirect,
+                    GLsizeiptr size, const char *name)
+{
+   const GLsizeiptr end = (GLsizeiptr) indirect + size;
+
+   if (!_mesa_valid_prim_mode(ctx, mode, name))
+      return GL_FALSE;
+
+   /* From the ARB_draw_indirect specification:
+    *
+    *   "An INVALID_OPERATION error is generated [...] if <indirect> is not
+    *    word aligned."
+    */
+   if ((GLsizeiptr) indirect & (sizeof(GLuint) - 1)) {
+      _mesa_error(ctx, GL_INVALID_OPERATION,
+                  "%s(indirect is not aligned)", name);
+      return GL_FALSE;
+   }
+
+   if (!_mesa_is_bufferobj(ctx->DrawIndirectBuffer)) {
+      _mesa_error(ctx, GL_INVALID_OPERATION,
+                  "%s: no buffer bound to GL_DRAW_INDIRECT_BUFFER", name);
+      return GL_FALSE;
+   }
+
+   if (_mesa_check_disallowed_mapping(ctx->DrawIndirectBuffer)) {
+      _mesa_error(ctx, GL_INVALID_OPERATION,
+                  "%s(DRAW_INDIRECT_BUFFER is mapped)", name);
+      return GL_FALSE;
+   }
+
+   if (ctx->DrawIndirectBuffer->Size < end) {
+      _mesa_error(ctx, GL_INVALID_OPERATION,
+                  "%s(DRAW_INDIRECT_BUFFER too small)", name);
+      return GL_FALSE;
+   }
+
+   if (!check_valid_to_render(ctx, name))
+      return GL_FALSE;
+
+   return GL_TRUE;
+}
+
+static inline GLboolean
+valid_draw_indirect_elements(struct gl_context *ctx,
+                             GLenum mode, GLenum type, const GLvoid *indirect,
+                             GLsizeiptr size, const char *name)
+{
+   if (!valid_elements_type(ctx, type, name))
+      return GL_FALSE;
+
+   /* Unlike regular DrawElements, the indices must come from a buffer
+    * object, there being no way to pass a client pointer.
+    */
+   if (!_mesa_is_bufferobj(ctx->Array.ArrayObj->ElementArrayBufferObj)) {
+      _mesa_error(ctx, GL_INVALID_OPERATION,
+                  "%s: no buffer bound to GL_ELEMENT_ARRAY_BUFFER", name);
+      return GL_FALSE;
+   }
+
+   return valid_draw_indirect(ctx, mode, indirect, size, name);
+}
+
+static inline GLboolean
+valid_draw_indirect_multi(struct gl_context *ctx,
+                          GLsizei primcount, GLsizei stride,
+                          const char *name)
+{
+   if (primcount < 0) {
+      _mesa_error(ctx, GL_INVALID_VALUE, "%s(primcount < 0)", name);
+      return GL_FALSE;
+   }
+
+   if (stride < 0) {
+      _mesa_error(ctx, GL_INVALID_VALUE, "%s(stride < 0)", name);
+      return GL_FALSE;
+   }
+
+   if (stride % 4) {
+      _mesa_error(ctx, GL_INVALID_VALUE, "%s(stride %% 4)", name);
+      return GL_FALSE;
+   }
+
+   return GL_TRUE;
+}
+
+/**
+ * Compute the number of bytes of the indirect buffer read by \p primcount
+ * (at least one) draw commands of \p cmd_size bytes, \p stride bytes apart.
+ * Returns GL_FALSE with an error if that doesn't fit in a GLsizeiptr.
+ */
+static inline GLboolean
+draw_indirect_multi_size(struct gl_context *ctx,
+                         GLsizei primcount, GLsizei stride,
+                         GLsizeiptr cmd_size, GLsizeiptr *size,
+                         const char *name)
+{
+   if (primcount > 1 && stride > 0 &&
+       (GLsizeiptr) (primcount - 1) > (PTRDIFF_MAX - cmd_size) / stride) {
+      _mesa_error(ctx, GL_INVALID_OPERATION,
+                  "%s(DRAW_INDIRECT_BUFFER too small)", name);
+      return GL_FALSE;
+   }
+
+   *size = (GLsizeiptr) (primcount - 1) * stride + cmd_size;
+   return GL_TRUE;
+}
+
+GLboolean
+_mesa_validate_DrawArraysIndirect(struct gl_context *ctx,
+                                  GLenum mode,
+                                  const GLvoid *indirect)
+{
+   const unsigned drawArraysNumParams = 4;
+
+   FLUSH_CURRENT(ctx, 0);
+
+   return valid_draw_indirect(ctx, mode,
+                              indirect, drawArraysNumParams * sizeof(GLuint),
+                              "glDrawArraysIndirect");
+}
+
+GLboolean
+_mesa_validate_DrawElementsIndirect(struct gl_context *ctx,
+                                    GLenum mode, GLenum type,
+                                    const GLvoid *indirect)
+{
+   const unsigned drawElementsNumParams = 5;
+
+   FLUSH_CURRENT(ctx, 0);
+
+   return valid_draw_indirect_elements(ctx, mode, type,
+                                       indirect,
+                                       drawElementsNumParams * sizeof(GLuint),
+                                       "glDrawElementsIndirect");
+}
+
+GLboolean
+_mesa_validate_MultiDrawArraysIndirect(struct gl_context *ctx,
+                                       GLenum mode,
+                                       const GLvoid *indirect,
+                                       GLsizei primcount, GLsizei stride)
+{
+   GLsizeiptr size = 0;
+   const unsigned drawArraysNumParams = 4;
+
+   FLUSH_CURRENT(ctx, 0);
+
+   if (!valid_draw_indirect_multi(ctx, primcount, stride,
+                                  "glMultiDrawArraysIndirect"))
+      return GL_FALSE;
+
+   /* Nothing to draw, but not an error either. */
+   if (primcount == 0)
+      return GL_FALSE;
+
+   /* number of bytes of the indirect buffer which will be read */
+   if (!draw_indirect_multi_size(ctx, primcount, stride,
+                                 drawArraysNumParams * sizeof(GLuint), &size,
+                                 "glMultiDrawArraysIndirect"))
+      return GL_FALSE;
+
+   return valid_draw_indirect(ctx, mode, indirect, size,
+                              "glMultiDrawArraysIndirect");
+}
+
+GLboolean
+_mesa_validate_MultiDrawElementsIndirect(struct gl_context *ctx,
+                                         GLenum mode, GLenum type,
+                                         const GLvoid *indirect,
+                                         GLsizei primcount, GLsizei stride)
+{
+   GLsizeiptr size = 0;
+   const unsigned drawElementsNumParams = 5;
+
+   FLUSH_CURRENT(ctx, 0);
+
+   if (!valid_draw_indirect_multi(ctx, primcount, stride,
+                                  "glMultiDrawElementsIndirect"))
+      return GL_FALSE;
+
+   if (primcount == 0)
+      return GL_FALSE;
+
+   if (!draw_indirect_multi_size(ctx, primcount, stride,
+                                 drawElementsNumParams * sizeof(GLuint), &size,
+                                 "glMultiDrawElementsIndirect"))
+      return GL_FALSE;
+
+   return valid_draw_indirect_elements(ctx, mode, type,
+                                       indirect, size,
+                                       "glMultiDrawElementsIndirect");
+}
@@ -87,6 +87,12 @@ get_buffer_target(struct gl_context *ctx, GLenum target)
       return &ctx->CopyReadBuffer;
    case GL_COPY_WRITE_BUFFER:
       return &ctx->CopyWriteBuffer;
+   case GL_DRAW_INDIRECT_BUFFER:
+      if (ctx->API == API_OPENGL_CORE &&
+          ctx->Extensions.ARB_draw_indirect) {
+         return &ctx->DrawIndirectBuffer;
+      }
+      break;
    case GL_TRANSFORM_FEEDBACK_BUFFER:
       if (ctx->Extensions.EXT_transform_feedback) {
          return &ctx->TransformFeedback.CurrentBuffer;
@@ -220,7 +226,7 @@ buffer_object_subdata_range_good( struct gl_context * ctx, GLenum target,
                   (unsigned long) bufObj->Size);
       return NULL;
    }
-   if (_mesa_bufferobj_mapped(bufObj)) {
+   if (_mesa_check_disallowed_mapping(bufObj)) {
       /* Buffer is currently mapped */
       _mesa_error(ctx, GL_INVALID_OPERATION, "%s", caller);
       return NULL;
@@ -352,6 +358,8 @@ _mesa_initialize_buffer_object( struct gl_context *ctx,
    obj->Name = name;
    obj->Usage = GL_STATIC_DRAW_ARB;
    obj->AccessFlags = 0;
+   obj->StorageFlags = (GL_MAP_READ_BIT | GL_MAP_WRITE_BIT |
+                        GL_DYNAMIC_STORAGE_BIT);
 }
 
 
@@ -619,6 +627,9 @@ _mesa_init_buffer_objects( struct gl_context *ctx )
    _mesa_reference_buffer_object(ctx, &ctx->CopyWriteBuffer,
                                  ctx->Shared->NullBufferObj);
 
+   _mesa_reference_buffer_object(ctx, &ctx->DrawIndirectBuffer,
+                                 ctx->Shared->NullBufferObj);
+
    ctx->UniformBufferBindings = calloc(ctx->Const.MaxUniformBufferBindings,
 				      sizeof(*ctx->UniformBufferBindings));
 
@@ -645,6 +656,8 @@ _mesa_free_buffer_objects( struct gl_context *ctx )
    _mesa_reference_buffer_object(ctx, &ctx->CopyReadBuffer, NULL);
    _mesa_reference_buffer_object(ctx, &ctx->CopyWriteBuffer, NULL);
 
+   _mesa_reference_buffer_object(ctx, &ctx->DrawIndirectBuffer, NULL);
+
    _mesa_reference_buffer_object(ctx, &ctx->UniformBuffer, NULL);
 
    for (i = 0; i < ctx->Const.MaxUniformBufferBindings; i++) {
@@ -883,6 +896,11 @@ _mesa_DeleteBuffers(GLsizei n, const GLuint *ids)
             _mesa_BindBuffer( GL_COPY_WRITE_BUFFER, 0 );
          }
 
+         /* unbind ARB_draw_indirect binding point */
+         if (ctx->DrawIndirectBuffer == bufObj) {
+            _mesa_BindBuffer( GL_DRAW_INDIRECT_BUFFER, 0 );
+         }
+
          /* unbind transform feedback binding points */
          if (ctx->TransformFeedback.CurrentBuffer == bufObj) {
             _mesa_BindBuffer( GL_TRANSFORM_FEEDBACK_BUFFER, 0 );
@@ -1054,6 +1072,11 @@ _mesa_BufferData(GLenum target, GLsizeiptrARB size,
    if (!bufObj)
       return;
 
+   if (bufObj->Immutable) {
+      _mesa_error(ctx, GL_INVALID_OPERATION, "glBufferData(immutable)");
+      return;
+   }
+
    if (_mesa_bufferobj_mapped(bufObj)) {
       /* Unmap the existing buffer.  We'll replace it now.  Not an error. */
       ctx->Driver.UnmapBuffer(ctx, bufObj);
@@ -1081,6 +1104,89 @@ _mesa_BufferData(GLenum target, GLsizeiptrARB size,
 }
 
 
+/**
+ * Allocate immutable storage for a buffer object (GL_ARB_buffer_storage).
+ *
+ * The storage is allocated through the driver's BufferData hook; drivers
+ * that care about the access the application asked for can look at
+ * bufObj->StorageFlags, which is set before the hook is called.
+ */
+void GLAPIENTRY
+_mesa_BufferStorage(GLenum target, GLsizeiptr size, const GLvoid *data,
+                    GLbitfield flags)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   struct gl_buffer_object *bufObj;
+
+   if (MESA_VERBOSE & VERBOSE_API)
+      _mesa_debug(ctx, "glBufferStorage(%s, %ld, %p, 0x%x)\n",
+                  _mesa_lookup_enum_by_nr(target),
+                  (long int) size, data, flags);
+
+   if (!ctx->Extensions.ARB_buffer_storage) {
+      _mesa_error(ctx, GL_INVALID_OPERATION,
+                  "glBufferStorage(extension not supported)");
+      return;
+   }
+
+   if (size <= 0) {
+      _mesa_error(ctx, GL_INVALID_VALUE, "glBufferStorage(size <= 0)");
+      return;
+   }
+
+   if (flags & ~(GL_MAP_READ_BIT |
+                 GL_MAP_WRITE_BIT |
+                 GL_MAP_PERSISTENT_BIT |
+                 GL_MAP_COHERENT_BIT |
+                 GL_DYNAMIC_STORAGE_BIT |
+                 GL_CLIENT_STORAGE_BIT)) {
+      _mesa_error(ctx, GL_INVALID_VALUE, "glBufferStorage(flags)");
+      return;
+   }
+
+   if ((flags & GL_MAP_PERSISTENT_BIT) &&
+       !(flags & (GL_MAP_READ_BIT | GL_MAP_WRITE_BIT))) {
+      _mesa_error(ctx, GL_INVALID_VALUE,
+                  "glBufferStorage(persistent, but neither read nor write)");
+      return;
+   }
+
+   if ((flags & GL_MAP_COHERENT_BIT) && !(flags & GL_MAP_PERSISTENT_BIT)) {
+      _mesa_error(ctx, GL_INVALID_VALUE,
+                  "glBufferStorage(coherent, but not persistent)");
+      return;
+   }
+
+   bufObj = get_buffer(ctx, "glBufferStorage", target);
+   if (!bufObj)
+      return;
+
+   if (bufObj->Immutable) {
+      _mesa_error(ctx, GL_INVALID_OPERATION, "glBufferStorage(immutable)");
+      return;
+   }
+
+   if (_mesa_bufferobj_mapped(bufObj)) {
+      /* Unmap the existing buffer.  We'll replace it now.  Not an error. */
+      ctx->Driver.UnmapBuffer(ctx, bufObj);
+      bufObj->AccessFlags = 0;
+      ASSERT(bufObj->Pointer == NULL);
+   }
+
+   FLUSH_VERTICES(ctx, _NEW_BUFFER_OBJECT);
+
+   bufObj->Written = GL_TRUE;
+   bufObj->Immutable = GL_TRUE;
+   bufObj->StorageFlags = flags;
+
+   ASSERT(ctx->Driver.BufferData);
+   if (!ctx->Driver.BufferData(ctx, target, size, data, GL_DYNAMIC_DRAW,
+                               bufObj)) {
+      _mesa_error(ctx, GL_OUT_OF_MEMORY, "glBufferStorage()");
+   }
+}
+
+
 void GLAPIENTRY
 _mesa_BufferSubData(GLenum target, GLintptrARB offset,
                        GLsizeiptrARB size, const GLvoid * data)
@@ -1095,6 +1201,12 @@ _mesa_BufferSubData(GLenum target, GLintptrARB offset,
       return;
    }
 
+   if (bufObj->Immutable &&
+       !(bufObj->StorageFlags & GL_DYNAMIC_STORAGE_BIT)) {
+      _mesa_error(ctx, GL_INVALID_OPERATION, "glBufferSubData");
+      return;
+   }
+
    if (size == 0)
       return;
 
@@ -1167,6 +1279,13 @@ _mesa_MapBuffer(GLenum target, GLenum access)
       return NULL;
    }
 
+   if (bufObj->Immutable &&
+       (accessFlags & ~bufObj->StorageFlags)) {
+      _mesa_error(ctx, GL_INVALID_OPERATION,
+                  "glMapBuffer(access not allowed by the buffer storage)");
+      return NULL;
+   }
+
    if (!bufObj->Size) {
       _mesa_error(ctx, GL_OUT_OF_MEMORY,
                   "glMapBuffer(buffer size = 0)");
@@ -1320,6 +1439,16 @@ _mesa_GetBufferParameteriv(GLenum target, GLenum pname, GLint *params)
          goto invalid_pname;
       *params = (GLint) bufObj->Length;
       return;
+   case GL_BUFFER_IMMUTABLE_STORAGE:
+      if (!ctx->Extensions.ARB_buffer_storage)
+         goto invalid_pname;
+      *params = bufObj->Immutable;
+      return;
+   case GL_BUFFER_STORAGE_FLAGS:
+      if (!ctx->Extensions.ARB_buffer_storage)
+         goto invalid_pname;
+      *params = bufObj->StorageFlags;
+      return;
    default:
       ; /* fall-through */
    }
@@ -1373,6 +1502,16 @@ _mesa_GetBufferParameteri64v(GLenum target, GLenum pname, GLint64 *params)
          goto invalid_pname;
       *params = bufObj->Length;
       return;
+   case GL_BUFFER_IMMUTABLE_STORAGE:
+      if (!ctx->Extensions.ARB_buffer_storage)
+         goto invalid_pname;
+      *params = bufObj->Immutable;
+      return;
+   case GL_BUFFER_STORAGE_FLAGS:
+      if (!ctx->Extensions.ARB_buffer_storage)
+         goto invalid_pname;
+      *params = bufObj->StorageFlags;
+      return;
    default:
       ; /* fall-through */
    }
@@ -1418,13 +1557,13 @@ _mesa_CopyBufferSubData(GLenum readTarget, GLenum writeTarget,
    if (!dst)
       return;
 
-   if (_mesa_bufferobj_mapped(src)) {
+   if (_mesa_check_disallowed_mapping(src)) {
       _mesa_error(ctx, GL_INVALID_OPERATION,
                   "glCopyBufferSubData(readBuffer is mapped)");
       return;
    }
 
-   if (_mesa_bufferobj_mapped(dst)) {
+   if (_mesa_check_disallowed_mapping(dst)) {
       _mesa_error(ctx, GL_INVALID_OPERATION,
                   "glCopyBufferSubData(writeBuffer is mapped)");
       return;
@@ -1530,12 +1669,20 @@ _mesa_MapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length,
                   GL_MAP_INVALIDATE_RANGE_BIT |
                   GL_MAP_INVALIDATE_BUFFER_BIT |
                   GL_MAP_FLUSH_EXPLICIT_BIT |
-                  GL_MAP_UNSYNCHRONIZED_BIT)) {
+                  GL_MAP_UNSYNCHRONIZED_BIT |
+                  GL_MAP_PERSISTENT_BIT |
+                  GL_MAP_COHERENT_BIT)) {
       /* generate an error if any undefind bit is set */
       _mesa_error(ctx, GL_INVALID_VALUE, "glMapBufferRange(access)");
       return NULL;
    }
 
+   if (!ctx->Extensions.ARB_buffer_storage &&
+       (access & (GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT))) {
+      _mesa_error(ctx, GL_INVALID_VALUE, "glMapBufferRange(access)");
+      return NULL;
+   }
+
    if ((access & (GL_MAP_READ_BIT | GL_MAP_WRITE_BIT)) == 0) {
       _mesa_error(ctx, GL_INVALID_OPERATION,
                   "glMapBufferRange(access indicates neither read or write)");
@@ -1574,6 +1721,25 @@ _mesa_MapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length,
       return NULL;
    }
 
+   /* The GL_ARB_buffer_storage spec says:
+    *
+    *     "If <access> contains any of MAP_READ_BIT, MAP_WRITE_BIT,
+    *     MAP_PERSISTENT_BIT or MAP_COHERENT_BIT and the corresponding bit
+    *     is not set in the BUFFER_STORAGE_FLAGS of the buffer, an
+    *     INVALID_OPERATION error is generated."
+    *
+    * Buffers created by glBufferData allow reading and writing, but
+    * never persistent or coherent mappings.
+    */
+   if (access & ~bufObj->StorageFlags &
+       (GL_MAP_READ_BIT | GL_MAP_WRITE_BIT |
+        GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT)) {
+      _mesa_error(ctx, GL_INVALID_OPERATION,
+                  "glMapBufferRange(access not allowed by the buffer "
+                  "storage)");
+      return NULL;
+   }
+
    if (!bufObj->Size) {
       _mesa_error(ctx, GL_OUT_OF_MEMORY,
                   "glMapBufferRange(buffer size = 0)");
@@ -2261,7 +2427,7 @@ _mesa_InvalidateBufferSubData(GLuint buffer, GLintptr offset,
     *     mapped by MapBuffer, or if the invalidate range intersects the range
     *     currently mapped by MapBufferRange."
     */
-   if (_mesa_bufferobj_mapped(bufObj)) {
+   if (_mesa_check_disallowed_mapping(bufObj)) {
       const GLintptr mapEnd = bufObj->Offset + bufObj->Length;
 
       /* The regions do not overlap if and only if the end of the discard
@@ -2306,7 +2472,7 @@ _mesa_InvalidateBufferData(GLuint buffer)
     *     mapped by MapBuffer, or if the invalidate range intersects the range
     *     currently mapped by MapBufferRange."
     */
-   if (_mesa_bufferobj_mapped(bufObj)) {
+   if (_mesa_check_disallowed_mapping(bufObj)) {
       _mesa_error(ctx, GL_INVALID_OPERATION,
                   "glInvalidateBufferData(intersection with mapped "
                   "range)");
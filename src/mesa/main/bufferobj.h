@@ -45,6 +45,18 @@ _mesa_bufferobj_mapped(const struct gl_buffer_object *obj)
    return obj->Pointer != NULL;
 }
 
+/**
+ * Is the given buffer object mapped in a way that forbids the GL from using
+ * it at the same time?  Persistent mappings (GL_ARB_buffer_storage) may stay
+ * in place while the buffer is used for drawing, pixel transfers, etc.
+ */
+static inline GLboolean
+_mesa_check_disallowed_mapping(const struct gl_buffer_object *obj)
+{
+   return _mesa_bufferobj_mapped(obj) &&
+          !(obj->AccessFlags & GL_MAP_PERSISTENT_BIT);
+}
+
 /**
  * Is the given buffer object a user-created buffer object?
  * Mesa uses default buffer objects in several places.  Default buffers
@@ -111,6 +123,9 @@ _mesa_IsBuffer(GLuint buffer);
 void GLAPIENTRY
 _mesa_BufferData(GLenum target, GLsizeiptrARB size, const GLvoid * data, GLenum usage);
 void GLAPIENTRY
+_mesa_BufferStorage(GLenum target, GLsizeiptr size, const GLvoid *data,
+                    GLbitfield flags);
+void GLAPIENTRY
 _mesa_BufferSubData(GLenum target, GLintptrARB offset, GLsizeiptrARB size, const GLvoid * data);
 void GLAPIENTRY
 _mesa_GetBufferSubData(GLenum target, GLintptrARB offset, GLsizeiptrARB size, void * data);
@@ -99,6 +99,7 @@
 #include "fog.h"
 #include "formats.h"
 #include "framebuffer.h"
+#include "glthread.h"
 #include "hint.h"
 #include "hash.h"
 #include "light.h"
@@ -1136,6 +1137,8 @@ _mesa_create_context(gl_api api,
 void
 _mesa_free_context_data( struct gl_context *ctx )
 {
+   _mesa_glthread_destroy(ctx);
+
    if (!_mesa_get_current_context()){
       /* No current context, but we may need one in order to delete
        * texture objs, etc.  So temporarily bind the context now.
@@ -1471,6 +1474,12 @@ _mesa_make_current( struct gl_context *newCtx,
       }
    }
 
+   /* Let the driver thread of the current context run out of work before
+    * the context changes hands.
+    */
+   if (curCtx)
+      _mesa_glthread_finish(curCtx);
+
    if (curCtx && 
       (curCtx->WinSysDrawBuffer || curCtx->WinSysReadBuffer) &&
        /* make sure this context is valid for flushing */
@@ -1564,6 +1573,9 @@ _mesa_make_current( struct gl_context *newCtx,
 
 	 newCtx->FirstTimeCurrent = GL_FALSE;
       }
+
+      if (newCtx->GLThread)
+         _glapi_set_dispatch(newCtx->MarshalExec);
    }
    
    return GL_TRUE;
@@ -792,6 +792,9 @@ destroy_list(struct gl_context *ctx, GLuint list)
 
    _mesa_delete_list(ctx, dlist);
    _mesa_HashRemove(ctx->Shared->DisplayList, list);
+
+   /* invalidate the pointers resolved by save_CallList() */
+   ctx->Shared->DisplayListGeneration++;
 }
 
 
@@ -1044,6 +1047,74 @@ alloc_instruction(struct gl_context *ctx, OpCode opcode, GLuint nparams)
 
 
 
+/**
+ * Return the bit used for \p cap in gl_dlist_state::Current.Enabled, or
+ * zero if we don't track whether it's enabled.  These are the common
+ * non-indexed caps that aren't per texture unit.
+ */
+static GLbitfield
+tracked_cap_bit(GLenum cap)
+{
+   switch (cap) {
+   case GL_ALPHA_TEST:           return 1 << 0;
+   case GL_BLEND:                return 1 << 1;
+   case GL_COLOR_MATERIAL:       return 1 << 2;
+   case GL_CULL_FACE:            return 1 << 3;
+   case GL_DEPTH_TEST:           return 1 << 4;
+   case GL_FOG:                  return 1 << 5;
+   case GL_LIGHTING:             return 1 << 6;
+   case GL_LINE_SMOOTH:          return 1 << 7;
+   case GL_LINE_STIPPLE:         return 1 << 8;
+   case GL_NORMALIZE:            return 1 << 9;
+   case GL_POLYGON_OFFSET_FILL:  return 1 << 10;
+   case GL_POLYGON_STIPPLE:      return 1 << 11;
+   case GL_RESCALE_NORMAL:       return 1 << 12;
+   case GL_STENCIL_TEST:         return 1 << 13;
+   case GL_LIGHT0:
+   case GL_LIGHT1:
+   case GL_LIGHT2:
+   case GL_LIGHT3:
+   case GL_LIGHT4:
+   case GL_LIGHT5:
+   case GL_LIGHT6:
+   case GL_LIGHT7:
+      return 1 << (16 + cap - GL_LIGHT0);
+   default:
+      return 0;
+   }
+}
+
+
+/**
+ * Check whether setting current attribute \p attr would be a no-op,
+ * because the list being compiled already set it to the same value.
+ * Only valid after SAVE_FLUSH_VERTICES(), which is when vertex lists
+ * write back the attribute values they leave current.
+ */
+static inline GLboolean
+is_redundant_attr(const struct gl_context *ctx, GLuint attr, GLuint size,
+                  GLfloat x, GLfloat y, GLfloat z, GLfloat w)
+{
+   const GLfloat *current = ctx->ListState.CurrentAttrib[attr];
+
+   /* these provoke a vertex rather than just setting state */
+   if (attr == VERT_ATTRIB_POS || attr == VERT_ATTRIB_GENERIC0)
+      return GL_FALSE;
+
+   /* with GL_COLOR_MATERIAL, glColor also updates the material */
+   if (attr == VERT_ATTRIB_COLOR0) {
+      const GLbitfield bit = tracked_cap_bit(GL_COLOR_MATERIAL);
+      if (!(ctx->ListState.Current.EnableKnown & bit) ||
+          (ctx->ListState.Current.Enabled & bit))
+         return GL_FALSE;
+   }
+
+   return ctx->ListState.ActiveAttribSize[attr] == size &&
+          current[0] == x && current[1] == y &&
+          current[2] == z && current[3] == w;
+}
+
+
 /*
  * Display List compilation functions
  */
@@ -1356,7 +1427,11 @@ save_DrawElementsInstancedBaseVertexBaseInstance(GLenum mode,
 	       "glDrawElementsInstancedBaseVertexBaseInstance() during display list compile");
 }
 
-static void invalidate_saved_current_state( struct gl_context *ctx )
+/**
+ * Forget the current attribute and material values recorded while
+ * compiling, after a command that changes them when the list executes.
+ */
+static void invalidate_saved_current_attribs( struct gl_context *ctx )
 {
    GLint i;
 
@@ -1365,6 +1440,11 @@ static void invalidate_saved_current_state( struct gl_context *ctx )
 
    for (i = 0; i < MAT_ATTRIB_MAX; i++)
       ctx->ListState.ActiveMaterialSize[i] = 0;
+}
+
+static void invalidate_saved_current_state( struct gl_context *ctx )
+{
+   invalidate_saved_current_attribs( ctx );
 
    memset(&ctx->ListState.Current, 0, sizeof ctx->ListState.Current);
 
@@ -1378,9 +1458,14 @@ save_CallList(GLuint list)
    Node *n;
    SAVE_FLUSH_VERTICES(ctx);
 
-   n = alloc_instruction(ctx, OPCODE_CALL_LIST, 1);
+   n = alloc_instruction(ctx, OPCODE_CALL_LIST, 3);
    if (n) {
       n[1].ui = list;
+      /* Resolve the list now, so executing this one doesn't need to look
+       * it up, unless it gets deleted or replaced in the meantime.
+       */
+      n[2].data = list ? lookup_list(ctx, list) : NULL;
+      n[3].ui = ctx->Shared->DisplayListGeneration;
    }
 
    /* After this, we don't know what state we're in.  Invalidate all
@@ -2188,7 +2273,21 @@ save_CullFace(GLenum mode)
 {
    GET_CURRENT_CONTEXT(ctx);
    Node *n;
-   ASSERT_OUTSIDE_SAVE_BEGIN_END_AND_FLUSH(ctx);
+   ASSERT_OUTSIDE_SAVE_BEGIN_END(ctx);
+
+   if (ctx->ListState.Current.CullFace == mode) {
+      /* redundant */
+      if (ctx->ExecuteFlag) {
+         CALL_CullFace(ctx->Exec, (mode));
+      }
+      return;
+   }
+
+   SAVE_FLUSH_VERTICES(ctx);
+
+   if (mode == GL_FRONT || mode == GL_BACK || mode == GL_FRONT_AND_BACK)
+      ctx->ListState.Current.CullFace = mode;
+
    n = alloc_instruction(ctx, OPCODE_CULL_FACE, 1);
    if (n) {
       n[1].e = mode;
@@ -2204,7 +2303,21 @@ save_DepthFunc(GLenum func)
 {
    GET_CURRENT_CONTEXT(ctx);
    Node *n;
-   ASSERT_OUTSIDE_SAVE_BEGIN_END_AND_FLUSH(ctx);
+   ASSERT_OUTSIDE_SAVE_BEGIN_END(ctx);
+
+   if (ctx->ListState.Current.DepthFunc == func) {
+      /* redundant */
+      if (ctx->ExecuteFlag) {
+         CALL_DepthFunc(ctx->Exec, (func));
+      }
+      return;
+   }
+
+   SAVE_FLUSH_VERTICES(ctx);
+
+   if (func >= GL_NEVER && func <= GL_ALWAYS)
+      ctx->ListState.Current.DepthFunc = func;
+
    n = alloc_instruction(ctx, OPCODE_DEPTH_FUNC, 1);
    if (n) {
       n[1].e = func;
@@ -2252,8 +2365,24 @@ static void GLAPIENTRY
 save_Disable(GLenum cap)
 {
    GET_CURRENT_CONTEXT(ctx);
+   const GLbitfield bit = tracked_cap_bit(cap);
    Node *n;
-   ASSERT_OUTSIDE_SAVE_BEGIN_END_AND_FLUSH(ctx);
+   ASSERT_OUTSIDE_SAVE_BEGIN_END(ctx);
+
+   if (bit && (ctx->ListState.Current.EnableKnown & bit) &&
+       (ctx->ListState.Current.Enabled & bit) == 0) {
+      /* redundant */
+      if (ctx->ExecuteFlag) {
+         CALL_Disable(ctx->Exec, (cap));
+      }
+      return;
+   }
+
+   SAVE_FLUSH_VERTICES(ctx);
+
+   ctx->ListState.Current.EnableKnown |= bit;
+   ctx->ListState.Current.Enabled &= ~bit;
+
    n = alloc_instruction(ctx, OPCODE_DISABLE, 1);
    if (n) {
       n[1].e = cap;
@@ -2270,6 +2399,10 @@ save_DisableIndexed(GLuint index, GLenum cap)
    GET_CURRENT_CONTEXT(ctx);
    Node *n;
    ASSERT_OUTSIDE_SAVE_BEGIN_END_AND_FLUSH(ctx);
+
+   /* the non-indexed state is now a mix of enabled and disabled */
+   ctx->ListState.Current.EnableKnown &= ~tracked_cap_bit(cap);
+
    n = alloc_instruction(ctx, OPCODE_DISABLE_INDEXED, 2);
    if (n) {
       n[1].ui = index;
@@ -2326,8 +2459,24 @@ static void GLAPIENTRY
 save_Enable(GLenum cap)
 {
    GET_CURRENT_CONTEXT(ctx);
+   const GLbitfield bit = tracked_cap_bit(cap);
    Node *n;
-   ASSERT_OUTSIDE_SAVE_BEGIN_END_AND_FLUSH(ctx);
+   ASSERT_OUTSIDE_SAVE_BEGIN_END(ctx);
+
+   if (bit && (ctx->ListState.Current.EnableKnown & bit) &&
+       (ctx->ListState.Current.Enabled & bit) == bit) {
+      /* redundant */
+      if (ctx->ExecuteFlag) {
+         CALL_Enable(ctx->Exec, (cap));
+      }
+      return;
+   }
+
+   SAVE_FLUSH_VERTICES(ctx);
+
+   ctx->ListState.Current.EnableKnown |= bit;
+   ctx->ListState.Current.Enabled |= bit;
+
    n = alloc_instruction(ctx, OPCODE_ENABLE, 1);
    if (n) {
       n[1].e = cap;
@@ -2345,6 +2494,10 @@ save_EnableIndexed(GLuint index, GLenum cap)
    GET_CURRENT_CONTEXT(ctx);
    Node *n;
    ASSERT_OUTSIDE_SAVE_BEGIN_END_AND_FLUSH(ctx);
+
+   /* the non-indexed state is now a mix of enabled and disabled */
+   ctx->ListState.Current.EnableKnown &= ~tracked_cap_bit(cap);
+
    n = alloc_instruction(ctx, OPCODE_ENABLE_INDEXED, 2);
    if (n) {
       n[1].ui = index;
@@ -2369,6 +2522,8 @@ save_EvalMesh1(GLenum mode, GLint i1, GLint i2)
       n[2].i = i1;
       n[3].i = i2;
    }
+   /* Evaluators set the current attributes. */
+   invalidate_saved_current_attribs(ctx);
    if (ctx->ExecuteFlag) {
       CALL_EvalMesh1(ctx->Exec, (mode, i1, i2));
    }
@@ -2389,6 +2544,8 @@ save_EvalMesh2(GLenum mode, GLint i1, GLint i2, GLint j1, GLint j2)
       n[4].i = j1;
       n[5].i = j2;
    }
+   /* Evaluators set the current attributes. */
+   invalidate_saved_current_attribs(ctx);
    if (ctx->ExecuteFlag) {
       CALL_EvalMesh2(ctx->Exec, (mode, i1, i2, j1, j2));
    }
@@ -2471,7 +2628,21 @@ save_FrontFace(GLenum mode)
 {
    GET_CURRENT_CONTEXT(ctx);
    Node *n;
-   ASSERT_OUTSIDE_SAVE_BEGIN_END_AND_FLUSH(ctx);
+   ASSERT_OUTSIDE_SAVE_BEGIN_END(ctx);
+
+   if (ctx->ListState.Current.FrontFace == mode) {
+      /* redundant */
+      if (ctx->ExecuteFlag) {
+         CALL_FrontFace(ctx->Exec, (mode));
+      }
+      return;
+   }
+
+   SAVE_FLUSH_VERTICES(ctx);
+
+   if (mode == GL_CW || mode == GL_CCW)
+      ctx->ListState.Current.FrontFace = mode;
+
    n = alloc_instruction(ctx, OPCODE_FRONT_FACE, 1);
    if (n) {
       n[1].e = mode;
@@ -2773,7 +2944,21 @@ save_LineWidth(GLfloat width)
 {
    GET_CURRENT_CONTEXT(ctx);
    Node *n;
-   ASSERT_OUTSIDE_SAVE_BEGIN_END_AND_FLUSH(ctx);
+   ASSERT_OUTSIDE_SAVE_BEGIN_END(ctx);
+
+   if (ctx->ListState.Current.LineWidth == width) {
+      /* redundant */
+      if (ctx->ExecuteFlag) {
+         CALL_LineWidth(ctx->Exec, (width));
+      }
+      return;
+   }
+
+   SAVE_FLUSH_VERTICES(ctx);
+
+   if (width > 0.0F)
+      ctx->ListState.Current.LineWidth = width;
+
    n = alloc_instruction(ctx, OPCODE_LINE_WIDTH, 1);
    if (n) {
       n[1].f = width;
@@ -3047,7 +3232,27 @@ save_MatrixMode(GLenum mode)
 {
    GET_CURRENT_CONTEXT(ctx);
    Node *n;
-   ASSERT_OUTSIDE_SAVE_BEGIN_END_AND_FLUSH(ctx);
+   ASSERT_OUTSIDE_SAVE_BEGIN_END(ctx);
+
+   if (ctx->ListState.Current.MatrixMode == mode) {
+      /* redundant */
+      if (ctx->ExecuteFlag) {
+         CALL_MatrixMode(ctx->Exec, (mode));
+      }
+      return;
+   }
+
+   SAVE_FLUSH_VERTICES(ctx);
+
+   /* Only remember valid values, so errors still get raised.  Anything
+    * else (including GL_MATRIXi_ARB) leaves the mode unknown, so that the
+    * next change is always recorded.
+    */
+   if (mode == GL_MODELVIEW || mode == GL_PROJECTION || mode == GL_TEXTURE)
+      ctx->ListState.Current.MatrixMode = mode;
+   else
+      ctx->ListState.Current.MatrixMode = 0;
+
    n = alloc_instruction(ctx, OPCODE_MATRIX_MODE, 1);
    if (n) {
       n[1].e = mode;
@@ -3292,7 +3497,21 @@ save_PointSize(GLfloat size)
 {
    GET_CURRENT_CONTEXT(ctx);
    Node *n;
-   ASSERT_OUTSIDE_SAVE_BEGIN_END_AND_FLUSH(ctx);
+   ASSERT_OUTSIDE_SAVE_BEGIN_END(ctx);
+
+   if (ctx->ListState.Current.PointSize == size) {
+      /* redundant */
+      if (ctx->ExecuteFlag) {
+         CALL_PointSize(ctx->Exec, (size));
+      }
+      return;
+   }
+
+   SAVE_FLUSH_VERTICES(ctx);
+
+   if (size > 0.0F)
+      ctx->ListState.Current.PointSize = size;
+
    n = alloc_instruction(ctx, OPCODE_POINT_SIZE, 1);
    if (n) {
       n[1].f = size;
@@ -3371,6 +3590,10 @@ save_PopAttrib(void)
    GET_CURRENT_CONTEXT(ctx);
    ASSERT_OUTSIDE_SAVE_BEGIN_END_AND_FLUSH(ctx);
    (void) alloc_instruction(ctx, OPCODE_POP_ATTRIB, 0);
+
+   /* Any of the state we're tracking may have been restored. */
+   invalidate_saved_current_attribs(ctx);
+   memset(&ctx->ListState.Current, 0, sizeof ctx->ListState.Current);
    if (ctx->ExecuteFlag) {
       CALL_PopAttrib(ctx->Exec, ());
    }
@@ -5280,15 +5503,17 @@ save_Attr1fNV(GLenum attr, GLfloat x)
    GET_CURRENT_CONTEXT(ctx);
    Node *n;
    SAVE_FLUSH_VERTICES(ctx);
-   n = alloc_instruction(ctx, OPCODE_ATTR_1F_NV, 2);
-   if (n) {
-      n[1].e = attr;
-      n[2].f = x;
-   }
 
    ASSERT(attr < MAX_VERTEX_GENERIC_ATTRIBS);
-   ctx->ListState.ActiveAttribSize[attr] = 1;
-   ASSIGN_4V(ctx->ListState.CurrentAttrib[attr], x, 0, 0, 1);
+   if (!is_redundant_attr(ctx, attr, 1, x, 0, 0, 1)) {
+      n = alloc_instruction(ctx, OPCODE_ATTR_1F_NV, 2);
+      if (n) {
+         n[1].e = attr;
+         n[2].f = x;
+      }
+      ctx->ListState.ActiveAttribSize[attr] = 1;
+      ASSIGN_4V(ctx->ListState.CurrentAttrib[attr], x, 0, 0, 1);
+   }
 
    if (ctx->ExecuteFlag) {
       CALL_VertexAttrib1fNV(ctx->Exec, (attr, x));
@@ -5301,16 +5526,18 @@ save_Attr2fNV(GLenum attr, GLfloat x, GLfloat y)
    GET_CURRENT_CONTEXT(ctx);
    Node *n;
    SAVE_FLUSH_VERTICES(ctx);
-   n = alloc_instruction(ctx, OPCODE_ATTR_2F_NV, 3);
-   if (n) {
-      n[1].e = attr;
-      n[2].f = x;
-      n[3].f = y;
-   }
 
    ASSERT(attr < MAX_VERTEX_GENERIC_ATTRIBS);
-   ctx->ListState.ActiveAttribSize[attr] = 2;
-   ASSIGN_4V(ctx->ListState.CurrentAttrib[attr], x, y, 0, 1);
+   if (!is_redundant_attr(ctx, attr, 2, x, y, 0, 1)) {
+      n = alloc_instruction(ctx, OPCODE_ATTR_2F_NV, 3);
+      if (n) {
+         n[1].e = attr;
+         n[2].f = x;
+         n[3].f = y;
+      }
+      ctx->ListState.ActiveAttribSize[attr] = 2;
+      ASSIGN_4V(ctx->ListState.CurrentAttrib[attr], x, y, 0, 1);
+   }
 
    if (ctx->ExecuteFlag) {
       CALL_VertexAttrib2fNV(ctx->Exec, (attr, x, y));
@@ -5323,17 +5550,19 @@ save_Attr3fNV(GLenum attr, GLfloat x, GLfloat y, GLfloat z)
    GET_CURRENT_CONTEXT(ctx);
    Node *n;
    SAVE_FLUSH_VERTICES(ctx);
-   n = alloc_instruction(ctx, OPCODE_ATTR_3F_NV, 4);
-   if (n) {
-      n[1].e = attr;
-      n[2].f = x;
-      n[3].f = y;
-      n[4].f = z;
-   }
 
    ASSERT(attr < MAX_VERTEX_GENERIC_ATTRIBS);
-   ctx->ListState.ActiveAttribSize[attr] = 3;
-   ASSIGN_4V(ctx->ListState.CurrentAttrib[attr], x, y, z, 1);
+   if (!is_redundant_attr(ctx, attr, 3, x, y, z, 1)) {
+      n = alloc_instruction(ctx, OPCODE_ATTR_3F_NV, 4);
+      if (n) {
+         n[1].e = attr;
+         n[2].f = x;
+         n[3].f = y;
+         n[4].f = z;
+      }
+      ctx->ListState.ActiveAttribSize[attr] = 3;
+      ASSIGN_4V(ctx->ListState.CurrentAttrib[attr], x, y, z, 1);
+   }
 
    if (ctx->ExecuteFlag) {
       CALL_VertexAttrib3fNV(ctx->Exec, (attr, x, y, z));
@@ -5346,18 +5575,20 @@ save_Attr4fNV(GLenum attr, GLfloat x, GLfloat y, GLfloat z, GLfloat w)
    GET_CURRENT_CONTEXT(ctx);
    Node *n;
    SAVE_FLUSH_VERTICES(ctx);
-   n = alloc_instruction(ctx, OPCODE_ATTR_4F_NV, 5);
-   if (n) {
-      n[1].e = attr;
-      n[2].f = x;
-      n[3].f = y;
-      n[4].f = z;
-      n[5].f = w;
-   }
 
    ASSERT(attr < MAX_VERTEX_GENERIC_ATTRIBS);
-   ctx->ListState.ActiveAttribSize[attr] = 4;
-   ASSIGN_4V(ctx->ListState.CurrentAttrib[attr], x, y, z, w);
+   if (!is_redundant_attr(ctx, attr, 4, x, y, z, w)) {
+      n = alloc_instruction(ctx, OPCODE_ATTR_4F_NV, 5);
+      if (n) {
+         n[1].e = attr;
+         n[2].f = x;
+         n[3].f = y;
+         n[4].f = z;
+         n[5].f = w;
+      }
+      ctx->ListState.ActiveAttribSize[attr] = 4;
+      ASSIGN_4V(ctx->ListState.CurrentAttrib[attr], x, y, z, w);
+   }
 
    if (ctx->ExecuteFlag) {
       CALL_VertexAttrib4fNV(ctx->Exec, (attr, x, y, z, w));
@@ -5369,17 +5600,20 @@ static void GLAPIENTRY
 save_Attr1fARB(GLenum attr, GLfloat x)
 {
    GET_CURRENT_CONTEXT(ctx);
+   const GLuint index = VERT_ATTRIB_GENERIC(attr);
    Node *n;
    SAVE_FLUSH_VERTICES(ctx);
-   n = alloc_instruction(ctx, OPCODE_ATTR_1F_ARB, 2);
-   if (n) {
-      n[1].e = attr;
-      n[2].f = x;
-   }
 
    ASSERT(attr < MAX_VERTEX_GENERIC_ATTRIBS);
-   ctx->ListState.ActiveAttribSize[attr] = 1;
-   ASSIGN_4V(ctx->ListState.CurrentAttrib[attr], x, 0, 0, 1);
+   if (!is_redundant_attr(ctx, index, 1, x, 0, 0, 1)) {
+      n = alloc_instruction(ctx, OPCODE_ATTR_1F_ARB, 2);
+      if (n) {
+         n[1].e = attr;
+         n[2].f = x;
+      }
+      ctx->ListState.ActiveAttribSize[index] = 1;
+      ASSIGN_4V(ctx->ListState.CurrentAttrib[index], x, 0, 0, 1);
+   }
 
    if (ctx->ExecuteFlag) {
       CALL_VertexAttrib1fARB(ctx->Exec, (attr, x));
@@ -5390,18 +5624,21 @@ static void GLAPIENTRY
 save_Attr2fARB(GLenum attr, GLfloat x, GLfloat y)
 {
    GET_CURRENT_CONTEXT(ctx);
+   const GLuint index = VERT_ATTRIB_GENERIC(attr);
    Node *n;
    SAVE_FLUSH_VERTICES(ctx);
-   n = alloc_instruction(ctx, OPCODE_ATTR_2F_ARB, 3);
-   if (n) {
-      n[1].e = attr;
-      n[2].f = x;
-      n[3].f = y;
-   }
 
    ASSERT(attr < MAX_VERTEX_GENERIC_ATTRIBS);
-   ctx->ListState.ActiveAttribSize[attr] = 2;
-   ASSIGN_4V(ctx->ListState.CurrentAttrib[attr], x, y, 0, 1);
+   if (!is_redundant_attr(ctx, index, 2, x, y, 0, 1)) {
+      n = alloc_instruction(ctx, OPCODE_ATTR_2F_ARB, 3);
+      if (n) {
+         n[1].e = attr;
+         n[2].f = x;
+         n[3].f = y;
+      }
+      ctx->ListState.ActiveAttribSize[index] = 2;
+      ASSIGN_4V(ctx->ListState.CurrentAttrib[index], x, y, 0, 1);
+   }
 
    if (ctx->ExecuteFlag) {
       CALL_VertexAttrib2fARB(ctx->Exec, (attr, x, y));
@@ -5412,19 +5649,22 @@ static void GLAPIENTRY
 save_Attr3fARB(GLenum attr, GLfloat x, GLfloat y, GLfloat z)
 {
    GET_CURRENT_CONTEXT(ctx);
+   const GLuint index = VERT_ATTRIB_GENERIC(attr);
    Node *n;
    SAVE_FLUSH_VERTICES(ctx);
-   n = alloc_instruction(ctx, OPCODE_ATTR_3F_ARB, 4);
-   if (n) {
-      n[1].e = attr;
-      n[2].f = x;
-      n[3].f = y;
-      n[4].f = z;
-   }
 
    ASSERT(attr < MAX_VERTEX_GENERIC_ATTRIBS);
-   ctx->ListState.ActiveAttribSize[attr] = 3;
-   ASSIGN_4V(ctx->ListState.CurrentAttrib[attr], x, y, z, 1);
+   if (!is_redundant_attr(ctx, index, 3, x, y, z, 1)) {
+      n = alloc_instruction(ctx, OPCODE_ATTR_3F_ARB, 4);
+      if (n) {
+         n[1].e = attr;
+         n[2].f = x;
+         n[3].f = y;
+         n[4].f = z;
+      }
+      ctx->ListState.ActiveAttribSize[index] = 3;
+      ASSIGN_4V(ctx->ListState.CurrentAttrib[index], x, y, z, 1);
+   }
 
    if (ctx->ExecuteFlag) {
       CALL_VertexAttrib3fARB(ctx->Exec, (attr, x, y, z));
@@ -5435,20 +5675,23 @@ static void GLAPIENTRY
 save_Attr4fARB(GLenum attr, GLfloat x, GLfloat y, GLfloat z, GLfloat w)
 {
    GET_CURRENT_CONTEXT(ctx);
+   const GLuint index = VERT_ATTRIB_GENERIC(attr);
    Node *n;
    SAVE_FLUSH_VERTICES(ctx);
-   n = alloc_instruction(ctx, OPCODE_ATTR_4F_ARB, 5);
-   if (n) {
-      n[1].e = attr;
-      n[2].f = x;
-      n[3].f = y;
-      n[4].f = z;
-      n[5].f = w;
-   }
 
    ASSERT(attr < MAX_VERTEX_GENERIC_ATTRIBS);
-   ctx->ListState.ActiveAttribSize[attr] = 4;
-   ASSIGN_4V(ctx->ListState.CurrentAttrib[attr], x, y, z, w);
+   if (!is_redundant_attr(ctx, index, 4, x, y, z, w)) {
+      n = alloc_instruction(ctx, OPCODE_ATTR_4F_ARB, 5);
+      if (n) {
+         n[1].e = attr;
+         n[2].f = x;
+         n[3].f = y;
+         n[4].f = z;
+         n[5].f = w;
+      }
+      ctx->ListState.ActiveAttribSize[index] = 4;
+      ASSIGN_4V(ctx->ListState.CurrentAttrib[index], x, y, z, w);
+   }
 
    if (ctx->ExecuteFlag) {
       CALL_VertexAttrib4fARB(ctx->Exec, (attr, x, y, z, w));
@@ -5466,6 +5709,8 @@ save_EvalCoord1f(GLfloat x)
    if (n) {
       n[1].f = x;
    }
+   /* Evaluators set the current attributes. */
+   invalidate_saved_current_attribs(ctx);
    if (ctx->ExecuteFlag) {
       CALL_EvalCoord1f(ctx->Exec, (x));
    }
@@ -5488,6 +5733,8 @@ save_EvalCoord2f(GLfloat x, GLfloat y)
       n[1].f = x;
       n[2].f = y;
    }
+   /* Evaluators set the current attributes. */
+   invalidate_saved_current_attribs(ctx);
    if (ctx->ExecuteFlag) {
       CALL_EvalCoord2f(ctx->Exec, (x, y));
    }
@@ -5510,6 +5757,8 @@ save_EvalPoint1(GLint x)
    if (n) {
       n[1].i = x;
    }
+   /* Evaluators set the current attributes. */
+   invalidate_saved_current_attribs(ctx);
    if (ctx->ExecuteFlag) {
       CALL_EvalPoint1(ctx->Exec, (x));
    }
@@ -5526,6 +5775,8 @@ save_EvalPoint2(GLint x, GLint y)
       n[1].i = x;
       n[2].i = y;
    }
+   /* Evaluators set the current attributes. */
+   invalidate_saved_current_attribs(ctx);
    if (ctx->ExecuteFlag) {
       CALL_EvalPoint2(ctx->Exec, (x, y));
    }
@@ -7287,6 +7538,9 @@ islist(struct gl_context *ctx, GLuint list)
 /**********************************************************************/
 
 
+static void
+execute_dlist(struct gl_context *ctx, struct gl_display_list *dlist);
+
 /*
  * Execute a display list.  Note that the ListBase offset must have already
  * been added before calling this function.  I.e. the list argument is
@@ -7297,21 +7551,32 @@ static void
 execute_list(struct gl_context *ctx, GLuint list)
 {
    struct gl_display_list *dlist;
-   Node *n;
-   GLboolean done;
 
-   if (list == 0 || !islist(ctx, list))
+   if (list == 0)
+      return;
+
+   dlist = lookup_list(ctx, list);
+   if (!dlist)
       return;
 
+   execute_dlist(ctx, dlist);
+}
+
+
+/**
+ * Execute the commands of a display list that has already been looked up.
+ */
+static void
+execute_dlist(struct gl_context *ctx, struct gl_display_list *dlist)
+{
+   Node *n;
+   GLboolean done;
+
    if (ctx->ListState.CallDepth == MAX_LIST_NESTING) {
       /* raise an error? */
       return;
    }
 
-   dlist = lookup_list(ctx, list);
-   if (!dlist)
-      return;
-
    ctx->ListState.CallDepth++;
 
    if (ctx->Driver.BeginCallList)
@@ -7386,7 +7651,12 @@ execute_list(struct gl_context *ctx, GLuint list)
          case OPCODE_CALL_LIST:
             /* Generated by glCallList(), don't add ListBase */
             if (ctx->ListState.CallDepth < MAX_LIST_NESTING) {
-               execute_list(ctx, n[1].ui);
+               /* use the list resolved at compile time if still valid */
+               if (n[2].data &&
+                   n[3].ui == ctx->Shared->DisplayListGeneration)
+                  execute_dlist(ctx, (struct gl_display_list *) n[2].data);
+               else
+                  execute_list(ctx, n[1].ui);
             }
             break;
          case OPCODE_CALL_LIST_OFFSET:
@@ -1336,7 +1336,7 @@ create_new_program(struct gl_context *ctx, struct state_key *key)
 
    validate_ir_tree(p.shader->ir);
 
-   while (do_common_optimization(p.shader->ir, false, false, 32))
+   while (do_common_optimization(p.shader->ir, false, false, 32, false))
       ;
    reparent_ir(p.shader->ir, p.shader->ir);
 
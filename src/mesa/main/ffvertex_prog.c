@@ -40,6 +40,7 @@
 #include "main/ffvertex_prog.h"
 #include "program/program.h"
 #include "program/prog_cache.h"
+#include "program/prog_diskcache.h"
 #include "program/prog_instruction.h"
 #include "program/prog_parameter.h"
 #include "program/prog_print.h"
@@ -1645,6 +1646,18 @@ create_new_program( const struct state_key *key,
 }
 
 
+/**
+ * Everything that create_new_program() depends on, used as the key of the
+ * disk cache which is shared by all drivers.
+ */
+struct disk_key
+{
+   struct state_key state;
+   GLuint mvp_with_dp4;
+   GLuint max_temps;
+};
+
+
 /**
  * Return a vertex program which implements the current fixed-function
  * transform/lighting/texgen operations.
@@ -1653,16 +1666,31 @@ struct gl_vertex_program *
 _mesa_get_fixed_func_vertex_program(struct gl_context *ctx)
 {
    struct gl_vertex_program *prog;
-   struct state_key key;
+   struct disk_key disk_key;
+   struct state_key *key = &disk_key.state;
 
    /* Grab all the relevent state and put it in a single structure:
     */
-   make_state_key(ctx, &key);
+   memset(&disk_key, 0, sizeof(disk_key));
+   make_state_key(ctx, key);
+   disk_key.mvp_with_dp4 = ctx->mvp_with_dp4;
+   disk_key.max_temps = ctx->Const.VertexProgram.MaxTemps;
 
    /* Look for an already-prepared program for this state:
     */
    prog = gl_vertex_program(
-      _mesa_search_program_cache(ctx->VertexProgram.Cache, &key, sizeof(key)));
+      _mesa_search_program_cache(ctx->VertexProgram.Cache, key, sizeof(*key)));
+
+   if (!prog) {
+      /* Maybe an earlier run generated it */
+      prog = gl_vertex_program(
+         _mesa_load_program_from_disk(ctx, GL_VERTEX_PROGRAM_ARB,
+                                      &disk_key, sizeof(disk_key)));
+      if (prog) {
+         _mesa_program_cache_insert(ctx, ctx->VertexProgram.Cache,
+                                    key, sizeof(*key), &prog->Base);
+      }
+   }
 
    if (!prog) {
       /* OK, we'll have to build a new one */
@@ -1673,7 +1701,7 @@ _mesa_get_fixed_func_vertex_program(struct gl_context *ctx)
       if (!prog)
          return NULL;
 
-      create_new_program( &key, prog,
+      create_new_program( key, prog,
                           ctx->mvp_with_dp4,
                           ctx->Const.VertexProgram.MaxTemps );
 
@@ -1683,7 +1711,9 @@ _mesa_get_fixed_func_vertex_program(struct gl_context *ctx)
                                           &prog->Base );
 #endif
       _mesa_program_cache_insert(ctx, ctx->VertexProgram.Cache,
-                                 &key, sizeof(key), &prog->Base);
+                                 key, sizeof(*key), &prog->Base);
+
+      _mesa_store_program_to_disk(&disk_key, sizeof(disk_key), &prog->Base);
    }
 
    return prog;
@@ -368,6 +368,7 @@ EXTRA_EXT(ARB_timer_query);
 EXTRA_EXT(ARB_map_buffer_alignment);
 EXTRA_EXT(ARB_texture_cube_map_array);
 EXTRA_EXT(ARB_texture_buffer_range);
+EXTRA_EXT(ARB_draw_indirect);
 EXTRA_EXT(ARB_texture_multisample);
 
 static const int
@@ -758,6 +759,9 @@ find_custom_value(struct gl_context *ctx, const struct value_desc *d, union valu
    case GL_COPY_WRITE_BUFFER:
       v->value_int = ctx->CopyWriteBuffer->Name;
       break;
+   case GL_DRAW_INDIRECT_BUFFER_BINDING:
+      v->value_int = ctx->DrawIndirectBuffer->Name;
+      break;
 
    case GL_PIXEL_PACK_BUFFER_BINDING_EXT:
       v->value_int = ctx->Pack.BufferObj->Name;
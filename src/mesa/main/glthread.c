@@ -0,0 +1,566 @@
+/*
+ * Copyright © 2013 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file glthread.c
+ * Threaded dispatch.
+ *
+ * When MESA_GLTHREAD is set, the application thread gets a dispatch table
+ * whose functions, generated by gl_marshal.py, record each call into a
+ * batch instead of executing it.  Full batches are handed to a driver
+ * thread, which runs the commands through the context's regular dispatch
+ * table.  Validation, state updates and drawing thus overlap with the
+ * application's own work.
+ *
+ * Pointer arguments of known size are copied into the command.  Vertex
+ * array pointers are queued as they are, and so are index and pixel data
+ * pointers while a buffer object is bound, since they are offsets then.
+ * The application thread tracks those bindings itself.  Draws are only
+ * queued while no vertex array of the bound vertex array object points to
+ * client memory.
+ *
+ * Other calls, such as the ones that return a value, wait for the driver
+ * thread to drain its queue and then execute directly on the application
+ * thread.
+ */
+
+#include "main/glthread.h"
+#include "main/bufferobj.h"
+#include "main/eval.h"
+#include "main/hash.h"
+#include "main/imports.h"
+
+
+static struct glthread_vao *
+lookup_vao(struct glthread_state *glthread, GLuint name)
+{
+   if (name == 0)
+      return &glthread->default_vao;
+
+   return _mesa_HashLookup(glthread->vaos, name);
+}
+
+
+/**
+ * Copy the client state tracked by the application thread from the
+ * context.  The driver thread must be idle.
+ */
+static void
+read_client_state(struct gl_context *ctx)
+{
+   struct glthread_state *glthread = ctx->GLThread;
+   struct gl_array_object *obj = ctx->Array.ArrayObj;
+   struct glthread_vao *vao = lookup_vao(glthread, obj->Name);
+   GLuint i;
+
+   glthread->array_buffer = ctx->Array.ArrayBufferObj->Name;
+   glthread->pixel_unpack_buffer = ctx->Unpack.BufferObj->Name;
+   glthread->client_active_texture = ctx->Array.ActiveTexture;
+
+   if (vao == NULL) {
+      vao = calloc(1, sizeof(*vao));
+      if (vao == NULL) {
+         /* Unknown arrays count as client memory, which keeps draws
+          * synchronous until the next successful bind.
+          */
+         glthread->current_vao = &glthread->default_vao;
+         glthread->default_vao.user_arrays = ~(GLbitfield64) 0;
+         return;
+      }
+      _mesa_HashInsert(glthread->vaos, obj->Name, vao);
+   }
+
+   vao->user_arrays = 0;
+   for (i = 0; i < Elements(obj->VertexAttrib); i++) {
+      const struct gl_client_array *array = &obj->VertexAttrib[i];
+
+      if (!_mesa_is_bufferobj(array->BufferObj) && array->Ptr != NULL)
+         vao->user_arrays |= VERT_BIT(i);
+   }
+   vao->element_array_buffer = obj->ElementArrayBufferObj->Name;
+
+   glthread->current_vao = vao;
+}
+
+
+/**
+ * Wait for the driver thread and copy the tracked client state from the
+ * context again, after calls that change it in ways the application thread
+ * doesn't follow, such as glPopClientAttrib and glDeleteBuffers.
+ */
+void
+_mesa_glthread_restore_client_state(struct gl_context *ctx)
+{
+   _mesa_glthread_finish(ctx);
+   read_client_state(ctx);
+}
+
+
+void
+_mesa_glthread_BindBuffer(struct gl_context *ctx, GLenum target,
+                          GLuint buffer)
+{
+   struct glthread_state *glthread = ctx->GLThread;
+
+   switch (target) {
+   case GL_ARRAY_BUFFER:
+      glthread->array_buffer = buffer;
+      break;
+   case GL_ELEMENT_ARRAY_BUFFER:
+      glthread->current_vao->element_array_buffer = buffer;
+      break;
+   case GL_PIXEL_UNPACK_BUFFER:
+      glthread->pixel_unpack_buffer = buffer;
+      break;
+   }
+}
+
+
+/**
+ * Called after glBindVertexArray has been queued.  Binding a name the
+ * application thread doesn't know yet, which is either an error or
+ * creates the object, reads the binding back from the context.
+ */
+void
+_mesa_glthread_BindVertexArray(struct gl_context *ctx, GLuint array)
+{
+   struct glthread_state *glthread = ctx->GLThread;
+   struct glthread_vao *vao = lookup_vao(glthread, array);
+
+   if (vao != NULL)
+      glthread->current_vao = vao;
+   else
+      _mesa_glthread_restore_client_state(ctx);
+}
+
+
+void
+_mesa_glthread_DeleteVertexArrays(struct gl_context *ctx, GLsizei n,
+                                  const GLuint *arrays)
+{
+   struct glthread_state *glthread = ctx->GLThread;
+   GLsizei i;
+
+   if (arrays == NULL)
+      return;
+
+   for (i = 0; i < n; i++) {
+      struct glthread_vao *vao;
+
+      if (arrays[i] == 0)
+         continue;
+
+      vao = _mesa_HashLookup(glthread->vaos, arrays[i]);
+      if (vao == NULL)
+         continue;
+
+      if (vao == glthread->current_vao)
+         glthread->current_vao = &glthread->default_vao;
+
+      _mesa_HashRemove(glthread->vaos, arrays[i]);
+      free(vao);
+   }
+}
+
+
+void
+_mesa_glthread_ClientActiveTexture(struct gl_context *ctx, GLenum texture)
+{
+   GLuint unit = texture - GL_TEXTURE0;
+
+   if (unit < MAX_TEXTURE_COORD_UNITS)
+      ctx->GLThread->client_active_texture = unit;
+}
+
+
+/**
+ * Track the arrays glInterleavedArrays sets.  The ones it only disables
+ * keep their pointers.
+ */
+void
+_mesa_glthread_InterleavedArrays(struct gl_context *ctx, GLenum format,
+                                 const GLvoid *pointer)
+{
+   bool tflag, cflag, nflag;
+
+   switch (format) {
+   case GL_V2F:
+   case GL_V3F:
+      tflag = false; cflag = false; nflag = false;
+      break;
+   case GL_C4UB_V2F:
+   case GL_C4UB_V3F:
+   case GL_C3F_V3F:
+      tflag = false; cflag = true; nflag = false;
+      break;
+   case GL_N3F_V3F:
+      tflag = false; cflag = false; nflag = true;
+      break;
+   case GL_C4F_N3F_V3F:
+      tflag = false; cflag = true; nflag = true;
+      break;
+   case GL_T2F_V3F:
+   case GL_T4F_V4F:
+      tflag = true; cflag = false; nflag = false;
+      break;
+   case GL_T2F_C4UB_V3F:
+   case GL_T2F_C3F_V3F:
+      tflag = true; cflag = true; nflag = false;
+      break;
+   case GL_T2F_N3F_V3F:
+      tflag = true; cflag = false; nflag = true;
+      break;
+   case GL_T2F_C4F_N3F_V3F:
+   case GL_T4F_C4F_N3F_V4F:
+      tflag = true; cflag = true; nflag = true;
+      break;
+   default:
+      return;
+   }
+
+   if (tflag)
+      _mesa_glthread_TexCoordPointer(ctx, pointer);
+   if (cflag)
+      _mesa_glthread_AttribPointer(ctx, VERT_ATTRIB_COLOR0, pointer);
+   if (nflag)
+      _mesa_glthread_AttribPointer(ctx, VERT_ATTRIB_NORMAL, pointer);
+   _mesa_glthread_AttribPointer(ctx, VERT_ATTRIB_POS, pointer);
+}
+
+
+/**
+ * Number of values glMap1 reads from its points argument, or 0 if the
+ * arguments are invalid.
+ */
+size_t
+_mesa_glthread_map1_count(GLenum target, GLint stride, GLint order)
+{
+   GLint k = _mesa_evaluator_components(target);
+
+   if (k == 0 || stride < k || stride > MARSHAL_MAX_CMD_SIZE ||
+       order < 1 || order > MAX_EVAL_ORDER)
+      return 0;
+
+   return (order - 1) * stride + k;
+}
+
+
+/**
+ * Number of values glMap2 reads from its points argument, or 0 if the
+ * arguments are invalid.
+ */
+size_t
+_mesa_glthread_map2_count(GLenum target, GLint ustride, GLint uorder,
+                          GLint vstride, GLint vorder)
+{
+   GLint k = _mesa_evaluator_components(target);
+
+   if (k == 0 || ustride < k || ustride > MARSHAL_MAX_CMD_SIZE ||
+       vstride < k || vstride > MARSHAL_MAX_CMD_SIZE ||
+       uorder < 1 || uorder > MAX_EVAL_ORDER ||
+       vorder < 1 || vorder > MAX_EVAL_ORDER)
+      return 0;
+
+   return (uorder - 1) * ustride + (vorder - 1) * vstride + k;
+}
+
+
+#ifdef HAVE_PTHREAD
+
+static void
+glthread_execute_batch(struct gl_context *ctx, struct glthread_batch *batch)
+{
+   size_t pos = 0;
+
+   /* A synchronous call on the application thread may have switched the
+    * current dispatch table.
+    */
+   _glapi_set_dispatch(ctx->CurrentDispatch);
+
+   while (pos < batch->used)
+      pos += _mesa_unmarshal_dispatch_cmd(ctx, (char *) batch->buffer + pos);
+
+   assert(pos == batch->used);
+   batch->used = 0;
+}
+
+
+static void *
+glthread_worker(void *data)
+{
+   struct gl_context *ctx = data;
+   struct glthread_state *glthread = ctx->GLThread;
+
+   _glapi_check_multithread();
+   _glapi_set_context(ctx);
+   _glapi_set_dispatch(ctx->CurrentDispatch);
+
+   pthread_mutex_lock(&glthread->mutex);
+
+   while (true) {
+      struct glthread_batch *batch;
+
+      while (glthread->batch_queue == NULL && !glthread->shutdown)
+         pthread_cond_wait(&glthread->new_work, &glthread->mutex);
+
+      batch = glthread->batch_queue;
+      if (batch == NULL)
+         break;
+
+      glthread->batch_queue = batch->next;
+      if (glthread->batch_queue == NULL)
+         glthread->batch_queue_tail = &glthread->batch_queue;
+
+      pthread_mutex_unlock(&glthread->mutex);
+      glthread_execute_batch(ctx, batch);
+      pthread_mutex_lock(&glthread->mutex);
+
+      batch->next = glthread->free_batches;
+      glthread->free_batches = batch;
+      glthread->num_pending--;
+      pthread_cond_broadcast(&glthread->work_done);
+   }
+
+   pthread_mutex_unlock(&glthread->mutex);
+
+   return NULL;
+}
+
+
+static void
+free_vao(GLuint key, void *data, void *userData)
+{
+   free(data);
+}
+
+
+static void
+free_batches(struct glthread_batch *batch)
+{
+   while (batch != NULL) {
+      struct glthread_batch *next = batch->next;
+      free(batch);
+      batch = next;
+   }
+}
+
+
+/**
+ * Start the driver thread of a context and switch the calling thread to
+ * the marshalling dispatch table.  Does nothing unless MESA_GLTHREAD is
+ * set, or if any resource cannot be allocated.
+ */
+void
+_mesa_glthread_init(struct gl_context *ctx)
+{
+   struct glthread_state *glthread;
+   const char *env = _mesa_getenv("MESA_GLTHREAD");
+   unsigned i;
+
+   if (ctx->GLThread != NULL || env == NULL ||
+       (strcmp(env, "true") != 0 && strcmp(env, "1") != 0))
+      return;
+
+   glthread = calloc(1, sizeof(*glthread));
+   if (glthread == NULL)
+      return;
+
+   /* One batch is being recorded while the others are queued. */
+   for (i = 0; i < MARSHAL_MAX_BATCHES + 1; i++) {
+      struct glthread_batch *batch = malloc(sizeof(*batch));
+      if (batch == NULL) {
+         free_batches(glthread->free_batches);
+         free(glthread);
+         return;
+      }
+
+      batch->next = glthread->free_batches;
+      glthread->free_batches = batch;
+   }
+
+   glthread->vaos = _mesa_NewHashTable();
+   if (glthread->vaos == NULL) {
+      free_batches(glthread->free_batches);
+      free(glthread);
+      return;
+   }
+
+   ctx->MarshalExec = _mesa_create_marshal_table();
+   if (ctx->MarshalExec == NULL) {
+      _mesa_DeleteHashTable(glthread->vaos);
+      free_batches(glthread->free_batches);
+      free(glthread);
+      return;
+   }
+
+   glthread->batch = glthread->free_batches;
+   glthread->free_batches = glthread->batch->next;
+   glthread->batch->used = 0;
+   glthread->batch_queue_tail = &glthread->batch_queue;
+
+   pthread_mutex_init(&glthread->mutex, NULL);
+   pthread_cond_init(&glthread->new_work, NULL);
+   pthread_cond_init(&glthread->work_done, NULL);
+
+   ctx->GLThread = glthread;
+   read_client_state(ctx);
+
+   if (pthread_create(&glthread->thread, NULL, glthread_worker, ctx) != 0) {
+      ctx->GLThread = NULL;
+      pthread_mutex_destroy(&glthread->mutex);
+      pthread_cond_destroy(&glthread->new_work);
+      pthread_cond_destroy(&glthread->work_done);
+      _mesa_HashDeleteAll(glthread->vaos, free_vao, NULL);
+      _mesa_DeleteHashTable(glthread->vaos);
+      free(glthread->batch);
+      free_batches(glthread->free_batches);
+      free(glthread);
+      free(ctx->MarshalExec);
+      ctx->MarshalExec = NULL;
+      return;
+   }
+
+   _glapi_check_multithread();
+   _glapi_set_dispatch(ctx->MarshalExec);
+}
+
+
+/**
+ * Wait for all pending commands and stop the driver thread.
+ */
+void
+_mesa_glthread_destroy(struct gl_context *ctx)
+{
+   struct glthread_state *glthread = ctx->GLThread;
+
+   if (glthread == NULL)
+      return;
+
+   _mesa_glthread_finish(ctx);
+
+   pthread_mutex_lock(&glthread->mutex);
+   glthread->shutdown = true;
+   pthread_cond_signal(&glthread->new_work);
+   pthread_mutex_unlock(&glthread->mutex);
+
+   pthread_join(glthread->thread, NULL);
+
+   pthread_mutex_destroy(&glthread->mutex);
+   pthread_cond_destroy(&glthread->new_work);
+   pthread_cond_destroy(&glthread->work_done);
+
+   _mesa_HashDeleteAll(glthread->vaos, free_vao, NULL);
+   _mesa_DeleteHashTable(glthread->vaos);
+   free(glthread->batch);
+   free_batches(glthread->free_batches);
+   free(glthread);
+   ctx->GLThread = NULL;
+
+   if (_mesa_get_current_context() == ctx)
+      _glapi_set_dispatch(ctx->CurrentDispatch);
+
+   free(ctx->MarshalExec);
+   ctx->MarshalExec = NULL;
+}
+
+
+/**
+ * Hand the batch being recorded over to the driver thread.
+ */
+void
+_mesa_glthread_flush_batch(struct gl_context *ctx)
+{
+   struct glthread_state *glthread = ctx->GLThread;
+   struct glthread_batch *batch;
+
+   if (glthread == NULL || glthread->batch->used == 0)
+      return;
+
+   batch = glthread->batch;
+
+   pthread_mutex_lock(&glthread->mutex);
+
+   while (glthread->num_pending >= MARSHAL_MAX_BATCHES)
+      pthread_cond_wait(&glthread->work_done, &glthread->mutex);
+
+   batch->next = NULL;
+   *glthread->batch_queue_tail = batch;
+   glthread->batch_queue_tail = &batch->next;
+   glthread->num_pending++;
+   pthread_cond_signal(&glthread->new_work);
+
+   /* There are MARSHAL_MAX_BATCHES + 1 batches, so at least one is free. */
+   glthread->batch = glthread->free_batches;
+   glthread->free_batches = glthread->batch->next;
+   glthread->batch->used = 0;
+
+   pthread_mutex_unlock(&glthread->mutex);
+}
+
+
+/**
+ * Wait until the driver thread has executed every recorded command.
+ *
+ * Called before anything that needs the context state to be current, such
+ * as synchronous GL calls, MakeCurrent and buffer swaps.  Calls from the
+ * driver thread itself return immediately.
+ */
+void
+_mesa_glthread_finish(struct gl_context *ctx)
+{
+   struct glthread_state *glthread = ctx->GLThread;
+
+   if (glthread == NULL || pthread_equal(pthread_self(), glthread->thread))
+      return;
+
+   _mesa_glthread_flush_batch(ctx);
+
+   pthread_mutex_lock(&glthread->mutex);
+   while (glthread->num_pending > 0)
+      pthread_cond_wait(&glthread->work_done, &glthread->mutex);
+   pthread_mutex_unlock(&glthread->mutex);
+}
+
+#else /* HAVE_PTHREAD */
+
+void
+_mesa_glthread_init(struct gl_context *ctx)
+{
+}
+
+void
+_mesa_glthread_destroy(struct gl_context *ctx)
+{
+}
+
+void
+_mesa_glthread_flush_batch(struct gl_context *ctx)
+{
+}
+
+void
+_mesa_glthread_finish(struct gl_context *ctx)
+{
+}
+
+#endif /* HAVE_PTHREAD */
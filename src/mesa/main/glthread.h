@@ -0,0 +1,295 @@
+/*
+ * Copyright © 2013 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file glthread.h
+ * Threaded dispatch: GL calls made by the application are recorded into
+ * batches and executed by a separate driver thread.
+ */
+
+#ifndef MESA_GLTHREAD_H
+#define MESA_GLTHREAD_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "main/glheader.h"
+#include "main/context.h"
+#include "main/api_exec.h"
+#include "main/macros.h"
+#include "glapi/glapi.h"
+
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
+
+
+/** Size of a command batch, in bytes */
+#define MARSHAL_BATCH_SIZE (16 * 1024)
+
+/**
+ * Largest command, in bytes.  Calls whose arguments don't fit are executed
+ * synchronously instead.
+ */
+#define MARSHAL_MAX_CMD_SIZE (8 * 1024)
+
+/**
+ * Number of batches that may be queued for the driver thread before the
+ * application thread has to wait for it.
+ */
+#define MARSHAL_MAX_BATCHES 8
+
+
+/** Header of every command in a batch */
+struct marshal_cmd_base
+{
+   /** One of the marshal_dispatch_cmd_id values */
+   uint16_t cmd_id;
+
+   /** Size of the command in bytes, including this header */
+   uint16_t cmd_size;
+};
+
+
+struct glthread_batch
+{
+   struct glthread_batch *next;
+
+   /** Number of bytes of \c buffer in use */
+   size_t used;
+
+   uint64_t buffer[MARSHAL_BATCH_SIZE / 8];
+};
+
+
+/**
+ * Vertex array state of a vertex array object, as tracked by the
+ * application thread.
+ */
+struct glthread_vao
+{
+   /** Attributes whose array points to client memory */
+   GLbitfield64 user_arrays;
+
+   /** Name of the bound GL_ELEMENT_ARRAY_BUFFER */
+   GLuint element_array_buffer;
+};
+
+
+struct glthread_state
+{
+#ifdef HAVE_PTHREAD
+   pthread_t thread;
+
+   /** Protects everything below except \c batch */
+   pthread_mutex_t mutex;
+
+   /** Signaled when a batch is queued or on shutdown */
+   pthread_cond_t new_work;
+
+   /** Signaled when the driver thread is done with a batch */
+   pthread_cond_t work_done;
+#endif
+
+   /** Batches waiting for the driver thread, oldest first */
+   struct glthread_batch *batch_queue;
+   struct glthread_batch **batch_queue_tail;
+
+   /** Batches queued or being executed */
+   unsigned num_pending;
+
+   /** Batches available for recording */
+   struct glthread_batch *free_batches;
+
+   bool shutdown;
+
+   /** Batch being recorded by the application thread */
+   struct glthread_batch *batch;
+
+   /**
+    * \name Client state tracked by the application thread
+    *
+    * Decides whether draws can be queued and whether pointer arguments are
+    * buffer offsets or have to be copied.
+    */
+   /*@{*/
+   /** Vertex array objects by name, other than the default one */
+   struct _mesa_HashTable *vaos;
+   struct glthread_vao default_vao;
+   struct glthread_vao *current_vao;
+
+   GLuint array_buffer;
+   GLuint pixel_unpack_buffer;
+
+   /** Unit selected by glClientActiveTexture */
+   GLuint client_active_texture;
+   /*@}*/
+};
+
+
+extern void
+_mesa_glthread_init(struct gl_context *ctx);
+
+extern void
+_mesa_glthread_destroy(struct gl_context *ctx);
+
+extern void
+_mesa_glthread_flush_batch(struct gl_context *ctx);
+
+extern void
+_mesa_glthread_finish(struct gl_context *ctx);
+
+extern void
+_mesa_glthread_restore_client_state(struct gl_context *ctx);
+
+extern void
+_mesa_glthread_BindBuffer(struct gl_context *ctx, GLenum target,
+                          GLuint buffer);
+
+extern void
+_mesa_glthread_BindVertexArray(struct gl_context *ctx, GLuint array);
+
+extern void
+_mesa_glthread_DeleteVertexArrays(struct gl_context *ctx, GLsizei n,
+                                  const GLuint *arrays);
+
+extern void
+_mesa_glthread_ClientActiveTexture(struct gl_context *ctx, GLenum texture);
+
+extern void
+_mesa_glthread_InterleavedArrays(struct gl_context *ctx, GLenum format,
+                                 const GLvoid *pointer);
+
+extern size_t
+_mesa_glthread_map1_count(GLenum target, GLint stride, GLint order);
+
+extern size_t
+_mesa_glthread_map2_count(GLenum target, GLint ustride, GLint uorder,
+                          GLint vstride, GLint vorder);
+
+extern size_t
+_mesa_unmarshal_dispatch_cmd(struct gl_context *ctx, const void *cmd);
+
+extern struct _glapi_table *
+_mesa_create_marshal_table(void);
+
+
+/**
+ * Reserve room for a command in the current batch.
+ *
+ * \param size  size of the command structure, including its header
+ */
+static inline void *
+_mesa_glthread_allocate_command(struct gl_context *ctx, uint16_t cmd_id,
+                                size_t size)
+{
+   struct glthread_state *glthread = ctx->GLThread;
+   struct marshal_cmd_base *cmd_base;
+   const size_t aligned_size = ALIGN(size, 8);
+
+   if (glthread->batch->used + aligned_size > MARSHAL_BATCH_SIZE)
+      _mesa_glthread_flush_batch(ctx);
+
+   cmd_base = (struct marshal_cmd_base *)
+      ((char *) glthread->batch->buffer + glthread->batch->used);
+   glthread->batch->used += aligned_size;
+   cmd_base->cmd_id = cmd_id;
+   cmd_base->cmd_size = aligned_size;
+   return cmd_base;
+}
+
+
+
+/**
+ * Record whether the array of an attribute points to client memory, as
+ * the gl*Pointer functions do.
+ */
+static inline void
+_mesa_glthread_AttribPointer(struct gl_context *ctx, GLuint attrib,
+                             const GLvoid *pointer)
+{
+   struct glthread_state *glthread = ctx->GLThread;
+
+   if (glthread->array_buffer == 0 && pointer != NULL)
+      glthread->current_vao->user_arrays |= VERT_BIT(attrib);
+   else
+      glthread->current_vao->user_arrays &= ~VERT_BIT(attrib);
+}
+
+static inline void
+_mesa_glthread_GenericAttribPointer(struct gl_context *ctx, GLuint index,
+                                    const GLvoid *pointer)
+{
+   if (index < VERT_ATTRIB_GENERIC_MAX)
+      _mesa_glthread_AttribPointer(ctx, VERT_ATTRIB_GENERIC(index), pointer);
+}
+
+static inline void
+_mesa_glthread_TexCoordPointer(struct gl_context *ctx, const GLvoid *pointer)
+{
+   GLuint unit = ctx->GLThread->client_active_texture;
+
+   _mesa_glthread_AttribPointer(ctx, VERT_ATTRIB_TEX(unit), pointer);
+}
+
+static inline bool
+_mesa_glthread_has_user_arrays(const struct gl_context *ctx)
+{
+   return ctx->GLThread->current_vao->user_arrays != 0;
+}
+
+static inline bool
+_mesa_glthread_has_element_buffer(const struct gl_context *ctx)
+{
+   return ctx->GLThread->current_vao->element_array_buffer != 0;
+}
+
+static inline bool
+_mesa_glthread_has_unpack_buffer(const struct gl_context *ctx)
+{
+   return ctx->GLThread->pixel_unpack_buffer != 0;
+}
+
+/**
+ * Size of the client memory index data read by a glDrawElements call, or
+ * 0 if it's invalid or too large to be copied into a command.
+ */
+static inline size_t
+_mesa_glthread_index_data_size(GLenum type, GLsizei count)
+{
+   if (count <= 0 || count > MARSHAL_MAX_CMD_SIZE)
+      return 0;
+
+   switch (type) {
+   case GL_UNSIGNED_BYTE:
+      return count;
+   case GL_UNSIGNED_SHORT:
+      return count * sizeof(GLushort);
+   case GL_UNSIGNED_INT:
+      return count * sizeof(GLuint);
+   default:
+      return 0;
+   }
+}
+
+#endif /* MESA_GLTHREAD_H */
@@ -54,6 +54,45 @@
  */
 #define DELETED_KEY_VALUE 1
 
+/**
+ * Lock-free lookups.
+ *
+ * Every bind and draw looks objects up in the tables of the shared state,
+ * so with several contexts sharing objects the table mutex becomes a
+ * point of contention.  Since glGen*() hands out small contiguous names,
+ * we mirror the entries for keys below DIRECT_MAX_KEY in a flat array
+ * that _mesa_HashLookup() reads without taking the mutex.
+ *
+ * Writers still serialize on the mutex and update both the hash table and
+ * the array.  When the array has to grow, a new one is published and the
+ * old one is kept around until the table is destroyed, because a reader
+ * may still be looking at it.  Such a reader sees the entry as it was just
+ * before the array was replaced, which is no different from having done
+ * the lookup a moment earlier.  The arrays grow by doubling, so the
+ * retired ones never add up to more than the current one.
+ */
+#if !defined(THREADS)
+/* Single-threaded build, plain loads and stores are enough. */
+#define HASH_LOCKLESS_LOOKUP 1
+#define direct_load(p)       (*(p))
+#define direct_store(p, v)   (*(p) = (v))
+#elif defined(__clang__) || \
+      (defined(__GNUC__) && (__GNUC__ > 4 || \
+                             (__GNUC__ == 4 && __GNUC_MINOR__ >= 7)))
+#define HASH_LOCKLESS_LOOKUP 1
+#define direct_load(p)       __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define direct_store(p, v)   __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#endif
+
+#define DIRECT_MIN_SIZE 64
+#define DIRECT_MAX_KEY (64 * 1024)
+
+struct hash_direct {
+   GLuint Size;                   /**< number of keys covered */
+   struct hash_direct *Retired;   /**< previous, smaller array */
+   void *Data[1];                 /**< really Data[Size] */
+};
+
 /**
  * The hash table data structure.  
  */
@@ -65,6 +104,8 @@ struct _mesa_HashTable {
    GLboolean InDeleteAll;                /**< Debug check */
    /** Value that would be in the table for DELETED_KEY_VALUE. */
    void *deleted_key_data;
+   /** Mirror of the entries for small keys, read without locking. */
+   struct hash_direct *Direct;
 };
 
 /** @{
@@ -145,6 +186,12 @@ _mesa_DeleteHashTable(struct _mesa_HashTable *table)
 
    _mesa_hash_table_destroy(table->ht, NULL);
 
+   while (table->Direct) {
+      struct hash_direct *retired = table->Direct->Retired;
+      free(table->Direct);
+      table->Direct = retired;
+   }
+
    _glthread_DESTROY_MUTEX(table->Mutex);
    _glthread_DESTROY_MUTEX(table->WalkMutex);
    free(table);
@@ -187,7 +234,18 @@ void *
 _mesa_HashLookup(struct _mesa_HashTable *table, GLuint key)
 {
    void *res;
+#ifdef HASH_LOCKLESS_LOOKUP
+   const struct hash_direct *direct;
+#endif
+
    assert(table);
+
+#ifdef HASH_LOCKLESS_LOOKUP
+   direct = direct_load(&table->Direct);
+   if (direct && key < direct->Size)
+      return direct_load(&direct->Data[key]);
+#endif
+
    _glthread_LOCK_MUTEX(table->Mutex);
    res = _mesa_HashLookup_unlocked(table, key);
    _glthread_UNLOCK_MUTEX(table->Mutex);
@@ -195,6 +253,71 @@ _mesa_HashLookup(struct _mesa_HashTable *table, GLuint key)
 }
 
 
+/**
+ * Make sure the lock-free lookup array covers \p key, if it is small
+ * enough to be mirrored there.  Called with the table mutex held.
+ */
+static void
+grow_direct(struct _mesa_HashTable *table, GLuint key)
+{
+#ifdef HASH_LOCKLESS_LOOKUP
+   struct hash_direct *old = table->Direct;
+   struct hash_direct *direct;
+   struct hash_entry *entry;
+   GLuint size = old ? old->Size : DIRECT_MIN_SIZE;
+
+   if (key >= DIRECT_MAX_KEY || (old && key < old->Size))
+      return;
+
+   while (size <= key)
+      size *= 2;
+
+   direct = calloc(1, sizeof(*direct) + (size - 1) * sizeof(void *));
+   if (!direct)
+      return; /* lookups of this key will just take the mutex */
+
+   direct->Size = size;
+   direct->Retired = old;
+
+   if (old) {
+      memcpy(direct->Data, old->Data, old->Size * sizeof(void *));
+      /* keys that used to be out of range only exist in the hash table */
+      hash_table_foreach(table->ht, entry) {
+         GLuint k = (GLuint) (uintptr_t) entry->key;
+         if (k >= old->Size && k < size)
+            direct->Data[k] = entry->data;
+      }
+   }
+   else {
+      hash_table_foreach(table->ht, entry) {
+         GLuint k = (GLuint) (uintptr_t) entry->key;
+         if (k < size)
+            direct->Data[k] = entry->data;
+      }
+      direct->Data[DELETED_KEY_VALUE] = table->deleted_key_data;
+   }
+
+   direct_store(&table->Direct, direct);
+#endif
+}
+
+
+/**
+ * Update the lock-free lookup array after \p key changed.  Called with
+ * the table mutex held.
+ */
+static inline void
+set_direct(struct _mesa_HashTable *table, GLuint key, void *data)
+{
+#ifdef HASH_LOCKLESS_LOOKUP
+   struct hash_direct *direct = table->Direct;
+
+   if (direct && key < direct->Size)
+      direct_store(&direct->Data[key], data);
+#endif
+}
+
+
 /**
  * Insert a key/pointer pair into the hash table.  
  * If an entry with this key already exists we'll replace the existing entry.
@@ -217,6 +340,8 @@ _mesa_HashInsert(struct _mesa_HashTable *table, GLuint key, void *data)
    if (key > table->MaxKey)
       table->MaxKey = key;
 
+   grow_direct(table, key);
+
    if (key == DELETED_KEY_VALUE) {
       table->deleted_key_data = data;
    } else {
@@ -228,6 +353,8 @@ _mesa_HashInsert(struct _mesa_HashTable *table, GLuint key, void *data)
       }
    }
 
+   set_direct(table, key, data);
+
    _glthread_UNLOCK_MUTEX(table->Mutex);
 }
 
@@ -264,6 +391,7 @@ _mesa_HashRemove(struct _mesa_HashTable *table, GLuint key)
       entry = _mesa_hash_table_search(table->ht, uint_hash(key), uint_key(key));
       _mesa_hash_table_remove(table->ht, entry);
    }
+   set_direct(table, key, NULL);
    _glthread_UNLOCK_MUTEX(table->Mutex);
 }
 
@@ -290,10 +418,12 @@ _mesa_HashDeleteAll(struct _mesa_HashTable *table,
    _glthread_LOCK_MUTEX(table->Mutex);
    table->InDeleteAll = GL_TRUE;
    hash_table_foreach(table->ht, entry) {
+      set_direct(table, (uintptr_t)entry->key, NULL);
       callback((uintptr_t)entry->key, entry->data, userData);
       _mesa_hash_table_remove(table->ht, entry);
    }
    if (table->deleted_key_data) {
+      set_direct(table, DELETED_KEY_VALUE, NULL);
       callback(DELETED_KEY_VALUE, table->deleted_key_data, userData);
       table->deleted_key_data = NULL;
    }
@@ -40,6 +40,12 @@
 #include "macros.h"
 #include "../../gallium/auxiliary/util/u_format_rgb9e5.h"
 #include "../../gallium/auxiliary/util/u_format_r11g11b10f.h"
+#include "../../gallium/auxiliary/util/u_box_filter.h"
+
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#include <unistd.h>
+#endif
 
 
 
@@ -161,7 +167,13 @@ do_row(GLenum datatype, GLuint comps, GLint srcWidth,
    assert(srcWidth == dstWidth || srcWidth == 2 * dstWidth);
    */
 
-   if (datatype == GL_UNSIGNED_BYTE && comps == 4) {
+   if (datatype == GL_UNSIGNED_BYTE && comps == 4 && k0 == 1) {
+      util_box_filter_row_4ub(srcRowA, srcRowB, dstWidth, dstRow);
+   }
+   else if (datatype == GL_UNSIGNED_BYTE && comps == 1 && k0 == 1) {
+      util_box_filter_row_1ub(srcRowA, srcRowB, dstWidth, dstRow);
+   }
+   else if (datatype == GL_UNSIGNED_BYTE && comps == 4) {
       GLuint i, j, k;
       const GLubyte(*rowA)[4] = (const GLubyte(*)[4]) srcRowA;
       const GLubyte(*rowB)[4] = (const GLubyte(*)[4]) srcRowB;
@@ -1442,6 +1454,128 @@ make_1d_mipmap(GLenum datatype, GLuint comps, GLint border,
 }
 
 
+/**
+ * A band of destination rows for make_2d_mipmap(), each one averaged from
+ * one or two source rows.
+ */
+struct mipmap_rows
+{
+   GLenum datatype;
+   GLuint comps;
+   GLint srcWidth;
+   const GLubyte *srcA, *srcB;
+   GLint srcRowStride;  /**< source step per destination row */
+   GLint dstWidth;
+   GLubyte *dst;
+   GLint dstRowStride;
+   GLint count;
+};
+
+
+/**
+ * Levels with at least this many bytes are filtered on several threads.
+ * Smaller ones aren't worth the cost of starting them.
+ */
+#define MIPMAP_THREAD_MIN_BYTES (256 * 1024)
+
+#define MIPMAP_MAX_THREADS 8
+
+
+static void
+do_rows(const struct mipmap_rows *rows)
+{
+   const GLubyte *srcA = rows->srcA, *srcB = rows->srcB;
+   GLubyte *dst = rows->dst;
+   GLint row;
+
+   for (row = 0; row < rows->count; row++) {
+      do_row(rows->datatype, rows->comps, rows->srcWidth, srcA, srcB,
+             rows->dstWidth, dst);
+      srcA += rows->srcRowStride;
+      srcB += rows->srcRowStride;
+      dst += rows->dstRowStride;
+   }
+}
+
+
+#ifdef HAVE_PTHREAD
+
+static void *
+do_rows_thread(void *data)
+{
+   do_rows((const struct mipmap_rows *) data);
+   return NULL;
+}
+
+
+static int
+mipmap_thread_count(void)
+{
+   static int count = 0;
+
+   if (count == 0) {
+      long n = sysconf(_SC_NPROCESSORS_ONLN);
+      count = (int) CLAMP(n, 1, MIPMAP_MAX_THREADS);
+   }
+   return count;
+}
+
+
+/**
+ * Split the rows into bands and filter them in parallel.  The calling
+ * thread does the last band itself.
+ */
+static void
+do_rows_threaded(const struct mipmap_rows *rows)
+{
+   struct mipmap_rows bands[MIPMAP_MAX_THREADS];
+   pthread_t threads[MIPMAP_MAX_THREADS];
+   GLboolean started[MIPMAP_MAX_THREADS];
+   const GLint numBands = MIN2(mipmap_thread_count(), rows->count);
+   GLint i, first = 0;
+
+   if (numBands <= 1) {
+      do_rows(rows);
+      return;
+   }
+
+   for (i = 0; i < numBands; i++) {
+      const GLint last = rows->count * (i + 1) / numBands;
+
+      bands[i] = *rows;
+      bands[i].srcA += first * rows->srcRowStride;
+      bands[i].srcB += first * rows->srcRowStride;
+      bands[i].dst += first * rows->dstRowStride;
+      bands[i].count = last - first;
+      first = last;
+   }
+
+   for (i = 0; i < numBands - 1; i++) {
+      started[i] = pthread_create(&threads[i], NULL, do_rows_thread,
+                                  &bands[i]) == 0;
+      if (!started[i])
+         do_rows(&bands[i]);
+   }
+
+   do_rows(&bands[numBands - 1]);
+
+   for (i = 0; i < numBands - 1; i++) {
+      if (started[i])
+         pthread_join(threads[i], NULL);
+   }
+}
+
+#else
+
+static void
+do_rows_threaded(const struct mipmap_rows *rows)
+{
+   do_rows(rows);
+}
+
+#endif
+
+
 static void
 make_2d_mipmap(GLenum datatype, GLuint comps, GLint border,
                GLint srcWidth, GLint srcHeight,
@@ -1472,12 +1606,24 @@ make_2d_mipmap(GLenum datatype, GLuint comps, GLint border,
 
    dst = dstPtr + border * ((dstWidth + 1) * bpt);
 
-   for (row = 0; row < dstHeightNB; row++) {
-      do_row(datatype, comps, srcWidthNB, srcA, srcB,
-             dstWidthNB, dst);
-      srcA += srcRowStep * srcRowStride;
-      srcB += srcRowStep * srcRowStride;
-      dst += dstRowStride;
+   {
+      struct mipmap_rows rows;
+
+      rows.datatype = datatype;
+      rows.comps = comps;
+      rows.srcWidth = srcWidthNB;
+      rows.srcA = srcA;
+      rows.srcB = srcB;
+      rows.srcRowStride = srcRowStep * srcRowStride;
+      rows.dstWidth = dstWidthNB;
+      rows.dst = dst;
+      rows.dstRowStride = dstRowStride;
+      rows.count = dstHeightNB;
+
+      if (dstWidthNB * dstHeightNB * bpt >= MIPMAP_THREAD_MIN_BYTES)
+         do_rows_threaded(&rows);
+      else
+         do_rows(&rows);
    }
 
    /* This is ugly but probably won't be used much */
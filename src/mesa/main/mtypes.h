@@ -76,6 +76,7 @@ struct gl_program_cache;
 struct gl_texture_object;
 struct gl_context;
 struct st_context;
+struct glthread_state;
 struct gl_uniform_storage;
 struct prog_instruction;
 struct gl_program_parameter_list;
@@ -1410,6 +1411,8 @@ struct gl_buffer_object
    GLenum Usage;        /**< GL_STREAM_DRAW_ARB, GL_STREAM_READ_ARB, etc. */
    GLsizeiptrARB Size;  /**< Size of buffer storage in bytes */
    GLubyte *Data;       /**< Location of storage either in RAM or VRAM. */
+   GLbitfield StorageFlags; /**< GL_MAP_PERSISTENT_BIT, etc. */
+   GLboolean Immutable; /**< GL_ARB_buffer_storage */
    /** Fields describing a mapped buffer */
    /*@{*/
    GLbitfield AccessFlags; /**< Mask of GL_MAP_x_BIT flags */
@@ -2501,6 +2504,12 @@ struct gl_shared_state
    _glthread_Mutex Mutex;		   /**< for thread safety */
    GLint RefCount;			   /**< Reference count */
    struct _mesa_HashTable *DisplayList;	   /**< Display lists hash table */
+   /**
+    * Incremented whenever a display list is deleted or replaced, so lists
+    * calling other lists know whether the pointers they resolved at
+    * compile time are still good.
+    */
+   GLuint DisplayListGeneration;
    struct _mesa_HashTable *TexObjects;	   /**< Texture objects hash table */
 
    /** Default texture objects (shared by all texture units) */
@@ -2952,6 +2961,7 @@ struct gl_extensions
    GLboolean ARB_ES3_compatibility;
    GLboolean ARB_base_instance;
    GLboolean ARB_blend_func_extended;
+   GLboolean ARB_buffer_storage;
    GLboolean ARB_color_buffer_float;
    GLboolean ARB_conservative_depth;
    GLboolean ARB_depth_buffer_float;
@@ -2959,6 +2969,7 @@ struct gl_extensions
    GLboolean ARB_depth_texture;
    GLboolean ARB_draw_buffers_blend;
    GLboolean ARB_draw_elements_base_vertex;
+   GLboolean ARB_draw_indirect;
    GLboolean ARB_draw_instanced;
    GLboolean ARB_fragment_coord_conventions;
    GLboolean ARB_fragment_program;
@@ -2973,6 +2984,7 @@ struct gl_extensions
    GLboolean ARB_internalformat_query;
    GLboolean ARB_map_buffer_alignment;
    GLboolean ARB_map_buffer_range;
+   GLboolean ARB_multi_draw_indirect;
    GLboolean ARB_occlusion_query;
    GLboolean ARB_occlusion_query2;
    GLboolean ARB_point_sprite;
@@ -3231,6 +3243,14 @@ struct gl_dlist_state
        * list.  Used to eliminate some redundant state changes.
        */
       GLenum ShadeModel;
+      GLenum MatrixMode;
+      GLenum FrontFace;
+      GLenum CullFace;
+      GLenum DepthFunc;
+      GLfloat LineWidth;
+      GLfloat PointSize;
+      GLbitfield EnableKnown;  /**< caps whose enable state is known */
+      GLbitfield Enabled;      /**< caps known to be enabled */
    } Current;
 };
 
@@ -3337,6 +3357,13 @@ struct gl_driver_flags
 
    /** gl_context::RasterDiscard */
    GLbitfield NewRasterizerDiscard;
+
+   /**
+    * GLSL uniforms used by a shader stage, indexed by gl_shader_type.
+    * When set, glUniform only flags the stages that use the uniform
+    * instead of _NEW_PROGRAM_CONSTANTS.
+    */
+   GLbitfield NewShaderConstants[MESA_SHADER_TYPES];
 };
 
 struct gl_uniform_buffer_binding
@@ -3393,8 +3420,17 @@ struct gl_context
     * re-set on glXMakeCurrent().
     */
    struct _glapi_table *CurrentDispatch;
+   /**
+    * The dispatch table installed on the application thread when the
+    * threaded dispatch is enabled.  Its functions queue commands for
+    * \c GLThread, which runs them through \c CurrentDispatch.
+    */
+   struct _glapi_table *MarshalExec;
    /*@}*/
 
+   /** Threaded dispatch state, NULL unless MESA_GLTHREAD is set */
+   struct glthread_state *GLThread;
+
    struct gl_config Visual;
    struct gl_framebuffer *DrawBuffer;	/**< buffer for writing */
    struct gl_framebuffer *ReadBuffer;	/**< buffer for reading */
@@ -3506,6 +3542,8 @@ struct gl_context
    struct gl_buffer_object *CopyReadBuffer; /**< GL_ARB_copy_buffer */
    struct gl_buffer_object *CopyWriteBuffer; /**< GL_ARB_copy_buffer */
 
+   struct gl_buffer_object *DrawIndirectBuffer; /**< GL_ARB_draw_indirect */
+
    /**
     * Current GL_ARB_uniform_buffer_object binding referenced by
     * GL_UNIFORM_BUFFER target for glBufferData, glMapBuffer, etc.
@@ -6103,3 +6103,109 @@ _mesa_rebase_rgba_uint(GLuint n, GLuint rgba[][4], GLenum baseFormat)
 }
 
 
+/**
+ * 32-bit RGBA8 formats, seen as packed 32-bit words, come in two families
+ * in which the formats only differ by the position of the R and B bytes
+ * and by whether the alpha byte is used.  Converting between members of
+ * the same family is a byte swap within the word plus forcing alpha to
+ * one, which _mesa_swizzle_rgba8_row() does without going through float.
+ */
+static const struct {
+   gl_format rgba, bgra;   /* the formats with alpha */
+   gl_format rgbx, bgrx;   /* the formats with an unused alpha byte */
+   GLuint swapMask;        /* low byte of the R/B pair */
+   GLuint alphaMask;
+} rgba8_families[] = {
+   { MESA_FORMAT_RGBA8888_REV, MESA_FORMAT_ARGB8888,
+     MESA_FORMAT_RGBX8888_REV, MESA_FORMAT_XRGB8888,
+     0x000000ff, 0xff000000 },
+   { MESA_FORMAT_RGBA8888, MESA_FORMAT_ARGB8888_REV,
+     MESA_FORMAT_RGBX8888, MESA_FORMAT_XRGB8888_REV,
+     0x0000ff00, 0x000000ff },
+};
+
+
+/**
+ * Check if reading pixels of \p srcFormat back as \p format / \p type can
+ * be done with _mesa_swizzle_rgba8_row(), and get the masks for it.
+ *
+ * \param srcBaseFormat  the base format the user asked for, which may
+ *                       have dropped the alpha channel of \p srcFormat
+ */
+GLboolean
+_mesa_get_rgba8_swizzle(gl_format srcFormat, GLenum srcBaseFormat,
+                        GLenum format, GLenum type, GLboolean swapBytes,
+                        GLuint *swapMask, GLuint *setMask)
+{
+   GLuint i;
+
+   if (srcBaseFormat != GL_RGBA && srcBaseFormat != GL_RGB)
+      return GL_FALSE;
+
+   for (i = 0; i < Elements(rgba8_families); i++) {
+      GLboolean srcRGB, srcX, dstRGB;
+
+      if (srcFormat == rgba8_families[i].rgba ||
+          srcFormat == rgba8_families[i].rgbx)
+         srcRGB = GL_TRUE;
+      else if (srcFormat == rgba8_families[i].bgra ||
+               srcFormat == rgba8_families[i].bgrx)
+         srcRGB = GL_FALSE;
+      else
+         continue;
+
+      if (_mesa_format_matches_format_and_type(rgba8_families[i].rgba,
+                                               format, type, swapBytes))
+         dstRGB = GL_TRUE;
+      else if (_mesa_format_matches_format_and_type(rgba8_families[i].bgra,
+                                                    format, type, swapBytes))
+         dstRGB = GL_FALSE;
+      else
+         return GL_FALSE;
+
+      srcX = srcFormat == rgba8_families[i].rgbx ||
+             srcFormat == rgba8_families[i].bgrx;
+
+      *swapMask = srcRGB != dstRGB ? rgba8_families[i].swapMask : 0;
+      *setMask = srcX || srcBaseFormat == GL_RGB ?
+                 rgba8_families[i].alphaMask : 0;
+      return GL_TRUE;
+   }
+
+   return GL_FALSE;
+}
+
+
+/**
+ * Convert a row of \p n 32-bit pixels using the masks returned by
+ * _mesa_get_rgba8_swizzle().
+ *
+ * Two pixels are handled at a time in a 64-bit word.  The masks are the
+ * same for both halves, so this works the same on either endianness.
+ */
+void
+_mesa_swizzle_rgba8_row(GLuint n, const GLubyte *src, GLubyte *dst,
+                        GLuint swapMask, GLuint setMask)
+{
+   const uint64_t lo = swapMask | ((uint64_t) swapMask << 32);
+   const uint64_t keep = ~(lo | (lo << 16));
+   const uint64_t set = setMask | ((uint64_t) setMask << 32);
+   GLuint i;
+
+   for (i = 0; i + 2 <= n; i += 2) {
+      uint64_t p;
+
+      memcpy(&p, src + i * 4, 8);
+      p = (p & keep) | ((p >> 16) & lo) | ((p & lo) << 16) | set;
+      memcpy(dst + i * 4, &p, 8);
+   }
+
+   if (i < n) {
+      GLuint p;
+
+      memcpy(&p, src + i * 4, 4);
+      p = (p & (GLuint) keep) | ((p >> 16) & swapMask) |
+          ((p & swapMask) << 16) | setMask;
+      memcpy(dst + i * 4, &p, 4);
+   }
+}
@@ -163,4 +163,13 @@ _mesa_rebase_rgba_float(GLuint n, GLfloat rgba[][4], GLenum baseFormat);
 extern void
 _mesa_rebase_rgba_uint(GLuint n, GLuint rgba[][4], GLenum baseFormat);
 
+extern GLboolean
+_mesa_get_rgba8_swizzle(gl_format srcFormat, GLenum srcBaseFormat,
+                        GLenum format, GLenum type, GLboolean swapBytes,
+                        GLuint *swapMask, GLuint *setMask);
+
+extern void
+_mesa_swizzle_rgba8_row(GLuint n, const GLubyte *src, GLubyte *dst,
+                        GLuint swapMask, GLuint setMask);
+
 #endif
@@ -0,0 +1,145 @@
+/*
+ * Copyright © 2013 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/**
+ * Several threads looking up objects in a shared _mesa_HashTable while
+ * another one keeps inserting and removing entries, the way contexts
+ * sharing objects use the tables in gl_shared_state.
+ *
+ * Checks that a lookup only ever returns NULL or the right object, and
+ * prints the lookup rate so changes to the locking can be compared.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <assert.h>
+#include <sys/time.h>
+#include "hash.h"
+
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+
+#define NUM_READERS 8
+#define NUM_KEYS 1024
+#define NUM_LOOKUPS (4 * 1024 * 1024)
+
+static struct _mesa_HashTable *table;
+static GLuint objects[2 * NUM_KEYS];
+static volatile int readers_done;
+
+static void *
+reader(void *data)
+{
+   GLuint seed = (GLuint) (uintptr_t) data;
+   int i;
+
+   for (i = 0; i < NUM_LOOKUPS; i++) {
+      GLuint key;
+      GLuint *obj;
+
+      seed = seed * 1103515245 + 12345;
+      key = 1 + (seed >> 8) % (2 * NUM_KEYS - 1);
+
+      obj = _mesa_HashLookup(table, key);
+      if (obj && *obj != key) {
+         fprintf(stderr, "lookup of %u returned %u\n", key, *obj);
+         abort();
+      }
+   }
+
+   return NULL;
+}
+
+static void *
+writer(void *data)
+{
+   GLuint key = NUM_KEYS;
+
+   (void) data;
+
+   /* Keep the upper half of the key space changing, which also makes the
+    * table grow while the readers are running.
+    */
+   while (!readers_done) {
+      _mesa_HashInsert(table, key, &objects[key]);
+      _mesa_HashRemove(table, key);
+      if (++key == 2 * NUM_KEYS)
+         key = NUM_KEYS;
+   }
+
+   return NULL;
+}
+
+int
+main(int argc, char **argv)
+{
+   pthread_t readers[NUM_READERS], writer_thread;
+   struct timeval start, end;
+   double seconds;
+   GLuint i;
+
+   table = _mesa_NewHashTable();
+
+   for (i = 0; i < 2 * NUM_KEYS; i++)
+      objects[i] = i;
+   for (i = 1; i < NUM_KEYS; i++)
+      _mesa_HashInsert(table, i, &objects[i]);
+
+   gettimeofday(&start, NULL);
+
+   pthread_create(&writer_thread, NULL, writer, NULL);
+   for (i = 0; i < NUM_READERS; i++)
+      pthread_create(&readers[i], NULL, reader, (void *) (uintptr_t) (i + 1));
+
+   for (i = 0; i < NUM_READERS; i++)
+      pthread_join(readers[i], NULL);
+   readers_done = 1;
+   pthread_join(writer_thread, NULL);
+
+   gettimeofday(&end, NULL);
+
+   seconds = (end.tv_sec - start.tv_sec) + (end.tv_usec - start.tv_usec) / 1e6;
+   printf("%d threads: %.1f million lookups/s\n", NUM_READERS,
+          NUM_READERS * (double) NUM_LOOKUPS / seconds / 1e6);
+
+   /* Every key that was inserted once and never removed is still there. */
+   for (i = 1; i < NUM_KEYS; i++)
+      assert(_mesa_HashLookup(table, i) == &objects[i]);
+
+   for (i = 1; i < NUM_KEYS; i++)
+      _mesa_HashRemove(table, i);
+   _mesa_DeleteHashTable(table);
+
+   return 0;
+}
+
+#else
+
+int
+main(int argc, char **argv)
+{
+   /* tell automake to skip this test */
+   return 77;
+}
+
+#endif
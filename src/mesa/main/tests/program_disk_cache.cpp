@@ -0,0 +1,241 @@
+/*
+ * Mesa 3-D graphics library
+ *
+ * Copyright (C) 2013  VMware, Inc.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+extern "C" {
+#include "main/glheader.h"
+#include "main/imports.h"
+#include "main/mtypes.h"
+#include "program/prog_diskcache.h"
+#include "program/prog_instruction.h"
+#include "program/prog_parameter.h"
+#include "program/program.h"
+}
+
+class ProgramDiskCache : public ::testing::Test {
+public:
+   virtual void SetUp();
+   virtual void TearDown();
+
+   void corrupt_cache_file(bool truncate);
+   struct gl_program *make_program();
+
+   char dir[64];
+   struct gl_context ctx;
+};
+
+void
+ProgramDiskCache::SetUp()
+{
+   strcpy(dir, "/tmp/mesa-program-cache-XXXXXX");
+   ASSERT_TRUE(mkdtemp(dir) != NULL);
+   setenv("MESA_PROGRAM_CACHE_DIR", dir, 1);
+   unsetenv("MESA_PROGRAM_CACHE_DISABLE");
+
+   memset(&ctx, 0, sizeof(ctx));
+   ctx.Driver.NewProgram = _mesa_new_program;
+   ctx.Driver.DeleteProgram = _mesa_delete_program;
+}
+
+void
+ProgramDiskCache::TearDown()
+{
+   DIR *d = opendir(dir);
+   struct dirent *e;
+   char path[128];
+
+   while (d && (e = readdir(d)) != NULL) {
+      if (e->d_name[0] == '.')
+         continue;
+      snprintf(path, sizeof(path), "%s/%s", dir, e->d_name);
+      unlink(path);
+   }
+   if (d)
+      closedir(d);
+   rmdir(dir);
+   unsetenv("MESA_PROGRAM_CACHE_DIR");
+}
+
+/**
+ * Flip the last byte of the only file in the cache, or cut it short.
+ */
+void
+ProgramDiskCache::corrupt_cache_file(bool truncate)
+{
+   DIR *d = opendir(dir);
+   struct dirent *e;
+   char path[128];
+   FILE *f;
+   long size;
+   int c;
+
+   ASSERT_TRUE(d != NULL);
+   path[0] = '\0';
+   while ((e = readdir(d)) != NULL) {
+      if (e->d_name[0] != '.')
+         snprintf(path, sizeof(path), "%s/%s", dir, e->d_name);
+   }
+   closedir(d);
+   ASSERT_NE('\0', path[0]);
+
+   f = fopen(path, "r+b");
+   ASSERT_TRUE(f != NULL);
+   fseek(f, 0, SEEK_END);
+   size = ftell(f);
+   if (truncate) {
+      ASSERT_EQ(0, ftruncate(fileno(f), size - 1));
+   } else {
+      fseek(f, size - 1, SEEK_SET);
+      c = fgetc(f);
+      fseek(f, size - 1, SEEK_SET);
+      fputc(c ^ 0xff, f);
+   }
+   fclose(f);
+}
+
+struct gl_program *
+ProgramDiskCache::make_program()
+{
+   static const gl_constant_value values[4] = {
+      { 1.0f }, { 2.0f }, { 3.0f }, { 4.0f }
+   };
+   struct gl_program *prog =
+      ctx.Driver.NewProgram(&ctx, GL_VERTEX_PROGRAM_ARB, 0);
+   struct prog_instruction *inst = _mesa_alloc_instructions(2);
+
+   _mesa_init_instructions(inst, 2);
+   inst[0].Opcode = OPCODE_MOV;
+   inst[0].DstReg.File = PROGRAM_OUTPUT;
+   inst[0].DstReg.Index = VARYING_SLOT_POS;
+   inst[0].SrcReg[0].File = PROGRAM_CONSTANT;
+   inst[0].SrcReg[0].Index = 0;
+   inst[1].Opcode = OPCODE_END;
+
+   prog->Instructions = inst;
+   prog->NumInstructions = 2;
+   prog->OutputsWritten = BITFIELD64_BIT(VARYING_SLOT_POS);
+   prog->Parameters = _mesa_new_parameter_list();
+   _mesa_add_named_constant(prog->Parameters, "c", values, 4);
+   prog->NumParameters = 1;
+
+   return prog;
+}
+
+TEST_F(ProgramDiskCache, ProgramRoundTrip)
+{
+   static const GLuint key[3] = { 1, 2, 3 };
+   struct gl_program *prog = make_program();
+   struct gl_program *loaded;
+
+   _mesa_store_program_to_disk(key, sizeof(key), prog);
+   loaded = _mesa_load_program_from_disk(&ctx, GL_VERTEX_PROGRAM_ARB,
+                                         key, sizeof(key));
+   ASSERT_TRUE(loaded != NULL);
+
+   EXPECT_EQ(prog->OutputsWritten, loaded->OutputsWritten);
+   EXPECT_EQ(prog->NumParameters, loaded->NumParameters);
+   ASSERT_EQ(prog->NumInstructions, loaded->NumInstructions);
+   EXPECT_EQ(OPCODE_MOV, loaded->Instructions[0].Opcode);
+   EXPECT_EQ(PROGRAM_OUTPUT, loaded->Instructions[0].DstReg.File);
+   EXPECT_EQ(PROGRAM_CONSTANT, loaded->Instructions[0].SrcReg[0].File);
+   EXPECT_EQ(OPCODE_END, loaded->Instructions[1].Opcode);
+
+   ASSERT_EQ(1u, loaded->Parameters->NumParameters);
+   EXPECT_STREQ("c", loaded->Parameters->Parameters[0].Name);
+   EXPECT_EQ(PROGRAM_CONSTANT, loaded->Parameters->Parameters[0].Type);
+   EXPECT_EQ(0, memcmp(prog->Parameters->ParameterValues[0],
+                       loaded->Parameters->ParameterValues[0],
+                       sizeof(prog->Parameters->ParameterValues[0])));
+
+   _mesa_reference_program(&ctx, &prog, NULL);
+   _mesa_reference_program(&ctx, &loaded, NULL);
+}
+
+TEST_F(ProgramDiskCache, BlobRoundTrip)
+{
+   static const char key[] = "key";
+   static const char data[] = "some data";
+   GLuint size = 0;
+   char *loaded;
+
+   _mesa_store_blob_to_disk(GL_FRAGMENT_PROGRAM_ARB, key, sizeof(key),
+                            data, sizeof(data));
+   loaded = (char *) _mesa_load_blob_from_disk(GL_FRAGMENT_PROGRAM_ARB,
+                                               key, sizeof(key), &size);
+   ASSERT_TRUE(loaded != NULL);
+   EXPECT_EQ(sizeof(data), size);
+   EXPECT_STREQ(data, loaded);
+   free(loaded);
+}
+
+TEST_F(ProgramDiskCache, MismatchedKey)
+{
+   static const GLuint key[3] = { 1, 2, 3 };
+   static const GLuint other_key[3] = { 1, 2, 4 };
+   struct gl_program *prog = make_program();
+   GLuint size;
+
+   _mesa_store_program_to_disk(key, sizeof(key), prog);
+   _mesa_reference_program(&ctx, &prog, NULL);
+
+   EXPECT_TRUE(_mesa_load_program_from_disk(&ctx, GL_VERTEX_PROGRAM_ARB,
+                                            other_key,
+                                            sizeof(other_key)) == NULL);
+   EXPECT_TRUE(_mesa_load_program_from_disk(&ctx, GL_VERTEX_PROGRAM_ARB,
+                                            key, sizeof(key) - 1) == NULL);
+   EXPECT_TRUE(_mesa_load_blob_from_disk(GL_VERTEX_PROGRAM_ARB,
+                                         key, sizeof(key), &size) == NULL);
+}
+
+TEST_F(ProgramDiskCache, CorruptFile)
+{
+   static const char key[] = "key";
+   static const char data[] = "some data";
+   GLuint size;
+
+   _mesa_store_blob_to_disk(GL_FRAGMENT_PROGRAM_ARB, key, sizeof(key),
+                            data, sizeof(data));
+   corrupt_cache_file(false);
+   EXPECT_TRUE(_mesa_load_blob_from_disk(GL_FRAGMENT_PROGRAM_ARB,
+                                         key, sizeof(key), &size) == NULL);
+}
+
+TEST_F(ProgramDiskCache, TruncatedFile)
+{
+   static const GLuint key[3] = { 1, 2, 3 };
+   struct gl_program *prog = make_program();
+
+   _mesa_store_program_to_disk(key, sizeof(key), prog);
+   _mesa_reference_program(&ctx, &prog, NULL);
+
+   corrupt_cache_file(true);
+   EXPECT_TRUE(_mesa_load_program_from_disk(&ctx, GL_VERTEX_PROGRAM_ARB,
+                                            key, sizeof(key)) == NULL);
+}
@@ -0,0 +1,361 @@
+/*
+ * Copyright © 2013 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file register_allocate.cpp
+ * Checks the register allocator against a straightforward implementation
+ * of the same algorithm, on random interference graphs.
+ *
+ * The allocator simplifies the graph with a heap and, for large graphs,
+ * keeps a sparse adjacency set.  Both only change how fast the answer is
+ * found, so the registers it picks and the node it suggests to spill must
+ * be the same as those of the simple version below, which runs the pq
+ * test over all the nodes until nothing changes.
+ */
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <vector>
+
+extern "C" {
+#include "main/glheader.h"
+#include "program/register_allocate.h"
+#include "ralloc.h"
+}
+
+#define NO_REG ~0u
+
+namespace {
+
+/**
+ * Pseudo-random numbers that are the same on every platform.
+ */
+class random_source {
+public:
+   random_source(unsigned seed) : state(seed * 2654435761u + 1) {}
+
+   unsigned next(unsigned range)
+   {
+      state = state * 1103515245u + 12345u;
+      return (state >> 8) % range;
+   }
+
+private:
+   unsigned state;
+};
+
+/**
+ * Register set and interference graph, as passed to the allocator.
+ */
+struct reference_graph {
+   unsigned num_regs;
+   std::vector<std::vector<bool> > conflicts;
+   std::vector<std::vector<bool> > classes;
+   bool round_robin;
+
+   std::vector<unsigned> node_class;
+   std::vector<std::vector<unsigned> > adjacency;
+   std::vector<unsigned> reg;
+   std::vector<float> spill_cost;
+
+   std::vector<std::vector<unsigned> > q;
+   std::vector<unsigned> p;
+   std::vector<bool> in_stack;
+   std::vector<unsigned> stack;
+
+   void finalize();
+   bool pq_test(unsigned n);
+   bool simplify();
+   void optimistic_color();
+   bool select();
+   int best_spill_node();
+};
+
+void
+reference_graph::finalize()
+{
+   q.assign(classes.size(), std::vector<unsigned>(classes.size(), 0));
+   p.assign(classes.size(), 0);
+
+   for (unsigned b = 0; b < classes.size(); b++) {
+      for (unsigned r = 0; r < num_regs; r++)
+         p[b] += classes[b][r];
+
+      for (unsigned c = 0; c < classes.size(); c++) {
+         for (unsigned rc = 0; rc < num_regs; rc++) {
+            unsigned n = 0;
+
+            if (!classes[c][rc])
+               continue;
+            for (unsigned rb = 0; rb < num_regs; rb++)
+               n += conflicts[rc][rb] && classes[b][rb];
+            q[b][c] = std::max(q[b][c], n);
+         }
+      }
+   }
+}
+
+bool
+reference_graph::pq_test(unsigned n)
+{
+   unsigned total = 0;
+
+   for (unsigned i = 0; i < adjacency[n].size(); i++) {
+      unsigned n2 = adjacency[n][i];
+
+      if (!in_stack[n2])
+         total += q[node_class[n]][node_class[n2]];
+   }
+
+   return total < p[node_class[n]];
+}
+
+bool
+reference_graph::simplify()
+{
+   bool progress = true;
+
+   while (progress) {
+      progress = false;
+
+      for (int i = node_class.size() - 1; i >= 0; i--) {
+         if (in_stack[i] || reg[i] != NO_REG)
+            continue;
+
+         if (pq_test(i)) {
+            stack.push_back(i);
+            in_stack[i] = true;
+            progress = true;
+         }
+      }
+   }
+
+   for (unsigned i = 0; i < node_class.size(); i++) {
+      if (!in_stack[i])
+         return false;
+   }
+   return true;
+}
+
+void
+reference_graph::optimistic_color()
+{
+   for (unsigned i = 0; i < node_class.size(); i++) {
+      if (in_stack[i] || reg[i] != NO_REG)
+         continue;
+
+      stack.push_back(i);
+      in_stack[i] = true;
+   }
+}
+
+bool
+reference_graph::select()
+{
+   unsigned start_search_reg = 0;
+
+   while (!stack.empty()) {
+      unsigned n = stack.back();
+      unsigned ri, r = 0;
+
+      for (ri = 0; ri < num_regs; ri++) {
+         unsigned i;
+
+         r = (start_search_reg + ri) % num_regs;
+         if (!classes[node_class[n]][r])
+            continue;
+
+         for (i = 0; i < adjacency[n].size(); i++) {
+            unsigned n2 = adjacency[n][i];
+
+            if (!in_stack[n2] && reg[n2] != NO_REG && conflicts[r][reg[n2]])
+               break;
+         }
+         if (i == adjacency[n].size())
+            break;
+      }
+      if (ri == num_regs)
+         return false;
+
+      reg[n] = r;
+      in_stack[n] = false;
+      stack.pop_back();
+
+      if (round_robin)
+         start_search_reg = r + 1;
+   }
+
+   return true;
+}
+
+int
+reference_graph::best_spill_node()
+{
+   int best_node = -1;
+   float best_benefit = 0.0;
+
+   for (unsigned n = 0; n < node_class.size(); n++) {
+      float benefit = 0;
+
+      if (spill_cost[n] <= 0.0 || in_stack[n])
+         continue;
+
+      for (unsigned i = 0; i < adjacency[n].size(); i++) {
+         benefit += (float) q[node_class[n]][node_class[adjacency[n][i]]] /
+            p[node_class[n]];
+      }
+
+      if (benefit / spill_cost[n] > best_benefit) {
+         best_benefit = benefit / spill_cost[n];
+         best_node = n;
+      }
+   }
+
+   return best_node;
+}
+
+/**
+ * Builds the same random problem for the allocator and the reference,
+ * runs both, and compares the results.
+ *
+ * The registers are 64 scalars plus 63 pairs of neighbouring scalars.
+ * Nodes are a scalar twice as often as a pair, and each interferes with
+ * \p degree others on average, all within \p window nodes of it.
+ */
+void
+check_random_graph(unsigned seed, unsigned count, unsigned degree,
+                   unsigned window)
+{
+   random_source random(seed);
+   reference_graph ref;
+   unsigned i;
+
+   ref.num_regs = 64 + 63;
+   ref.conflicts.assign(ref.num_regs,
+                        std::vector<bool>(ref.num_regs, false));
+   ref.round_robin = seed & 1;
+
+   struct ra_regs *regs = ra_alloc_reg_set(NULL, ref.num_regs);
+   const unsigned scalar = ra_alloc_reg_class(regs);
+   const unsigned pair = ra_alloc_reg_class(regs);
+
+   ref.classes.assign(2, std::vector<bool>(ref.num_regs, false));
+   for (i = 0; i < ref.num_regs; i++)
+      ref.conflicts[i][i] = true;
+   for (i = 0; i < 64; i++) {
+      ra_class_add_reg(regs, scalar, i);
+      ref.classes[scalar][i] = true;
+   }
+   for (i = 0; i < 63; i++) {
+      ra_class_add_reg(regs, pair, 64 + i);
+      ref.classes[pair][64 + i] = true;
+      ra_add_transitive_reg_conflict(regs, i, 64 + i);
+      ra_add_transitive_reg_conflict(regs, i + 1, 64 + i);
+   }
+   /* The same conflicts, transitively closed over the scalars. */
+   for (i = 0; i < 63; i++) {
+      for (unsigned j = 0; j < 63; j++) {
+         if (j + 1 >= i && j <= i + 1) {
+            ref.conflicts[64 + i][64 + j] = true;
+         }
+      }
+      ref.conflicts[64 + i][i] = ref.conflicts[i][64 + i] = true;
+      ref.conflicts[64 + i][i + 1] = ref.conflicts[i + 1][64 + i] = true;
+   }
+   if (ref.round_robin)
+      ra_set_allocate_round_robin(regs);
+   ra_set_finalize(regs, NULL);
+   ref.finalize();
+
+   struct ra_graph *g = ra_alloc_interference_graph(regs, count);
+
+   ref.node_class.resize(count);
+   ref.adjacency.assign(count, std::vector<unsigned>());
+   ref.reg.assign(count, NO_REG);
+   ref.spill_cost.resize(count);
+   ref.in_stack.assign(count, false);
+
+   for (i = 0; i < count; i++) {
+      ref.node_class[i] = random.next(3) ? scalar : pair;
+      ra_set_node_class(g, i, ref.node_class[i]);
+   }
+   if (count > 2) {
+      ra_set_node_reg(g, 1, 5);
+      ref.reg[1] = 5;
+   }
+   for (i = 0; i < count * degree; i++) {
+      const unsigned a = random.next(count);
+      const unsigned b = (a + 1 + random.next(window)) % count;
+      bool found = false;
+
+      ra_add_node_interference(g, a, b);
+      for (unsigned j = 0; j < ref.adjacency[a].size(); j++)
+         found |= ref.adjacency[a][j] == b;
+      if (a != b && !found) {
+         ref.adjacency[a].push_back(b);
+         ref.adjacency[b].push_back(a);
+      }
+   }
+   for (i = 0; i < count; i++) {
+      ref.spill_cost[i] = 1.0f + i % 7;
+      ra_set_node_spill_cost(g, i, ref.spill_cost[i]);
+   }
+
+   bool ref_ok = ref.simplify();
+   if (!ref_ok)
+      ref.optimistic_color();
+   ref_ok = ref.select();
+
+   EXPECT_EQ(ref_ok, (bool) ra_allocate_no_spills(g))
+      << "seed " << seed << ", " << count << " nodes";
+   for (i = 0; i < count; i++) {
+      ASSERT_EQ(ref.reg[i], ra_get_node_reg(g, i))
+         << "node " << i << ", seed " << seed << ", " << count << " nodes";
+   }
+   EXPECT_EQ(ref.best_spill_node(), ra_get_best_spill_node(g))
+      << "seed " << seed << ", " << count << " nodes";
+
+   ralloc_free(regs);
+}
+
+} /* anonymous namespace */
+
+TEST(RegisterAllocate, SmallGraphs)
+{
+   for (unsigned seed = 0; seed < 20; seed++)
+      check_random_graph(seed, 50 + seed * 10, 2 + seed % 6, 40);
+}
+
+TEST(RegisterAllocate, OptimisticColoring)
+{
+   /* Dense enough that simplify gets stuck and some nodes don't fit. */
+   for (unsigned seed = 0; seed < 10; seed++)
+      check_random_graph(seed, 300, 60 + seed, 150);
+}
+
+TEST(RegisterAllocate, SparseAdjacency)
+{
+   /* Graphs above RA_DENSE_ADJACENCY_MAX nodes use the sparse edge set. */
+   for (unsigned seed = 0; seed < 4; seed++)
+      check_random_graph(seed, 5000 + seed * 1000, 4 + seed * 4, 40);
+}
@@ -606,6 +606,58 @@ get_tex_memcpy(struct gl_context *ctx, GLenum format, GLenum type,
 }
 
 
+/**
+ * Try to get the texture image of a 32-bit RGBA8-like format with a byte
+ * swizzle, see _mesa_get_rgba8_swizzle().
+ * \return GL_TRUE if done, GL_FALSE otherwise
+ */
+static GLboolean
+get_tex_swizzle(struct gl_context *ctx, GLenum format, GLenum type,
+                GLvoid *pixels,
+                struct gl_texture_image *texImage)
+{
+   const GLenum target = texImage->TexObject->Target;
+   GLuint swapMask, setMask;
+   GLubyte *dst, *src;
+   GLint dstRowStride, srcRowStride;
+   GLuint row;
+
+   if (target != GL_TEXTURE_1D &&
+       target != GL_TEXTURE_2D &&
+       target != GL_TEXTURE_RECTANGLE &&
+       !_mesa_is_cube_face(target))
+      return GL_FALSE;
+
+   if (!_mesa_get_rgba8_swizzle(texImage->TexFormat, texImage->_BaseFormat,
+                                format, type, ctx->Pack.SwapBytes,
+                                &swapMask, &setMask))
+      return GL_FALSE;
+
+   dst = _mesa_image_address2d(&ctx->Pack, pixels, texImage->Width,
+                               texImage->Height, format, type, 0, 0);
+   dstRowStride =
+      _mesa_image_row_stride(&ctx->Pack, texImage->Width, format, type);
+
+   ctx->Driver.MapTextureImage(ctx, texImage, 0,
+                               0, 0, texImage->Width, texImage->Height,
+                               GL_MAP_READ_BIT, &src, &srcRowStride);
+   if (!src) {
+      _mesa_error(ctx, GL_OUT_OF_MEMORY, "glGetTexImage");
+      return GL_TRUE;
+   }
+
+   for (row = 0; row < texImage->Height; row++) {
+      _mesa_swizzle_rgba8_row(texImage->Width, src, dst, swapMask, setMask);
+      dst += dstRowStride;
+      src += srcRowStride;
+   }
+
+   ctx->Driver.UnmapTextureImage(ctx, texImage, 0);
+
+   return GL_TRUE;
+}
+
+
 /**
  * This is the software fallback for Driver.GetTexImage().
  * All error checking will have been done before this routine is called.
@@ -655,6 +707,9 @@ _mesa_get_teximage(struct gl_context *ctx,
    if (get_tex_memcpy(ctx, format, type, pixels, texImage)) {
       /* all done */
    }
+   else if (get_tex_swizzle(ctx, format, type, pixels, texImage)) {
+      /* all done */
+   }
    else if (format == GL_DEPTH_COMPONENT) {
       get_tex_depth(ctx, dimensions, format, type, pixels, texImage);
    }
@@ -867,7 +922,7 @@ getteximage_error_check(struct gl_context *ctx, GLenum target, GLint level,
 
    if (_mesa_is_bufferobj(ctx->Pack.BufferObj)) {
       /* PBO should not be mapped */
-      if (_mesa_bufferobj_mapped(ctx->Pack.BufferObj)) {
+      if (_mesa_check_disallowed_mapping(ctx->Pack.BufferObj)) {
          _mesa_error(ctx, GL_INVALID_OPERATION,
                      "glGetTexImage(PBO is mapped)");
          return GL_TRUE;
@@ -1010,7 +1065,7 @@ getcompressedteximage_error_check(struct gl_context *ctx, GLenum target,
       }
 
       /* make sure PBO is not mapped */
-      if (_mesa_bufferobj_mapped(ctx->Pack.BufferObj)) {
+      if (_mesa_check_disallowed_mapping(ctx->Pack.BufferObj)) {
          _mesa_error(ctx, GL_INVALID_OPERATION,
                      "glGetCompressedTexImage(PBO is mapped)");
          return GL_TRUE;
@@ -838,6 +838,38 @@ byteswap_mapping( GLboolean swapBytes,
 
 
 
+/**
+ * Compute the mapping from the components of an image with one byte per
+ * component (or 8_8_8_8 packed pixels) to the components of the
+ * destination texels.
+ * \param rgba2dst  says which RGBA component each destination component
+ *                  holds
+ * \param map  returns, for each of the 4 destination components, the
+ *             source component index or ZERO/ONE
+ */
+static void
+compute_ubyte_swizzle(GLenum srcFormat, GLenum srcType, GLboolean swapBytes,
+                      GLenum baseInternalFormat, const GLubyte *rgba2dst,
+                      GLubyte *map)
+{
+   const GLubyte *srctype2ubyte, *swap;
+   GLubyte src2base[6], base2rgba[6];
+   GLint i;
+
+   /* Translate from src->baseInternal->GL_RGBA->dst.  This will
+    * correctly deal with RGBA->RGB->RGBA conversions where the final
+    * A value must be 0xff regardless of the incoming alpha values.
+    */
+   compute_component_mapping(srcFormat, baseInternalFormat, src2base);
+   compute_component_mapping(baseInternalFormat, GL_RGBA, base2rgba);
+   swap = byteswap_mapping(swapBytes, srcType);
+   srctype2ubyte = type_mapping(srcType);
+
+   for (i = 0; i < 4; i++)
+      map[i] = srctype2ubyte[swap[src2base[base2rgba[rgba2dst[i]]]]];
+}
+
+
 /**
  * Transfer a GLubyte texture image with component swizzling.
  */
@@ -860,9 +892,7 @@ _mesa_swizzle_ubyte_image(struct gl_context *ctx,
 			  const struct gl_pixelstore_attrib *srcPacking )
 {
    GLint srcComponents = _mesa_components_in_format(srcFormat);
-   const GLubyte *srctype2ubyte, *swap;
-   GLubyte map[4], src2base[6], base2rgba[6];
-   GLint i;
+   GLubyte map[4];
    const GLint srcRowStride =
       _mesa_image_row_stride(srcPacking, srcWidth,
                              srcFormat, GL_UNSIGNED_BYTE);
@@ -876,18 +906,8 @@ _mesa_swizzle_ubyte_image(struct gl_context *ctx,
 
    (void) ctx;
 
-   /* Translate from src->baseInternal->GL_RGBA->dst.  This will
-    * correctly deal with RGBA->RGB->RGBA conversions where the final
-    * A value must be 0xff regardless of the incoming alpha values.
-    */
-   compute_component_mapping(srcFormat, baseInternalFormat, src2base);
-   compute_component_mapping(baseInternalFormat, GL_RGBA, base2rgba);
-   swap = byteswap_mapping(srcPacking->SwapBytes, srcType);
-   srctype2ubyte = type_mapping(srcType);
-
-
-   for (i = 0; i < 4; i++)
-      map[i] = srctype2ubyte[swap[src2base[base2rgba[rgba2dst[i]]]]];
+   compute_ubyte_swizzle(srcFormat, srcType, srcPacking->SwapBytes,
+                         baseInternalFormat, rgba2dst, map);
 
 /*    printf("map %d %d %d %d\n", map[0], map[1], map[2], map[3]);  */
 
@@ -916,6 +936,118 @@ _mesa_swizzle_ubyte_image(struct gl_context *ctx,
 }
 
 
+/**
+ * Size of the conversion tables used by swizzle_convert_ubyte_image():
+ * the destination value for each 8-bit source component value, followed
+ * by the values for 0.0 and 1.0.
+ */
+#define CONVERT_TABLE_SIZE 258
+
+
+/**
+ * Return GL_TRUE if the source image can be converted by
+ * swizzle_convert_ubyte_image() instead of going through a temporary
+ * float image.
+ */
+static GLboolean
+can_convert_ubyte_image(const struct gl_context *ctx,
+                        GLenum baseInternalFormat,
+                        GLenum srcFormat, GLenum srcType)
+{
+   return !ctx->_ImageTransferState &&
+          (srcType == GL_UNSIGNED_BYTE ||
+           srcType == GL_UNSIGNED_INT_8_8_8_8 ||
+           srcType == GL_UNSIGNED_INT_8_8_8_8_REV) &&
+          can_swizzle(baseInternalFormat) &&
+          can_swizzle(srcFormat);
+}
+
+
+/**
+ * Store a GLubyte source image in a texture with wider components,
+ * swizzling and converting each component through a lookup table.
+ * This is one pass over the image, row by row, without a temporary image.
+ *
+ * \param dstFormat  the base format of the texture, which determines the
+ *                   number and order of the destination components
+ * \param compSize  4 for GLfloat components, 2 for 16-bit components
+ * \param table  CONVERT_TABLE_SIZE destination values of size compSize
+ */
+static void
+swizzle_convert_ubyte_image(GLuint dimensions,
+                            GLenum srcFormat, GLenum srcType,
+                            GLenum baseInternalFormat,
+                            GLenum dstFormat, GLuint compSize,
+                            const void *table,
+                            GLint dstRowStride, GLubyte **dstSlices,
+                            GLint srcWidth, GLint srcHeight, GLint srcDepth,
+                            const GLvoid *srcAddr,
+                            const struct gl_pixelstore_attrib *srcPacking)
+{
+#define SWZ_CONVERT(TYPE)                                    \
+   do {                                                      \
+      const TYPE *tab = (const TYPE *) table;                \
+      TYPE *dst = (TYPE *) dstRow;                           \
+      GLint col;                                             \
+      GLuint j;                                              \
+      for (col = 0; col < srcWidth; col++) {                 \
+         for (j = 0; j < srcComponents; j++)                 \
+            idx[j] = src[j];                                 \
+         for (j = 0; j < dstComponents; j++)                 \
+            dst[j] = tab[idx[map[j]]];                       \
+         src += srcComponents;                               \
+         dst += dstComponents;                               \
+      }                                                      \
+   } while (0)
+
+   const GLuint srcComponents = _mesa_components_in_format(srcFormat);
+   const GLuint dstComponents = _mesa_components_in_format(dstFormat);
+   const GLint srcRowStride =
+      _mesa_image_row_stride(srcPacking, srcWidth,
+                             srcFormat, GL_UNSIGNED_BYTE);
+   const GLint srcImageStride
+      = _mesa_image_image_stride(srcPacking, srcWidth, srcHeight, srcFormat,
+                                 GL_UNSIGNED_BYTE);
+   const GLubyte *srcImage
+      = (const GLubyte *) _mesa_image_address(dimensions, srcPacking, srcAddr,
+                                              srcWidth, srcHeight, srcFormat,
+                                              GL_UNSIGNED_BYTE, 0, 0, 0);
+   const int dstIdx = get_map_idx(dstFormat);
+   GLubyte map[4];
+   GLuint idx[6];
+   GLint img, row;
+
+   ASSERT(srcComponents <= 4);
+   ASSERT(dstComponents <= 4);
+
+   compute_ubyte_swizzle(srcFormat, srcType, srcPacking->SwapBytes,
+                         baseInternalFormat, mappings[dstIdx].from_rgba, map);
+
+   /* the table entries following the 256 component values */
+   idx[ZERO] = 256;
+   idx[ONE] = 257;
+
+   for (img = 0; img < srcDepth; img++) {
+      const GLubyte *srcRow = srcImage;
+      GLubyte *dstRow = dstSlices[img];
+      for (row = 0; row < srcHeight; row++) {
+         const GLubyte *src = srcRow;
+         if (compSize == 4) {
+            SWZ_CONVERT(GLfloat);
+         }
+         else {
+            ASSERT(compSize == 2);
+            SWZ_CONVERT(GLushort);
+         }
+         dstRow += dstRowStride;
+         srcRow += srcRowStride;
+      }
+      srcImage += srcImageStride;
+   }
+#undef SWZ_CONVERT
+}
+
+
 /**
  * Teximage storage routine for when a simple memcpy will do.
  * No pixel transfer operations or special texel encodings allowed.
@@ -976,27 +1108,62 @@ memcpy_texture(struct gl_context *ctx,
 static GLboolean
 store_ubyte_texture(TEXSTORE_PARAMS)
 {
-   const GLint srcRowStride = srcWidth * 4 * sizeof(GLubyte);
-   GLubyte *tempImage, *src;
-   GLint img;
-
-   tempImage = _mesa_make_temp_ubyte_image(ctx, dims,
-                                           baseInternalFormat,
-                                           GL_RGBA,
-                                           srcWidth, srcHeight, srcDepth,
-                                           srcFormat, srcType, srcAddr,
-                                           srcPacking);
-   if (!tempImage)
+   const GLint components = _mesa_components_in_format(baseInternalFormat);
+   const GLint srcStride =
+      _mesa_image_row_stride(srcPacking, srcWidth, srcFormat, srcType);
+   GLubyte *rowBuffer, *rgbaRow;
+   GLubyte map[6];
+   GLint img, row, col, k;
+
+   /* Unpack and pack one row at a time rather than through a temporary
+    * image, so the source is only read once and the intermediate data
+    * stays in the cache.
+    */
+   rowBuffer = malloc(srcWidth * (components + 4) * sizeof(GLubyte));
+   if (!rowBuffer)
       return GL_FALSE;
+   rgbaRow = rowBuffer + srcWidth * components;
+
+   compute_component_mapping(baseInternalFormat, GL_RGBA, map);
 
-   src = tempImage;
    for (img = 0; img < srcDepth; img++) {
-      _mesa_pack_ubyte_rgba_rect(dstFormat, srcWidth, srcHeight,
-                                 src, srcRowStride,
-                                 dstSlices[img], dstRowStride);
-      src += srcHeight * srcRowStride;
+      const GLubyte *src =
+         (const GLubyte *) _mesa_image_address(dims, srcPacking, srcAddr,
+                                               srcWidth, srcHeight,
+                                               srcFormat, srcType,
+                                               img, 0, 0);
+      GLubyte *dstRow = dstSlices[img];
+      for (row = 0; row < srcHeight; row++) {
+         if (baseInternalFormat == GL_RGBA) {
+            _mesa_unpack_color_span_ubyte(ctx, srcWidth, GL_RGBA, rgbaRow,
+                                          srcFormat, srcType, src, srcPacking,
+                                          ctx->_ImageTransferState);
+         }
+         else {
+            GLubyte tmp[6];
+
+            _mesa_unpack_color_span_ubyte(ctx, srcWidth, baseInternalFormat,
+                                          rowBuffer, srcFormat, srcType, src,
+                                          srcPacking,
+                                          ctx->_ImageTransferState);
+
+            tmp[ZERO] = 0x0;
+            tmp[ONE] = 0xff;
+            for (col = 0; col < srcWidth; col++) {
+               for (k = 0; k < components; k++)
+                  tmp[k] = rowBuffer[col * components + k];
+               for (k = 0; k < 4; k++)
+                  rgbaRow[col * 4 + k] = tmp[map[k]];
+            }
+         }
+
+         _mesa_pack_ubyte_rgba_row(dstFormat, srcWidth,
+                                   (const GLubyte (*)[4]) rgbaRow, dstRow);
+         dstRow += dstRowStride;
+         src += srcStride;
+      }
    }
-   free(tempImage);
+   free(rowBuffer);
 
    return GL_TRUE;
 }
@@ -1787,7 +1954,24 @@ _mesa_texstore_unorm16(TEXSTORE_PARAMS)
           dstFormat == MESA_FORMAT_I16);
    ASSERT(_mesa_get_format_bytes(dstFormat) == 2);
 
-   {
+   if (can_convert_ubyte_image(ctx, baseInternalFormat, srcFormat, srcType)) {
+      /* unorm8 source: convert with a table, without a float image */
+      GLushort table[CONVERT_TABLE_SIZE];
+      GLint i;
+
+      for (i = 0; i < 256; i++)
+         UNCLAMPED_FLOAT_TO_USHORT(table[i], UBYTE_TO_FLOAT(i));
+      table[256] = 0;
+      table[257] = 0xffff;
+
+      swizzle_convert_ubyte_image(dims, srcFormat, srcType,
+                                  baseInternalFormat, baseFormat,
+                                  sizeof(GLushort), table,
+                                  dstRowStride, dstSlices,
+                                  srcWidth, srcHeight, srcDepth, srcAddr,
+                                  srcPacking);
+   }
+   else {
       /* general path */
       const GLfloat *tempImage = _mesa_make_temp_float_image(ctx, dims,
                                                  baseInternalFormat,
@@ -1827,7 +2011,24 @@ _mesa_texstore_rgba_16(TEXSTORE_PARAMS)
           dstFormat == MESA_FORMAT_XBGR16161616_UNORM);
    ASSERT(_mesa_get_format_bytes(dstFormat) == 8);
 
-   {
+   if (can_convert_ubyte_image(ctx, baseInternalFormat, srcFormat, srcType)) {
+      /* unorm8 source: convert with a table, without a float image */
+      GLushort table[CONVERT_TABLE_SIZE];
+      GLint i;
+
+      for (i = 0; i < 256; i++)
+         UNCLAMPED_FLOAT_TO_USHORT(table[i], UBYTE_TO_FLOAT(i));
+      table[256] = 0;
+      table[257] = 0xffff;
+
+      swizzle_convert_ubyte_image(dims, srcFormat, srcType,
+                                  baseInternalFormat, GL_RGBA,
+                                  sizeof(GLushort), table,
+                                  dstRowStride, dstSlices,
+                                  srcWidth, srcHeight, srcDepth, srcAddr,
+                                  srcPacking);
+   }
+   else {
       /* general path */
       /* Hardcode GL_RGBA as the base format, which forces alpha to 1.0
        * if the internal format is RGB. */
@@ -2691,7 +2892,24 @@ _mesa_texstore_rgba_float32(TEXSTORE_PARAMS)
           baseInternalFormat == GL_RG);
    ASSERT(_mesa_get_format_bytes(dstFormat) == components * sizeof(GLfloat));
 
-   {
+   if (can_convert_ubyte_image(ctx, baseInternalFormat, srcFormat, srcType)) {
+      /* unorm8 source: convert with a table, without a float image */
+      GLfloat table[CONVERT_TABLE_SIZE];
+      GLint i;
+
+      for (i = 0; i < 256; i++)
+         table[i] = UBYTE_TO_FLOAT(i);
+      table[256] = 0.0F;
+      table[257] = 1.0F;
+
+      swizzle_convert_ubyte_image(dims, srcFormat, srcType,
+                                  baseInternalFormat, baseFormat,
+                                  sizeof(GLfloat), table,
+                                  dstRowStride, dstSlices,
+                                  srcWidth, srcHeight, srcDepth, srcAddr,
+                                  srcPacking);
+   }
+   else {
       /* general path */
       const GLfloat *tempImage = _mesa_make_temp_float_image(ctx, dims,
                                                  baseInternalFormat,
@@ -2756,7 +2974,24 @@ _mesa_texstore_rgba_float16(TEXSTORE_PARAMS)
           baseInternalFormat == GL_RG);
    ASSERT(_mesa_get_format_bytes(dstFormat) == components * sizeof(GLhalfARB));
 
-   {
+   if (can_convert_ubyte_image(ctx, baseInternalFormat, srcFormat, srcType)) {
+      /* unorm8 source: convert with a table, without a float image */
+      GLhalfARB table[CONVERT_TABLE_SIZE];
+      GLint i;
+
+      for (i = 0; i < 256; i++)
+         table[i] = _mesa_float_to_half(UBYTE_TO_FLOAT(i));
+      table[256] = _mesa_float_to_half(0.0F);
+      table[257] = _mesa_float_to_half(1.0F);
+
+      swizzle_convert_ubyte_image(dims, srcFormat, srcType,
+                                  baseInternalFormat, baseFormat,
+                                  sizeof(GLhalfARB), table,
+                                  dstRowStride, dstSlices,
+                                  srcWidth, srcHeight, srcDepth, srcAddr,
+                                  srcPacking);
+   }
+   else {
       /* general path */
       const GLfloat *tempImage = _mesa_make_temp_float_image(ctx, dims,
                                                  baseInternalFormat,
@@ -462,6 +462,28 @@ log_program_parameters(const struct gl_shader_program *shProg)
 }
 #endif
 
+/**
+ * Flush vertices and flag the state that a change to \c uni invalidates
+ *
+ * Drivers that set \c gl_driver_flags::NewShaderConstants only get told
+ * about the stages that actually use the uniform.  Everyone else gets
+ * \c _NEW_PROGRAM_CONSTANTS.
+ */
+static void
+flush_vertices_for_uniform(struct gl_context *ctx,
+                           const struct gl_uniform_storage *uni)
+{
+   GLbitfield new_driver_state = 0;
+
+   for (unsigned i = 0; i < MESA_SHADER_TYPES; i++) {
+      if (uni->active_shader_mask & (1 << i))
+         new_driver_state |= ctx->DriverFlags.NewShaderConstants[i];
+   }
+
+   FLUSH_VERTICES(ctx, new_driver_state ? 0 : _NEW_PROGRAM_CONSTANTS);
+   ctx->NewDriverState |= new_driver_state;
+}
+
 /**
  * Propagate some values from uniform backing storage to driver storage
  *
@@ -745,7 +767,7 @@ _mesa_uniform(struct gl_context *ctx, struct gl_shader_program *shProg,
       count = MIN2(count, (int) (uni->array_elements - offset));
    }
 
-   FLUSH_VERTICES(ctx, _NEW_PROGRAM_CONSTANTS);
+   flush_vertices_for_uniform(ctx, uni);
 
    /* Store the data in the "actual type" backing storage for the uniform.
     */
@@ -898,7 +920,7 @@ _mesa_uniform_matrix(struct gl_context *ctx, struct gl_shader_program *shProg,
       count = MIN2(count, (int) (uni->array_elements - offset));
    }
 
-   FLUSH_VERTICES(ctx, _NEW_PROGRAM_CONSTANTS);
+   flush_vertices_for_uniform(ctx, uni);
 
    /* Store the data in the "actual type" backing storage for the uniform.
     */
@@ -54,9 +54,10 @@ typedef int (*hash_compare_func_t)(const void *key1, const void *key2);
  *
  * Creates a hash table with the specified number of buckets.  The supplied
  * \c hash and \c compare routines are used when adding elements to the table
- * and when searching for elements in the table.
+ * and when searching for elements in the table.  The table grows as elements
+ * are added, so the number of buckets is only a starting size.
  *
- * \param num_buckets  Number of buckets (bins) in the hash table.
+ * \param num_buckets  Initial number of buckets (bins) in the hash table.
  * \param hash         Function used to compute hash value of input keys.
  * \param compare      Function used to compare keys.
  */
@@ -3013,7 +3013,8 @@ _mesa_ir_link_shader(struct gl_context *ctx, struct gl_shader_program *prog)
 	 progress = do_lower_jumps(ir, true, true, options->EmitNoMainReturn, options->EmitNoCont, options->EmitNoLoops) || progress;
 
 	 progress = do_common_optimization(ir, true, true,
-					   options->MaxUnrollIterations)
+					   options->MaxUnrollIterations,
+					   options->EmitNoLoops)
 	   || progress;
 
 	 progress = lower_quadop_vector(ir, true) || progress;
@@ -3123,7 +3124,7 @@ _mesa_glsl_compile_shader(struct gl_context *ctx, struct gl_shader *shader)
       /* Do some optimization at compile time to reduce shader IR size
        * and reduce later work if the same shader is linked multiple times
        */
-      while (do_common_optimization(shader->ir, false, false, 32))
+      while (do_common_optimization(shader->ir, false, false, 32, false))
 	 ;
 
       validate_ir_tree(shader->ir);
@@ -86,11 +86,14 @@ rehash(struct gl_program_cache *cache)
    struct cache_item *c, *next;
    GLuint size, i;
 
-   cache->last = NULL;
-
    size = cache->size * 3;
-   items = malloc(size * sizeof(*items));
-   memset(items, 0, size * sizeof(*items));
+   items = calloc(size, sizeof(*items));
+   if (!items) {
+      /* keep using the current table, just with longer chains */
+      return;
+   }
+
+   cache->last = NULL;
 
    for (i = 0; i < cache->size; i++)
       for (c = cache->items[i]; c; c = next) {
@@ -216,12 +219,8 @@ _mesa_program_cache_insert(struct gl_context *ctx,
 
    c->program = program;  /* no refcount change */
 
-   if (cache->n_items > cache->size * 1.5) {
-      if (cache->size < 1000)
-	 rehash(cache);
-      else 
-	 clear_cache(ctx, cache, GL_FALSE);
-   }
+   if (cache->n_items > cache->size * 1.5)
+      rehash(cache);
 
    cache->n_items++;
    c->next = cache->items[hash % cache->size];
@@ -245,12 +244,8 @@ _mesa_shader_cache_insert(struct gl_context *ctx,
 
    c->program = (struct gl_program *)program;  /* no refcount change */
 
-   if (cache->n_items > cache->size * 1.5) {
-      if (cache->size < 1000)
-	 rehash(cache);
-      else
-	 clear_cache(ctx, cache, GL_TRUE);
-   }
+   if (cache->n_items > cache->size * 1.5)
+      rehash(cache);
 
    cache->n_items++;
    c->next = cache->items[hash % cache->size];
@@ -0,0 +1,677 @@
+/*
+ * Mesa 3-D graphics library
+ *
+ * Copyright (C) 2013  VMware, Inc.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+
+/**
+ * \file prog_diskcache.c
+ * On-disk cache of generated programs.
+ *
+ * Programs that Mesa builds from a state key, like the fixed-function
+ * vertex programs, are saved with one file per key so that later runs
+ * can load them instead of generating them again.  Each file starts with
+ * the build ID, the target and the whole key, and is only used if they
+ * all match.  The build ID identifies the library binary itself, see
+ * get_build_id().  The structures are written in their native layout,
+ * which the build ID and the structure sizes in the header account for.
+ *
+ * The files go to $MESA_PROGRAM_CACHE_DIR if set, else to mesa/programs
+ * in $XDG_CACHE_HOME or ~/.cache.  Setting MESA_PROGRAM_CACHE_DISABLE
+ * turns the cache off.  Only vertex programs are supported so far, other
+ * data can be stored as an opaque blob.
+ *
+ * Fixed-function fragment programs are built as GLSL shaders by
+ * ff_fragment_shader.cpp.  With the state tracker, their TGSI is saved
+ * through the blob interface by st_shader_cache.c, but the GLSL IR is
+ * still generated and linked on each run, and classic drivers keep
+ * nothing.  Saving linked shader programs needs IR serialization, which
+ * is left for later.
+ */
+
+
+#include "main/glheader.h"
+#include "main/imports.h"
+#include "main/macros.h"
+#include "main/mtypes.h"
+#include "git_sha1.h"
+#include "glapi/glthread.h"
+#include "program/prog_diskcache.h"
+#include "program/prog_instruction.h"
+#include "program/prog_parameter.h"
+#include "program/program.h"
+
+
+#ifndef _WIN32
+
+#include <errno.h>
+#include <limits.h>
+#include <stdio.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+#ifdef HAVE_DLOPEN
+#include <dlfcn.h>
+#endif
+
+
+/** Programs and blobs are told apart so that they never share a file */
+#define PROGRAM_MAGIC "MESAPROG"
+#define BLOB_MAGIC    "MESABLOB"
+
+
+/**
+ * Get a string that changes whenever the library is rebuilt.  The version
+ * and git SHA1 don't, since tarball builds have no SHA1 and local patches
+ * keep HEAD's, so the inode, size and modification time of the binary
+ * holding this code are added.
+ * \return NULL if the binary can't be found, which turns the cache off
+ */
+static const char *
+get_build_id(void)
+{
+   _glthread_DECLARE_STATIC_MUTEX(build_id_mutex);
+   static char build_id[256];
+   static GLboolean done;
+   const char *id = NULL;
+
+   _glthread_LOCK_MUTEX(build_id_mutex);
+   if (!done) {
+#ifdef HAVE_DLOPEN
+      Dl_info info;
+      struct stat st;
+
+      if (dladdr((void *) get_build_id, &info) && info.dli_fname &&
+          stat(info.dli_fname, &st) == 0) {
+         _mesa_snprintf(build_id, sizeof(build_id),
+                        "Mesa " PACKAGE_VERSION
+#ifdef MESA_GIT_SHA1
+                        " " MESA_GIT_SHA1
+#endif
+                        " %llx %llx %llx",
+                        (unsigned long long) st.st_ino,
+                        (unsigned long long) st.st_size,
+                        (unsigned long long) st.st_mtime);
+      }
+#endif
+      done = GL_TRUE;
+   }
+   if (build_id[0])
+      id = build_id;
+   _glthread_UNLOCK_MUTEX(build_id_mutex);
+
+   return id;
+}
+
+
+/**
+ * Growable byte buffer for writing cache files.
+ */
+struct blob
+{
+   GLubyte *data;
+   size_t size, alloc;
+   GLboolean error;   /**< set if out of memory */
+};
+
+/**
+ * Cursor for reading cache files.
+ */
+struct blob_reader
+{
+   const GLubyte *data, *end;
+   GLboolean error;   /**< set if reading past the end */
+};
+
+
+static void
+blob_write(struct blob *b, const void *data, size_t size)
+{
+   if (b->error)
+      return;
+
+   if (b->size + size > b->alloc) {
+      size_t alloc = MAX2(b->alloc * 2, b->size + size + 1024);
+      GLubyte *p = realloc(b->data, alloc);
+      if (!p) {
+         b->error = GL_TRUE;
+         return;
+      }
+      b->data = p;
+      b->alloc = alloc;
+   }
+
+   memcpy(b->data + b->size, data, size);
+   b->size += size;
+}
+
+
+static void
+blob_write_uint(struct blob *b, GLuint value)
+{
+   blob_write(b, &value, sizeof(value));
+}
+
+
+static void
+blob_read(struct blob_reader *r, void *data, size_t size)
+{
+   if (r->error || (size_t) (r->end - r->data) < size) {
+      r->error = GL_TRUE;
+      memset(data, 0, size);
+      return;
+   }
+
+   memcpy(data, r->data, size);
+   r->data += size;
+}
+
+
+static GLuint
+blob_read_uint(struct blob_reader *r)
+{
+   GLuint value;
+   blob_read(r, &value, sizeof(value));
+   return value;
+}
+
+
+/**
+ * 64-bit FNV-1a hash, for file names and checksums.
+ */
+static uint64_t
+hash_data(const void *data, size_t size)
+{
+   const GLubyte *bytes = (const GLubyte *) data;
+   uint64_t hash = 0xcbf29ce484222325ull;
+   size_t i;
+
+   for (i = 0; i < size; i++) {
+      hash ^= bytes[i];
+      hash *= 0x100000001b3ull;
+   }
+
+   return hash;
+}
+
+
+/**
+ * Write the part of a cache file that identifies the entry.
+ */
+static void
+write_header(struct blob *b, const char *magic, GLenum target,
+             const void *key, GLuint keysize)
+{
+   const char *build_id = get_build_id();
+
+   if (!build_id) {
+      b->error = GL_TRUE;
+      return;
+   }
+
+   blob_write(b, magic, strlen(magic));
+   blob_write_uint(b, strlen(build_id));
+   blob_write(b, build_id, strlen(build_id));
+   blob_write_uint(b, sizeof(struct prog_instruction));
+   blob_write_uint(b, sizeof(struct gl_program_parameter));
+   blob_write_uint(b, target);
+   blob_write_uint(b, keysize);
+   blob_write(b, key, keysize);
+}
+
+
+/**
+ * Get the path of the cache file for the given header.
+ * \return GL_FALSE if the cache is disabled
+ */
+static GLboolean
+get_cache_path(char *dir, char *path, size_t size, const struct blob *header)
+{
+   const char *env;
+
+   if (_mesa_getenv("MESA_PROGRAM_CACHE_DISABLE"))
+      return GL_FALSE;
+
+   if ((env = _mesa_getenv("MESA_PROGRAM_CACHE_DIR")))
+      _mesa_snprintf(dir, size, "%s", env);
+   else if ((env = _mesa_getenv("XDG_CACHE_HOME")))
+      _mesa_snprintf(dir, size, "%s/mesa/programs", env);
+   else if ((env = _mesa_getenv("HOME")))
+      _mesa_snprintf(dir, size, "%s/.cache/mesa/programs", env);
+   else
+      return GL_FALSE;
+
+   _mesa_snprintf(path, size, "%s/%016llx.prog", dir,
+                  (unsigned long long) hash_data(header->data, header->size));
+   return GL_TRUE;
+}
+
+
+/**
+ * Create a directory and its parents.
+ */
+static GLboolean
+make_dirs(char *path)
+{
+   char *p;
+
+   for (p = path + 1; *p; p++) {
+      if (*p == '/') {
+         *p = '\0';
+         if (mkdir(path, 0755) != 0 && errno != EEXIST) {
+            *p = '/';
+            return GL_FALSE;
+         }
+         *p = '/';
+      }
+   }
+
+   return mkdir(path, 0755) == 0 || errno == EEXIST;
+}
+
+
+#define WRITE_FIELD(b, s, f) blob_write(b, &(s)->f, sizeof((s)->f))
+#define READ_FIELD(r, s, f)  blob_read(r, &(s)->f, sizeof((s)->f))
+
+
+static void
+write_program(struct blob *b, const struct gl_program *prog)
+{
+   const struct gl_program_parameter_list *params = prog->Parameters;
+   GLuint i;
+
+   WRITE_FIELD(b, prog, InputsRead);
+   WRITE_FIELD(b, prog, OutputsWritten);
+   WRITE_FIELD(b, prog, SystemValuesRead);
+   WRITE_FIELD(b, prog, InputFlags);
+   WRITE_FIELD(b, prog, OutputFlags);
+   WRITE_FIELD(b, prog, TexturesUsed);
+   WRITE_FIELD(b, prog, SamplersUsed);
+   WRITE_FIELD(b, prog, ShadowSamplers);
+   WRITE_FIELD(b, prog, SamplerUnits);
+   WRITE_FIELD(b, prog, IndirectRegisterFiles);
+   WRITE_FIELD(b, prog, NumTemporaries);
+   WRITE_FIELD(b, prog, NumParameters);
+   WRITE_FIELD(b, prog, NumAttributes);
+   WRITE_FIELD(b, prog, NumAddressRegs);
+   WRITE_FIELD(b, prog, NumAluInstructions);
+   WRITE_FIELD(b, prog, NumTexInstructions);
+   WRITE_FIELD(b, prog, NumTexIndirections);
+   WRITE_FIELD(b, prog, NumNativeInstructions);
+   WRITE_FIELD(b, prog, NumNativeTemporaries);
+   WRITE_FIELD(b, prog, NumNativeParameters);
+   WRITE_FIELD(b, prog, NumNativeAttributes);
+   WRITE_FIELD(b, prog, NumNativeAddressRegs);
+   WRITE_FIELD(b, prog, NumNativeAluInstructions);
+   WRITE_FIELD(b, prog, NumNativeTexInstructions);
+   WRITE_FIELD(b, prog, NumNativeTexIndirections);
+
+   if (prog->Target == GL_VERTEX_PROGRAM_ARB) {
+      const struct gl_vertex_program *vp =
+         (const struct gl_vertex_program *) prog;
+      WRITE_FIELD(b, vp, IsPositionInvariant);
+      WRITE_FIELD(b, vp, UsesClipDistance);
+   }
+
+   /* Comments are only for debugging and not saved */
+   blob_write_uint(b, prog->NumInstructions);
+   for (i = 0; i < prog->NumInstructions; i++) {
+      struct prog_instruction inst = prog->Instructions[i];
+      inst.Comment = NULL;
+      blob_write(b, &inst, sizeof(inst));
+   }
+
+   blob_write_uint(b, params->NumParameters);
+   WRITE_FIELD(b, params, StateFlags);
+   for (i = 0; i < params->NumParameters; i++) {
+      const struct gl_program_parameter *p = params->Parameters + i;
+      const GLuint len = p->Name ? strlen(p->Name) + 1 : 0;
+
+      blob_write_uint(b, len);
+      blob_write(b, p->Name, len);
+      WRITE_FIELD(b, p, Type);
+      WRITE_FIELD(b, p, DataType);
+      WRITE_FIELD(b, p, Size);
+      WRITE_FIELD(b, p, Initialized);
+      WRITE_FIELD(b, p, StateIndexes);
+      blob_write(b, params->ParameterValues[i],
+                 sizeof(params->ParameterValues[i]));
+   }
+}
+
+
+/**
+ * Fill in a new program from a cache file.
+ * \return GL_FALSE if the file is truncated or out of memory
+ */
+static GLboolean
+read_program(struct blob_reader *r, struct gl_program *prog)
+{
+   struct gl_program_parameter_list *params;
+   GLuint i, n;
+
+   READ_FIELD(r, prog, InputsRead);
+   READ_FIELD(r, prog, OutputsWritten);
+   READ_FIELD(r, prog, SystemValuesRead);
+   READ_FIELD(r, prog, InputFlags);
+   READ_FIELD(r, prog, OutputFlags);
+   READ_FIELD(r, prog, TexturesUsed);
+   READ_FIELD(r, prog, SamplersUsed);
+   READ_FIELD(r, prog, ShadowSamplers);
+   READ_FIELD(r, prog, SamplerUnits);
+   READ_FIELD(r, prog, IndirectRegisterFiles);
+   READ_FIELD(r, prog, NumTemporaries);
+   READ_FIELD(r, prog, NumParameters);
+   READ_FIELD(r, prog, NumAttributes);
+   READ_FIELD(r, prog, NumAddressRegs);
+   READ_FIELD(r, prog, NumAluInstructions);
+   READ_FIELD(r, prog, NumTexInstructions);
+   READ_FIELD(r, prog, NumTexIndirections);
+   READ_FIELD(r, prog, NumNativeInstructions);
+   READ_FIELD(r, prog, NumNativeTemporaries);
+   READ_FIELD(r, prog, NumNativeParameters);
+   READ_FIELD(r, prog, NumNativeAttributes);
+   READ_FIELD(r, prog, NumNativeAddressRegs);
+   READ_FIELD(r, prog, NumNativeAluInstructions);
+   READ_FIELD(r, prog, NumNativeTexInstructions);
+   READ_FIELD(r, prog, NumNativeTexIndirections);
+
+   if (prog->Target == GL_VERTEX_PROGRAM_ARB) {
+      struct gl_vertex_program *vp = (struct gl_vertex_program *) prog;
+      READ_FIELD(r, vp, IsPositionInvariant);
+      READ_FIELD(r, vp, UsesClipDistance);
+   }
+
+   n = blob_read_uint(r);
+   if (r->error || n == 0 ||
+       n > (size_t) (r->end - r->data) / sizeof(struct prog_instruction))
+      return GL_FALSE;
+
+   prog->Instructions = _mesa_alloc_instructions(n);
+   if (!prog->Instructions)
+      return GL_FALSE;
+   prog->NumInstructions = n;
+
+   for (i = 0; i < n; i++) {
+      blob_read(r, &prog->Instructions[i], sizeof(prog->Instructions[i]));
+      prog->Instructions[i].Comment = NULL;
+   }
+
+   n = blob_read_uint(r);
+   if (r->error || n > (size_t) (r->end - r->data))
+      return GL_FALSE;
+
+   params = n ? _mesa_new_parameter_list_sized(n) : _mesa_new_parameter_list();
+   if (!params)
+      return GL_FALSE;
+   prog->Parameters = params;
+   if (n && (!params->Parameters || !params->ParameterValues))
+      return GL_FALSE;
+
+   READ_FIELD(r, params, StateFlags);
+   for (i = 0; i < n && !r->error; i++) {
+      struct gl_program_parameter *p = params->Parameters + i;
+      const GLuint len = blob_read_uint(r);
+
+      if (len) {
+         char *name;
+
+         if (len > (size_t) (r->end - r->data))
+            return GL_FALSE;
+         name = malloc(len);
+         if (!name)
+            return GL_FALSE;
+         blob_read(r, name, len);
+         name[len - 1] = '\0';
+         p->Name = name;
+      }
+      /* count the parameter now so that it's freed with the list */
+      params->NumParameters = i + 1;
+
+      READ_FIELD(r, p, Type);
+      READ_FIELD(r, p, DataType);
+      READ_FIELD(r, p, Size);
+      READ_FIELD(r, p, Initialized);
+      READ_FIELD(r, p, StateIndexes);
+      blob_read(r, params->ParameterValues[i],
+                sizeof(params->ParameterValues[i]));
+   }
+
+   return !r->error;
+}
+
+
+/**
+ * Read the cache file for the given header.
+ * \return the payload, which the caller must free, or NULL on a miss
+ */
+static GLubyte *
+read_cache_file(const struct blob *header, GLuint *payload_size)
+{
+   GLubyte *data = NULL, *payload = NULL;
+   char dir[PATH_MAX], path[PATH_MAX];
+   uint64_t checksum;
+   FILE *f;
+   long size;
+
+   if (header->error || !get_cache_path(dir, path, sizeof(path), header))
+      return NULL;
+
+   f = fopen(path, "rb");
+   if (!f)
+      return NULL;
+
+   if (fseek(f, 0, SEEK_END) == 0 &&
+       (size = ftell(f)) > (long) (header->size + sizeof(checksum)) &&
+       fseek(f, 0, SEEK_SET) == 0 &&
+       (data = malloc(size)) != NULL &&
+       fread(data, 1, size, f) != (size_t) size) {
+      free(data);
+      data = NULL;
+   }
+   fclose(f);
+
+   if (!data || memcmp(data, header->data, header->size) != 0)
+      goto done;
+
+   memcpy(&checksum, data + header->size, sizeof(checksum));
+   *payload_size = size - header->size - sizeof(checksum);
+   if (checksum != hash_data(data + header->size + sizeof(checksum),
+                             *payload_size))
+      goto done;
+
+   payload = malloc(*payload_size);
+   if (payload)
+      memcpy(payload, data + header->size + sizeof(checksum), *payload_size);
+
+done:
+   free(data);
+   return payload;
+}
+
+
+/**
+ * Write the cache file for the given header.
+ */
+static void
+write_cache_file(const struct blob *header,
+                 const void *payload, GLuint payload_size)
+{
+   char dir[PATH_MAX], path[PATH_MAX], tmp[PATH_MAX + 32];
+   uint64_t checksum;
+   FILE *f;
+
+   if (header->error ||
+       !get_cache_path(dir, path, sizeof(path), header) ||
+       !make_dirs(dir))
+      return;
+
+   checksum = hash_data(payload, payload_size);
+
+   /* Write to a temporary file first so that other processes never see
+    * a partial file.
+    */
+   _mesa_snprintf(tmp, sizeof(tmp), "%s.%ld", path, (long) getpid());
+   f = fopen(tmp, "wb");
+   if (!f)
+      return;
+
+   if (fwrite(header->data, 1, header->size, f) != header->size ||
+       fwrite(&checksum, 1, sizeof(checksum), f) != sizeof(checksum) ||
+       fwrite(payload, 1, payload_size, f) != payload_size) {
+      fclose(f);
+      unlink(tmp);
+      return;
+   }
+
+   if (fclose(f) != 0 || rename(tmp, path) != 0)
+      unlink(tmp);
+}
+
+
+/**
+ * Look for a program generated from the given key in the disk cache.
+ * \return a new program, or NULL if there's none
+ */
+struct gl_program *
+_mesa_load_program_from_disk(struct gl_context *ctx, GLenum target,
+                             const void *key, GLuint keysize)
+{
+   struct blob header = { NULL, 0, 0, GL_FALSE };
+   struct gl_program *prog = NULL;
+   struct blob_reader r;
+   GLubyte *data;
+   GLuint size;
+
+   if (target != GL_VERTEX_PROGRAM_ARB)
+      return NULL;
+
+   write_header(&header, PROGRAM_MAGIC, target, key, keysize);
+   data = read_cache_file(&header, &size);
+   free(header.data);
+   if (!data)
+      return NULL;
+
+   r.data = data;
+   r.end = data + size;
+   r.error = GL_FALSE;
+
+   prog = ctx->Driver.NewProgram(ctx, target, 0);
+   if (prog && (!read_program(&r, prog) || r.data != r.end))
+      _mesa_reference_program(ctx, &prog, NULL);
+
+   free(data);
+   return prog;
+}
+
+
+/**
+ * Save a program generated from the given key to the disk cache.
+ * Errors are ignored, the cache is only an optimization.
+ */
+void
+_mesa_store_program_to_disk(const void *key, GLuint keysize,
+                            const struct gl_program *prog)
+{
+   struct blob header = { NULL, 0, 0, GL_FALSE };
+   struct blob payload = { NULL, 0, 0, GL_FALSE };
+
+   if (prog->Target != GL_VERTEX_PROGRAM_ARB)
+      return;
+
+   write_header(&header, PROGRAM_MAGIC, prog->Target, key, keysize);
+   write_program(&payload, prog);
+   if (!payload.error)
+      write_cache_file(&header, payload.data, payload.size);
+
+   free(header.data);
+   free(payload.data);
+}
+
+
+/**
+ * Look for data that isn't a gl_program, like the TGSI tokens of the
+ * state tracker, in the disk cache.  \p kind tells apart the users.
+ * \return the data, which the caller must free, or NULL if there's none
+ */
+void *
+_mesa_load_blob_from_disk(GLenum kind, const void *key, GLuint keysize,
+                          GLuint *size)
+{
+   struct blob header = { NULL, 0, 0, GL_FALSE };
+   void *data;
+
+   write_header(&header, BLOB_MAGIC, kind, key, keysize);
+   data = read_cache_file(&header, size);
+   free(header.data);
+   return data;
+}
+
+
+/**
+ * Save data stored under the given kind and key to the disk cache.
+ */
+void
+_mesa_store_blob_to_disk(GLenum kind, const void *key, GLuint keysize,
+                         const void *data, GLuint size)
+{
+   struct blob header = { NULL, 0, 0, GL_FALSE };
+
+   write_header(&header, BLOB_MAGIC, kind, key, keysize);
+   write_cache_file(&header, data, size);
+   free(header.data);
+}
+
+#else /* _WIN32 */
+
+struct gl_program *
+_mesa_load_program_from_disk(struct gl_context *ctx, GLenum target,
+                             const void *key, GLuint keysize)
+{
+   return NULL;
+}
+
+
+void
+_mesa_store_program_to_disk(const void *key, GLuint keysize,
+                            const struct gl_program *prog)
+{
+}
+
+
+void *
+_mesa_load_blob_from_disk(GLenum kind, const void *key, GLuint keysize,
+                          GLuint *size)
+{
+   return NULL;
+}
+
+
+void
+_mesa_store_blob_to_disk(GLenum kind, const void *key, GLuint keysize,
+                         const void *data, GLuint size)
+{
+}
+
+#endif /* _WIN32 */
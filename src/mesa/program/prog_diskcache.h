@@ -0,0 +1,54 @@
+/*
+ * Mesa 3-D graphics library
+ *
+ * Copyright (C) 2013  VMware, Inc.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+
+#ifndef PROG_DISKCACHE_H
+#define PROG_DISKCACHE_H
+
+
+#include "main/glheader.h"
+
+struct gl_context;
+struct gl_program;
+
+
+extern struct gl_program *
+_mesa_load_program_from_disk(struct gl_context *ctx, GLenum target,
+                             const void *key, GLuint keysize);
+
+extern void
+_mesa_store_program_to_disk(const void *key, GLuint keysize,
+                            const struct gl_program *prog);
+
+extern void *
+_mesa_load_blob_from_disk(GLenum kind, const void *key, GLuint keysize,
+                          GLuint *size);
+
+extern void
+_mesa_store_blob_to_disk(GLenum kind, const void *key, GLuint keysize,
+                         const void *data, GLuint size);
+
+
+#endif /* PROG_DISKCACHE_H */
@@ -1690,3 +1690,733 @@ _mesa_execute_program(struct gl_context * ctx,
 
    return GL_TRUE;
 }
+
+
+
+/*
+ * Span execution.
+ *
+ * Straight-line programs, i.e. those without flow control, condition
+ * codes or address registers, can be run one instruction at a time over
+ * a chunk of fragments instead of one fragment at a time over the whole
+ * program.  The opcode dispatch and the register/swizzle decoding are
+ * then done once per chunk, and the loops over the fragments are simple
+ * enough for the compiler to vectorize.  Every fragment computes the
+ * same thing the interpreter above would.
+ */
+
+
+/**
+ * Can the source register be read by _mesa_execute_program_span()?
+ */
+static GLboolean
+span_src_ok(const struct gl_program *program, const struct prog_instruction *inst,
+            const struct prog_src_register *source)
+{
+   GLuint i;
+
+   if (source->RelAddr)
+      return GL_FALSE;
+
+   /* only SWZ has ZERO/ONE swizzles, DDX/DDY handle any register */
+   if (inst->Opcode != OPCODE_SWZ) {
+      for (i = 0; i < 4; i++) {
+         if (GET_SWZ(source->Swizzle, i) > SWIZZLE_W)
+            return GL_FALSE;
+      }
+   }
+
+   switch (source->File) {
+   case PROGRAM_TEMPORARY:
+      return source->Index < (GLint) program->NumTemporaries;
+   case PROGRAM_INPUT:
+      return program->Target == GL_FRAGMENT_PROGRAM_ARB &&
+             source->Index < VARYING_SLOT_MAX;
+   case PROGRAM_OUTPUT:
+      return source->Index < MAX_PROGRAM_OUTPUTS;
+   case PROGRAM_LOCAL_PARAM:
+   case PROGRAM_ENV_PARAM:
+   case PROGRAM_STATE_VAR:
+   case PROGRAM_CONSTANT:
+   case PROGRAM_UNIFORM:
+      return GL_TRUE;
+   default:
+      return GL_FALSE;
+   }
+}
+
+
+/**
+ * Can the program be run with _mesa_execute_program_span()?  Only
+ * fragment programs are supported.
+ */
+GLboolean
+_mesa_program_span_executable(const struct gl_program *program)
+{
+   GLuint pc, i;
+
+   if (program->Target != GL_FRAGMENT_PROGRAM_ARB)
+      return GL_FALSE;
+
+   for (pc = 0; pc < program->NumInstructions; pc++) {
+      const struct prog_instruction *inst = program->Instructions + pc;
+
+      switch (inst->Opcode) {
+      case OPCODE_END:
+         return GL_TRUE;
+      case OPCODE_ABS:
+      case OPCODE_ADD:
+      case OPCODE_CMP:
+      case OPCODE_COS:
+      case OPCODE_DDX:
+      case OPCODE_DDY:
+      case OPCODE_DP2:
+      case OPCODE_DP3:
+      case OPCODE_DP4:
+      case OPCODE_DPH:
+      case OPCODE_DST:
+      case OPCODE_EX2:
+      case OPCODE_FLR:
+      case OPCODE_FRC:
+      case OPCODE_KIL:
+      case OPCODE_LG2:
+      case OPCODE_LIT:
+      case OPCODE_LRP:
+      case OPCODE_MAD:
+      case OPCODE_MAX:
+      case OPCODE_MIN:
+      case OPCODE_MOV:
+      case OPCODE_MUL:
+      case OPCODE_NOP:
+      case OPCODE_POW:
+      case OPCODE_RCP:
+      case OPCODE_RSQ:
+      case OPCODE_SCS:
+      case OPCODE_SEQ:
+      case OPCODE_SGE:
+      case OPCODE_SGT:
+      case OPCODE_SIN:
+      case OPCODE_SLE:
+      case OPCODE_SLT:
+      case OPCODE_SNE:
+      case OPCODE_SSG:
+      case OPCODE_SUB:
+      case OPCODE_SWZ:
+      case OPCODE_TEX:
+      case OPCODE_TXB:
+      case OPCODE_TXL:
+      case OPCODE_TXP:
+      case OPCODE_TRUNC:
+      case OPCODE_XPD:
+         break;
+      default:
+         return GL_FALSE;
+      }
+
+      if (inst->CondUpdate ||
+          inst->DstReg.CondMask != COND_TR)
+         return GL_FALSE;
+
+      for (i = 0; i < _mesa_num_inst_src_regs(inst->Opcode); i++) {
+         if (!span_src_ok(program, inst, &inst->SrcReg[i]))
+            return GL_FALSE;
+      }
+
+      if (_mesa_num_inst_dst_regs(inst->Opcode)) {
+         const struct prog_dst_register *dstReg = &inst->DstReg;
+
+         if (dstReg->RelAddr)
+            return GL_FALSE;
+         if (dstReg->File == PROGRAM_TEMPORARY) {
+            if (dstReg->Index >= program->NumTemporaries)
+               return GL_FALSE;
+         }
+         else if (dstReg->File == PROGRAM_OUTPUT) {
+            if (dstReg->Index >= MAX_PROGRAM_OUTPUTS)
+               return GL_FALSE;
+         }
+         else {
+            return GL_FALSE;
+         }
+      }
+   }
+
+   return GL_TRUE;
+}
+
+
+/**
+ * Allocate the span machine, or grow it to hold the program's
+ * temporaries.
+ * \return GL_FALSE if out of memory
+ */
+GLboolean
+_mesa_reserve_program_span_machine(struct gl_program_span_machine **span,
+                                   const struct gl_program *program)
+{
+   struct gl_program_span_machine *sm = *span;
+
+   if (!sm) {
+      sm = _mesa_align_calloc(sizeof(*sm), 16);
+      if (!sm)
+         return GL_FALSE;
+      *span = sm;
+   }
+
+   if (sm->NumTemporaries < program->NumTemporaries) {
+      _mesa_align_free(sm->Temporaries);
+      sm->Temporaries = _mesa_align_calloc(program->NumTemporaries *
+                                           sizeof(sm->Temporaries[0]), 16);
+      if (!sm->Temporaries) {
+         sm->NumTemporaries = 0;
+         return GL_FALSE;
+      }
+      sm->NumTemporaries = program->NumTemporaries;
+   }
+
+   return GL_TRUE;
+}
+
+
+void
+_mesa_free_program_span_machine(struct gl_program_span_machine *span)
+{
+   if (span) {
+      _mesa_align_free(span->Temporaries);
+      _mesa_align_free(span);
+   }
+}
+
+
+/**
+ * Return the per-fragment storage of a register, or NULL if the register
+ * has the same value for all fragments.
+ */
+static inline GLfloat (*
+get_span_register(const struct prog_src_register *source,
+                  struct gl_program_span_machine *span))[PROG_SPAN_CHUNK]
+{
+   switch (source->File) {
+   case PROGRAM_TEMPORARY:
+      return span->Temporaries[source->Index];
+   case PROGRAM_INPUT:
+      return span->Inputs[source->Index];
+   case PROGRAM_OUTPUT:
+      return span->Outputs[source->Index];
+   default:
+      return NULL;
+   }
+}
+
+
+/**
+ * Fetch a source register for n fragments, as fetch_vector4() does for
+ * one.  On return, result[i] points to the n values of component i,
+ * either in the register itself or in the scratch storage.
+ */
+static void
+fetch_span_vector4(const struct prog_src_register *source,
+                   const struct gl_program_machine *machine,
+                   struct gl_program_span_machine *span, GLuint n,
+                   GLfloat (*scratch)[PROG_SPAN_CHUNK],
+                   const GLfloat *result[4])
+{
+   GLfloat (*reg)[PROG_SPAN_CHUNK] = get_span_register(source, span);
+   GLuint c, i;
+
+   if (!reg) {
+      /* constant, broadcast it */
+      GLfloat value[4];
+      fetch_vector4(source, machine, value);
+      for (c = 0; c < 4; c++) {
+         for (i = 0; i < n; i++)
+            scratch[c][i] = value[c];
+         result[c] = scratch[c];
+      }
+      return;
+   }
+
+   for (c = 0; c < 4; c++) {
+      const GLfloat *src = reg[GET_SWZ(source->Swizzle, c)];
+
+      if (source->Abs && source->Negate) {
+         for (i = 0; i < n; i++)
+            scratch[c][i] = -FABSF(src[i]);
+         result[c] = scratch[c];
+      }
+      else if (source->Abs) {
+         for (i = 0; i < n; i++)
+            scratch[c][i] = FABSF(src[i]);
+         result[c] = scratch[c];
+      }
+      else if (source->Negate) {
+         for (i = 0; i < n; i++)
+            scratch[c][i] = -src[i];
+         result[c] = scratch[c];
+      }
+      else {
+         result[c] = src;
+      }
+   }
+}
+
+
+/**
+ * Store the result of an instruction for n fragments, as store_vector4()
+ * does for one.
+ */
+static void
+store_span_vector4(const struct prog_instruction *inst,
+                   struct gl_program_span_machine *span, GLuint n,
+                   const GLfloat *value[4])
+{
+   const struct prog_dst_register *dstReg = &inst->DstReg;
+   GLfloat (*dst)[PROG_SPAN_CHUNK] = dstReg->File == PROGRAM_TEMPORARY ?
+      span->Temporaries[dstReg->Index] : span->Outputs[dstReg->Index];
+   GLuint c, i;
+
+   for (c = 0; c < 4; c++) {
+      if (dstReg->WriteMask & (1 << c)) {
+         const GLfloat *v = value[c];
+         GLfloat *d = dst[c];
+
+         if (inst->SaturateMode == SATURATE_ZERO_ONE) {
+            for (i = 0; i < n; i++)
+               d[i] = CLAMP(v[i], 0.0F, 1.0F);
+         }
+         else {
+            memcpy(d, v, n * sizeof(GLfloat));
+         }
+      }
+   }
+}
+
+
+/**
+ * Texture instructions for n fragments.  The texture fetch functions only
+ * take one texcoord, so this loops over the live fragments.
+ */
+static void
+fetch_span_texels(struct gl_context *ctx,
+                  const struct gl_program_machine *machine,
+                  const struct prog_instruction *inst, GLuint n,
+                  const GLubyte mask[], const GLfloat *coord[4],
+                  GLfloat (*result)[PROG_SPAN_CHUNK])
+{
+   GLuint i;
+
+   for (i = 0; i < n; i++) {
+      GLfloat texcoord[4], color[4];
+
+      if (!mask[i])
+         continue;
+
+      texcoord[0] = coord[0][i];
+      texcoord[1] = coord[1][i];
+      texcoord[2] = coord[2][i];
+      texcoord[3] = coord[3][i];
+
+      switch (inst->Opcode) {
+      case OPCODE_TEX:
+         /* see _mesa_execute_program() */
+         texcoord[3] = 1.0f;
+         fetch_texel(ctx, machine, inst, texcoord, 0.0, color);
+         break;
+      case OPCODE_TXB:
+         fetch_texel(ctx, machine, inst, texcoord, texcoord[3], color);
+         break;
+      case OPCODE_TXL:
+         machine->FetchTexelLod(ctx, texcoord, texcoord[3],
+                                machine->Samplers[inst->TexSrcUnit], color);
+         break;
+      case OPCODE_TXP:
+         if (texcoord[3] != 0.0) {
+            texcoord[0] /= texcoord[3];
+            texcoord[1] /= texcoord[3];
+            texcoord[2] /= texcoord[3];
+         }
+         fetch_texel(ctx, machine, inst, texcoord, 0.0, color);
+         break;
+      default:
+         ASSERT(0);
+         return;
+      }
+
+      result[0][i] = color[0];
+      result[1][i] = color[1];
+      result[2][i] = color[2];
+      result[3][i] = color[3];
+   }
+}
+
+
+/**
+ * Component-wise operations on the enabled components of 1, 2 or 3
+ * sources, 'a', 'b' and 'c' are the values of the source components.
+ */
+#define SPAN_OP(EXPR)                                                   \
+   do {                                                                 \
+      for (k = 0; k < 4; k++) {                                         \
+         if (writeMask & (1 << k)) {                                    \
+            const GLfloat *a = src[0][k], *b = src[1][k], *c = src[2][k]; \
+            GLfloat *r = result[k];                                     \
+            (void) b;                                                   \
+            (void) c;                                                   \
+            for (i = 0; i < n; i++)                                     \
+               r[i] = (EXPR);                                           \
+         }                                                              \
+      }                                                                 \
+   } while (0)
+
+/**
+ * Operations with a scalar result in all four components, 'a' and 'b'
+ * are the x components of the first two sources.
+ */
+#define SPAN_SCALAR_OP(EXPR)                                            \
+   do {                                                                 \
+      const GLfloat *a = src[0][0], *b = src[1][0];                     \
+      GLfloat *r = result[0];                                           \
+      (void) a;                                                         \
+      (void) b;                                                         \
+      for (i = 0; i < n; i++)                                           \
+         r[i] = (EXPR);                                                 \
+      value[1] = value[2] = value[3] = r;                               \
+   } while (0)
+
+
+/**
+ * Execute a straight-line fragment program, as accepted by
+ * _mesa_program_span_executable(), for 'count' consecutive fragments
+ * starting at machine->CurElement.  The inputs are read from
+ * machine->Attribs and the outputs are left in span->Outputs.
+ *
+ * \param machine  machine state, initialized as for _mesa_execute_program()
+ * \param span  storage for the registers, which must have been reserved
+ *              for the program
+ * \param count  number of fragments, at most PROG_SPAN_CHUNK
+ * \param mask  the fragments to run, killed fragments are removed
+ * \return GL_FALSE if any fragment executed KIL, else GL_TRUE.
+ */
+GLboolean
+_mesa_execute_program_span(struct gl_context *ctx,
+                           const struct gl_program *program,
+                           struct gl_program_machine *machine,
+                           struct gl_program_span_machine *span,
+                           GLuint count, GLubyte mask[])
+{
+   const GLuint first = machine->CurElement;
+   const GLuint n = count;
+   GLboolean killed = GL_FALSE;
+   GLuint pc, attr, i, k;
+
+   ASSERT(count <= PROG_SPAN_CHUNK);
+   ASSERT(span->NumTemporaries >= program->NumTemporaries);
+
+   machine->CurProgram = program;
+   machine->EnvParams = ctx->FragmentProgram.Parameters;
+
+   /* Transpose the inputs.  Outputs that the program only partially writes
+    * keep the value they have in the interpreter's machine.
+    */
+   for (attr = 0; attr < VARYING_SLOT_MAX; attr++) {
+      if (program->InputsRead & BITFIELD64_BIT(attr)) {
+         const GLfloat (*in)[4] =
+            (const GLfloat (*)[4]) machine->Attribs[attr] + first;
+         for (i = 0; i < n; i++) {
+            span->Inputs[attr][0][i] = in[i][0];
+            span->Inputs[attr][1][i] = in[i][1];
+            span->Inputs[attr][2][i] = in[i][2];
+            span->Inputs[attr][3][i] = in[i][3];
+         }
+      }
+   }
+   for (attr = 0; attr < MAX_PROGRAM_OUTPUTS; attr++) {
+      if (program->OutputsWritten & BITFIELD64_BIT(attr)) {
+         for (k = 0; k < 4; k++) {
+            for (i = 0; i < n; i++)
+               span->Outputs[attr][k][i] = machine->Outputs[attr][k];
+         }
+      }
+   }
+
+   for (pc = 0; pc < program->NumInstructions; pc++) {
+      const struct prog_instruction *inst = program->Instructions + pc;
+      const GLuint writeMask = inst->DstReg.WriteMask;
+      GLfloat (*result)[PROG_SPAN_CHUNK] = span->Result;
+      const GLfloat *src[3][4];
+      const GLfloat *value[4];
+      GLuint numSrc = _mesa_num_inst_src_regs(inst->Opcode);
+
+      if (inst->Opcode == OPCODE_END)
+         break;
+
+      if (inst->Opcode == OPCODE_SWZ ||
+          inst->Opcode == OPCODE_DDX ||
+          inst->Opcode == OPCODE_DDY)
+         numSrc = 0;
+
+      for (i = 0; i < 3; i++) {
+         if (i < numSrc)
+            fetch_span_vector4(&inst->SrcReg[i], machine, span, n,
+                               span->Src[i], src[i]);
+         else
+            src[i][0] = src[i][1] = src[i][2] = src[i][3] = NULL;
+      }
+
+      for (k = 0; k < 4; k++)
+         value[k] = result[k];
+
+      switch (inst->Opcode) {
+      case OPCODE_ABS:
+         SPAN_OP(FABSF(a[i]));
+         break;
+      case OPCODE_ADD:
+         SPAN_OP(a[i] + b[i]);
+         break;
+      case OPCODE_CMP:
+         SPAN_OP(a[i] < 0.0F ? b[i] : c[i]);
+         break;
+      case OPCODE_COS:
+         SPAN_SCALAR_OP((GLfloat) cos(a[i]));
+         break;
+      case OPCODE_DDX:
+      case OPCODE_DDY:
+         {
+            const struct prog_src_register *source = &inst->SrcReg[0];
+
+            if (source->File == PROGRAM_INPUT &&
+                source->Index < (GLint) machine->NumDeriv) {
+               const GLfloat *deriv = inst->Opcode == OPCODE_DDX ?
+                  machine->DerivX[source->Index] :
+                  machine->DerivY[source->Index];
+               GLfloat *invQ = span->Src[0][0];
+
+               for (i = 0; i < n; i++)
+                  invQ[i] = 1.0f /
+                     machine->Attribs[VARYING_SLOT_POS][first + i][3];
+
+               for (k = 0; k < 4; k++) {
+                  const GLfloat d = deriv[GET_SWZ(source->Swizzle, k)];
+                  GLfloat *r = result[k];
+
+                  for (i = 0; i < n; i++)
+                     r[i] = d * invQ[i];
+                  if (source->Abs) {
+                     for (i = 0; i < n; i++)
+                        r[i] = FABSF(r[i]);
+                  }
+                  if (source->Negate) {
+                     for (i = 0; i < n; i++)
+                        r[i] = -r[i];
+                  }
+               }
+            }
+            else {
+               for (k = 0; k < 4; k++)
+                  memset(result[k], 0, n * sizeof(GLfloat));
+            }
+         }
+         break;
+      case OPCODE_DP2:
+         SPAN_SCALAR_OP(src[0][0][i] * src[1][0][i] +
+                        src[0][1][i] * src[1][1][i]);
+         break;
+      case OPCODE_DP3:
+         SPAN_SCALAR_OP(src[0][0][i] * src[1][0][i] +
+                        src[0][1][i] * src[1][1][i] +
+                        src[0][2][i] * src[1][2][i]);
+         break;
+      case OPCODE_DP4:
+         SPAN_SCALAR_OP(src[0][0][i] * src[1][0][i] +
+                        src[0][1][i] * src[1][1][i] +
+                        src[0][2][i] * src[1][2][i] +
+                        src[0][3][i] * src[1][3][i]);
+         break;
+      case OPCODE_DPH:
+         SPAN_SCALAR_OP(src[0][0][i] * src[1][0][i] +
+                        src[0][1][i] * src[1][1][i] +
+                        src[0][2][i] * src[1][2][i] + src[1][3][i]);
+         break;
+      case OPCODE_DST:
+         for (i = 0; i < n; i++) {
+            result[0][i] = 1.0F;
+            result[1][i] = src[0][1][i] * src[1][1][i];
+            result[2][i] = src[0][2][i];
+            result[3][i] = src[1][3][i];
+         }
+         break;
+      case OPCODE_EX2:
+         SPAN_SCALAR_OP((GLfloat) pow(2.0, a[i]));
+         break;
+      case OPCODE_FLR:
+         SPAN_OP(FLOORF(a[i]));
+         break;
+      case OPCODE_FRC:
+         SPAN_OP(a[i] - FLOORF(a[i]));
+         break;
+      case OPCODE_KIL:
+         for (i = 0; i < n; i++) {
+            if (mask[i] &&
+                (src[0][0][i] < 0.0F || src[0][1][i] < 0.0F ||
+                 src[0][2][i] < 0.0F || src[0][3][i] < 0.0F)) {
+               mask[i] = GL_FALSE;
+               killed = GL_TRUE;
+            }
+         }
+         break;
+      case OPCODE_LG2:
+         /* The fast LOG2 macro doesn't meet the precision requirements. */
+         SPAN_SCALAR_OP(a[i] == 0.0F ? -FLT_MAX :
+                        (float)(log(a[i]) * 1.442695F));
+         break;
+      case OPCODE_LIT:
+         {
+            const GLfloat epsilon = 1.0F / 256.0F;      /* from NV VP spec */
+
+            for (i = 0; i < n; i++) {
+               const GLfloat x = MAX2(src[0][0][i], 0.0F);
+               const GLfloat y = MAX2(src[0][1][i], 0.0F);
+               const GLfloat w = CLAMP(src[0][3][i],
+                                       -(128.0F - epsilon),
+                                       (128.0F - epsilon));
+               result[0][i] = 1.0F;
+               result[1][i] = x;
+               if (x > 0.0F) {
+                  if (y == 0.0 && w == 0.0)
+                     result[2][i] = 1.0F;
+                  else
+                     result[2][i] = (GLfloat) pow(y, w);
+               }
+               else {
+                  result[2][i] = 0.0F;
+               }
+               result[3][i] = 1.0F;
+            }
+         }
+         break;
+      case OPCODE_LRP:
+         SPAN_OP(a[i] * b[i] + (1.0F - a[i]) * c[i]);
+         break;
+      case OPCODE_MAD:
+         SPAN_OP(a[i] * b[i] + c[i]);
+         break;
+      case OPCODE_MAX:
+         SPAN_OP(MAX2(a[i], b[i]));
+         break;
+      case OPCODE_MIN:
+         SPAN_OP(MIN2(a[i], b[i]));
+         break;
+      case OPCODE_MOV:
+         SPAN_OP(a[i]);
+         break;
+      case OPCODE_MUL:
+         SPAN_OP(a[i] * b[i]);
+         break;
+      case OPCODE_NOP:
+         break;
+      case OPCODE_POW:
+         SPAN_SCALAR_OP((GLfloat) pow(a[i], b[i]));
+         break;
+      case OPCODE_RCP:
+         SPAN_SCALAR_OP(1.0F / a[i]);
+         break;
+      case OPCODE_RSQ:
+         SPAN_SCALAR_OP(INV_SQRTF(FABSF(a[i])));
+         break;
+      case OPCODE_SCS:
+         for (i = 0; i < n; i++) {
+            result[0][i] = (GLfloat) cos(src[0][0][i]);
+            result[1][i] = (GLfloat) sin(src[0][0][i]);
+            result[2][i] = 0.0;    /* undefined! */
+            result[3][i] = 0.0;    /* undefined! */
+         }
+         break;
+      case OPCODE_SEQ:
+         SPAN_OP((a[i] == b[i]) ? 1.0F : 0.0F);
+         break;
+      case OPCODE_SGE:
+         SPAN_OP((a[i] >= b[i]) ? 1.0F : 0.0F);
+         break;
+      case OPCODE_SGT:
+         SPAN_OP((a[i] > b[i]) ? 1.0F : 0.0F);
+         break;
+      case OPCODE_SIN:
+         SPAN_SCALAR_OP((GLfloat) sin(a[i]));
+         break;
+      case OPCODE_SLE:
+         SPAN_OP((a[i] <= b[i]) ? 1.0F : 0.0F);
+         break;
+      case OPCODE_SLT:
+         SPAN_OP((a[i] < b[i]) ? 1.0F : 0.0F);
+         break;
+      case OPCODE_SNE:
+         SPAN_OP((a[i] != b[i]) ? 1.0F : 0.0F);
+         break;
+      case OPCODE_SSG:
+         SPAN_OP((GLfloat) ((a[i] > 0.0F) - (a[i] < 0.0F)));
+         break;
+      case OPCODE_SUB:
+         SPAN_OP(a[i] - b[i]);
+         break;
+      case OPCODE_SWZ:
+         {
+            const struct prog_src_register *source = &inst->SrcReg[0];
+            GLfloat (*reg)[PROG_SPAN_CHUNK] = get_span_register(source, span);
+            const GLfloat *constant =
+               reg ? NULL : get_src_register_pointer(source, machine);
+
+            for (k = 0; k < 4; k++) {
+               const GLuint swz = GET_SWZ(source->Swizzle, k);
+               const GLboolean negate = (source->Negate >> k) & 1;
+               GLfloat *r = result[k];
+
+               if (swz > SWIZZLE_W || !reg) {
+                  GLfloat v = swz == SWIZZLE_ZERO ? 0.0F :
+                              swz == SWIZZLE_ONE ? 1.0F : constant[swz];
+                  if (negate)
+                     v = -v;
+                  for (i = 0; i < n; i++)
+                     r[i] = v;
+               }
+               else if (negate) {
+                  for (i = 0; i < n; i++)
+                     r[i] = -reg[swz][i];
+               }
+               else {
+                  memcpy(r, reg[swz], n * sizeof(GLfloat));
+               }
+            }
+         }
+         break;
+      case OPCODE_TEX:
+      case OPCODE_TXB:
+      case OPCODE_TXL:
+      case OPCODE_TXP:
+         fetch_span_texels(ctx, machine, inst, n, mask, src[0], result);
+         break;
+      case OPCODE_TRUNC:
+         SPAN_OP((GLfloat) (GLint) a[i]);
+         break;
+      case OPCODE_XPD:
+         for (i = 0; i < n; i++) {
+            result[0][i] = src[0][1][i] * src[1][2][i] -
+                           src[0][2][i] * src[1][1][i];
+            result[1][i] = src[0][2][i] * src[1][0][i] -
+                           src[0][0][i] * src[1][2][i];
+            result[2][i] = src[0][0][i] * src[1][1][i] -
+                           src[0][1][i] * src[1][0][i];
+            result[3][i] = 1.0;
+         }
+         break;
+      default:
+         _mesa_problem(ctx, "Bad opcode %d in _mesa_execute_program_span",
+                       inst->Opcode);
+         return GL_TRUE;
+      }
+
+      if (_mesa_num_inst_dst_regs(inst->Opcode))
+         store_span_vector4(inst, span, n, value);
+   }
+
+   return !killed;
+}
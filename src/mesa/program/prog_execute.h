@@ -79,6 +79,27 @@ struct gl_program_machine
 };
 
 
+/** Number of fragments run together by _mesa_execute_program_span() */
+#define PROG_SPAN_CHUNK 64
+
+
+/**
+ * Register storage for _mesa_execute_program_span().  Each register
+ * holds one array of PROG_SPAN_CHUNK fragments per component.
+ */
+struct gl_program_span_machine
+{
+   GLfloat (*Temporaries)[4][PROG_SPAN_CHUNK];
+   GLuint NumTemporaries; /**< Size of the Temporaries array */
+   GLfloat Inputs[VARYING_SLOT_MAX][4][PROG_SPAN_CHUNK];
+   GLfloat Outputs[MAX_PROGRAM_OUTPUTS][4][PROG_SPAN_CHUNK];
+
+   /** Instruction operands and result */
+   GLfloat Src[3][4][PROG_SPAN_CHUNK];
+   GLfloat Result[4][PROG_SPAN_CHUNK];
+};
+
+
 extern void
 _mesa_get_program_register(struct gl_context *ctx, gl_register_file file,
                            GLuint index, GLfloat val[4]);
@@ -88,5 +109,22 @@ _mesa_execute_program(struct gl_context *ctx,
                       const struct gl_program *program,
                       struct gl_program_machine *machine);
 
+extern GLboolean
+_mesa_program_span_executable(const struct gl_program *program);
+
+extern GLboolean
+_mesa_reserve_program_span_machine(struct gl_program_span_machine **span,
+                                   const struct gl_program *program);
+
+extern void
+_mesa_free_program_span_machine(struct gl_program_span_machine *span);
+
+extern GLboolean
+_mesa_execute_program_span(struct gl_context *ctx,
+                           const struct gl_program *program,
+                           struct gl_program_machine *machine,
+                           struct gl_program_span_machine *span,
+                           GLuint count, GLubyte mask[]);
+
 
 #endif /* PROG_EXECUTE_H */
@@ -42,7 +42,8 @@ struct hash_table {
     hash_compare_func_t  compare;
 
     unsigned num_buckets;
-    struct node buckets[1];
+    unsigned num_entries;
+    struct node *buckets;
 };
 
 
@@ -50,9 +51,18 @@ struct hash_node {
     struct node link;
     const void *key;
     void *data;
+
+    /** Cached result of hash_table::hash for \c key. */
+    unsigned hash_value;
 };
 
 
+/**
+ * Number of entries per bucket, on average, above which the table grows.
+ */
+#define HASH_TABLE_MAX_LOAD 2
+
+
 struct hash_table *
 hash_table_ctor(unsigned num_buckets, hash_func_t hash,
                 hash_compare_func_t compare)
@@ -65,12 +75,18 @@ hash_table_ctor(unsigned num_buckets, hash_func_t hash,
         num_buckets = 16;
     }
 
-    ht = malloc(sizeof(*ht) + ((num_buckets - 1) 
-				     * sizeof(ht->buckets[0])));
+    ht = malloc(sizeof(*ht));
     if (ht != NULL) {
+        ht->buckets = malloc(num_buckets * sizeof(ht->buckets[0]));
+        if (ht->buckets == NULL) {
+            free(ht);
+            return NULL;
+        }
+
         ht->hash = hash;
         ht->compare = compare;
         ht->num_buckets = num_buckets;
+        ht->num_entries = 0;
 
         for (i = 0; i < num_buckets; i++) {
             make_empty_list(& ht->buckets[i]);
@@ -85,6 +101,7 @@ void
 hash_table_dtor(struct hash_table *ht)
 {
    hash_table_clear(ht);
+   free(ht->buckets);
    free(ht);
 }
 
@@ -105,20 +122,62 @@ hash_table_clear(struct hash_table *ht)
 
       assert(is_empty_list(& ht->buckets[i]));
    }
+
+   ht->num_entries = 0;
+}
+
+
+/**
+ * Doubles the number of buckets once the chains get too long
+ *
+ * Tables are often created with a small, fixed bucket count but end up
+ * holding thousands of entries, such as the symbol table of a shader once
+ * the built-in functions are added.  Growing keeps lookups from walking long
+ * chains.
+ */
+static void
+grow(struct hash_table *ht)
+{
+   const unsigned num_buckets = ht->num_buckets * 2;
+   struct node *buckets;
+   unsigned i;
+
+   buckets = malloc(num_buckets * sizeof(buckets[0]));
+   if (buckets == NULL)
+      return;
+
+   for (i = 0; i < num_buckets; i++) {
+      make_empty_list(& buckets[i]);
+   }
+
+   /* Walk each chain from the tail so that entries with the same key keep
+    * their order, the most recently inserted one being found first.
+    */
+   for (i = 0; i < ht->num_buckets; i++) {
+      while (!is_empty_list(& ht->buckets[i])) {
+         struct hash_node *hn = (struct hash_node *) last_elem(& ht->buckets[i]);
+
+         remove_from_list(& hn->link);
+         insert_at_head(& buckets[hn->hash_value % num_buckets], & hn->link);
+      }
+   }
+
+   free(ht->buckets);
+   ht->buckets = buckets;
+   ht->num_buckets = num_buckets;
 }
 
 
 static struct hash_node *
-get_node(struct hash_table *ht, const void *key)
+get_node(struct hash_table *ht, const void *key, unsigned hash_value)
 {
-    const unsigned hash_value = (*ht->hash)(key);
     const unsigned bucket = hash_value % ht->num_buckets;
     struct node *node;
 
     foreach(node, & ht->buckets[bucket]) {
        struct hash_node *hn = (struct hash_node *) node;
 
-       if ((*ht->compare)(hn->key, key) == 0) {
+       if (hn->hash_value == hash_value && (*ht->compare)(hn->key, key) == 0) {
 	  return hn;
        }
     }
@@ -126,10 +185,30 @@ get_node(struct hash_table *ht, const void *key)
     return NULL;
 }
 
+static void
+add_node(struct hash_table *ht, void *data, const void *key,
+         unsigned hash_value)
+{
+    struct hash_node *node;
+
+    if (ht->num_entries >= ht->num_buckets * HASH_TABLE_MAX_LOAD) {
+        grow(ht);
+    }
+
+    node = calloc(1, sizeof(*node));
+
+    node->data = data;
+    node->key = key;
+    node->hash_value = hash_value;
+
+    insert_at_head(& ht->buckets[hash_value % ht->num_buckets], & node->link);
+    ht->num_entries++;
+}
+
 void *
 hash_table_find(struct hash_table *ht, const void *key)
 {
-   struct hash_node *hn = get_node(ht, key);
+   struct hash_node *hn = get_node(ht, key, (*ht->hash)(key));
 
    return (hn == NULL) ? NULL : hn->data;
 }
@@ -137,51 +216,32 @@ hash_table_find(struct hash_table *ht, const void *key)
 void
 hash_table_insert(struct hash_table *ht, void *data, const void *key)
 {
-    const unsigned hash_value = (*ht->hash)(key);
-    const unsigned bucket = hash_value % ht->num_buckets;
-    struct hash_node *node;
-
-    node = calloc(1, sizeof(*node));
-
-    node->data = data;
-    node->key = key;
-
-    insert_at_head(& ht->buckets[bucket], & node->link);
+    add_node(ht, data, key, (*ht->hash)(key));
 }
 
 bool
 hash_table_replace(struct hash_table *ht, void *data, const void *key)
 {
     const unsigned hash_value = (*ht->hash)(key);
-    const unsigned bucket = hash_value % ht->num_buckets;
-    struct node *node;
-    struct hash_node *hn;
-
-    foreach(node, & ht->buckets[bucket]) {
-       hn = (struct hash_node *) node;
+    struct hash_node *hn = get_node(ht, key, hash_value);
 
-       if ((*ht->compare)(hn->key, key) == 0) {
-	  hn->data = data;
-	  return true;
-       }
+    if (hn != NULL) {
+       hn->data = data;
+       return true;
     }
 
-    hn = calloc(1, sizeof(*hn));
-
-    hn->data = data;
-    hn->key = key;
-
-    insert_at_head(& ht->buckets[bucket], & hn->link);
+    add_node(ht, data, key, hash_value);
     return false;
 }
 
 void
 hash_table_remove(struct hash_table *ht, const void *key)
 {
-   struct node *node = (struct node *) get_node(ht, key);
+   struct node *node = (struct node *) get_node(ht, key, (*ht->hash)(key));
    if (node != NULL) {
       remove_from_list(node);
       free(node);
+      ht->num_entries--;
       return;
    }
 }
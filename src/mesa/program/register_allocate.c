@@ -81,6 +81,13 @@
 
 #define NO_REG ~0
 
+/**
+ * Graphs with more nodes than this track which nodes interfere in a hash
+ * set of edges instead of a bitset row per node, which would take
+ * count^2 bits.
+ */
+#define RA_DENSE_ADJACENCY_MAX 4096
+
 struct ra_reg {
    GLboolean *conflicts;
    unsigned int *conflict_list;
@@ -120,7 +127,8 @@ struct ra_node {
    /** @{
     *
     * List of which nodes this node interferes with.  This should be
-    * symmetric with the other node.
+    * symmetric with the other node.  The adjacency bitset is only
+    * allocated for graphs of up to RA_DENSE_ADJACENCY_MAX nodes.
     */
    BITSET_WORD *adjacency;
    unsigned int *adjacency_list;
@@ -141,6 +149,12 @@ struct ra_node {
     */
    GLboolean in_stack;
 
+   /**
+    * Sum of q(B,C) over the neighbors still in the graph, kept up to
+    * date by ra_simplify() as nodes are pushed on the stack.
+    */
+   unsigned int q_total;
+
    /* For an implementation that needs register spilling, this is the
     * approximate cost of spilling this node.
     */
@@ -157,6 +171,15 @@ struct ra_graph {
 
    unsigned int *stack;
    unsigned int stack_count;
+
+   /**
+    * Open-addressed hash set of interfering node pairs, used instead of
+    * the per-node adjacency bitsets for large graphs.  Each edge is
+    * stored once, as (min << 32 | max) + 1 so that 0 marks a free slot.
+    */
+   uint64_t *edges;
+   unsigned int edges_size; /**< power of two */
+   unsigned int edges_count;
 };
 
 /**
@@ -277,12 +300,15 @@ ra_class_add_reg(struct ra_regs *regs, unsigned int c, unsigned int r)
  * Must be called after all conflicts and register classes have been
  * set up and before the register set is used for allocation.
  * To avoid costly q value computation, use the q_values paramater
- * to pass precomputed q values to this function.
+ * to pass precomputed q values to this function.  Drivers with a fixed
+ * register set can generate that table once at build time, the way the
+ * r300 compiler does, since it only depends on the classes and conflicts.
  */
 void
 ra_set_finalize(struct ra_regs *regs, unsigned int **q_values)
 {
-   unsigned int b, c;
+   unsigned int b, c, rc;
+   unsigned int *conflicts;
 
    for (b = 0; b < regs->class_count; b++) {
       regs->classes[b]->q = ralloc_array(regs, unsigned int, regs->class_count);
@@ -297,37 +323,110 @@ ra_set_finalize(struct ra_regs *regs, unsigned int **q_values)
       return;
    }
 
+   for (b = 0; b < regs->class_count; b++) {
+      for (c = 0; c < regs->class_count; c++)
+         regs->classes[b]->q[c] = 0;
+   }
+
    /* Compute, for each class B and C, how many regs of B an
     * allocation to C could conflict with.
+    *
+    * Walk each register's conflict list once, counting its conflicts
+    * in every class, and fold those counts into the q values of the
+    * classes the register belongs to.  This is O(r*c*(conflicts+c))
+    * instead of going over every register for every pair of classes.
     */
-   for (b = 0; b < regs->class_count; b++) {
+   conflicts = ralloc_array(NULL, unsigned int, regs->class_count);
+
+   for (rc = 0; rc < regs->count; rc++) {
+      struct ra_reg *reg = &regs->regs[rc];
+      unsigned int i;
+
+      for (b = 0; b < regs->class_count; b++) {
+         GLboolean *class_regs = regs->classes[b]->regs;
+
+         conflicts[b] = 0;
+         for (i = 0; i < reg->num_conflicts; i++) {
+            if (class_regs[reg->conflict_list[i]])
+               conflicts[b]++;
+         }
+      }
+
       for (c = 0; c < regs->class_count; c++) {
-	 unsigned int rc;
-	 int max_conflicts = 0;
-
-	 for (rc = 0; rc < regs->count; rc++) {
-	    int conflicts = 0;
-	    int i;
-
-	    if (!regs->classes[c]->regs[rc])
-	       continue;
-
-	    for (i = 0; i < regs->regs[rc].num_conflicts; i++) {
-	       unsigned int rb = regs->regs[rc].conflict_list[i];
-	       if (regs->classes[b]->regs[rb])
-		  conflicts++;
-	    }
-	    max_conflicts = MAX2(max_conflicts, conflicts);
-	 }
-	 regs->classes[b]->q[c] = max_conflicts;
+         if (!regs->classes[c]->regs[rc])
+            continue;
+
+         for (b = 0; b < regs->class_count; b++) {
+            regs->classes[b]->q[c] = MAX2(regs->classes[b]->q[c],
+                                          conflicts[b]);
+         }
       }
    }
+
+   ralloc_free(conflicts);
+}
+
+static inline unsigned int
+ra_edge_hash(uint64_t key, unsigned int size)
+{
+   return (unsigned int) ((key * 0x9e3779b97f4a7c15ull) >> 32) & (size - 1);
+}
+
+static inline uint64_t
+ra_edge_key(unsigned int n1, unsigned int n2)
+{
+   if (n1 > n2) {
+      unsigned int tmp = n1;
+      n1 = n2;
+      n2 = tmp;
+   }
+   return (((uint64_t) n1 << 32) | n2) + 1;
+}
+
+/**
+ * Adds the edge to the hash set, returning GL_FALSE if it was already
+ * present.
+ */
+static GLboolean
+ra_add_edge(struct ra_graph *g, uint64_t key)
+{
+   unsigned int i;
+
+   if (g->edges_count * 2 >= g->edges_size) {
+      uint64_t *old = g->edges;
+      unsigned int old_size = g->edges_size;
+
+      g->edges_size *= 2;
+      g->edges = rzalloc_array(g, uint64_t, g->edges_size);
+      for (i = 0; i < old_size; i++) {
+         if (old[i]) {
+            unsigned int j = ra_edge_hash(old[i], g->edges_size);
+
+            while (g->edges[j])
+               j = (j + 1) & (g->edges_size - 1);
+            g->edges[j] = old[i];
+         }
+      }
+      ralloc_free(old);
+   }
+
+   i = ra_edge_hash(key, g->edges_size);
+   while (g->edges[i]) {
+      if (g->edges[i] == key)
+         return GL_FALSE;
+      i = (i + 1) & (g->edges_size - 1);
+   }
+
+   g->edges[i] = key;
+   g->edges_count++;
+   return GL_TRUE;
 }
 
 static void
 ra_add_node_adjacency(struct ra_graph *g, unsigned int n1, unsigned int n2)
 {
-   BITSET_SET(g->nodes[n1].adjacency, n2);
+   if (g->nodes[n1].adjacency)
+      BITSET_SET(g->nodes[n1].adjacency, n2);
 
    if (g->nodes[n1].adjacency_count >=
        g->nodes[n1].adjacency_list_size) {
@@ -354,9 +453,18 @@ ra_alloc_interference_graph(struct ra_regs *regs, unsigned int count)
 
    g->stack = rzalloc_array(g, unsigned int, count);
 
+   if (count > RA_DENSE_ADJACENCY_MAX) {
+      g->edges_size = 1;
+      while (g->edges_size < count * 8)
+         g->edges_size *= 2;
+      g->edges = rzalloc_array(g, uint64_t, g->edges_size);
+   }
+
    for (i = 0; i < count; i++) {
-      int bitset_count = BITSET_WORDS(count);
-      g->nodes[i].adjacency = rzalloc_array(g, BITSET_WORD, bitset_count);
+      if (!g->edges) {
+         int bitset_count = BITSET_WORDS(count);
+         g->nodes[i].adjacency = rzalloc_array(g, BITSET_WORD, bitset_count);
+      }
 
       g->nodes[i].adjacency_list_size = 4;
       g->nodes[i].adjacency_list =
@@ -381,13 +489,21 @@ void
 ra_add_node_interference(struct ra_graph *g,
 			 unsigned int n1, unsigned int n2)
 {
-   if (!BITSET_TEST(g->nodes[n1].adjacency, n2)) {
+   GLboolean new_edge;
+
+   if (g->edges)
+      new_edge = n1 != n2 && ra_add_edge(g, ra_edge_key(n1, n2));
+   else
+      new_edge = !BITSET_TEST(g->nodes[n1].adjacency, n2);
+
+   if (new_edge) {
       ra_add_node_adjacency(g, n1, n2);
       ra_add_node_adjacency(g, n2, n1);
    }
 }
 
-static GLboolean pq_test(struct ra_graph *g, unsigned int n)
+static unsigned int
+ra_node_q_total(struct ra_graph *g, unsigned int n)
 {
    unsigned int j;
    unsigned int q = 0;
@@ -402,7 +518,50 @@ static GLboolean pq_test(struct ra_graph *g, unsigned int n)
       }
    }
 
-   return q < g->regs->classes[n_class]->p;
+   return q;
+}
+
+static inline GLboolean
+pq_test(struct ra_graph *g, unsigned int n)
+{
+   return g->nodes[n].q_total < g->regs->classes[g->nodes[n].class]->p;
+}
+
+/** Max-heap of node numbers, for ra_simplify(). */
+static void
+ra_heap_push(unsigned int *heap, unsigned int *count, unsigned int n)
+{
+   unsigned int i = (*count)++;
+
+   while (i > 0 && heap[(i - 1) / 2] < n) {
+      heap[i] = heap[(i - 1) / 2];
+      i = (i - 1) / 2;
+   }
+   heap[i] = n;
+}
+
+static unsigned int
+ra_heap_pop(unsigned int *heap, unsigned int *count)
+{
+   unsigned int top = heap[0];
+   unsigned int last = heap[--(*count)];
+   unsigned int i = 0;
+
+   for (;;) {
+      unsigned int child = i * 2 + 1;
+
+      if (child >= *count)
+         break;
+      if (child + 1 < *count && heap[child + 1] > heap[child])
+         child++;
+      if (heap[child] <= last)
+         break;
+      heap[i] = heap[child];
+      i = child;
+   }
+   heap[i] = last;
+
+   return top;
 }
 
 /**
@@ -410,6 +569,13 @@ static GLboolean pq_test(struct ra_graph *g, unsigned int n)
  * trivially-colorable nodes into a stack of nodes to be colored,
  * removing them from the graph, and rinsing and repeating.
  *
+ * Rather than re-running the pq test on every node until nothing
+ * changes, each node's q total is updated as its neighbors are
+ * removed, and nodes that become colorable are queued.  The queue is
+ * ordered so that nodes get pushed in the same order as repeated
+ * passes from the highest node number down would push them: a node
+ * freed up by a lower-numbered node waits for the next pass.
+ *
  * Returns GL_TRUE if all nodes were removed from the graph.  GL_FALSE
  * means that either spilling will be required, or optimistic coloring
  * should be applied.
@@ -417,25 +583,62 @@ static GLboolean pq_test(struct ra_graph *g, unsigned int n)
 GLboolean
 ra_simplify(struct ra_graph *g)
 {
-   GLboolean progress = GL_TRUE;
-   int i;
+   unsigned int *heap, *next;
+   unsigned int heap_count = 0, next_count = 0;
+   unsigned int i;
 
-   while (progress) {
-      progress = GL_FALSE;
+   heap = ralloc_array(g, unsigned int, g->count);
+   next = ralloc_array(g, unsigned int, g->count);
 
-      for (i = g->count - 1; i >= 0; i--) {
-	 if (g->nodes[i].in_stack || g->nodes[i].reg != NO_REG)
-	    continue;
+   for (i = 0; i < g->count; i++) {
+      if (g->nodes[i].in_stack || g->nodes[i].reg != NO_REG)
+	 continue;
 
-	 if (pq_test(g, i)) {
-	    g->stack[g->stack_count] = i;
-	    g->stack_count++;
-	    g->nodes[i].in_stack = GL_TRUE;
-	    progress = GL_TRUE;
-	 }
+      g->nodes[i].q_total = ra_node_q_total(g, i);
+      if (pq_test(g, i))
+         ra_heap_push(heap, &heap_count, i);
+   }
+
+   while (heap_count) {
+      while (heap_count) {
+         unsigned int n = ra_heap_pop(heap, &heap_count);
+         unsigned int j;
+
+         g->stack[g->stack_count] = n;
+         g->stack_count++;
+         g->nodes[n].in_stack = GL_TRUE;
+
+         for (j = 0; j < g->nodes[n].adjacency_count; j++) {
+            unsigned int n2 = g->nodes[n].adjacency_list[j];
+            struct ra_node *node2 = &g->nodes[n2];
+            unsigned int p2;
+
+            if (node2->in_stack || node2->reg != NO_REG)
+               continue;
+
+            p2 = g->regs->classes[node2->class]->p;
+            if (node2->q_total < p2)
+               continue;
+
+            node2->q_total -=
+               g->regs->classes[node2->class]->q[g->nodes[n].class];
+            if (node2->q_total < p2) {
+               if (n2 < n)
+                  ra_heap_push(heap, &heap_count, n2);
+               else
+                  next[next_count++] = n2;
+            }
+         }
       }
+
+      for (i = 0; i < next_count; i++)
+         ra_heap_push(heap, &heap_count, next[i]);
+      next_count = 0;
    }
 
+   ralloc_free(heap);
+   ralloc_free(next);
+
    for (i = 0; i < g->count; i++) {
       if (!g->nodes[i].in_stack)
 	 return GL_FALSE;
@@ -454,8 +657,11 @@ ra_simplify(struct ra_graph *g)
 GLboolean
 ra_select(struct ra_graph *g)
 {
-   int i;
+   unsigned int i;
    int start_search_reg = 0;
+   BITSET_WORD *used;
+
+   used = ralloc_array(g, BITSET_WORD, BITSET_WORDS(g->regs->count));
 
    while (g->stack_count != 0) {
       unsigned int ri;
@@ -463,28 +669,32 @@ ra_select(struct ra_graph *g)
       int n = g->stack[g->stack_count - 1];
       struct ra_class *c = g->regs->classes[g->nodes[n].class];
 
-      /* Find the lowest-numbered reg which is not used by a member
-       * of the graph adjacent to us.
+      /* Mark the registers taken by a member of the graph adjacent to
+       * us, then find the lowest-numbered reg which isn't.
        */
+      memset(used, 0, BITSET_WORDS(g->regs->count) * sizeof(BITSET_WORD));
+      for (i = 0; i < g->nodes[n].adjacency_count; i++) {
+         unsigned int n2 = g->nodes[n].adjacency_list[i];
+         struct ra_reg *reg2;
+         unsigned int k;
+
+         if (g->nodes[n2].in_stack || g->nodes[n2].reg == NO_REG)
+            continue;
+
+         reg2 = &g->regs->regs[g->nodes[n2].reg];
+         for (k = 0; k < reg2->num_conflicts; k++)
+            BITSET_SET(used, reg2->conflict_list[k]);
+      }
+
       for (ri = 0; ri < g->regs->count; ri++) {
          r = (start_search_reg + ri) % g->regs->count;
-	 if (!c->regs[r])
-	    continue;
-
-	 /* Check if any of our neighbors conflict with this register choice. */
-	 for (i = 0; i < g->nodes[n].adjacency_count; i++) {
-	    unsigned int n2 = g->nodes[n].adjacency_list[i];
-
-	    if (!g->nodes[n2].in_stack &&
-		g->regs->regs[r].conflicts[g->nodes[n2].reg]) {
-	       break;
-	    }
-	 }
-	 if (i == g->nodes[n].adjacency_count)
+	 if (c->regs[r] && !BITSET_TEST(used, r))
 	    break;
       }
-      if (ri == g->regs->count)
+      if (ri == g->regs->count) {
+         ralloc_free(used);
 	 return GL_FALSE;
+      }
 
       g->nodes[n].reg = r;
       g->nodes[n].in_stack = GL_FALSE;
@@ -494,6 +704,7 @@ ra_select(struct ra_graph *g)
          start_search_reg = r + 1;
    }
 
+   ralloc_free(used);
    return GL_TRUE;
 }
 
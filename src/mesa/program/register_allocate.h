@@ -32,7 +32,8 @@ struct ra_regs;
  * Register set setup.
  *
  * This should be done once at backend initializaion, as
- * ra_set_finalize is O(r^2*c^2).  The registers may be virtual
+ * ra_set_finalize is O(r*c*(conflicts+c)), unless the q values are
+ * precomputed and passed in.  The registers may be virtual
  * registers, such as aligned register pairs that conflict with the
  * two real registers from which they are composed.
  */
@@ -133,7 +133,7 @@ struct _mesa_symbol_table_iterator {
 static void
 check_symbol_table(struct _mesa_symbol_table *table)
 {
-#if 1
+#ifndef NDEBUG
     struct scope_level *scope;
 
     for (scope = table->current_scope; scope != NULL; scope = scope->next) {
@@ -28,6 +28,7 @@
 
 #include "main/glheader.h"
 #include "main/context.h"
+#include "main/macros.h"
 
 #include "pipe/p_defines.h"
 #include "st_context.h"
@@ -35,6 +36,7 @@
 #include "st_cb_bitmap.h"
 #include "st_program.h"
 #include "st_manager.h"
+#include "st_debug.h"
 
 
 /**
@@ -75,13 +77,36 @@ static const struct st_tracked_state *atoms[] =
 
 void st_init_atoms( struct st_context *st )
 {
-   /* no-op */
+   STATIC_ASSERT(Elements(atoms) <= Elements(st->atom_stats.atom_updates));
 }
 
 
 void st_destroy_atoms( struct st_context *st )
 {
-   /* no-op */
+   if (ST_DEBUG & DEBUG_ATOMS) {
+      const unsigned validations = MAX2(st->atom_stats.validations, 1);
+      GLuint i;
+
+      debug_printf("st: %u validations, %u atom updates, %.2f per "
+                   "validation\n", st->atom_stats.validations,
+                   st->atom_stats.updates,
+                   (float) st->atom_stats.updates / validations);
+
+      for (i = 0; i < Elements(atoms); i++) {
+         debug_printf("st:   %-28s %8u\n", atoms[i]->name,
+                      st->atom_stats.atom_updates[i]);
+      }
+   }
+}
+
+
+static INLINE void
+count_atom_update( struct st_context *st, GLuint i )
+{
+   if (ST_DEBUG & DEBUG_ATOMS) {
+      st->atom_stats.updates++;
+      st->atom_stats.atom_updates[i]++;
+   }
 }
 
 
@@ -158,9 +183,18 @@ void st_validate_state( struct st_context *st )
    st->dirty.st |= st->ctx->NewDriverState;
    st->ctx->NewDriverState = 0;
 
+   /* Pick a new variant if uniforms the fragment shader was specialized on
+    * may have changed.
+    */
+   if (st->fp && st->fp->num_specialized_uniforms &&
+       ((state->mesa & _NEW_PROGRAM_CONSTANTS) ||
+        (state->st & ST_NEW_FS_CONSTANTS))) {
+      state->st |= ST_NEW_FRAGMENT_PROGRAM;
+   }
+
    check_attrib_edgeflag(st);
 
-   if (state->mesa)
+   if (state->mesa || (state->st & ST_NEW_SHADER_CONSTANTS))
       st_flush_bitmap_cache(st);
 
    check_program_state( st );
@@ -172,6 +206,9 @@ void st_validate_state( struct st_context *st )
 
    /*printf("%s %x/%x\n", __FUNCTION__, state->mesa, state->st);*/
 
+   if (ST_DEBUG & DEBUG_ATOMS)
+      st->atom_stats.validations++;
+
 #ifdef DEBUG
    if (1) {
 #else
@@ -199,6 +236,7 @@ void st_validate_state( struct st_context *st )
 
 	 if (check_state(state, &atom->dirty)) {
 	    atoms[i]->update( st );
+	    count_atom_update(st, i);
 	    /*printf("after: %x\n", atom->dirty.mesa);*/
 	 }
 
@@ -217,8 +255,10 @@ void st_validate_state( struct st_context *st )
    }
    else {
       for (i = 0; i < Elements(atoms); i++) {	 
-	 if (check_state(state, &atoms[i]->dirty))
+	 if (check_state(state, &atoms[i]->dirty)) {
 	    atoms[i]->update( st );
+	    count_atom_update(st, i);
+	 }
       }
    }
 
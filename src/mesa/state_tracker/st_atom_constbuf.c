@@ -128,7 +128,8 @@ const struct st_tracked_state st_update_vs_constants = {
    "st_update_vs_constants",				/* name */
    {							/* dirty */
       _NEW_PROGRAM_CONSTANTS,                           /* mesa */
-      ST_NEW_VERTEX_PROGRAM,				/* st */
+      (ST_NEW_VERTEX_PROGRAM |
+       ST_NEW_VS_CONSTANTS),				/* st */
    },
    update_vs_constants					/* update */
 };
@@ -151,7 +152,8 @@ const struct st_tracked_state st_update_fs_constants = {
    "st_update_fs_constants",				/* name */
    {							/* dirty */
       _NEW_PROGRAM_CONSTANTS,                           /* mesa */
-      ST_NEW_FRAGMENT_PROGRAM,				/* st */
+      (ST_NEW_FRAGMENT_PROGRAM |
+       ST_NEW_FS_CONSTANTS),				/* st */
    },
    update_fs_constants					/* update */
 };
@@ -173,7 +175,8 @@ const struct st_tracked_state st_update_gs_constants = {
    "st_update_gs_constants",				/* name */
    {							/* dirty */
       _NEW_PROGRAM_CONSTANTS,                           /* mesa */
-      ST_NEW_GEOMETRY_PROGRAM,				/* st */
+      (ST_NEW_GEOMETRY_PROGRAM |
+       ST_NEW_GS_CONSTANTS),				/* st */
    },
    update_gs_constants					/* update */
 };
@@ -88,6 +88,19 @@ update_fp( struct st_context *st )
    key.clamp_color = st->clamp_frag_color_in_shader &&
                      st->ctx->Color._ClampFragmentColor;
 
+   /* _NEW_PROGRAM_CONSTANTS */
+   if (stfp->num_specialized_uniforms) {
+      const struct gl_program_parameter_list *params =
+         stfp->Base.Base.Parameters;
+      GLuint i;
+
+      key.specialized = 1;
+      for (i = 0; i < stfp->num_specialized_uniforms; i++) {
+         key.uniform_values[i] =
+            params->ParameterValues[stfp->specialized_uniforms[i]][0];
+      }
+   }
+
    st->fp_variant = st_get_fp_variant(st, stfp, &key);
 
    st_reference_fragprog(st, &st->fp, stfp);
@@ -38,6 +38,7 @@
 
 #include "st_context.h"
 #include "st_cb_bufferobjects.h"
+#include "st_cb_readpixels.h"
 #include "st_debug.h"
 
 #include "pipe/p_context.h"
@@ -78,6 +79,8 @@ st_bufferobj_free(struct gl_context *ctx, struct gl_buffer_object *obj)
    assert(obj->RefCount == 0);
    assert(st_obj->transfer == NULL);
 
+   st_discard_pbo_readback(st_context(ctx), st_obj);
+
    if (st_obj->buffer) 
       pipe_resource_reference(&st_obj->buffer, NULL);
 
@@ -121,6 +124,8 @@ st_bufferobj_subdata(struct gl_context *ctx,
       return;
    }
 
+   st_finish_pbo_readback(st_context(ctx), st_obj);
+
    /* Now that transfers are per-context, we don't have to figure out
     * flushing here.  Usually drivers won't need to flush in this case
     * even if the buffer is currently referenced by hardware - they
@@ -157,6 +162,8 @@ st_bufferobj_get_subdata(struct gl_context *ctx,
       return;
    }
 
+   st_finish_pbo_readback(st_context(ctx), st_obj);
+
    pipe_buffer_read(st_context(ctx)->pipe, st_obj->buffer,
                     offset, size, data);
 }
@@ -182,6 +189,9 @@ st_bufferobj_data(struct gl_context *ctx,
    struct st_buffer_object *st_obj = st_buffer_object(obj);
    unsigned bind, pipe_usage;
 
+   /* The old contents are going away, including any pending readback. */
+   st_discard_pbo_readback(st, st_obj);
+
    if (st_obj->Base.Size == size && st_obj->Base.Usage == usage && data) {
       /* Just discard the old contents and write new data.
        * This should be the same as creating a new buffer, but we avoid
@@ -243,6 +253,19 @@ st_bufferobj_data(struct gl_context *ctx,
       pipe_usage = PIPE_USAGE_DEFAULT;
    }
 
+   if (obj->Immutable) {
+      /* glBufferStorage: the flags say more about how the buffer will be
+       * used than the usage hint does.
+       */
+      if (obj->StorageFlags & GL_CLIENT_STORAGE_BIT)
+         pipe_usage = PIPE_USAGE_STAGING;
+      else if (obj->StorageFlags & GL_MAP_PERSISTENT_BIT)
+         pipe_usage = PIPE_USAGE_STREAM;
+      else if (!(obj->StorageFlags & (GL_DYNAMIC_STORAGE_BIT |
+                                      GL_MAP_WRITE_BIT)))
+         pipe_usage = PIPE_USAGE_IMMUTABLE;
+   }
+
    pipe_resource_reference( &st_obj->buffer, NULL );
 
    if (ST_DEBUG & DEBUG_BUFFER) {
@@ -268,6 +291,29 @@ st_bufferobj_data(struct gl_context *ctx,
 }
 
 
+/**
+ * Bring back the application's persistent mapping, if Mesa's own mapping
+ * had set it aside.
+ */
+static void
+restore_saved_map(struct st_buffer_object *st_obj)
+{
+   struct gl_buffer_object *obj = &st_obj->Base;
+
+   if (!st_obj->saved_map.Pointer)
+      return;
+
+   st_obj->transfer = st_obj->saved_map.transfer;
+   obj->Pointer = st_obj->saved_map.Pointer;
+   obj->Offset = st_obj->saved_map.Offset;
+   obj->Length = st_obj->saved_map.Length;
+   obj->AccessFlags = st_obj->saved_map.AccessFlags;
+
+   st_obj->saved_map.transfer = NULL;
+   st_obj->saved_map.Pointer = NULL;
+}
+
+
 /**
  * Called via glMapBufferRange().
  */
@@ -308,11 +354,38 @@ st_bufferobj_map_range(struct gl_context *ctx,
    if (access & MESA_MAP_NOWAIT_BIT)
       flags |= PIPE_TRANSFER_DONTBLOCK;
 
+   if (access & GL_MAP_PERSISTENT_BIT)
+      flags |= PIPE_TRANSFER_PERSISTENT;
+
+   if (access & GL_MAP_COHERENT_BIT)
+      flags |= PIPE_TRANSFER_COHERENT;
+
    assert(offset >= 0);
    assert(length >= 0);
    assert(offset < obj->Size);
    assert(offset + length <= obj->Size);
 
+   if (access & GL_MAP_INVALIDATE_BUFFER_BIT)
+      st_discard_pbo_readback(st_context(ctx), st_obj);
+   else
+      st_finish_pbo_readback(st_context(ctx), st_obj);
+
+   if (_mesa_bufferobj_mapped(obj)) {
+      /* The only mapping that may be active at this point is a persistent
+       * one made by the application.  Mesa wants to look at the buffer on
+       * the CPU (index scans, PBO transfers, ...), so set the application's
+       * mapping aside until the matching unmap.
+       */
+      assert(obj->AccessFlags & GL_MAP_PERSISTENT_BIT);
+      assert(!st_obj->saved_map.Pointer);
+
+      st_obj->saved_map.transfer = st_obj->transfer;
+      st_obj->saved_map.Pointer = obj->Pointer;
+      st_obj->saved_map.Offset = obj->Offset;
+      st_obj->saved_map.Length = obj->Length;
+      st_obj->saved_map.AccessFlags = obj->AccessFlags;
+   }
+
    obj->Pointer = pipe_buffer_map_range(pipe,
                                         st_obj->buffer,
                                         offset, length,
@@ -325,6 +398,7 @@ st_bufferobj_map_range(struct gl_context *ctx,
    }
    else {
       st_obj->transfer = NULL;
+      restore_saved_map(st_obj);
    }
 
    return obj->Pointer;
@@ -369,6 +443,8 @@ st_bufferobj_unmap(struct gl_context *ctx, struct gl_buffer_object *obj)
    obj->Pointer = NULL;
    obj->Offset = 0;
    obj->Length = 0;
+
+   restore_saved_map(st_obj);
    return GL_TRUE;
 }
 
@@ -392,8 +468,11 @@ st_copy_buffer_subdata(struct gl_context *ctx,
       return;
 
    /* buffer should not already be mapped */
-   assert(!src->Pointer);
-   assert(!dst->Pointer);
+   assert(!_mesa_check_disallowed_mapping(src));
+   assert(!_mesa_check_disallowed_mapping(dst));
+
+   st_finish_pbo_readback(st_context(ctx), srcObj);
+   st_finish_pbo_readback(st_context(ctx), dstObj);
 
    u_box_1d(readOffset, size, &box);
 
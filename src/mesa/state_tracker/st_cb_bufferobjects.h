@@ -34,6 +34,7 @@
 struct dd_function_table;
 struct pipe_resource;
 struct st_context;
+struct st_pbo_readback;
 
 /**
  * State_tracker vertex/pixel buffer object, derived from Mesa's
@@ -44,6 +45,21 @@ struct st_buffer_object
    struct gl_buffer_object Base;
    struct pipe_resource *buffer;     /* GPU storage */
    struct pipe_transfer *transfer; /* In-progress map information */
+
+   /**
+    * The application's persistent mapping (GL_ARB_buffer_storage), set
+    * aside while Mesa maps the buffer for its own CPU access.
+    */
+   struct {
+      struct pipe_transfer *transfer;
+      GLvoid *Pointer;
+      GLintptr Offset;
+      GLsizeiptr Length;
+      GLbitfield AccessFlags;
+   } saved_map;
+
+   /** A glReadPixels into this buffer that hasn't been copied into it yet */
+   struct st_pbo_readback *readback;
 };
 
 
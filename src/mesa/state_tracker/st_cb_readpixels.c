@@ -31,6 +31,9 @@
 #include "main/readpix.h"
 #include "main/enums.h"
 #include "main/framebuffer.h"
+#include "main/bufferobj.h"
+#include "vbo/vbo.h"
+#include "util/u_atomic.h"
 #include "util/u_inlines.h"
 #include "util/u_format.h"
 
@@ -38,6 +41,8 @@
 #include "st_atom.h"
 #include "st_context.h"
 #include "st_cb_bitmap.h"
+#include "st_cb_bufferobjects.h"
+#include "st_cb_flush.h"
 #include "st_cb_readpixels.h"
 #include "state_tracker/st_cb_texture.h"
 #include "state_tracker/st_format.h"
@@ -45,55 +50,55 @@
 
 
 /**
- * This uses a blit to copy the read buffer to a texture format which matches
- * the format and type combo and then a fast read-back is done using memcpy.
- * We can do arbitrary X/Y/Z/W/0/1 swizzling here as long as there is
- * a format which matches the swizzling.
- *
- * If such a format isn't available, we fall back to _mesa_readpixels.
+ * A glReadPixels into a pixel pack buffer that has been queued on the GPU
+ * but not copied into the buffer yet.
+ */
+struct st_pbo_readback
+{
+   struct pipe_resource *resource;  /**< staging copy of the pixels */
+   struct pipe_fence_handle *fence;
+   GLsizei width, height;
+   GLenum format, type;
+   struct gl_pixelstore_attrib pack;
+   GLintptr offset;                 /**< of the pixels in the buffer */
+};
+
+/**
+ * Number of queued readbacks in the whole process.  Only used to skip
+ * looking for them when drawing, so it doesn't matter which context or
+ * screen they belong to.
+ */
+static int32_t st_pending_pbo_readbacks = 0;
+
+
+/**
+ * Blit the region being read back to a new staging texture in a format
+ * which matches the format and type combo, so that it can be copied out
+ * with memcpy.  We can do arbitrary X/Y/Z/W/0/1 swizzling here as long
+ * as there is a format which matches the swizzling.
  *
- * NOTE: Some drivers use a blit to convert between tiled and linear
- *       texture layouts during texture uploads/downloads, so the blit
- *       we do here should be free in such cases.
+ * \return the staging texture, or NULL if the blit can't be done
  */
-static void
-st_readpixels(struct gl_context *ctx, GLint x, GLint y,
-              GLsizei width, GLsizei height,
-              GLenum format, GLenum type,
-              const struct gl_pixelstore_attrib *pack,
-              GLvoid *pixels)
+static struct pipe_resource *
+blit_to_staging(struct st_context *st, struct st_renderbuffer *strb,
+                GLint x, GLint y, GLsizei width, GLsizei height,
+                GLenum format, GLenum type,
+                const struct gl_pixelstore_attrib *pack)
 {
-   struct st_context *st = st_context(ctx);
-   struct gl_renderbuffer *rb =
-         _mesa_get_read_renderbuffer_for_format(ctx, format);
-   struct st_renderbuffer *strb = st_renderbuffer(rb);
-   struct pipe_context *pipe = st->pipe;
-   struct pipe_screen *screen = pipe->screen;
-   struct pipe_resource *src;
-   struct pipe_resource *dst = NULL;
+   struct gl_context *ctx = st->ctx;
+   struct gl_renderbuffer *rb = &strb->Base;
+   struct pipe_screen *screen = st->pipe->screen;
+   struct pipe_resource *src = strb->texture;
+   struct pipe_resource *dst;
    struct pipe_resource dst_templ;
    enum pipe_format dst_format, src_format;
    struct pipe_blit_info blit;
    unsigned bind = PIPE_BIND_TRANSFER_READ;
-   struct pipe_transfer *tex_xfer;
-   ubyte *map = NULL;
-
-   /* Validate state (to be sure we have up-to-date framebuffer surfaces)
-    * and flush the bitmap cache prior to reading. */
-   st_validate_state(st);
-   st_flush_bitmap_cache(st);
-
-   if (!st->prefer_blit_based_texture_transfer) {
-      goto fallback;
-   }
-
-   /* This must be done after state validation. */
-   src = strb->texture;
 
    /* XXX Fallback for depth-stencil formats due to an incomplete
     * stencil blit implementation in some drivers. */
    if (format == GL_DEPTH_STENCIL) {
-      goto fallback;
+      return NULL;
    }
 
    /* We are creating a texture of the size of the region being read back.
@@ -101,26 +106,18 @@ st_readpixels(struct gl_context *ctx, GLint x, GLint y,
    if (!screen->get_param(screen, PIPE_CAP_NPOT_TEXTURES) &&
        (!util_is_power_of_two(width) ||
         !util_is_power_of_two(height))) {
-      goto fallback;
+      return NULL;
    }
 
    /* If the base internal format and the texture format don't match, we have
     * to use the slow path. */
    if (rb->_BaseFormat !=
        _mesa_get_format_base_format(rb->Format)) {
-      goto fallback;
-   }
-
-   /* See if the texture format already matches the format and type,
-    * in which case the memcpy-based fast path will likely be used and
-    * we don't have to blit. */
-   if (_mesa_format_matches_format_and_type(rb->Format, format,
-                                            type, pack->SwapBytes)) {
-      goto fallback;
+      return NULL;
    }
 
    if (_mesa_readpixels_needs_slow_path(ctx, format, type, GL_TRUE)) {
-      goto fallback;
+      return NULL;
    }
 
    /* Convert the source format to what is expected by ReadPixels
@@ -133,7 +130,7 @@ st_readpixels(struct gl_context *ctx, GLint x, GLint y,
        !screen->is_format_supported(screen, src_format, src->target,
                                     src->nr_samples,
                                     PIPE_BIND_SAMPLER_VIEW)) {
-      goto fallback;
+      return NULL;
    }
 
    if (format == GL_DEPTH_COMPONENT || format == GL_DEPTH_STENCIL)
@@ -146,7 +143,7 @@ st_readpixels(struct gl_context *ctx, GLint x, GLint y,
    dst_format = st_choose_matching_format(screen, bind, format, type,
                                           pack->SwapBytes);
    if (dst_format == PIPE_FORMAT_NONE) {
-      goto fallback;
+      return NULL;
    }
 
    /* create the destination texture */
@@ -162,7 +159,7 @@ st_readpixels(struct gl_context *ctx, GLint x, GLint y,
 
    dst = screen->resource_create(screen, &dst_templ);
    if (!dst) {
-      goto fallback;
+      return NULL;
    }
 
    blit.src.resource = src;
@@ -192,35 +189,290 @@ st_readpixels(struct gl_context *ctx, GLint x, GLint y,
    /* blit */
    st->pipe->blit(st->pipe, &blit);
 
-   /* map resources */
-   pixels = _mesa_map_pbo_dest(ctx, pack, pixels);
+   return dst;
+}
 
-   map = pipe_transfer_map_3d(pipe, dst, 0, PIPE_TRANSFER_READ,
+
+/**
+ * Copy the pixels out of a staging texture made by blit_to_staging().
+ */
+static GLboolean
+copy_from_staging(struct pipe_context *pipe, struct pipe_resource *src,
+                  GLsizei width, GLsizei height,
+                  GLenum format, GLenum type,
+                  const struct gl_pixelstore_attrib *pack,
+                  GLvoid *pixels)
+{
+   const uint bytesPerRow = width * util_format_get_blocksize(src->format);
+   struct pipe_transfer *tex_xfer;
+   ubyte *map;
+   GLint row;
+
+   map = pipe_transfer_map_3d(pipe, src, 0, PIPE_TRANSFER_READ,
                               0, 0, 0, width, height, 1, &tex_xfer);
-   if (!map) {
-      _mesa_unmap_pbo_dest(ctx, pack);
-      pipe_resource_reference(&dst, NULL);
-      goto fallback;
-   }
+   if (!map)
+      return GL_FALSE;
 
    /* memcpy data into a user buffer */
-   {
-      const uint bytesPerRow = width * util_format_get_blocksize(dst_format);
-      GLuint row;
-
-      for (row = 0; row < height; row++) {
-         GLvoid *dest = _mesa_image_address3d(pack, pixels,
-                                              width, height, format,
-                                              type, 0, row, 0);
-         memcpy(dest, map, bytesPerRow);
-         map += tex_xfer->stride;
-      }
+   for (row = 0; row < height; row++) {
+      GLvoid *dest = _mesa_image_address3d(pack, pixels,
+                                           width, height, format,
+                                           type, 0, row, 0);
+      memcpy(dest, map, bytesPerRow);
+      map += tex_xfer->stride;
    }
 
    pipe_transfer_unmap(pipe, tex_xfer);
+   return GL_TRUE;
+}
+
+
+/**
+ * Queue a glReadPixels into a pixel pack buffer.
+ *
+ * The pixels are blitted to a staging texture and the GPU is flushed, but
+ * nothing waits for the rendering to finish.  The pixels are copied into
+ * the buffer by st_finish_pbo_readback() once the buffer's contents are
+ * needed: when it is mapped or read or drawn from.  This lets a
+ * glReadPixels per frame overlap with the rendering of the next frame.
+ *
+ * \return GL_FALSE if the read has to be done right away
+ */
+static GLboolean
+queue_pbo_readback(struct st_context *st, struct st_renderbuffer *strb,
+                   GLint x, GLint y, GLsizei width, GLsizei height,
+                   GLenum format, GLenum type,
+                   const struct gl_pixelstore_attrib *pack,
+                   GLvoid *pixels)
+{
+   struct st_buffer_object *stobj = st_buffer_object(pack->BufferObj);
+   struct st_pbo_readback *readback;
+   struct pipe_resource *dst;
+
+   if (format == GL_DEPTH_COMPONENT ||
+       format == GL_STENCIL_INDEX ||
+       format == GL_DEPTH_STENCIL) {
+      return GL_FALSE;
+   }
+
+   /* The application can see the contents of a persistent mapping at any
+    * time, so there is nothing to wait for.
+    */
+   if (_mesa_bufferobj_mapped(&stobj->Base) || !stobj->buffer) {
+      return GL_FALSE;
+   }
+
+   readback = CALLOC_STRUCT(st_pbo_readback);
+   if (!readback) {
+      return GL_FALSE;
+   }
+
+   /* An earlier read into the same buffer must land first. */
+   st_finish_pbo_readback(st, stobj);
+
+   dst = blit_to_staging(st, strb, x, y, width, height, format, type, pack);
+   if (!dst) {
+      FREE(readback);
+      return GL_FALSE;
+   }
+
+   readback->resource = dst;
+   readback->width = width;
+   readback->height = height;
+   readback->format = format;
+   readback->type = type;
+   readback->pack = *pack;
+   readback->pack.BufferObj = NULL;
+   readback->offset = (GLintptr) pixels;
+
+   /* Get the rendering and the blit going, without waiting for them. */
+   st_flush(st, &readback->fence, 0);
+
+   stobj->readback = readback;
+   p_atomic_inc(&st_pending_pbo_readbacks);
+   return GL_TRUE;
+}
+
+
+/**
+ * Wait for a queued readback and copy its pixels into the buffer.
+ */
+void
+st_complete_pbo_readback(struct st_context *st, struct st_buffer_object *obj)
+{
+   struct st_pbo_readback *readback = obj->readback;
+   struct pipe_context *pipe = st->pipe;
+   struct pipe_screen *screen = pipe->screen;
+   struct pipe_transfer *transfer;
+   GLubyte *map;
+
+   obj->readback = NULL;
+   p_atomic_dec(&st_pending_pbo_readbacks);
+
+   if (readback->fence) {
+      screen->fence_finish(screen, readback->fence, PIPE_TIMEOUT_INFINITE);
+      screen->fence_reference(screen, &readback->fence, NULL);
+   }
+
+   map = pipe_buffer_map(pipe, obj->buffer, PIPE_TRANSFER_WRITE, &transfer);
+   if (map) {
+      copy_from_staging(pipe, readback->resource,
+                        readback->width, readback->height,
+                        readback->format, readback->type, &readback->pack,
+                        map + readback->offset);
+      pipe_buffer_unmap(pipe, transfer);
+   }
+
+   pipe_resource_reference(&readback->resource, NULL);
+   FREE(readback);
+}
+
+
+/**
+ * Drop a queued readback whose pixels aren't wanted any more, because
+ * the buffer is being deleted or its storage replaced.
+ */
+void
+st_discard_pbo_readback(struct st_context *st, struct st_buffer_object *obj)
+{
+   struct st_pbo_readback *readback = obj->readback;
+   struct pipe_screen *screen = st->pipe->screen;
+
+   if (!readback)
+      return;
+
+   obj->readback = NULL;
+   p_atomic_dec(&st_pending_pbo_readbacks);
+
+   screen->fence_reference(screen, &readback->fence, NULL);
+   pipe_resource_reference(&readback->resource, NULL);
+   FREE(readback);
+}
+
+
+/**
+ * Complete the queued readbacks into any buffer the draw about to be
+ * done may read from or write to.
+ */
+void
+st_finish_pbo_readbacks_for_draw(struct st_context *st,
+                                 const struct gl_client_array **arrays,
+                                 const struct _mesa_index_buffer *ib,
+                                 struct gl_buffer_object *indirect)
+{
+   struct gl_context *ctx = st->ctx;
+   struct gl_transform_feedback_object *xfb =
+      ctx->TransformFeedback.CurrentObject;
+   GLuint i;
+
+   if (likely(!st_pending_pbo_readbacks))
+      return;
+
+   for (i = 0; i < VERT_ATTRIB_MAX; i++) {
+      if (arrays[i] && _mesa_is_bufferobj(arrays[i]->BufferObj))
+         st_finish_pbo_readback(st, st_buffer_object(arrays[i]->BufferObj));
+   }
+
+   if (ib && _mesa_is_bufferobj(ib->obj))
+      st_finish_pbo_readback(st, st_buffer_object(ib->obj));
+
+   if (indirect && _mesa_is_bufferobj(indirect))
+      st_finish_pbo_readback(st, st_buffer_object(indirect));
+
+   for (i = 0; i < ctx->Const.MaxUniformBufferBindings; i++) {
+      struct gl_buffer_object *obj =
+         ctx->UniformBufferBindings[i].BufferObject;
+
+      if (_mesa_is_bufferobj(obj))
+         st_finish_pbo_readback(st, st_buffer_object(obj));
+   }
+
+   for (i = 0; i < ctx->Const.MaxCombinedTextureImageUnits; i++) {
+      struct gl_texture_object *texObj =
+         ctx->Texture.Unit[i].CurrentTex[TEXTURE_BUFFER_INDEX];
+
+      if (texObj && texObj->BufferObject &&
+          _mesa_is_bufferobj(texObj->BufferObject))
+         st_finish_pbo_readback(st, st_buffer_object(texObj->BufferObject));
+   }
+
+   if (xfb->Active) {
+      for (i = 0; i < MAX_FEEDBACK_BUFFERS; i++) {
+         if (xfb->Buffers[i] && _mesa_is_bufferobj(xfb->Buffers[i]))
+            st_finish_pbo_readback(st, st_buffer_object(xfb->Buffers[i]));
+      }
+   }
+}
+
+
+/**
+ * This uses a blit to copy the read buffer to a texture format which matches
+ * the format and type combo and then a fast read-back is done using memcpy.
+ *
+ * If such a format isn't available, we fall back to _mesa_readpixels.
+ *
+ * Reads into a pixel pack buffer are queued instead, see
+ * queue_pbo_readback().
+ *
+ * NOTE: Some drivers use a blit to convert between tiled and linear
+ *       texture layouts during texture uploads/downloads, so the blit
+ *       we do here should be free in such cases.
+ */
+static void
+st_readpixels(struct gl_context *ctx, GLint x, GLint y,
+              GLsizei width, GLsizei height,
+              GLenum format, GLenum type,
+              const struct gl_pixelstore_attrib *pack,
+              GLvoid *pixels)
+{
+   struct st_context *st = st_context(ctx);
+   struct gl_renderbuffer *rb =
+         _mesa_get_read_renderbuffer_for_format(ctx, format);
+   struct st_renderbuffer *strb = st_renderbuffer(rb);
+   struct pipe_context *pipe = st->pipe;
+   struct pipe_resource *dst;
+   GLvoid *dest;
+   GLboolean success;
+
+   /* Validate state (to be sure we have up-to-date framebuffer surfaces)
+    * and flush the bitmap cache prior to reading. */
+   st_validate_state(st);
+   st_flush_bitmap_cache(st);
+
+   if (_mesa_is_bufferobj(pack->BufferObj) &&
+       queue_pbo_readback(st, strb, x, y, width, height, format, type,
+                          pack, pixels)) {
+      return;
+   }
+
+   if (!st->prefer_blit_based_texture_transfer) {
+      goto fallback;
+   }
+
+   /* See if the texture format already matches the format and type,
+    * in which case the memcpy-based fast path will likely be used and
+    * we don't have to blit. */
+   if (_mesa_format_matches_format_and_type(rb->Format, format,
+                                            type, pack->SwapBytes)) {
+      goto fallback;
+   }
+
+   dst = blit_to_staging(st, strb, x, y, width, height, format, type, pack);
+   if (!dst) {
+      goto fallback;
+   }
+
+   /* map resources */
+   dest = _mesa_map_pbo_dest(ctx, pack, pixels);
+
+   success = copy_from_staging(pipe, dst, width, height, format, type,
+                               pack, dest);
+
    _mesa_unmap_pbo_dest(ctx, pack);
    pipe_resource_reference(&dst, NULL);
-   return;
+
+   if (success)
+      return;
 
 fallback:
    _mesa_readpixels(ctx, x, y, width, height, format, type, pack, pixels);
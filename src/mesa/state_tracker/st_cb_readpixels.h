@@ -30,11 +30,38 @@
 #define ST_CB_READPIXELS_H
 
 #include "main/glheader.h"
+#include "st_cb_bufferobjects.h"
 
 struct dd_function_table;
+struct gl_client_array;
+struct _mesa_index_buffer;
+struct st_context;
 
 extern void
 st_init_readpixels_functions(struct dd_function_table *functions);
 
+extern void
+st_complete_pbo_readback(struct st_context *st, struct st_buffer_object *obj);
+
+extern void
+st_discard_pbo_readback(struct st_context *st, struct st_buffer_object *obj);
+
+extern void
+st_finish_pbo_readbacks_for_draw(struct st_context *st,
+                                 const struct gl_client_array **arrays,
+                                 const struct _mesa_index_buffer *ib,
+                                 struct gl_buffer_object *indirect);
+
+
+/**
+ * Make sure a glReadPixels queued into the buffer has landed in it.
+ */
+static INLINE void
+st_finish_pbo_readback(struct st_context *st, struct st_buffer_object *obj)
+{
+   if (unlikely(obj->readback))
+      st_complete_pbo_readback(st, obj);
+}
+
 
 #endif /* ST_CB_READPIXELS_H */
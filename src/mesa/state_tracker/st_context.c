@@ -65,6 +65,7 @@
 #include "st_extensions.h"
 #include "st_gen_mipmap.h"
 #include "st_program.h"
+#include "st_shader_cache.h"
 #include "pipe/p_context.h"
 #include "util/u_inlines.h"
 #include "util/u_upload_mgr.h"
@@ -72,6 +73,8 @@
 
 
 DEBUG_GET_ONCE_BOOL_OPTION(mesa_mvp_dp4, "MESA_MVP_DP4", FALSE)
+DEBUG_GET_ONCE_BOOL_OPTION(st_specialize_uniforms, "ST_SPECIALIZE_UNIFORMS",
+                           FALSE)
 
 
 /**
@@ -141,6 +144,7 @@ st_create_context_priv( struct gl_context *ctx, struct pipe_context *pipe,
    }
 
    st->cso_context = cso_create_context(pipe);
+   st_init_shader_cache(st);
 
    st_init_atoms( st );
    st_init_bitmap(st);
@@ -165,12 +169,17 @@ st_create_context_priv( struct gl_context *ctx, struct pipe_context *pipe,
       st->velems_util_draw[i].src_format = PIPE_FORMAT_R32G32B32A32_FLOAT;
    }
 
-   /* we want all vertex data to be placed in buffer objects */
-   vbo_use_buffer_objects(ctx);
-
+   /* Software vertex pipelines get the immediate mode vertices straight
+    * from vbo's vertex store.  Everything else needs all vertex data to be
+    * placed in buffer objects, which spares hardware drivers an upload of
+    * user vertex buffers at every draw.
+    */
+   if (!screen->get_param(screen, PIPE_CAP_USER_VERTEX_BUFFERS_IN_PLACE)) {
+      vbo_use_buffer_objects(ctx);
 
-   /* make sure that no VBOs are left mapped when we're drawing. */
-   vbo_always_unmap_buffers(ctx);
+      /* make sure that no VBOs are left mapped when we're drawing. */
+      vbo_always_unmap_buffers(ctx);
+   }
 
    /* Need these flags:
     */
@@ -192,6 +201,7 @@ st_create_context_priv( struct gl_context *ctx, struct pipe_context *pipe,
       !!(screen->get_param(screen, PIPE_CAP_TEXTURE_BORDER_COLOR_QUIRK) &
          (PIPE_QUIRK_TEXTURE_BORDER_COLOR_SWIZZLE_NV50 |
           PIPE_QUIRK_TEXTURE_BORDER_COLOR_SWIZZLE_R600));
+   st->specialize_uniforms = debug_get_option_st_specialize_uniforms();
 
    /* GL limits and extensions */
    st_init_limits(st);
@@ -209,6 +219,9 @@ static void st_init_driver_flags(struct gl_driver_flags *f)
 {
    f->NewArray = ST_NEW_VERTEX_ARRAYS;
    f->NewRasterizerDiscard = ST_NEW_RASTERIZER;
+   f->NewShaderConstants[MESA_SHADER_VERTEX] = ST_NEW_VS_CONSTANTS;
+   f->NewShaderConstants[MESA_SHADER_FRAGMENT] = ST_NEW_FS_CONSTANTS;
+   f->NewShaderConstants[MESA_SHADER_GEOMETRY] = ST_NEW_GS_CONSTANTS;
 }
 
 struct st_context *st_create_context(gl_api api, struct pipe_context *pipe,
@@ -256,6 +269,7 @@ static void st_destroy_context_priv( struct st_context *st )
    st_destroy_bitmap(st);
    st_destroy_drawpix(st);
    st_destroy_drawtex(st);
+   st_destroy_shader_cache(st);
 
    for (shader = 0; shader < Elements(st->state.sampler_views); shader++) {
       for (i = 0; i < Elements(st->state.sampler_views[0]); i++) {
@@ -41,6 +41,7 @@ struct gen_mipmap_state;
 struct st_context;
 struct st_fragment_program;
 struct u_upload_mgr;
+struct util_hash_table;
 
 
 #define ST_NEW_MESA                    (1 << 0) /* Mesa state has changed */
@@ -51,6 +52,13 @@ struct u_upload_mgr;
 #define ST_NEW_GEOMETRY_PROGRAM        (1 << 5)
 #define ST_NEW_VERTEX_ARRAYS           (1 << 6)
 #define ST_NEW_RASTERIZER              (1 << 7)
+#define ST_NEW_VS_CONSTANTS            (1 << 8)
+#define ST_NEW_FS_CONSTANTS            (1 << 9)
+#define ST_NEW_GS_CONSTANTS            (1 << 10)
+
+#define ST_NEW_SHADER_CONSTANTS (ST_NEW_VS_CONSTANTS | \
+                                 ST_NEW_FS_CONSTANTS | \
+                                 ST_NEW_GS_CONSTANTS)
 
 
 struct st_state_flags {
@@ -95,6 +103,11 @@ struct st_context
     */
    boolean invalidate_on_gl_viewport;
 
+   /* Build fragment shader variants with the values of uniforms that
+    * control branches folded in.  Set with ST_SPECIALIZE_UNIFORMS.
+    */
+   boolean specialize_uniforms;
+
    boolean vertex_array_out_of_memory;
 
    /* Some state is contained in constant objects.
@@ -189,6 +202,10 @@ struct st_context
 
    struct cso_context *cso_context;
 
+   /** Driver shaders by shader state and by handle, see st_shader_cache.c */
+   struct util_hash_table *shader_csos;
+   struct util_hash_table *shader_cso_handles;
+
    void *winsys_drawable_handle;
 
    /* The number of vertex buffers from the last call of validate_arrays. */
@@ -198,6 +215,13 @@ struct st_context
    int32_t read_stamp;
 
    struct st_config_options options;
+
+   /** Counters for ST_DEBUG=atoms, printed when the context is destroyed */
+   struct {
+      unsigned validations;     /**< st_validate_state() calls with work */
+      unsigned updates;         /**< atom updates in total */
+      unsigned atom_updates[32];
+   } atom_stats;
 };
 
 
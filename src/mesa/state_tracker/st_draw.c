@@ -46,6 +46,7 @@
 #include "st_context.h"
 #include "st_atom.h"
 #include "st_cb_bufferobjects.h"
+#include "st_cb_readpixels.h"
 #include "st_cb_xformfb.h"
 #include "st_debug.h"
 #include "st_draw.h"
@@ -194,7 +195,8 @@ st_draw_vbo(struct gl_context *ctx,
 	    GLboolean index_bounds_valid,
             GLuint min_index,
             GLuint max_index,
-            struct gl_transform_feedback_object *tfb_vertcount)
+            struct gl_transform_feedback_object *tfb_vertcount,
+            struct gl_buffer_object *indirect)
 {
    struct st_context *st = st_context(ctx);
    struct pipe_index_buffer ibuffer = {0};
@@ -205,6 +207,8 @@ st_draw_vbo(struct gl_context *ctx,
    /* Mesa core state should have been validated already */
    assert(ctx->NewState == 0x0);
 
+   st_finish_pbo_readbacks_for_draw(st, arrays, ib, indirect);
+
    /* Validate state. */
    if (st->dirty.st || ctx->NewDriverState) {
       st_validate_state(st);
@@ -275,7 +279,15 @@ st_draw_vbo(struct gl_context *ctx,
                       info.indexed);
       }
 
-      if (info.count_from_stream_output) {
+      if (prims[i].is_indirect) {
+         /* The parameters live in the indirect buffer; there's nothing
+          * to trim here.
+          */
+         info.indirect = st_buffer_object(indirect)->buffer;
+         info.indirect_offset = prims[i].indirect_offset;
+         cso_draw_vbo(st->cso_context, &info);
+      }
+      else if (info.count_from_stream_output) {
          cso_draw_vbo(st->cso_context, &info);
       }
       else if (info.primitive_restart) {
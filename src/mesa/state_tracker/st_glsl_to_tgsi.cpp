@@ -68,6 +68,7 @@ extern "C" {
 #include "st_program.h"
 #include "st_glsl_to_tgsi.h"
 #include "st_mesa_to_tgsi.h"
+#include "st_shader_cache.h"
 }
 
 #define PROGRAM_IMMEDIATE PROGRAM_FILE_MAX
@@ -4441,6 +4442,20 @@ compile_tgsi_instruction(struct st_translate *t,
    }
 }
 
+/**
+ * Add the STATE_FB_WPOS_Y_TRANSFORM parameter to a fragment program that
+ * reads WPOS.
+ */
+static unsigned
+add_wpos_transform_state(const struct gl_program *program)
+{
+   static const gl_state_index wposTransformState[STATE_LENGTH]
+      = { STATE_INTERNAL, STATE_FB_WPOS_Y_TRANSFORM, 
+          (gl_state_index)0, (gl_state_index)0, (gl_state_index)0 };
+
+   return _mesa_add_state_reference(program->Parameters, wposTransformState);
+}
+
 /**
  * Emit the TGSI instructions for inverting and adjusting WPOS.
  * This code is unavoidable because it also depends on whether
@@ -4458,16 +4473,11 @@ emit_wpos_adjustment( struct st_translate *t,
     * Need to replace instances of INPUT[WPOS] with temp T
     * where T = INPUT[WPOS] by y is inverted.
     */
-   static const gl_state_index wposTransformState[STATE_LENGTH]
-      = { STATE_INTERNAL, STATE_FB_WPOS_Y_TRANSFORM, 
-          (gl_state_index)0, (gl_state_index)0, (gl_state_index)0 };
-   
    /* XXX: note we are modifying the incoming shader here!  Need to
     * do this before emitting the constant decls below, or this
     * will be missed:
     */
-   unsigned wposTransConst = _mesa_add_state_reference(program->Parameters,
-                                                       wposTransformState);
+   unsigned wposTransConst = add_wpos_transform_state(program);
 
    struct ureg_src wpostrans = ureg_DECL_constant( ureg, wposTransConst );
    struct ureg_dst wpos_temp = ureg_DECL_temporary( ureg );
@@ -4660,6 +4670,34 @@ emit_edgeflags(struct st_translate *t)
    ureg_MOV(ureg, edge_dst, edge_src);
 }
 
+static void
+detach_uniform_storage(glsl_to_tgsi_visitor *program)
+{
+   if (program->shader_program) {
+      for (unsigned i = 0; i < program->shader_program->NumUserUniformStorage; i++) {
+         struct gl_uniform_storage *const storage =
+               &program->shader_program->UniformStorage[i];
+
+         _mesa_uniform_detach_all_driver_storage(storage);
+      }
+   }
+}
+
+static void
+associate_uniform_storage(struct gl_context *ctx,
+                          glsl_to_tgsi_visitor *program)
+{
+   if (program->shader_program) {
+      for (unsigned i = 0; i < MESA_SHADER_TYPES; i++) {
+         if (program->shader_program->_LinkedShaders[i] == NULL)
+            continue;
+
+         _mesa_associate_uniform_storage(ctx, program->shader_program,
+               program->shader_program->_LinkedShaders[i]->Program->Parameters);
+      }
+   }
+}
+
 /**
  * Translate intermediate IR (glsl_to_tgsi_instruction) to TGSI format.
  * \param program  the program to translate
@@ -4719,14 +4757,7 @@ st_translate_program(
    t->outputMapping = outputMapping;
    t->ureg = ureg;
 
-   if (program->shader_program) {
-      for (i = 0; i < program->shader_program->NumUserUniformStorage; i++) {
-         struct gl_uniform_storage *const storage =
-               &program->shader_program->UniformStorage[i];
-
-         _mesa_uniform_detach_all_driver_storage(storage);
-      }
-   }
+   detach_uniform_storage(program);
 
    /*
     * Declare input attributes.
@@ -4941,19 +4972,11 @@ st_translate_program(
                        t->insn[t->labels[i].branch_target]);
    }
 
-   if (program->shader_program) {
-      /* This has to be done last.  Any operation the can cause
-       * prog->ParameterValues to get reallocated (e.g., anything that adds a
-       * program constant) has to happen before creating this linkage.
-       */
-      for (unsigned i = 0; i < MESA_SHADER_TYPES; i++) {
-         if (program->shader_program->_LinkedShaders[i] == NULL)
-            continue;
-
-         _mesa_associate_uniform_storage(ctx, program->shader_program,
-               program->shader_program->_LinkedShaders[i]->Program->Parameters);
-      }
-   }
+   /* This has to be done last.  Any operation the can cause
+    * prog->ParameterValues to get reallocated (e.g., anything that adds a
+    * program constant) has to happen before creating this linkage.
+    */
+   associate_uniform_storage(ctx, program);
 
 out:
    if (t) {
@@ -4971,73 +4994,285 @@ out:
 
    return ret;
 }
-/* ----------------------------- End TGSI code ------------------------------ */
+
+static void
+add_src_reg_to_key(struct st_shader_key *key, const st_src_reg *reg)
+{
+   const int values[7] = {
+      reg->file, reg->index, reg->index2D, (int) reg->swizzle, reg->negate,
+      reg->type, reg->reladdr != NULL
+   };
+
+   st_shader_key_add(key, values, sizeof(values));
+}
+
+static void
+add_dst_reg_to_key(struct st_shader_key *key, const st_dst_reg *reg)
+{
+   const int values[6] = {
+      reg->file, reg->index, reg->writemask, (int) reg->cond_mask,
+      reg->type, reg->reladdr != NULL
+   };
+
+   st_shader_key_add(key, values, sizeof(values));
+}
 
 /**
- * Convert a shader's GLSL IR into a Mesa gl_program, although without 
- * generating Mesa IR.
+ * Add everything st_translate_program() reads from the program, other
+ * than the mappings passed by the caller, to a shader cache key.
  */
-static struct gl_program *
-get_mesa_program(struct gl_context *ctx,
-                 struct gl_shader_program *shader_program,
-                 struct gl_shader *shader)
+static void
+add_program_to_key(struct st_shader_key *key,
+                   glsl_to_tgsi_visitor *program,
+                   const struct gl_program *proginfo)
 {
-   glsl_to_tgsi_visitor* v;
-   struct gl_program *prog;
-   GLenum target;
-   const char *target_string;
-   bool progress;
-   struct gl_shader_compiler_options *options =
-         &ctx->ShaderCompilerOptions[_mesa_shader_type_to_index(shader->Type)];
-   struct pipe_screen *pscreen = ctx->st->pipe->screen;
-   unsigned ptarget;
+   const struct gl_program_parameter_list *params = proginfo->Parameters;
+   GLbitfield64 bits[3];
+   int values[6];
+   unsigned i;
 
-   switch (shader->Type) {
-   case GL_VERTEX_SHADER:
-      target = GL_VERTEX_PROGRAM_ARB;
-      ptarget = PIPE_SHADER_VERTEX;
-      target_string = "vertex";
-      break;
-   case GL_FRAGMENT_SHADER:
-      target = GL_FRAGMENT_PROGRAM_ARB;
-      ptarget = PIPE_SHADER_FRAGMENT;
-      target_string = "fragment";
-      break;
-   case GL_GEOMETRY_SHADER:
-      target = GL_GEOMETRY_PROGRAM_NV;
-      ptarget = PIPE_SHADER_GEOMETRY;
-      target_string = "geometry";
-      break;
-   default:
-      assert(!"should not be reached");
-      return NULL;
+   bits[0] = proginfo->InputsRead;
+   bits[1] = proginfo->OutputsWritten;
+   bits[2] = proginfo->SystemValuesRead;
+   st_shader_key_add(key, bits, sizeof(bits));
+
+   if (proginfo->Target == GL_FRAGMENT_PROGRAM_ARB) {
+      const struct gl_fragment_program *fp =
+         (const struct gl_fragment_program *) proginfo;
+
+      values[0] = fp->OriginUpperLeft;
+      values[1] = fp->PixelCenterInteger;
+      st_shader_key_add(key, values, 2 * sizeof(values[0]));
    }
 
-   validate_ir_tree(shader->ir);
+   values[0] = program->num_address_regs;
+   values[1] = program->samplers_used;
+   values[2] = program->indirect_addr_consts;
+   values[3] = program->next_array;
+   values[4] = program->num_immediates;
+   values[5] = params ? params->NumParameters : 0;
+   st_shader_key_add(key, values, sizeof(values));
+   st_shader_key_add(key, program->array_sizes,
+                     program->next_array * sizeof(program->array_sizes[0]));
 
-   prog = ctx->Driver.NewProgram(ctx, target, shader_program->Name);
-   if (!prog)
+   /* Only the types of the parameters matter, except for the constants
+    * that become immediates.
+    */
+   for (i = 0; params && i < params->NumParameters; i++) {
+      values[0] = params->Parameters[i].Type;
+      values[1] = params->Parameters[i].DataType;
+      st_shader_key_add(key, values, 2 * sizeof(values[0]));
+      if (params->Parameters[i].Type == PROGRAM_CONSTANT)
+         st_shader_key_add(key, params->ParameterValues[i],
+                           4 * sizeof(params->ParameterValues[i][0]));
+   }
+
+   if (program->shader_program) {
+      struct gl_shader_program *shader_program = program->shader_program;
+
+      values[0] = shader_program->NumUniformBlocks;
+      st_shader_key_add(key, values, sizeof(values[0]));
+      for (i = 0; i < shader_program->NumUniformBlocks; i++) {
+         values[0] = shader_program->UniformBlocks[i].UniformBufferSize;
+         st_shader_key_add(key, values, sizeof(values[0]));
+      }
+   }
+
+   foreach_iter(exec_list_iterator, iter, program->immediates) {
+      immediate_storage *imm = (immediate_storage *)iter.get();
+
+      values[0] = imm->size;
+      values[1] = imm->type;
+      st_shader_key_add(key, values, 2 * sizeof(values[0]));
+      st_shader_key_add(key, imm->values, imm->size * sizeof(imm->values[0]));
+   }
+
+   foreach_iter(exec_list_iterator, iter, program->instructions) {
+      glsl_to_tgsi_instruction *inst = (glsl_to_tgsi_instruction *)iter.get();
+      int inst_values[8] = {
+         (int) inst->op, inst->cond_update, inst->saturate, inst->sampler,
+         inst->tex_target, inst->tex_shadow, (int) inst->tex_offset_num_offset,
+         inst->op == TGSI_OPCODE_CAL ? inst->function->sig_id : 0
+      };
+
+      st_shader_key_add(key, inst_values, sizeof(inst_values));
+      add_dst_reg_to_key(key, &inst->dst);
+      for (i = 0; i < Elements(inst->src); i++)
+         add_src_reg_to_key(key, &inst->src[i]);
+      for (i = 0; i < inst->tex_offset_num_offset; i++) {
+         values[0] = inst->tex_offsets[i].File;
+         values[1] = inst->tex_offsets[i].Index;
+         st_shader_key_add(key, values, 2 * sizeof(values[0]));
+      }
+   }
+}
+
+/**
+ * Translate a program like st_translate_program(), but look for the
+ * tokens in the shader cache first.  \p key holds the context state and
+ * anything the caller has set in \p ureg already, the rest is added here.
+ *
+ * \return the tokens, or NULL if the translation failed
+ */
+const struct tgsi_token *
+st_translate_program_cached(
+   struct gl_context *ctx,
+   struct st_shader_key *key,
+   uint procType,
+   struct ureg_program *ureg,
+   glsl_to_tgsi_visitor *program,
+   const struct gl_program *proginfo,
+   GLuint numInputs,
+   const GLuint inputMapping[],
+   const ubyte inputSemanticName[],
+   const ubyte inputSemanticIndex[],
+   const GLuint interpMode[],
+   const GLboolean is_centroid[],
+   GLuint numOutputs,
+   const GLuint outputMapping[],
+   const ubyte outputSemanticName[],
+   const ubyte outputSemanticIndex[],
+   boolean passthrough_edgeflags,
+   boolean clamp_color)
+{
+   const struct tgsi_token *tokens;
+   unsigned flags[4] = { numInputs, numOutputs, passthrough_edgeflags,
+                         clamp_color };
+   unsigned attr;
+
+   st_shader_key_add(key, flags, sizeof(flags));
+
+   /* The mappings are only read for the registers the program uses. */
+   for (attr = 0; attr < 64; attr++) {
+      if (proginfo->InputsRead & BITFIELD64_BIT(attr))
+         st_shader_key_add(key, &inputMapping[attr], sizeof(inputMapping[0]));
+      if (proginfo->OutputsWritten & BITFIELD64_BIT(attr))
+         st_shader_key_add(key, &outputMapping[attr], sizeof(outputMapping[0]));
+   }
+   if (passthrough_edgeflags) {
+      st_shader_key_add(key, &inputMapping[VERT_ATTRIB_EDGEFLAG],
+                        sizeof(inputMapping[0]));
+      st_shader_key_add(key, &outputMapping[VARYING_SLOT_EDGE],
+                        sizeof(outputMapping[0]));
+   }
+
+   if (inputSemanticName) {
+      st_shader_key_add(key, inputSemanticName, numInputs);
+      st_shader_key_add(key, inputSemanticIndex, numInputs);
+   }
+   if (interpMode)
+      st_shader_key_add(key, interpMode, numInputs * sizeof(interpMode[0]));
+   if (is_centroid)
+      st_shader_key_add(key, is_centroid, numInputs * sizeof(is_centroid[0]));
+   st_shader_key_add(key, outputSemanticName, numOutputs);
+   st_shader_key_add(key, outputSemanticIndex, numOutputs);
+
+   add_program_to_key(key, program, proginfo);
+
+   tokens = st_shader_cache_find(key);
+   if (tokens) {
+      /* Make the same changes to the program as the translation would. */
+      detach_uniform_storage(program);
+      if (procType == TGSI_PROCESSOR_FRAGMENT &&
+          (proginfo->InputsRead & VARYING_BIT_POS))
+         add_wpos_transform_state(proginfo);
+      associate_uniform_storage(ctx, program);
+      return tokens;
+   }
+
+   if (st_translate_program(ctx, procType, ureg, program, proginfo,
+                            numInputs, inputMapping, inputSemanticName,
+                            inputSemanticIndex, interpMode, is_centroid,
+                            numOutputs, outputMapping, outputSemanticName,
+                            outputSemanticIndex, passthrough_edgeflags,
+                            clamp_color) != PIPE_OK)
       return NULL;
-   prog->Parameters = _mesa_new_parameter_list();
-   v = new glsl_to_tgsi_visitor();
-   v->ctx = ctx;
-   v->prog = prog;
-   v->shader_program = shader_program;
-   v->options = options;
-   v->glsl_version = ctx->Const.GLSLVersion;
-   v->native_integers = ctx->Const.NativeIntegers;
 
-   v->have_sqrt = pscreen->get_shader_param(pscreen, ptarget,
-                                            PIPE_SHADER_CAP_TGSI_SQRT_SUPPORTED);
+   tokens = ureg_get_tokens(ureg, NULL);
+   st_shader_cache_insert(key, tokens);
+   return tokens;
+}
+/* ----------------------------- End TGSI code ------------------------------ */
 
-   _mesa_generate_parameters_list_for_uniforms(shader_program, shader,
-					       prog->Parameters);
+/**
+ * Finds the scalar uniforms that control if-statements (or conditional
+ * assignments, once ifs have been flattened), which are the candidates for
+ * building variants with the uniform values folded in.
+ */
+class specializable_uniform_visitor : public ir_hierarchical_visitor {
+public:
+   specializable_uniform_visitor(struct st_fragment_program *fp)
+      : fp(fp), in_condition(false)
+   {
+      fp->num_specialized_uniforms = 0;
+   }
 
-   /* Remove reads from output registers. */
-   lower_output_reads(shader->ir);
+   virtual ir_visitor_status visit_enter(ir_if *ir)
+   {
+      in_condition = true;
+      ir->condition->accept(this);
+      in_condition = false;
+
+      visit_list_elements(this, &ir->then_instructions);
+      visit_list_elements(this, &ir->else_instructions);
+      return visit_continue_with_parent;
+   }
+
+   virtual ir_visitor_status visit_enter(ir_assignment *ir)
+   {
+      if (ir->condition) {
+         in_condition = true;
+         ir->condition->accept(this);
+         in_condition = false;
+      }
+      return visit_continue_with_parent;
+   }
+
+   virtual ir_visitor_status visit(ir_dereference_variable *ir)
+   {
+      ir_variable *var = ir->var;
+
+      if (!in_condition || var->mode != ir_var_uniform ||
+          var->is_in_uniform_block() || !var->type->is_scalar() ||
+          var->type->is_float() || var->location < 0 ||
+          strncmp(var->name, "gl_", 3) == 0)
+         return visit_continue;
+
+      for (unsigned i = 0; i < fp->num_specialized_uniforms; i++) {
+         if (fp->specialized_uniforms[i] == (GLuint) var->location)
+            return visit_continue;
+      }
+
+      if (fp->num_specialized_uniforms < ST_MAX_SPECIALIZED_UNIFORMS) {
+         fp->specialized_uniforms[fp->num_specialized_uniforms++] =
+            var->location;
+      }
+      return visit_continue;
+   }
+
+   struct st_fragment_program *fp;
+   bool in_condition;
+};
+
+static void
+find_specializable_uniforms(struct st_fragment_program *fp, exec_list *ir)
+{
+   specializable_uniform_visitor v(fp);
+
+   visit_list_elements(&v, ir);
+}
+
+/**
+ * Emit the TGSI-like instructions for main() and every function it calls,
+ * then run the optimizations on the instruction stream.
+ */
+static void
+emit_program(glsl_to_tgsi_visitor *v, exec_list *ir)
+{
+   bool progress;
 
    /* Emit intermediate IR for main(). */
-   visit_exec_list(shader->ir, v);
+   visit_exec_list(ir, v);
 
    /* Now emit bodies for any functions that were used. */
    do {
@@ -5093,6 +5328,71 @@ get_mesa_program(struct gl_context *ctx,
    
    /* Write the END instruction. */
    v->emit(NULL, TGSI_OPCODE_END);
+}
+
+/**
+ * Convert a shader's GLSL IR into a Mesa gl_program, although without 
+ * generating Mesa IR.
+ */
+static struct gl_program *
+get_mesa_program(struct gl_context *ctx,
+                 struct gl_shader_program *shader_program,
+                 struct gl_shader *shader)
+{
+   glsl_to_tgsi_visitor* v;
+   struct gl_program *prog;
+   GLenum target;
+   const char *target_string;
+   struct gl_shader_compiler_options *options =
+         &ctx->ShaderCompilerOptions[_mesa_shader_type_to_index(shader->Type)];
+   struct pipe_screen *pscreen = ctx->st->pipe->screen;
+   unsigned ptarget;
+
+   switch (shader->Type) {
+   case GL_VERTEX_SHADER:
+      target = GL_VERTEX_PROGRAM_ARB;
+      ptarget = PIPE_SHADER_VERTEX;
+      target_string = "vertex";
+      break;
+   case GL_FRAGMENT_SHADER:
+      target = GL_FRAGMENT_PROGRAM_ARB;
+      ptarget = PIPE_SHADER_FRAGMENT;
+      target_string = "fragment";
+      break;
+   case GL_GEOMETRY_SHADER:
+      target = GL_GEOMETRY_PROGRAM_NV;
+      ptarget = PIPE_SHADER_GEOMETRY;
+      target_string = "geometry";
+      break;
+   default:
+      assert(!"should not be reached");
+      return NULL;
+   }
+
+   validate_ir_tree(shader->ir);
+
+   prog = ctx->Driver.NewProgram(ctx, target, shader_program->Name);
+   if (!prog)
+      return NULL;
+   prog->Parameters = _mesa_new_parameter_list();
+   v = new glsl_to_tgsi_visitor();
+   v->ctx = ctx;
+   v->prog = prog;
+   v->shader_program = shader_program;
+   v->options = options;
+   v->glsl_version = ctx->Const.GLSLVersion;
+   v->native_integers = ctx->Const.NativeIntegers;
+
+   v->have_sqrt = pscreen->get_shader_param(pscreen, ptarget,
+                                            PIPE_SHADER_CAP_TGSI_SQRT_SUPPORTED);
+
+   _mesa_generate_parameters_list_for_uniforms(shader_program, shader,
+					       prog->Parameters);
+
+   /* Remove reads from output registers. */
+   lower_output_reads(shader->ir);
+
+   emit_program(v, shader->ir);
 
    if (ctx->Shader.Flags & GLSL_DUMP) {
       printf("\n");
@@ -5133,6 +5433,8 @@ get_mesa_program(struct gl_context *ctx,
    case GL_FRAGMENT_SHADER:
       stfp = (struct st_fragment_program *)prog;
       stfp->glsl_to_tgsi = v;
+      if (ctx->st->specialize_uniforms)
+         find_specializable_uniforms(stfp, shader->ir);
       break;
    case GL_GEOMETRY_SHADER:
       stgp = (struct st_geometry_program *)prog;
@@ -5146,6 +5448,99 @@ get_mesa_program(struct gl_context *ctx,
    return prog;
 }
 
+/**
+ * Builds a visitor for the fragment program in which the uniforms listed in
+ * fp->specialized_uniforms are replaced by the given values, and the code
+ * is optimized again with that knowledge.
+ *
+ * Returns NULL if the GLSL IR of the program isn't available anymore.
+ */
+extern "C" struct glsl_to_tgsi_visitor *
+get_specialized_visitor(struct gl_context *ctx,
+                        struct st_fragment_program *fp,
+                        const gl_constant_value *values)
+{
+   struct gl_shader_program *shader_program =
+      ctx->Shader._CurrentFragmentProgram;
+   struct gl_program_parameter_list *params = fp->Base.Base.Parameters;
+   struct gl_shader_compiler_options *options =
+      &ctx->ShaderCompilerOptions[MESA_SHADER_FRAGMENT];
+   const char *names[ST_MAX_SPECIALIZED_UNIFORMS];
+   ir_constant_data data[ST_MAX_SPECIALIZED_UNIFORMS];
+   struct gl_shader *shader;
+   glsl_to_tgsi_visitor *v;
+   exec_list *ir;
+   bool progress;
+
+   if (shader_program == NULL)
+      return NULL;
+
+   shader = shader_program->_LinkedShaders[MESA_SHADER_FRAGMENT];
+   if (shader == NULL || shader->ir == NULL ||
+       shader->Program != &fp->Base.Base)
+      return NULL;
+
+   for (unsigned i = 0; i < fp->num_specialized_uniforms; i++) {
+      const struct gl_program_parameter *p =
+         &params->Parameters[fp->specialized_uniforms[i]];
+
+      names[i] = p->Name;
+      memset(&data[i], 0, sizeof(data[i]));
+
+      /* Without native integers, integer uniforms are stored as floats. */
+      if (ctx->Const.NativeIntegers)
+         data[i].u[0] = values[i].u;
+      else if (p->DataType == GL_UNSIGNED_INT)
+         data[i].u[0] = (unsigned) values[i].f;
+      else
+         data[i].i[0] = (int) values[i].f;
+   }
+
+   v = new glsl_to_tgsi_visitor();
+   v->ctx = ctx;
+   v->prog = &fp->Base.Base;
+   v->shader_program = shader_program;
+   v->options = options;
+   v->glsl_version = ctx->Const.GLSLVersion;
+   v->native_integers = ctx->Const.NativeIntegers;
+   v->have_sqrt = fp->glsl_to_tgsi->have_sqrt;
+
+   /* The instructions keep pointers into the IR, so the copy lives as long
+    * as the visitor does.
+    */
+   ir = new(v->mem_ctx) exec_list;
+   clone_ir_list(v->mem_ctx, ir, shader->ir);
+
+   do_specialize_uniforms(ir, fp->num_specialized_uniforms, names, data);
+
+   /* Same lowering as st_link_shader(), since folding a condition can
+    * leave jumps behind that the driver doesn't support.
+    */
+   do {
+      progress = false;
+
+      progress = do_lower_jumps(ir, true, true, options->EmitNoMainReturn,
+                                options->EmitNoCont, options->EmitNoLoops) ||
+                 progress;
+
+      progress = do_common_optimization(ir, true, true,
+                                        options->MaxUnrollIterations,
+                                        options->EmitNoLoops) ||
+                 progress;
+
+      progress = lower_if_to_cond_assign(ir, options->MaxIfDepth) || progress;
+   } while (progress);
+
+   validate_ir_tree(ir);
+
+   emit_program(v, ir);
+
+   /* Keep the sampler declarations of the unspecialized program. */
+   v->samplers_used = fp->glsl_to_tgsi->samplers_used;
+
+   return v;
+}
+
 extern "C" {
 
 struct gl_shader *
@@ -5246,7 +5641,8 @@ st_link_shader(struct gl_context *ctx, struct gl_shader_program *prog)
          progress = do_lower_jumps(ir, true, true, options->EmitNoMainReturn, options->EmitNoCont, options->EmitNoLoops) || progress;
 
          progress = do_common_optimization(ir, true, true,
-					   options->MaxUnrollIterations)
+					   options->MaxUnrollIterations,
+					   options->EmitNoLoops)
 	   || progress;
 
          progress = lower_if_to_cond_assign(ir, options->MaxIfDepth) || progress;
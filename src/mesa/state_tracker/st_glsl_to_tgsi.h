@@ -33,6 +33,8 @@ struct gl_context;
 struct gl_shader;
 struct gl_shader_program;
 struct glsl_to_tgsi_visitor;
+struct st_shader_key;
+union gl_constant_value;
 
 enum pipe_error st_translate_program(
    struct gl_context *ctx,
@@ -53,6 +55,27 @@ enum pipe_error st_translate_program(
    boolean passthrough_edgeflags,
    boolean clamp_color);
 
+const struct tgsi_token *
+st_translate_program_cached(
+   struct gl_context *ctx,
+   struct st_shader_key *key,
+   uint procType,
+   struct ureg_program *ureg,
+   struct glsl_to_tgsi_visitor *program,
+   const struct gl_program *proginfo,
+   GLuint numInputs,
+   const GLuint inputMapping[],
+   const ubyte inputSemanticName[],
+   const ubyte inputSemanticIndex[],
+   const GLuint interpMode[],
+   const GLboolean is_centroid[],
+   GLuint numOutputs,
+   const GLuint outputMapping[],
+   const ubyte outputSemanticName[],
+   const ubyte outputSemanticIndex[],
+   boolean passthrough_edgeflags,
+   boolean clamp_color);
+
 void free_glsl_to_tgsi_visitor(struct glsl_to_tgsi_visitor *v);
 void get_pixel_transfer_visitor(struct st_fragment_program *fp,
                                 struct glsl_to_tgsi_visitor *original,
@@ -60,6 +83,10 @@ void get_pixel_transfer_visitor(struct st_fragment_program *fp,
 void get_bitmap_visitor(struct st_fragment_program *fp,
                         struct glsl_to_tgsi_visitor *original,
                         int samplerIndex);
+struct glsl_to_tgsi_visitor *
+get_specialized_visitor(struct gl_context *ctx,
+                        struct st_fragment_program *fp,
+                        const union gl_constant_value *values);
 
 struct gl_shader *st_new_shader(struct gl_context *ctx, GLuint name, GLuint type);
 
@@ -32,6 +32,7 @@
 #include "main/teximage.h"
 #include "main/texstate.h"
 #include "main/framebuffer.h"
+#include "main/glthread.h"
 #include "main/fbobject.h"
 #include "main/renderbuffer.h"
 #include "main/version.h"
@@ -455,6 +456,8 @@ st_context_flush(struct st_context_iface *stctxi, unsigned flags,
    struct st_context *st = (struct st_context *) stctxi;
    enum pipe_flush_flags pipe_flags = 0;
 
+   _mesa_glthread_finish(st->ctx);
+
    if (flags & ST_FLUSH_END_OF_FRAME) {
       pipe_flags |= PIPE_FLUSH_END_OF_FRAME;
    }
@@ -472,7 +475,7 @@ st_context_teximage(struct st_context_iface *stctxi,
 {
    struct st_context *st = (struct st_context *) stctxi;
    struct gl_context *ctx = st->ctx;
-   struct gl_texture_unit *texUnit = _mesa_get_current_tex_unit(ctx);
+   struct gl_texture_unit *texUnit;
    struct gl_texture_object *texObj;
    struct gl_texture_image *texImage;
    struct st_texture_object *stObj;
@@ -481,6 +484,10 @@ st_context_teximage(struct st_context_iface *stctxi,
    GLuint width, height, depth;
    GLenum target;
 
+   /* The texture unit state is owned by the driver thread, if any. */
+   _mesa_glthread_finish(ctx);
+   texUnit = _mesa_get_current_tex_unit(ctx);
+
    switch (tex_type) {
    case ST_TEXTURE_1D:
       target = GL_TEXTURE_1D;
@@ -717,6 +724,9 @@ st_api_make_current(struct st_api *stapi, struct st_context_iface *stctxi,
    _glapi_check_multithread();
 
    if (st) {
+      /* The framebuffer state is owned by the driver thread, if any. */
+      _mesa_glthread_finish(st->ctx);
+
       /* reuse or create the draw fb */
       stdraw = st_framebuffer_reuse_or_create(st->ctx->WinSysDrawBuffer,
                                               stdrawi);
@@ -742,6 +752,12 @@ st_api_make_current(struct st_api *stapi, struct st_context_iface *stctxi,
          st->draw_stamp = stdraw->stamp - 1;
          st->read_stamp = stread->stamp - 1;
          st_context_validate(st, stdraw, stread);
+
+         /* Start the threaded dispatch, if requested, once the context is
+          * bound to a real framebuffer.
+          */
+         if (ret)
+            _mesa_glthread_init(st->ctx);
       }
       else {
          struct gl_framebuffer *incomplete = _mesa_get_incomplete_framebuffer();
@@ -51,6 +51,7 @@
 #include "st_context.h"
 #include "st_program.h"
 #include "st_mesa_to_tgsi.h"
+#include "st_shader_cache.h"
 #include "cso_cache/cso_context.h"
 
 
@@ -63,7 +64,8 @@ static void
 delete_vp_variant(struct st_context *st, struct st_vp_variant *vpv)
 {
    if (vpv->driver_shader) 
-      cso_delete_vertex_shader(st->cso_context, vpv->driver_shader);
+      st_delete_shader_cso(vpv->key.st, PIPE_SHADER_VERTEX,
+                           vpv->driver_shader);
       
    if (vpv->draw_shader)
       draw_delete_vertex_shader( st->draw, vpv->draw_shader );
@@ -104,7 +106,8 @@ static void
 delete_fp_variant(struct st_context *st, struct st_fp_variant *fpv)
 {
    if (fpv->driver_shader) 
-      cso_delete_fragment_shader(st->cso_context, fpv->driver_shader);
+      st_delete_shader_cso(fpv->key.st, PIPE_SHADER_FRAGMENT,
+                           fpv->driver_shader);
    if (fpv->parameters)
       _mesa_free_parameter_list(fpv->parameters);
    if (fpv->tgsi.tokens)
@@ -128,6 +131,7 @@ st_release_fp_variants(struct st_context *st, struct st_fragment_program *stfp)
    }
 
    stfp->variants = NULL;
+   stfp->num_specialized_variants = 0;
 }
 
 
@@ -139,7 +143,8 @@ static void
 delete_gp_variant(struct st_context *st, struct st_gp_variant *gpv)
 {
    if (gpv->driver_shader) 
-      cso_delete_geometry_shader(st->cso_context, gpv->driver_shader);
+      st_delete_shader_cso(gpv->key.st, PIPE_SHADER_GEOMETRY,
+                           gpv->driver_shader);
       
    free(gpv);
 }
@@ -298,7 +303,6 @@ st_translate_vertex_program(struct st_context *st,
                             const struct st_vp_variant_key *key)
 {
    struct st_vp_variant *vpv = CALLOC_STRUCT(st_vp_variant);
-   struct pipe_context *pipe = st->pipe;
    struct ureg_program *ureg;
    enum pipe_error error;
    unsigned num_outputs;
@@ -331,27 +335,35 @@ st_translate_vertex_program(struct st_context *st,
       debug_printf("\n");
    }
 
-   if (stvp->glsl_to_tgsi)
-      error = st_translate_program(st->ctx,
-                                   TGSI_PROCESSOR_VERTEX,
-                                   ureg,
-                                   stvp->glsl_to_tgsi,
-                                   &stvp->Base.Base,
-                                   /* inputs */
-                                   stvp->num_inputs,
-                                   stvp->input_to_index,
-                                   NULL, /* input semantic name */
-                                   NULL, /* input semantic index */
-                                   NULL, /* interp mode */
-                                   NULL, /* is centroid */
-                                   /* outputs */
-                                   stvp->num_outputs,
-                                   stvp->result_to_output,
-                                   stvp->output_semantic_name,
-                                   stvp->output_semantic_index,
-                                   key->passthrough_edgeflags,
-                                   key->clamp_color);
-   else
+   if (stvp->glsl_to_tgsi) {
+      struct st_shader_key cache_key;
+
+      st_shader_key_init(&cache_key, st, TGSI_PROCESSOR_VERTEX);
+      vpv->tgsi.tokens =
+         st_translate_program_cached(st->ctx,
+                                     &cache_key,
+                                     TGSI_PROCESSOR_VERTEX,
+                                     ureg,
+                                     stvp->glsl_to_tgsi,
+                                     &stvp->Base.Base,
+                                     /* inputs */
+                                     stvp->num_inputs,
+                                     stvp->input_to_index,
+                                     NULL, /* input semantic name */
+                                     NULL, /* input semantic index */
+                                     NULL, /* interp mode */
+                                     NULL, /* is centroid */
+                                     /* outputs */
+                                     stvp->num_outputs,
+                                     stvp->result_to_output,
+                                     stvp->output_semantic_name,
+                                     stvp->output_semantic_index,
+                                     key->passthrough_edgeflags,
+                                     key->clamp_color);
+      st_shader_key_fini(&cache_key);
+      error = vpv->tgsi.tokens ? PIPE_OK : PIPE_ERROR;
+   }
+   else {
       error = st_translate_mesa_program(st->ctx,
                                         TGSI_PROCESSOR_VERTEX,
                                         ureg,
@@ -369,14 +381,16 @@ st_translate_vertex_program(struct st_context *st,
                                         stvp->output_semantic_index,
                                         key->passthrough_edgeflags,
                                         key->clamp_color);
+      if (!error) {
+         vpv->tgsi.tokens = ureg_get_tokens( ureg, NULL );
+         if (!vpv->tgsi.tokens)
+            error = PIPE_ERROR_OUT_OF_MEMORY;
+      }
+   }
 
    if (error)
       goto fail;
 
-   vpv->tgsi.tokens = ureg_get_tokens( ureg, NULL );
-   if (!vpv->tgsi.tokens)
-      goto fail;
-
    ureg_destroy( ureg );
 
    if (stvp->glsl_to_tgsi) {
@@ -385,7 +399,8 @@ st_translate_vertex_program(struct st_context *st,
                                       &vpv->tgsi.stream_output);
    }
 
-   vpv->driver_shader = pipe->create_vs_state(pipe, &vpv->tgsi);
+   vpv->driver_shader = st_create_shader_cso(st, PIPE_SHADER_VERTEX,
+                                             &vpv->tgsi);
 
    if (ST_DEBUG & DEBUG_TGSI) {
       tgsi_dump( vpv->tgsi.tokens, 0 );
@@ -466,8 +481,8 @@ st_translate_fragment_program(struct st_context *st,
                               struct st_fragment_program *stfp,
                               const struct st_fp_variant_key *key)
 {
-   struct pipe_context *pipe = st->pipe;
    struct st_fp_variant *variant = CALLOC_STRUCT(st_fp_variant);
+   struct glsl_to_tgsi_visitor *glsl_to_tgsi = stfp->glsl_to_tgsi;
    GLboolean deleteFP = GL_FALSE;
 
    GLuint outputMapping[FRAG_RESULT_MAX];
@@ -492,6 +507,17 @@ st_translate_fragment_program(struct st_context *st,
       return NULL;
 
    assert(!(key->bitmap && key->drawpixels));
+   assert(!(key->specialized && (key->bitmap || key->drawpixels)));
+
+   if (key->specialized && glsl_to_tgsi) {
+      /* Fold the current uniform values into the shader.  If that isn't
+       * possible, the variant simply reads the uniforms like the generic one.
+       */
+      glsl_to_tgsi = get_specialized_visitor(st->ctx, stfp,
+                                             key->uniform_values);
+      if (!glsl_to_tgsi)
+         glsl_to_tgsi = stfp->glsl_to_tgsi;
+   }
 
    if (key->bitmap) {
       /* glBitmap drawing */
@@ -502,6 +528,7 @@ st_translate_fragment_program(struct st_context *st,
 
       variant->parameters = _mesa_clone_parameter_list(fp->Base.Parameters);
       stfp = st_fragment_program(fp);
+      glsl_to_tgsi = stfp->glsl_to_tgsi;
       deleteFP = GL_TRUE;
    }
    else if (key->drawpixels) {
@@ -519,6 +546,7 @@ st_translate_fragment_program(struct st_context *st,
          deleteFP = GL_TRUE;
       }
       stfp = st_fragment_program(fp);
+      glsl_to_tgsi = stfp->glsl_to_tgsi;
    }
 
    if (!stfp->glsl_to_tgsi)
@@ -724,26 +752,36 @@ st_translate_fragment_program(struct st_context *st,
       }
    }
 
-   if (stfp->glsl_to_tgsi)
-      st_translate_program(st->ctx,
-                           TGSI_PROCESSOR_FRAGMENT,
-                           ureg,
-                           stfp->glsl_to_tgsi,
-                           &stfp->Base.Base,
-                           /* inputs */
-                           fs_num_inputs,
-                           inputMapping,
-                           input_semantic_name,
-                           input_semantic_index,
-                           interpMode,
-                           is_centroid,
-                           /* outputs */
-                           fs_num_outputs,
-                           outputMapping,
-                           fs_output_semantic_name,
-                           fs_output_semantic_index, FALSE,
-                           key->clamp_color );
-   else
+   if (glsl_to_tgsi) {
+      /* the ureg properties set above */
+      const GLuint properties[2] = { write_all, stfp->Base.FragDepthLayout };
+      struct st_shader_key cache_key;
+
+      st_shader_key_init(&cache_key, st, TGSI_PROCESSOR_FRAGMENT);
+      st_shader_key_add(&cache_key, properties, sizeof(properties));
+      variant->tgsi.tokens =
+         st_translate_program_cached(st->ctx,
+                                     &cache_key,
+                                     TGSI_PROCESSOR_FRAGMENT,
+                                     ureg,
+                                     glsl_to_tgsi,
+                                     &stfp->Base.Base,
+                                     /* inputs */
+                                     fs_num_inputs,
+                                     inputMapping,
+                                     input_semantic_name,
+                                     input_semantic_index,
+                                     interpMode,
+                                     is_centroid,
+                                     /* outputs */
+                                     fs_num_outputs,
+                                     outputMapping,
+                                     fs_output_semantic_name,
+                                     fs_output_semantic_index, FALSE,
+                                     key->clamp_color );
+      st_shader_key_fini(&cache_key);
+   }
+   else {
       st_translate_mesa_program(st->ctx,
                                 TGSI_PROCESSOR_FRAGMENT,
                                 ureg,
@@ -761,18 +799,33 @@ st_translate_fragment_program(struct st_context *st,
                                 fs_output_semantic_index, FALSE,
                                 key->clamp_color);
 
-   variant->tgsi.tokens = ureg_get_tokens( ureg, NULL );
+      variant->tgsi.tokens = ureg_get_tokens( ureg, NULL );
+   }
    ureg_destroy( ureg );
 
-   /* fill in variant */
-   variant->driver_shader = pipe->create_fs_state(pipe, &variant->tgsi);
-   variant->key = *key;
+   if (variant->tgsi.tokens) {
+      /* fill in variant */
+      variant->driver_shader = st_create_shader_cso(st, PIPE_SHADER_FRAGMENT,
+                                                    &variant->tgsi);
+      variant->key = *key;
 
-   if (ST_DEBUG & DEBUG_TGSI) {
-      tgsi_dump( variant->tgsi.tokens, 0/*TGSI_DUMP_VERBOSE*/ );
-      debug_printf("\n");
+      if (ST_DEBUG & DEBUG_TGSI) {
+         tgsi_dump( variant->tgsi.tokens, 0/*TGSI_DUMP_VERBOSE*/ );
+         debug_printf("\n");
+      }
+   }
+   else {
+      debug_printf("%s: failed to translate fragment program\n",
+                   __FUNCTION__);
+      if (variant->parameters)
+         _mesa_free_parameter_list(variant->parameters);
+      free(variant);
+      variant = NULL;
    }
 
+   if (glsl_to_tgsi != stfp->glsl_to_tgsi)
+      free_glsl_to_tgsi_visitor(glsl_to_tgsi);
+
    if (deleteFP) {
       /* Free the temporary program made above */
       struct gl_fragment_program *fp = &stfp->Base;
@@ -801,12 +854,28 @@ st_get_fp_variant(struct st_context *st,
    }
 
    if (!fpv) {
+      if (key->specialized &&
+          stfp->num_specialized_variants >= ST_MAX_SPECIALIZED_VARIANTS) {
+         /* Too many combinations of uniform values have been seen.  Use
+          * the variant that reads the uniforms at run time instead.
+          */
+         struct st_fp_variant_key generic_key = *key;
+
+         generic_key.specialized = 0;
+         memset(generic_key.uniform_values, 0,
+                sizeof(generic_key.uniform_values));
+         return st_get_fp_variant(st, stfp, &generic_key);
+      }
+
       /* create new */
       fpv = st_translate_fragment_program(st, stfp, key);
       if (fpv) {
          /* insert into list */
          fpv->next = stfp->variants;
          stfp->variants = fpv;
+
+         if (key->specialized)
+            stfp->num_specialized_variants++;
       }
    }
 
@@ -824,7 +893,6 @@ st_translate_geometry_program(struct st_context *st,
 {
    GLuint inputMapping[VARYING_SLOT_MAX];
    GLuint outputMapping[VARYING_SLOT_MAX];
-   struct pipe_context *pipe = st->pipe;
    GLuint attr;
    GLbitfield64 inputsRead;
    GLuint vslot = 0;
@@ -1060,7 +1128,8 @@ st_translate_geometry_program(struct st_context *st,
    }
 
    /* fill in new variant */
-   gpv->driver_shader = pipe->create_gs_state(pipe, &stgp->tgsi);
+   gpv->driver_shader = st_create_shader_cso(st, PIPE_SHADER_GEOMETRY,
+                                             &stgp->tgsi);
    gpv->key = *key;
 
    if ((ST_DEBUG & DEBUG_TGSI) && (ST_DEBUG & DEBUG_MESA)) {
@@ -1199,6 +1268,8 @@ destroy_program_variants(struct st_context *st, struct gl_program *program)
             if (fpv->key.st == st) {
                /* unlink from list */
                *prevPtr = next;
+               if (fpv->key.specialized)
+                  stfp->num_specialized_variants--;
                /* destroy this variant */
                delete_fp_variant(st, fpv);
             }
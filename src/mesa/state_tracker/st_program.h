@@ -36,11 +36,20 @@
 
 #include "main/mtypes.h"
 #include "program/program.h"
+#include "program/prog_parameter.h"
 #include "pipe/p_state.h"
 #include "st_context.h"
 #include "st_glsl_to_tgsi.h"
 
 
+/**
+ * Maximum number of uniforms a fragment program can be specialized on, and
+ * maximum number of specialized variants built per fragment program.
+ */
+#define ST_MAX_SPECIALIZED_UNIFORMS 4
+#define ST_MAX_SPECIALIZED_VARIANTS 8
+
+
 /** Fragment program variant key */
 struct st_fp_variant_key
 {
@@ -58,6 +67,12 @@ struct st_fp_variant_key
 
    /** for ARB_color_buffer_float */
    GLuint clamp_color:1;
+
+   /** Uniform values folded into the shader as constants? */
+   GLuint specialized:1;
+
+   /** Raw values of st_fragment_program::specialized_uniforms */
+   gl_constant_value uniform_values[ST_MAX_SPECIALIZED_UNIFORMS];
 };
 
 
@@ -91,6 +106,16 @@ struct st_fragment_program
    struct gl_fragment_program Base;
    struct glsl_to_tgsi_visitor* glsl_to_tgsi;
 
+   /**
+    * Parameter indices of the scalar uniforms that control branches and
+    * that variants may be specialized on (see ST_SPECIALIZE_UNIFORMS).
+    */
+   GLuint specialized_uniforms[ST_MAX_SPECIALIZED_UNIFORMS];
+   GLuint num_specialized_uniforms;
+
+   /** Number of specialized variants in the variants list */
+   GLuint num_specialized_variants;
+
    struct st_fp_variant *variants;
 };
 
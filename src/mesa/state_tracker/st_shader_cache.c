@@ -0,0 +1,524 @@
+/*
+ * Mesa 3-D graphics library
+ *
+ * Copyright (C) 2013  VMware, Inc.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+
+/**
+ * \file st_shader_cache.c
+ * Caches of translated shaders.
+ *
+ * Relinking a GLSL program, or linking the same shaders again in another
+ * program, used to run the whole glsl_to_tgsi translation and create a
+ * new driver shader for every variant.  Now the tokens are kept in a
+ * process-wide cache keyed by everything the translation depends on
+ * (see st_shader_key), and saved to the disk cache of prog_diskcache.c
+ * so that later runs find them too.
+ *
+ * Driver shaders can't be shared between pipe contexts, so each context
+ * has its own table of them, keyed by the tokens.  Variants with the
+ * same tokens share one reference counted driver shader.
+ */
+
+
+#include "main/imports.h"
+#include "main/macros.h"
+#include "program/prog_diskcache.h"
+
+#include "pipe/p_context.h"
+#include "pipe/p_screen.h"
+#include "pipe/p_state.h"
+#include "cso_cache/cso_context.h"
+#include "os/os_thread.h"
+#include "tgsi/tgsi_parse.h"
+#include "util/u_hash.h"
+#include "util/u_hash_table.h"
+
+#include "st_context.h"
+#include "st_mesa_to_tgsi.h"
+#include "st_shader_cache.h"
+
+
+/** The cache is emptied when it grows beyond this */
+#define ST_SHADER_CACHE_MAX_ENTRIES 2048
+
+/** Tells the TGSI tokens apart from other data in the disk cache */
+#define ST_SHADER_CACHE_DISK_KIND 0x54475349 /* "TGSI" */
+
+
+struct cache_entry
+{
+   struct st_shader_key key;
+   const struct tgsi_token *tokens;
+};
+
+pipe_static_mutex(cache_mutex);
+static struct util_hash_table *cache;
+static unsigned cache_entries;
+static unsigned cache_users;
+
+
+/**
+ * A driver shader and the variants using it.
+ */
+struct shader_cso
+{
+   unsigned type;            /**< PIPE_SHADER_x */
+   unsigned hash;
+   struct pipe_shader_state state;
+   void *driver_shader;
+   unsigned refcount;
+};
+
+
+static unsigned
+key_hash(void *key)
+{
+   return ((const struct st_shader_key *) key)->hash;
+}
+
+
+static int
+key_compare(void *key1, void *key2)
+{
+   const struct st_shader_key *a = key1, *b = key2;
+
+   if (a->size != b->size)
+      return 1;
+   return memcmp(a->data, b->data, a->size);
+}
+
+
+void
+st_shader_key_add(struct st_shader_key *key, const void *data, unsigned size)
+{
+   if (key->error)
+      return;
+
+   if (key->size + size > key->alloc) {
+      unsigned alloc = MAX2(key->alloc * 2, key->size + size + 1024);
+      unsigned char *p = realloc(key->data, alloc);
+      if (!p) {
+         key->error = TRUE;
+         return;
+      }
+      key->data = p;
+      key->alloc = alloc;
+   }
+
+   memcpy(key->data + key->size, data, size);
+   key->size += size;
+}
+
+
+/**
+ * Start a key with the context state that affects all translations.
+ */
+void
+st_shader_key_init(struct st_shader_key *key, struct st_context *st,
+                   unsigned procType)
+{
+   struct pipe_screen *screen = st->pipe->screen;
+   const char *name = screen->get_name(screen);
+   const char *vendor = screen->get_vendor(screen);
+   unsigned values[3];
+
+   memset(key, 0, sizeof(*key));
+
+   /* The caps of the driver, like the supported fragment coord
+    * conventions, are implied by its name.
+    */
+   st_shader_key_add(key, name, strlen(name) + 1);
+   st_shader_key_add(key, vendor, strlen(vendor) + 1);
+
+   values[0] = procType;
+   values[1] = st->ctx->Const.NativeIntegers;
+   values[2] = st->ctx->Const.MaxTextureImageUnits;
+   st_shader_key_add(key, values, sizeof(values));
+}
+
+
+void
+st_shader_key_fini(struct st_shader_key *key)
+{
+   free(key->data);
+   key->data = NULL;
+}
+
+
+static enum pipe_error
+free_cache_entry(void *key, void *value, void *data)
+{
+   struct cache_entry *entry = value;
+
+   st_free_tokens(entry->tokens);
+   free(entry->key.data);
+   free(entry);
+   return PIPE_OK;
+}
+
+
+/**
+ * Add tokens to the in-memory cache.  Takes ownership of \p tokens.
+ */
+static void
+cache_insert_locked(const struct st_shader_key *key,
+                    const struct tgsi_token *tokens)
+{
+   struct cache_entry *entry;
+
+   if (util_hash_table_get(cache, (void *) key)) {
+      st_free_tokens(tokens);
+      return;
+   }
+
+   if (cache_entries >= ST_SHADER_CACHE_MAX_ENTRIES) {
+      util_hash_table_foreach(cache, free_cache_entry, NULL);
+      util_hash_table_clear(cache);
+      cache_entries = 0;
+   }
+
+   entry = CALLOC_STRUCT(cache_entry);
+   if (!entry) {
+      st_free_tokens(tokens);
+      return;
+   }
+
+   entry->key = *key;
+   entry->key.data = malloc(key->size);
+   entry->key.alloc = key->size;
+   entry->tokens = tokens;
+   if (!entry->key.data) {
+      free_cache_entry(NULL, entry, NULL);
+      return;
+   }
+
+   memcpy(entry->key.data, key->data, key->size);
+   if (util_hash_table_set(cache, &entry->key, entry) != PIPE_OK) {
+      free_cache_entry(NULL, entry, NULL);
+      return;
+   }
+
+   cache_entries++;
+}
+
+
+/**
+ * Load tokens from the disk cache.
+ */
+static const struct tgsi_token *
+load_tokens(const struct st_shader_key *key)
+{
+   struct tgsi_token *tokens;
+   GLuint size;
+   void *data;
+
+   data = _mesa_load_blob_from_disk(ST_SHADER_CACHE_DISK_KIND,
+                                    key->data, key->size, &size);
+   if (!data)
+      return NULL;
+
+   /* the file has a checksum, but make sure the tokens are complete */
+   tokens = NULL;
+   if (size >= 2 * sizeof(struct tgsi_token) &&
+       size % sizeof(struct tgsi_token) == 0 &&
+       tgsi_num_tokens(data) * sizeof(struct tgsi_token) == size) {
+      tokens = tgsi_alloc_tokens(size / sizeof(struct tgsi_token));
+      if (tokens)
+         memcpy(tokens, data, size);
+   }
+
+   free(data);
+   return tokens;
+}
+
+
+/**
+ * Look up the tokens of a translation.
+ * \return a copy of the tokens, to be freed with st_free_tokens(), or NULL
+ */
+const struct tgsi_token *
+st_shader_cache_find(struct st_shader_key *key)
+{
+   const struct tgsi_token *tokens = NULL;
+   struct cache_entry *entry;
+
+   if (key->error || !cache)
+      return NULL;
+
+   key->hash = util_hash_crc32(key->data, key->size);
+
+   pipe_mutex_lock(cache_mutex);
+   entry = util_hash_table_get(cache, key);
+   if (entry)
+      tokens = tgsi_dup_tokens(entry->tokens);
+   pipe_mutex_unlock(cache_mutex);
+
+   if (!entry) {
+      tokens = load_tokens(key);
+      if (tokens) {
+         const struct tgsi_token *copy = tgsi_dup_tokens(tokens);
+
+         if (copy) {
+            pipe_mutex_lock(cache_mutex);
+            cache_insert_locked(key, copy);
+            pipe_mutex_unlock(cache_mutex);
+         }
+      }
+   }
+
+   return tokens;
+}
+
+
+/**
+ * Save the tokens of a translation that st_shader_cache_find() didn't
+ * find, in memory and on disk.
+ */
+void
+st_shader_cache_insert(struct st_shader_key *key,
+                       const struct tgsi_token *tokens)
+{
+   const struct tgsi_token *copy;
+
+   if (key->error || !cache || !tokens)
+      return;
+
+   key->hash = util_hash_crc32(key->data, key->size);
+
+   copy = tgsi_dup_tokens(tokens);
+   if (copy) {
+      pipe_mutex_lock(cache_mutex);
+      cache_insert_locked(key, copy);
+      pipe_mutex_unlock(cache_mutex);
+   }
+
+   _mesa_store_blob_to_disk(ST_SHADER_CACHE_DISK_KIND, key->data, key->size,
+                            tokens,
+                            tgsi_num_tokens(tokens) * sizeof(struct tgsi_token));
+}
+
+
+static unsigned
+shader_cso_hash(void *key)
+{
+   return ((const struct shader_cso *) key)->hash;
+}
+
+
+static int
+shader_cso_compare(void *key1, void *key2)
+{
+   const struct shader_cso *a = key1, *b = key2;
+   unsigned n = tgsi_num_tokens(a->state.tokens);
+
+   if (a->type != b->type ||
+       n != tgsi_num_tokens(b->state.tokens) ||
+       memcmp(&a->state.stream_output, &b->state.stream_output,
+              sizeof(a->state.stream_output)) != 0)
+      return 1;
+
+   return memcmp(a->state.tokens, b->state.tokens,
+                 n * sizeof(struct tgsi_token));
+}
+
+
+static unsigned
+handle_hash(void *key)
+{
+   return (unsigned) ((uintptr_t) key >> 4);
+}
+
+
+static int
+handle_compare(void *key1, void *key2)
+{
+   return key1 != key2;
+}
+
+
+static void *
+create_driver_shader(struct pipe_context *pipe, unsigned type,
+                     const struct pipe_shader_state *state)
+{
+   switch (type) {
+   case PIPE_SHADER_VERTEX:
+      return pipe->create_vs_state(pipe, state);
+   case PIPE_SHADER_FRAGMENT:
+      return pipe->create_fs_state(pipe, state);
+   case PIPE_SHADER_GEOMETRY:
+      return pipe->create_gs_state(pipe, state);
+   default:
+      assert(0);
+      return NULL;
+   }
+}
+
+
+/**
+ * Create a driver shader, or return the existing one for the same
+ * shader state.  Release it with st_delete_shader_cso().
+ */
+void *
+st_create_shader_cso(struct st_context *st, unsigned type,
+                     const struct pipe_shader_state *state)
+{
+   struct pipe_context *pipe = st->pipe;
+   struct shader_cso probe, *cso;
+   void *driver_shader;
+
+   if (!st->shader_csos || !st->shader_cso_handles)
+      return create_driver_shader(pipe, type, state);
+
+   probe.type = type;
+   probe.hash = type ^ util_hash_crc32(state->tokens,
+                                       tgsi_num_tokens(state->tokens) *
+                                       sizeof(struct tgsi_token));
+   probe.state = *state;
+
+   cso = util_hash_table_get(st->shader_csos, &probe);
+   if (cso) {
+      cso->refcount++;
+      return cso->driver_shader;
+   }
+
+   driver_shader = create_driver_shader(pipe, type, state);
+   if (!driver_shader)
+      return NULL;
+
+   /* If the shader can't be added to the tables it simply isn't shared,
+    * st_delete_shader_cso() deletes unknown shaders right away.
+    */
+   cso = CALLOC_STRUCT(shader_cso);
+   if (!cso)
+      return driver_shader;
+
+   *cso = probe;
+   cso->state.tokens = tgsi_dup_tokens(state->tokens);
+   cso->driver_shader = driver_shader;
+   cso->refcount = 1;
+
+   if (!cso->state.tokens ||
+       util_hash_table_set(st->shader_csos, cso, cso) != PIPE_OK) {
+      if (cso->state.tokens)
+         st_free_tokens(cso->state.tokens);
+      FREE(cso);
+      return driver_shader;
+   }
+
+   if (util_hash_table_set(st->shader_cso_handles, driver_shader,
+                           cso) != PIPE_OK) {
+      util_hash_table_remove(st->shader_csos, cso);
+      st_free_tokens(cso->state.tokens);
+      FREE(cso);
+   }
+
+   return driver_shader;
+}
+
+
+/**
+ * Release a driver shader returned by st_create_shader_cso().
+ */
+void
+st_delete_shader_cso(struct st_context *st, unsigned type, void *shader)
+{
+   struct shader_cso *cso;
+
+   cso = st->shader_cso_handles ?
+      util_hash_table_get(st->shader_cso_handles, shader) : NULL;
+   if (cso) {
+      assert(cso->type == type);
+      if (--cso->refcount)
+         return;
+
+      util_hash_table_remove(st->shader_cso_handles, shader);
+      util_hash_table_remove(st->shader_csos, cso);
+      st_free_tokens(cso->state.tokens);
+      FREE(cso);
+   }
+
+   switch (type) {
+   case PIPE_SHADER_VERTEX:
+      cso_delete_vertex_shader(st->cso_context, shader);
+      break;
+   case PIPE_SHADER_FRAGMENT:
+      cso_delete_fragment_shader(st->cso_context, shader);
+      break;
+   case PIPE_SHADER_GEOMETRY:
+      cso_delete_geometry_shader(st->cso_context, shader);
+      break;
+   default:
+      assert(0);
+   }
+}
+
+
+void
+st_init_shader_cache(struct st_context *st)
+{
+   st->shader_csos = util_hash_table_create(shader_cso_hash,
+                                           shader_cso_compare);
+   st->shader_cso_handles = util_hash_table_create(handle_hash,
+                                                   handle_compare);
+
+   pipe_mutex_lock(cache_mutex);
+   if (cache_users++ == 0)
+      cache = util_hash_table_create(key_hash, key_compare);
+   pipe_mutex_unlock(cache_mutex);
+}
+
+
+static enum pipe_error
+free_shader_cso(void *key, void *value, void *data)
+{
+   struct shader_cso *cso = value;
+
+   st_free_tokens(cso->state.tokens);
+   FREE(cso);
+   return PIPE_OK;
+}
+
+
+void
+st_destroy_shader_cache(struct st_context *st)
+{
+   /* All variants are gone by now, the driver shaders of any that were
+    * leaked are destroyed along with the pipe context.
+    */
+   if (st->shader_csos) {
+      util_hash_table_foreach(st->shader_csos, free_shader_cso, NULL);
+      util_hash_table_destroy(st->shader_csos);
+   }
+   if (st->shader_cso_handles)
+      util_hash_table_destroy(st->shader_cso_handles);
+
+   pipe_mutex_lock(cache_mutex);
+   if (--cache_users == 0 && cache) {
+      util_hash_table_foreach(cache, free_cache_entry, NULL);
+      util_hash_table_destroy(cache);
+      cache = NULL;
+      cache_entries = 0;
+   }
+   pipe_mutex_unlock(cache_mutex);
+}
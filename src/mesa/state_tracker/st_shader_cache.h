@@ -0,0 +1,91 @@
+/*
+ * Mesa 3-D graphics library
+ *
+ * Copyright (C) 2013  VMware, Inc.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+
+#ifndef ST_SHADER_CACHE_H
+#define ST_SHADER_CACHE_H
+
+#include "pipe/p_compiler.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct pipe_shader_state;
+struct st_context;
+struct tgsi_token;
+
+
+/**
+ * Everything that goes into translating a program to TGSI, as a string
+ * of bytes.  Translations with the same key produce the same tokens.
+ */
+struct st_shader_key
+{
+   unsigned char *data;
+   unsigned size, alloc;
+   unsigned hash;
+   boolean error;   /**< out of memory, the key can't be used */
+};
+
+
+extern void
+st_shader_key_init(struct st_shader_key *key, struct st_context *st,
+                   unsigned procType);
+
+extern void
+st_shader_key_add(struct st_shader_key *key, const void *data, unsigned size);
+
+extern void
+st_shader_key_fini(struct st_shader_key *key);
+
+
+extern const struct tgsi_token *
+st_shader_cache_find(struct st_shader_key *key);
+
+extern void
+st_shader_cache_insert(struct st_shader_key *key,
+                       const struct tgsi_token *tokens);
+
+
+extern void *
+st_create_shader_cso(struct st_context *st, unsigned type,
+                     const struct pipe_shader_state *state);
+
+extern void
+st_delete_shader_cso(struct st_context *st, unsigned type, void *shader);
+
+
+extern void
+st_init_shader_cache(struct st_context *st);
+
+extern void
+st_destroy_shader_cache(struct st_context *st);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ST_SHADER_CACHE_H */
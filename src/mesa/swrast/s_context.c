@@ -40,6 +40,7 @@
 #include "s_lines.h"
 #include "s_points.h"
 #include "s_span.h"
+#include "s_spanbin.h"
 #include "s_texfetch.h"
 #include "s_triangle.h"
 #include "s_texfilter.h"
@@ -266,11 +267,19 @@ _swrast_update_fog_state( struct gl_context *ctx )
 static void
 _swrast_update_fragment_program(struct gl_context *ctx, GLbitfield newState)
 {
-   if (!_swrast_use_fragment_program(ctx))
+   SWcontext *swrast = SWRAST_CONTEXT(ctx);
+
+   if (!_swrast_use_fragment_program(ctx)) {
+      swrast->_FragProgSpan = GL_FALSE;
       return;
+   }
 
    _mesa_load_state_parameters(ctx,
                                ctx->FragmentProgram._Current->Base.Parameters);
+
+   if (newState & _NEW_PROGRAM)
+      swrast->_FragProgSpan =
+         _mesa_program_span_executable(&ctx->FragmentProgram._Current->Base);
 }
 
 
@@ -336,6 +345,13 @@ _swrast_update_specular_vertex_add(struct gl_context *ctx)
 
 #define _SWRAST_NEW_BLEND_FUNC _NEW_COLOR
 
+/* State referenced by _swrast_choose_span_func.
+ */
+#define _SWRAST_NEW_SPAN_FUNC (_SWRAST_NEW_DERIVED |		\
+			       _NEW_LIGHT |			\
+			       _NEW_FOG |			\
+			       _MESA_NEW_SEPARATE_SPECULAR)
+
 
 
 /**
@@ -422,6 +438,21 @@ _swrast_validate_blend_func(struct gl_context *ctx, GLuint n, const GLubyte mask
    swrast->BlendFunc( ctx, n, mask, src, dst, chanType );
 }
 
+/**
+ * Called via swrast->WriteRgbaSpan.  Examine GL state to choose a span
+ * function, then call it.
+ */
+static void
+_swrast_validate_span_func(struct gl_context *ctx, SWspan *span)
+{
+   SWcontext *swrast = SWRAST_CONTEXT(ctx);
+
+   _swrast_validate_derived( ctx );
+   _swrast_choose_span_func( ctx );
+
+   swrast->WriteRgbaSpan( ctx, span );
+}
+
 static void
 _swrast_sleep( struct gl_context *ctx, GLbitfield new_state )
 {
@@ -458,6 +489,9 @@ _swrast_invalidate_state( struct gl_context *ctx, GLbitfield new_state )
    if (new_state & _SWRAST_NEW_BLEND_FUNC)
       swrast->BlendFunc = _swrast_validate_blend_func;
 
+   if (new_state & _SWRAST_NEW_SPAN_FUNC)
+      swrast->WriteRgbaSpan = _swrast_validate_span_func;
+
    if (new_state & _SWRAST_NEW_TEXTURE_SAMPLE_FUNC)
       for (i = 0 ; i < ctx->Const.MaxTextureImageUnits ; i++)
 	 swrast->TextureSample[i] = NULL;
@@ -759,6 +793,7 @@ _swrast_CreateContext( struct gl_context *ctx )
    swrast->Triangle = _swrast_validate_triangle;
    swrast->InvalidateState = _swrast_sleep;
    swrast->BlendFunc = _swrast_validate_blend_func;
+   swrast->WriteRgbaSpan = _swrast_validate_span_func;
 
    swrast->AllowVertexFog = GL_TRUE;
    swrast->AllowPixelFog = GL_TRUE;
@@ -801,6 +836,8 @@ _swrast_CreateContext( struct gl_context *ctx )
 
    ctx->swrast_context = swrast;
 
+   _swrast_span_bin_create(ctx);
+
    swrast->stencil_temp.buf1 = malloc(SWRAST_MAX_WIDTH * sizeof(GLubyte));
    swrast->stencil_temp.buf2 = malloc(SWRAST_MAX_WIDTH * sizeof(GLubyte));
    swrast->stencil_temp.buf3 = malloc(SWRAST_MAX_WIDTH * sizeof(GLubyte));
@@ -826,9 +863,11 @@ _swrast_DestroyContext( struct gl_context *ctx )
       _mesa_debug(ctx, "_swrast_DestroyContext\n");
    }
 
+   _swrast_span_bin_destroy(ctx);
    free( swrast->SpanArrays );
    free( swrast->ZoomedArrays );
    free( swrast->TexelBuffer );
+   _mesa_free_program_span_machine(swrast->FragProgSpanMachine);
 
    free(swrast->stencil_temp.buf1);
    free(swrast->stencil_temp.buf2);
@@ -903,6 +942,7 @@ _swrast_render_finish( struct gl_context *ctx )
    SWcontext *swrast = SWRAST_CONTEXT(ctx);
 
    _swrast_flush(ctx);
+   _swrast_span_bin_flush(ctx);
 
    if (swrast->Driver.SpanRenderFinish)
       swrast->Driver.SpanRenderFinish( ctx );
@@ -64,6 +64,8 @@ typedef void (_ASMAPIP blend_func)( struct gl_context *ctx, GLuint n,
                                     GLvoid *src, const GLvoid *dst,
                                     GLenum chanType);
 
+typedef void (*swrast_span_func)( struct gl_context *ctx, SWspan *span );
+
 typedef void (*swrast_point_func)( struct gl_context *ctx, const SWvertex *);
 
 typedef void (*swrast_line_func)( struct gl_context *ctx,
@@ -223,6 +225,8 @@ typedef struct
    GLboolean _TextureCombinePrimary;
    GLboolean _FogEnabled;
    GLboolean _DeferredTexture;
+   /** Can the fragment program be run a span chunk at a time? */
+   GLboolean _FragProgSpan;
 
    /** List/array of the fragment attributes to interpolate */
    GLuint _ActiveAttribs[VARYING_SLOT_MAX];
@@ -292,6 +296,9 @@ typedef struct
    SWspanarrays *SpanArrays;
    SWspanarrays *ZoomedArrays;  /**< For pixel zooming */
 
+   /** Spans recorded for band-parallel rendering (s_spanbin.c) */
+   struct swrast_span_bin *SpanBin;
+
    /**
     * Used to buffer N GL_POINTS, instead of rendering one by one.
     */
@@ -300,6 +307,7 @@ typedef struct
    /** Internal hooks, kept up to date by the same mechanism as above.
     */
    blend_func BlendFunc;
+   swrast_span_func WriteRgbaSpan;
    texture_sample_func TextureSample[MAX_TEXTURE_IMAGE_UNITS];
 
    /** Buffer for saving the sampled texture colors.
@@ -311,6 +319,7 @@ typedef struct
 
    /** State used during execution of fragment programs */
    struct gl_program_machine FragProgMachine;
+   struct gl_program_span_machine *FragProgSpanMachine;
 
    /** Temporary arrays for stencil operations.  To avoid large stack
     * allocations.
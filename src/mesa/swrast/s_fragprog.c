@@ -150,18 +150,15 @@ fetch_texel_deriv( struct gl_context *ctx, const GLfloat texcoord[4],
 
 
 /**
- * Initialize the virtual fragment program machine state prior to running
- * fragment program on a fragment.  This involves initializing the input
- * registers, condition codes, etc.
- * \param machine  the virtual machine state to init
+ * Adjust the fragment's inputs before running the fragment program on it.
  * \param program  the fragment program we're about to run
  * \param span  the span of pixels we'll operate on
  * \param col  which element (column) of the span we'll operate on
  */
 static void
-init_machine(struct gl_context *ctx, struct gl_program_machine *machine,
-             const struct gl_fragment_program *program,
-             const SWspan *span, GLuint col)
+init_fragment(struct gl_context *ctx,
+              const struct gl_fragment_program *program,
+              const SWspan *span, GLuint col)
 {
    GLfloat *wpos = span->array->attribs[VARYING_SLOT_POS][col];
 
@@ -173,6 +170,28 @@ init_machine(struct gl_context *ctx, struct gl_program_machine *machine,
       wpos[1] += 0.5F;
    }
 
+   /* if running a GLSL program (not ARB_fragment_program) */
+   if (ctx->Shader.CurrentFragmentProgram) {
+      /* Store front/back facing value */
+      span->array->attribs[VARYING_SLOT_FACE][col][0] = 1.0F - span->facing;
+   }
+}
+
+
+/**
+ * Initialize the virtual fragment program machine state prior to running
+ * fragment program on a fragment.  This involves initializing the input
+ * registers, condition codes, etc.
+ * \param machine  the virtual machine state to init
+ * \param program  the fragment program we're about to run
+ * \param span  the span of pixels we'll operate on
+ * \param col  which element (column) of the span we'll operate on
+ */
+static void
+init_machine(struct gl_context *ctx, struct gl_program_machine *machine,
+             const struct gl_fragment_program *program,
+             const SWspan *span, GLuint col)
+{
    /* Setup pointer to input attributes */
    machine->Attribs = span->array->attribs;
 
@@ -182,12 +201,6 @@ init_machine(struct gl_context *ctx, struct gl_program_machine *machine,
 
    machine->Samplers = program->Base.SamplerUnits;
 
-   /* if running a GLSL program (not ARB_fragment_program) */
-   if (ctx->Shader.CurrentFragmentProgram) {
-      /* Store front/back facing value */
-      machine->Attribs[VARYING_SLOT_FACE][col][0] = 1.0F - span->facing;
-   }
-
    machine->CurElement = col;
 
    /* init condition codes */
@@ -204,6 +217,58 @@ init_machine(struct gl_context *ctx, struct gl_program_machine *machine,
 }
 
 
+/**
+ * Store the fragment program's results for one fragment.  Component c of
+ * output o is outputs[(o * 4 + c) * stride].
+ */
+static void
+store_outputs(struct gl_context *ctx, SWspan *span, GLuint col,
+              const GLfloat *outputs, GLuint stride)
+{
+   const struct gl_fragment_program *program = ctx->FragmentProgram._Current;
+   const GLbitfield64 outputsWritten = program->Base.OutputsWritten;
+
+#define OUTPUT(o, c) outputs[((o) * 4 + (c)) * stride]
+
+   /* Store result color */
+   if (outputsWritten & BITFIELD64_BIT(FRAG_RESULT_COLOR)) {
+      GLfloat *color = span->array->attribs[VARYING_SLOT_COL0][col];
+      ASSIGN_4V(color,
+                OUTPUT(FRAG_RESULT_COLOR, 0), OUTPUT(FRAG_RESULT_COLOR, 1),
+                OUTPUT(FRAG_RESULT_COLOR, 2), OUTPUT(FRAG_RESULT_COLOR, 3));
+   }
+   else {
+      /* Multiple drawbuffers / render targets
+       * Note that colors beyond 0 and 1 will overwrite other
+       * attributes, such as FOGC, TEX0, TEX1, etc.  That's OK.
+       */
+      GLuint buf;
+      for (buf = 0; buf < ctx->DrawBuffer->_NumColorDrawBuffers; buf++) {
+         if (outputsWritten & BITFIELD64_BIT(FRAG_RESULT_DATA0 + buf)) {
+            const GLuint o = FRAG_RESULT_DATA0 + buf;
+            GLfloat *color = span->array->attribs[VARYING_SLOT_COL0 + buf][col];
+            ASSIGN_4V(color, OUTPUT(o, 0), OUTPUT(o, 1),
+                      OUTPUT(o, 2), OUTPUT(o, 3));
+         }
+      }
+   }
+
+   /* Store result depth/z */
+   if (outputsWritten & BITFIELD64_BIT(FRAG_RESULT_DEPTH)) {
+      const GLfloat depth = OUTPUT(FRAG_RESULT_DEPTH, 2);
+      if (depth <= 0.0)
+         span->array->z[col] = 0;
+      else if (depth >= 1.0)
+         span->array->z[col] = ctx->DrawBuffer->_DepthMax;
+      else
+         span->array->z[col] =
+            (GLuint) (depth * ctx->DrawBuffer->_DepthMaxF + 0.5F);
+   }
+
+#undef OUTPUT
+}
+
+
 /**
  * Run fragment program on the pixels in span from 'start' to 'end' - 1.
  */
@@ -212,46 +277,16 @@ run_program(struct gl_context *ctx, SWspan *span, GLuint start, GLuint end)
 {
    SWcontext *swrast = SWRAST_CONTEXT(ctx);
    const struct gl_fragment_program *program = ctx->FragmentProgram._Current;
-   const GLbitfield64 outputsWritten = program->Base.OutputsWritten;
    struct gl_program_machine *machine = &swrast->FragProgMachine;
    GLuint i;
 
    for (i = start; i < end; i++) {
       if (span->array->mask[i]) {
+         init_fragment(ctx, program, span, i);
          init_machine(ctx, machine, program, span, i);
 
          if (_mesa_execute_program(ctx, &program->Base, machine)) {
-
-            /* Store result color */
-	    if (outputsWritten & BITFIELD64_BIT(FRAG_RESULT_COLOR)) {
-               COPY_4V(span->array->attribs[VARYING_SLOT_COL0][i],
-                       machine->Outputs[FRAG_RESULT_COLOR]);
-            }
-            else {
-               /* Multiple drawbuffers / render targets
-                * Note that colors beyond 0 and 1 will overwrite other
-                * attributes, such as FOGC, TEX0, TEX1, etc.  That's OK.
-                */
-               GLuint buf;
-               for (buf = 0; buf < ctx->DrawBuffer->_NumColorDrawBuffers; buf++) {
-                  if (outputsWritten & BITFIELD64_BIT(FRAG_RESULT_DATA0 + buf)) {
-                     COPY_4V(span->array->attribs[VARYING_SLOT_COL0 + buf][i],
-                             machine->Outputs[FRAG_RESULT_DATA0 + buf]);
-                  }
-               }
-            }
-
-            /* Store result depth/z */
-            if (outputsWritten & BITFIELD64_BIT(FRAG_RESULT_DEPTH)) {
-               const GLfloat depth = machine->Outputs[FRAG_RESULT_DEPTH][2];
-               if (depth <= 0.0)
-                  span->array->z[i] = 0;
-               else if (depth >= 1.0)
-                  span->array->z[i] = ctx->DrawBuffer->_DepthMax;
-               else
-                  span->array->z[i] =
-                     (GLuint) (depth * ctx->DrawBuffer->_DepthMaxF + 0.5F);
-            }
+            store_outputs(ctx, span, i, &machine->Outputs[0][0], 1);
          }
          else {
             /* killed fragment */
@@ -263,6 +298,61 @@ run_program(struct gl_context *ctx, SWspan *span, GLuint start, GLuint end)
 }
 
 
+/**
+ * Run a straight-line fragment program on the pixels in span from 'start'
+ * to 'end' - 1, PROG_SPAN_CHUNK pixels at a time.
+ * \return GL_FALSE if out of memory, nothing has been run then
+ */
+static GLboolean
+run_program_span(struct gl_context *ctx, SWspan *span,
+                 GLuint start, GLuint end)
+{
+   SWcontext *swrast = SWRAST_CONTEXT(ctx);
+   const struct gl_fragment_program *program = ctx->FragmentProgram._Current;
+   struct gl_program_machine *machine = &swrast->FragProgMachine;
+   struct gl_program_span_machine *sm;
+   GLuint i, j, n;
+
+   if (!_mesa_reserve_program_span_machine(&swrast->FragProgSpanMachine,
+                                           &program->Base))
+      return GL_FALSE;
+
+   sm = swrast->FragProgSpanMachine;
+
+   for (i = start; i < end; i += n) {
+      GLubyte *mask = span->array->mask + i;
+      GLboolean any = GL_FALSE;
+
+      n = MIN2(end - i, PROG_SPAN_CHUNK);
+
+      for (j = 0; j < n; j++) {
+         if (mask[j]) {
+            init_fragment(ctx, program, span, i + j);
+            any = GL_TRUE;
+         }
+      }
+      if (!any)
+         continue;
+
+      init_machine(ctx, machine, program, span, i);
+
+      if (!_mesa_execute_program_span(ctx, &program->Base, machine, sm,
+                                      n, mask)) {
+         /* some fragments were killed */
+         span->writeAll = GL_FALSE;
+      }
+
+      for (j = 0; j < n; j++) {
+         if (mask[j])
+            store_outputs(ctx, span, i + j, &sm->Outputs[0][0][j],
+                          PROG_SPAN_CHUNK);
+      }
+   }
+
+   return GL_TRUE;
+}
+
+
 /**
  * Execute the current fragment program for all the fragments
  * in the given span.
@@ -277,7 +367,9 @@ _swrast_exec_fragment_program( struct gl_context *ctx, SWspan *span )
       ASSERT(span->array->ChanType == GL_FLOAT);
    }
 
-   run_program(ctx, span, 0, span->end);
+   if (!SWRAST_CONTEXT(ctx)->_FragProgSpan ||
+       !run_program_span(ctx, span, 0, span->end))
+      run_program(ctx, span, 0, span->end);
 
    if (program->Base.OutputsWritten & BITFIELD64_BIT(FRAG_RESULT_COLOR)) {
       span->interpMask &= ~SPAN_RGBA;
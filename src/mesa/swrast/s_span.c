@@ -51,6 +51,7 @@
 #include "s_masking.h"
 #include "s_fragprog.h"
 #include "s_span.h"
+#include "s_spanbin.h"
 #include "s_stencil.h"
 #include "s_texcombine.h"
 
@@ -1120,286 +1121,148 @@ _swrast_put_row(struct gl_context *ctx, struct gl_renderbuffer *rb,
 
 
 
-/**
- * Apply all the per-fragment operations to a span.
- * This now includes texturing (_swrast_write_texture_span() is history).
- * This function may modify any of the array values in the span.
- * span->interpMask and span->arrayMask may be changed but will be restored
- * to their original values before returning.
- */
-void
-_swrast_write_rgba_span( struct gl_context *ctx, SWspan *span)
-{
-   const SWcontext *swrast = SWRAST_CONTEXT(ctx);
-   const GLuint *colorMask = (GLuint *) ctx->Color.ColorMask;
-   const GLbitfield origInterpMask = span->interpMask;
-   const GLbitfield origArrayMask = span->arrayMask;
-   const GLbitfield64 origArrayAttribs = span->arrayAttribs;
-   const GLenum origChanType = span->array->ChanType;
-   void * const origRgba = span->array->rgba;
-   const GLboolean shader = (_swrast_use_fragment_program(ctx)
-                             || ctx->ATIFragmentShader._Enabled);
-   const GLboolean shaderOrTexture = shader || ctx->Texture._EnabledCoordUnits;
-   struct gl_framebuffer *fb = ctx->DrawBuffer;
+/** \name Per-fragment operations handled by a span function */
+/*@{*/
+#define SPAN_FUNC_TEXTURE  0x01  /**< texturing or fragment shading */
+#define SPAN_FUNC_ALPHA    0x02  /**< alpha test */
+#define SPAN_FUNC_DEPTH    0x04  /**< depth and stencil tests */
+#define SPAN_FUNC_FOG      0x08  /**< fog */
+#define SPAN_FUNC_BLEND    0x10  /**< blending */
+#define SPAN_FUNC_OTHER    0x20  /**< depth bounds, stipple, color sum,
+                                      logic op and color masking */
+#define SPAN_FUNC_ALL      0x3f
+/*@}*/
 
-   /*
-   printf("%s()  interp 0x%x  array 0x%x\n", __FUNCTION__,
-          span->interpMask, span->arrayMask);
-   */
-
-   ASSERT(span->primitive == GL_POINT ||
-          span->primitive == GL_LINE ||
-	  span->primitive == GL_POLYGON ||
-          span->primitive == GL_BITMAP);
-
-   /* Fragment write masks */
-   if (span->arrayMask & SPAN_MASK) {
-      /* mask was initialized by caller, probably glBitmap */
-      span->writeAll = GL_FALSE;
-   }
-   else {
-      memset(span->array->mask, 1, span->end);
-      span->writeAll = GL_TRUE;
-   }
 
-   /* Clip to window/scissor box */
-   if (!clip_span(ctx, span)) {
-      return;
-   }
+#define NAME write_rgba_span_general
+#define FEATURES SPAN_FUNC_ALL
+#include "s_spantemp.h"
 
-   ASSERT(span->end <= SWRAST_MAX_WIDTH);
+#define NAME write_rgba_span_plain
+#define FEATURES 0
+#include "s_spantemp.h"
 
-   /* Depth bounds test */
-   if (ctx->Depth.BoundsTest && fb->Visual.depthBits > 0) {
-      if (!_swrast_depth_bounds_test(ctx, span)) {
-         return;
-      }
-   }
+#define NAME write_rgba_span_z
+#define FEATURES SPAN_FUNC_DEPTH
+#include "s_spantemp.h"
 
-#ifdef DEBUG
-   /* Make sure all fragments are within window bounds */
-   if (span->arrayMask & SPAN_XY) {
-      /* array of pixel locations */
-      GLuint i;
-      for (i = 0; i < span->end; i++) {
-         if (span->array->mask[i]) {
-            assert(span->array->x[i] >= fb->_Xmin);
-            assert(span->array->x[i] < fb->_Xmax);
-            assert(span->array->y[i] >= fb->_Ymin);
-            assert(span->array->y[i] < fb->_Ymax);
-         }
-      }
-   }
-#endif
+#define NAME write_rgba_span_blend
+#define FEATURES SPAN_FUNC_BLEND
+#include "s_spantemp.h"
 
-   /* Polygon Stippling */
-   if (ctx->Polygon.StippleFlag && span->primitive == GL_POLYGON) {
-      stipple_polygon_span(ctx, span);
-   }
+#define NAME write_rgba_span_tex
+#define FEATURES SPAN_FUNC_TEXTURE
+#include "s_spantemp.h"
 
-   /* This is the normal place to compute the fragment color/Z
-    * from texturing or shading.
-    */
-   if (shaderOrTexture && !swrast->_DeferredTexture) {
-      shade_texture_span(ctx, span);
-   }
+#define NAME write_rgba_span_tex_z
+#define FEATURES (SPAN_FUNC_TEXTURE | SPAN_FUNC_DEPTH)
+#include "s_spantemp.h"
 
-   /* Do the alpha test */
-   if (ctx->Color.AlphaEnabled) {
-      if (!_swrast_alpha_test(ctx, span)) {
-         /* all fragments failed test */
-         goto end;
-      }
-   }
+#define NAME write_rgba_span_tex_blend
+#define FEATURES (SPAN_FUNC_TEXTURE | SPAN_FUNC_BLEND)
+#include "s_spantemp.h"
 
-   /* Stencil and Z testing */
-   if (ctx->Stencil._Enabled || ctx->Depth.Test) {
-      if (!(span->arrayMask & SPAN_Z))
-         _swrast_span_interpolate_z(ctx, span);
+#define NAME write_rgba_span_tex_z_blend
+#define FEATURES (SPAN_FUNC_TEXTURE | SPAN_FUNC_DEPTH | SPAN_FUNC_BLEND)
+#include "s_spantemp.h"
 
-      if (ctx->Transform.DepthClamp)
-	 _swrast_depth_clamp_span(ctx, span);
+#define NAME write_rgba_span_tex_alpha_z_blend
+#define FEATURES (SPAN_FUNC_TEXTURE | SPAN_FUNC_ALPHA | SPAN_FUNC_DEPTH | \
+                  SPAN_FUNC_BLEND)
+#include "s_spantemp.h"
 
-      if (ctx->Stencil._Enabled) {
-         /* Combined Z/stencil tests */
-         if (!_swrast_stencil_and_ztest_span(ctx, span)) {
-            /* all fragments failed test */
-            goto end;
-         }
-      }
-      else if (fb->Visual.depthBits > 0) {
-         /* Just regular depth testing */
-         ASSERT(ctx->Depth.Test);
-         ASSERT(span->arrayMask & SPAN_Z);
-         if (!_swrast_depth_test_span(ctx, span)) {
-            /* all fragments failed test */
-            goto end;
-         }
-      }
-   }
+#define NAME write_rgba_span_tex_z_fog_blend
+#define FEATURES (SPAN_FUNC_TEXTURE | SPAN_FUNC_DEPTH | SPAN_FUNC_FOG | \
+                  SPAN_FUNC_BLEND)
+#include "s_spantemp.h"
 
-   if (ctx->Query.CurrentOcclusionObject) {
-      /* update count of 'passed' fragments */
-      struct gl_query_object *q = ctx->Query.CurrentOcclusionObject;
-      GLuint i;
-      for (i = 0; i < span->end; i++)
-         q->Result += span->array->mask[i];
-   }
 
-   /* We had to wait until now to check for glColorMask(0,0,0,0) because of
-    * the occlusion test.
-    */
-   if (fb->_NumColorDrawBuffers == 1 && colorMask[0] == 0x0) {
-      /* no colors to write */
-      goto end;
-   }
-
-   /* If we were able to defer fragment color computation to now, there's
-    * a good chance that many fragments will have already been killed by
-    * Z/stencil testing.
-    */
-   if (shaderOrTexture && swrast->_DeferredTexture) {
-      shade_texture_span(ctx, span);
-   }
-
-#if CHAN_BITS == 32
-   if ((span->arrayAttribs & VARYING_BIT_COL0) == 0) {
-      interpolate_active_attribs(ctx, span, VARYING_BIT_COL0);
-   }
-#else
-   if ((span->arrayMask & SPAN_RGBA) == 0) {
-      interpolate_int_colors(ctx, span);
-   }
-#endif
+/**
+ * The specialized span functions, cheapest first.
+ */
+static const struct {
+   GLbitfield features;
+   swrast_span_func func;
+} span_funcs[] = {
+   { 0, write_rgba_span_plain },
+   { SPAN_FUNC_DEPTH, write_rgba_span_z },
+   { SPAN_FUNC_BLEND, write_rgba_span_blend },
+   { SPAN_FUNC_TEXTURE, write_rgba_span_tex },
+   { SPAN_FUNC_TEXTURE | SPAN_FUNC_DEPTH, write_rgba_span_tex_z },
+   { SPAN_FUNC_TEXTURE | SPAN_FUNC_BLEND, write_rgba_span_tex_blend },
+   { SPAN_FUNC_TEXTURE | SPAN_FUNC_DEPTH | SPAN_FUNC_BLEND,
+     write_rgba_span_tex_z_blend },
+   { SPAN_FUNC_TEXTURE | SPAN_FUNC_ALPHA | SPAN_FUNC_DEPTH | SPAN_FUNC_BLEND,
+     write_rgba_span_tex_alpha_z_blend },
+   { SPAN_FUNC_TEXTURE | SPAN_FUNC_DEPTH | SPAN_FUNC_FOG | SPAN_FUNC_BLEND,
+     write_rgba_span_tex_z_fog_blend },
+};
 
-   ASSERT(span->arrayMask & SPAN_RGBA);
 
-   if (span->primitive == GL_BITMAP || !swrast->SpecularVertexAdd) {
-      /* Add primary and specular (diffuse + specular) colors */
-      if (!shader) {
-         if (ctx->Fog.ColorSumEnabled ||
-             (ctx->Light.Enabled &&
-              ctx->Light.Model.ColorControl == GL_SEPARATE_SPECULAR_COLOR)) {
-            add_specular(ctx, span);
-         }
-      }
-   }
+/**
+ * Pick the span function for the current state: the first specialized
+ * one that supports all the enabled per-fragment operations, or the
+ * general one.  Like the triangle functions, this is chosen again after
+ * any relevant state change.
+ */
+void
+_swrast_choose_span_func(struct gl_context *ctx)
+{
+   SWcontext *swrast = SWRAST_CONTEXT(ctx);
+   GLbitfield needed = 0x0;
+   GLuint i;
 
-   /* Fog */
-   if (swrast->_FogEnabled) {
-      _swrast_fog_rgba_span(ctx, span);
-   }
+   if (_swrast_use_fragment_program(ctx) ||
+       ctx->ATIFragmentShader._Enabled ||
+       ctx->Texture._EnabledCoordUnits)
+      needed |= SPAN_FUNC_TEXTURE;
 
-   /* Antialias coverage application */
-   if (span->arrayMask & SPAN_COVERAGE) {
-      apply_aa_coverage(span);
-   }
+   if (ctx->Color.AlphaEnabled)
+      needed |= SPAN_FUNC_ALPHA;
 
-   /* Clamp color/alpha values over the range [0.0, 1.0] before storage */
-   if (ctx->Color.ClampFragmentColor == GL_TRUE &&
-       span->array->ChanType == GL_FLOAT) {
-      clamp_colors(span);
-   }
+   if (ctx->Stencil._Enabled || ctx->Depth.Test)
+      needed |= SPAN_FUNC_DEPTH;
 
-   /*
-    * Write to renderbuffers.
-    * Depending on glDrawBuffer() state and the which color outputs are
-    * written by the fragment shader, we may either replicate one color to
-    * all renderbuffers or write a different color to each renderbuffer.
-    * multiFragOutputs=TRUE for the later case.
-    */
-   {
-      const GLuint numBuffers = fb->_NumColorDrawBuffers;
-      const struct gl_fragment_program *fp = ctx->FragmentProgram._Current;
-      const GLboolean multiFragOutputs = 
-         _swrast_use_fragment_program(ctx)
-         && fp->Base.OutputsWritten >= (1 << FRAG_RESULT_DATA0);
-      GLuint buf;
-
-      for (buf = 0; buf < numBuffers; buf++) {
-         struct gl_renderbuffer *rb = fb->_ColorDrawBuffers[buf];
-
-         /* color[fragOutput] will be written to buffer[buf] */
-
-         if (rb) {
-            /* re-use one of the attribute array buffers for rgbaSave */
-            GLchan (*rgbaSave)[4] = (GLchan (*)[4]) span->array->attribs[0];
-            struct swrast_renderbuffer *srb = swrast_renderbuffer(rb);
-            GLenum colorType = srb->ColorType;
-
-            assert(colorType == GL_UNSIGNED_BYTE ||
-                   colorType == GL_FLOAT);
-
-            /* set span->array->rgba to colors for renderbuffer's datatype */
-            if (span->array->ChanType != colorType) {
-               convert_color_type(span, colorType, 0);
-            }
-            else {
-               if (span->array->ChanType == GL_UNSIGNED_BYTE) {
-                  span->array->rgba = span->array->rgba8;
-               }
-               else {
-                  span->array->rgba = (void *)
-                     span->array->attribs[VARYING_SLOT_COL0];
-               }
-            }
+   if (swrast->_FogEnabled)
+      needed |= SPAN_FUNC_FOG;
 
-            if (!multiFragOutputs && numBuffers > 1) {
-               /* save colors for second, third renderbuffer writes */
-               memcpy(rgbaSave, span->array->rgba,
-                      4 * span->end * sizeof(GLchan));
-            }
+   if (ctx->Color.BlendEnabled)
+      needed |= SPAN_FUNC_BLEND;
 
-            ASSERT(rb->_BaseFormat == GL_RGBA ||
-                   rb->_BaseFormat == GL_RGB ||
-                   rb->_BaseFormat == GL_RED ||
-                   rb->_BaseFormat == GL_RG ||
-		   rb->_BaseFormat == GL_ALPHA);
+   if (ctx->Depth.BoundsTest ||
+       ctx->Polygon.StippleFlag ||
+       ctx->Color.ColorLogicOpEnabled ||
+       (swrast->_RasterMask & MASKING_BIT) ||
+       ctx->Fog.ColorSumEnabled ||
+       (ctx->Light.Enabled &&
+        ctx->Light.Model.ColorControl == GL_SEPARATE_SPECULAR_COLOR))
+      needed |= SPAN_FUNC_OTHER;
 
-            if (ctx->Color.ColorLogicOpEnabled) {
-               _swrast_logicop_rgba_span(ctx, rb, span);
-            }
-            else if ((ctx->Color.BlendEnabled >> buf) & 1) {
-               _swrast_blend_span(ctx, rb, span);
-            }
+   swrast->WriteRgbaSpan = write_rgba_span_general;
 
-            if (colorMask[buf] != 0xffffffff) {
-               _swrast_mask_rgba_span(ctx, rb, span, buf);
-            }
+   for (i = 0; i < Elements(span_funcs); i++) {
+      if ((span_funcs[i].features & needed) == needed) {
+         swrast->WriteRgbaSpan = span_funcs[i].func;
+         break;
+      }
+   }
+}
 
-            if (span->arrayMask & SPAN_XY) {
-               /* array of pixel coords */
-               put_values(ctx, rb,
-                          span->array->ChanType, span->end,
-                          span->array->x, span->array->y,
-                          span->array->rgba, span->array->mask);
-            }
-            else {
-               /* horizontal run of pixels */
-               _swrast_put_row(ctx, rb,
-                               span->array->ChanType,
-                               span->end, span->x, span->y,
-                               span->array->rgba,
-                               span->writeAll ? NULL: span->array->mask);
-            }
 
-            if (!multiFragOutputs && numBuffers > 1) {
-               /* restore original span values */
-               memcpy(span->array->rgba, rgbaSave,
-                      4 * span->end * sizeof(GLchan));
-            }
+/**
+ * Apply all the per-fragment operations to a span, using the span
+ * function chosen for the current state.
+ */
+void
+_swrast_write_rgba_span( struct gl_context *ctx, SWspan *span)
+{
+   const struct swrast_span_bin *bin = SWRAST_CONTEXT(ctx)->SpanBin;
 
-         } /* if rb */
-      } /* for buf */
-   }
+   /* spans recorded for band-parallel rendering go first */
+   if (bin && bin->NumSpans)
+      _swrast_span_bin_flush(ctx);
 
-end:
-   /* restore these values before returning */
-   span->interpMask = origInterpMask;
-   span->arrayMask = origArrayMask;
-   span->arrayAttribs = origArrayAttribs;
-   span->array->ChanType = origChanType;
-   span->array->rgba = origRgba;
+   SWRAST_CONTEXT(ctx)->WriteRgbaSpan(ctx, span);
 }
 
 
@@ -188,6 +188,9 @@ do {						\
 extern void
 _swrast_span_default_attribs(struct gl_context *ctx, SWspan *span);
 
+extern void
+_swrast_choose_span_func(struct gl_context *ctx);
+
 extern void
 _swrast_span_interpolate_z( const struct gl_context *ctx, SWspan *span );
 
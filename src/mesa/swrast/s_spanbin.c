@@ -0,0 +1,331 @@
+/*
+ * Mesa 3-D graphics library
+ *
+ * Copyright (C) 2013  VMware, Inc.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/**
+ * \file swrast/s_spanbin.c
+ * \brief Band-parallel span rendering.
+ *
+ * When built with OpenMP and more than one thread is available, the
+ * spans produced by the general RGBA triangle functions aren't written
+ * right away.  They're recorded and, when rendering finishes (or before
+ * anything else writes to the framebuffer), sorted into bands of
+ * SWRAST_BAND_HEIGHT scanlines which are rendered in parallel, each
+ * thread using its own SpanArrays.  Spans keep their order within a
+ * band and no two bands touch the same pixel, so the result is the same
+ * as writing the spans one at a time.
+ */
+
+#include "main/glheader.h"
+#include "main/imports.h"
+#include "main/macros.h"
+#include "main/mtypes.h"
+
+#include "s_blend.h"
+#include "s_context.h"
+#include "s_spanbin.h"
+#include "s_texcombine.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+
+/**
+ * Whether the current state lets spans be deferred.  Fragment programs,
+ * stencil testing and occlusion queries use scratch state in the
+ * context that the band threads would otherwise share.
+ */
+static inline GLboolean
+can_bin(struct gl_context *ctx)
+{
+   return !_swrast_use_fragment_program(ctx) &&
+          !ctx->ATIFragmentShader._Enabled &&
+          !ctx->Stencil._Enabled &&
+          !ctx->Query.CurrentOcclusionObject;
+}
+
+
+/**
+ * Make room for \p count more elements in a growable array.
+ */
+static GLboolean
+reserve(void **array, GLuint *max, GLuint num, GLuint count, size_t size)
+{
+   if (num + count > *max) {
+      GLuint newMax = MAX2(*max * 2, 256);
+      void *p;
+
+      while (newMax < num + count)
+         newMax *= 2;
+
+      p = realloc(*array, newMax * size);
+      if (!p)
+         return GL_FALSE;
+
+      *array = p;
+      *max = newMax;
+   }
+   return GL_TRUE;
+}
+
+
+void
+_swrast_span_bin_create(struct gl_context *ctx)
+{
+#ifdef _OPENMP
+   SWcontext *swrast = SWRAST_CONTEXT(ctx);
+
+   if (omp_get_max_threads() > 1) {
+      swrast->SpanBin = calloc(1, sizeof(struct swrast_span_bin));
+      if (swrast->SpanBin)
+         swrast->SpanBin->NewTriangle = GL_TRUE;
+   }
+#else
+   (void) ctx;
+#endif
+}
+
+
+void
+_swrast_span_bin_destroy(struct gl_context *ctx)
+{
+   SWcontext *swrast = SWRAST_CONTEXT(ctx);
+   struct swrast_span_bin *bin = swrast->SpanBin;
+
+   if (!bin)
+      return;
+
+   free(bin->Templates);
+   free(bin->Spans);
+   free(bin->Attribs);
+   free(bin->Order);
+   free(bin->BandStart);
+   free(bin);
+
+   swrast->SpanBin = NULL;
+}
+
+
+/**
+ * Called by the triangle functions before their first span, the next
+ * recorded span will save the interpolant steps of the new triangle.
+ */
+void
+_swrast_span_bin_new_triangle(struct gl_context *ctx)
+{
+   struct swrast_span_bin *bin = SWRAST_CONTEXT(ctx)->SpanBin;
+
+   if (bin)
+      bin->NewTriangle = GL_TRUE;
+}
+
+
+/**
+ * Record a span produced by s_tritemp.h, or write it right away if
+ * spans can't be deferred with the current state.
+ */
+void
+_swrast_bin_rgba_span(struct gl_context *ctx, SWspan *span)
+{
+   SWcontext *swrast = SWRAST_CONTEXT(ctx);
+   struct swrast_span_bin *bin = swrast->SpanBin;
+   const struct gl_framebuffer *fb = ctx->DrawBuffer;
+   const GLuint numAttribs = 1 + swrast->_NumActiveAttribs;
+   struct swrast_span_record *rec;
+   GLfloat (*attribs)[4];
+
+   if (!bin || span->arrayMask || span->primitive != GL_POLYGON ||
+       !can_bin(ctx)) {
+      _swrast_write_rgba_span(ctx, span);
+      return;
+   }
+
+   /* clip_span() would reject it anyway */
+   if (span->y < fb->_Ymin || span->y >= fb->_Ymax)
+      return;
+
+   if (bin->NumSpans >= SWRAST_BIN_MAX_SPANS)
+      _swrast_span_bin_flush(ctx);
+
+   if (!reserve((void **) &bin->Templates, &bin->MaxTemplates,
+                bin->NumTemplates, 1, sizeof(SWspan)) ||
+       !reserve((void **) &bin->Attribs, &bin->MaxAttribs,
+                bin->NumAttribs, numAttribs, sizeof(bin->Attribs[0])) ||
+       !reserve((void **) &bin->Spans, &bin->MaxSpans,
+                bin->NumSpans, 1, sizeof(*rec))) {
+      /* out of memory, render what we have and this span directly */
+      _swrast_span_bin_flush(ctx);
+      _swrast_write_rgba_span(ctx, span);
+      return;
+   }
+
+   if (bin->NewTriangle) {
+      bin->Templates[bin->NumTemplates++] = *span;
+      bin->NewTriangle = GL_FALSE;
+   }
+
+   rec = &bin->Spans[bin->NumSpans++];
+   rec->tmpl = bin->NumTemplates - 1;
+   rec->attribs = bin->NumAttribs;
+   rec->x = span->x;
+   rec->y = span->y;
+   rec->end = span->end;
+   rec->z = span->z;
+   rec->red = span->red;
+   rec->green = span->green;
+   rec->blue = span->blue;
+   rec->alpha = span->alpha;
+   rec->intTex[0] = span->intTex[0];
+   rec->intTex[1] = span->intTex[1];
+
+   attribs = bin->Attribs + bin->NumAttribs;
+   bin->NumAttribs += numAttribs;
+
+   COPY_4V(attribs[0], span->attrStart[VARYING_SLOT_POS]);
+   ATTRIB_LOOP_BEGIN
+      COPY_4V(attribs[1 + a], span->attrStart[attr]);
+   ATTRIB_LOOP_END
+}
+
+
+/**
+ * Write the recorded spans order[first..last-1], or first..last-1 if
+ * there's no order array.
+ */
+static void
+render_spans(struct gl_context *ctx, const struct swrast_span_bin *bin,
+             const GLuint *order, GLuint first, GLuint last)
+{
+   SWcontext *swrast = SWRAST_CONTEXT(ctx);
+   GLuint tmpl = ~0u;
+   GLuint i;
+   SWspan span;
+
+   for (i = first; i < last; i++) {
+      const struct swrast_span_record *rec =
+         &bin->Spans[order ? order[i] : i];
+      GLfloat (*attribs)[4] = bin->Attribs + rec->attribs;
+
+      if (rec->tmpl != tmpl) {
+         tmpl = rec->tmpl;
+         span = bin->Templates[tmpl];
+#ifdef _OPENMP
+         /* each thread needs to use a different (global) SpanArrays variable */
+         span.array = swrast->SpanArrays + omp_get_thread_num();
+#endif
+      }
+
+      span.x = rec->x;
+      span.y = rec->y;
+      span.end = rec->end;
+      span.z = rec->z;
+      span.red = rec->red;
+      span.green = rec->green;
+      span.blue = rec->blue;
+      span.alpha = rec->alpha;
+      span.intTex[0] = rec->intTex[0];
+      span.intTex[1] = rec->intTex[1];
+
+      COPY_4V(span.attrStart[VARYING_SLOT_POS], attribs[0]);
+      ATTRIB_LOOP_BEGIN
+         COPY_4V(span.attrStart[attr], attribs[1 + a]);
+      ATTRIB_LOOP_END
+
+      _swrast_write_rgba_span(ctx, &span);
+   }
+}
+
+
+/**
+ * Render all recorded spans.  Must be called while the renderbuffers
+ * are still mapped.
+ */
+void
+_swrast_span_bin_flush(struct gl_context *ctx)
+{
+   SWcontext *swrast = SWRAST_CONTEXT(ctx);
+   struct swrast_span_bin *bin = swrast->SpanBin;
+   const struct gl_framebuffer *fb = ctx->DrawBuffer;
+   const GLuint numSpans = bin ? bin->NumSpans : 0;
+   GLuint numBands, i;
+   GLboolean parallel = GL_TRUE;
+   GLint b;
+
+   (void) parallel;
+
+   if (!numSpans)
+      return;
+
+   /* _swrast_write_rgba_span() flushes a non-empty bin first */
+   bin->NumSpans = 0;
+
+   numBands = (fb->_Ymax + SWRAST_BAND_HEIGHT - 1) / SWRAST_BAND_HEIGHT;
+
+   if (!reserve((void **) &bin->BandStart, &bin->MaxBands,
+                0, numBands + 1, sizeof(GLuint)) ||
+       !reserve((void **) &bin->Order, &bin->MaxOrder,
+                0, numSpans, sizeof(GLuint))) {
+      render_spans(ctx, bin, NULL, 0, numSpans);
+      goto done;
+   }
+
+   /* Counting sort by band, which keeps the spans of a band in order.
+    * Afterwards BandStart[b] is the end of band b.
+    */
+   memset(bin->BandStart, 0, (numBands + 1) * sizeof(GLuint));
+   for (i = 0; i < numSpans; i++)
+      bin->BandStart[bin->Spans[i].y / SWRAST_BAND_HEIGHT + 1]++;
+   for (b = 1; b <= (GLint) numBands; b++)
+      bin->BandStart[b] += bin->BandStart[b - 1];
+   for (i = 0; i < numSpans; i++)
+      bin->Order[bin->BandStart[bin->Spans[i].y / SWRAST_BAND_HEIGHT]++] = i;
+
+   /* Set up the state that is otherwise created by the first span that
+    * needs it, before the threads could race for it.
+    */
+   if (ctx->Texture._EnabledCoordUnits && !_swrast_alloc_texel_buffer(ctx))
+      parallel = GL_FALSE;
+
+   _swrast_choose_span_func(ctx);
+
+   if (ctx->Color.BlendEnabled && fb->_ColorDrawBuffers[0]) {
+      struct swrast_renderbuffer *srb =
+         swrast_renderbuffer(fb->_ColorDrawBuffers[0]);
+      _swrast_choose_blend_func(ctx, srb->ColorType);
+   }
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic) if (parallel)
+#endif
+   for (b = 0; b < (GLint) numBands; b++) {
+      render_spans(ctx, bin, bin->Order,
+                   b ? bin->BandStart[b - 1] : 0, bin->BandStart[b]);
+   }
+
+done:
+   bin->NumTemplates = 0;
+   bin->NumAttribs = 0;
+   bin->NewTriangle = GL_TRUE;
+}
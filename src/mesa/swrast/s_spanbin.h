@@ -0,0 +1,99 @@
+/*
+ * Mesa 3-D graphics library
+ *
+ * Copyright (C) 2013  VMware, Inc.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#ifndef S_SPANBIN_H
+#define S_SPANBIN_H
+
+
+#include "s_span.h"
+
+
+struct gl_context;
+
+
+/** Height, in scanlines, of the bands rendered by one thread at a time */
+#define SWRAST_BAND_HEIGHT 16
+
+/** Recorded spans are rendered once this many are pending */
+#define SWRAST_BIN_MAX_SPANS (64 * 1024)
+
+
+/**
+ * One recorded span.  Only the values that the triangle rasterizer
+ * changes from one scanline to the next are kept here, the rest are in
+ * the triangle's template span.
+ */
+struct swrast_span_record
+{
+   GLuint tmpl;      /**< index into swrast_span_bin::Templates */
+   GLuint attribs;   /**< index of the attrStart values in ::Attribs */
+   GLint x, y;
+   GLuint end;
+   GLfixed z, red, green, blue, alpha, intTex[2];
+};
+
+
+/**
+ * Spans waiting to be rendered by band, see s_spanbin.c.
+ */
+struct swrast_span_bin
+{
+   /** Set when the next recorded span starts a new triangle */
+   GLboolean NewTriangle;
+
+   SWspan *Templates;
+   GLuint NumTemplates, MaxTemplates;
+
+   struct swrast_span_record *Spans;
+   GLuint NumSpans, MaxSpans;
+
+   /** attrStart[VARYING_SLOT_POS] then one entry per active attrib */
+   GLfloat (*Attribs)[4];
+   GLuint NumAttribs, MaxAttribs;
+
+   /** Span indices sorted by band, and where each band starts */
+   GLuint *Order;
+   GLuint *BandStart;
+   GLuint MaxOrder, MaxBands;
+};
+
+
+extern void
+_swrast_span_bin_create(struct gl_context *ctx);
+
+extern void
+_swrast_span_bin_destroy(struct gl_context *ctx);
+
+extern void
+_swrast_span_bin_new_triangle(struct gl_context *ctx);
+
+extern void
+_swrast_bin_rgba_span(struct gl_context *ctx, SWspan *span);
+
+extern void
+_swrast_span_bin_flush(struct gl_context *ctx);
+
+
+#endif /* S_SPANBIN_H */
@@ -591,14 +591,13 @@ swizzle_texels(GLuint swizzle, GLuint count, float4_array texels)
 
 
 /**
- * Apply texture mapping to a span of fragments.
+ * Allocate swrast->TexelBuffer if that hasn't been done yet.
+ * \return GL_FALSE if out of memory.
  */
-void
-_swrast_texture_span( struct gl_context *ctx, SWspan *span )
+GLboolean
+_swrast_alloc_texel_buffer(struct gl_context *ctx)
 {
    SWcontext *swrast = SWRAST_CONTEXT(ctx);
-   float4_array primary_rgba;
-   GLuint unit;
 
    if (!swrast->TexelBuffer) {
 #ifdef _OPENMP
@@ -616,10 +615,27 @@ _swrast_texture_span( struct gl_context *ctx, SWspan *span )
 			    SWRAST_MAX_WIDTH * 4 * sizeof(GLfloat));
       if (!swrast->TexelBuffer) {
 	 _mesa_error(ctx, GL_OUT_OF_MEMORY, "texture_combine");
-	 return;
+	 return GL_FALSE;
       }
    }
 
+   return GL_TRUE;
+}
+
+
+/**
+ * Apply texture mapping to a span of fragments.
+ */
+void
+_swrast_texture_span( struct gl_context *ctx, SWspan *span )
+{
+   SWcontext *swrast = SWRAST_CONTEXT(ctx);
+   float4_array primary_rgba;
+   GLuint unit;
+
+   if (!_swrast_alloc_texel_buffer(ctx))
+      return;
+
    primary_rgba = malloc(span->end * 4 * sizeof(GLfloat));
 
    if (!primary_rgba) {
@@ -44,6 +44,7 @@
 #include "s_context.h"
 #include "s_feedback.h"
 #include "s_span.h"
+#include "s_spanbin.h"
 #include "s_triangle.h"
 
 
@@ -88,8 +89,9 @@ _swrast_culltriangle( struct gl_context *ctx,
    span.redStep = 0;				\
    span.greenStep = 0;				\
    span.blueStep = 0;				\
-   span.alphaStep = 0;
-#define RENDER_SPAN( span )  _swrast_write_rgba_span(ctx, &span);
+   span.alphaStep = 0;				\
+   _swrast_span_bin_new_triangle(ctx);
+#define RENDER_SPAN( span )  _swrast_bin_rgba_span(ctx, &span);
 #include "s_tritemp.h"
 
 
@@ -106,8 +108,9 @@ _swrast_culltriangle( struct gl_context *ctx,
       /* texturing must be off */		\
       ASSERT(ctx->Texture._EnabledCoordUnits == 0);	\
       ASSERT(ctx->Light.ShadeModel==GL_SMOOTH);	\
-   }
-#define RENDER_SPAN( span )  _swrast_write_rgba_span(ctx, &span);
+   }						\
+   _swrast_span_bin_new_triangle(ctx);
+#define RENDER_SPAN( span )  _swrast_bin_rgba_span(ctx, &span);
 #include "s_tritemp.h"
 
 
@@ -870,7 +873,8 @@ fast_persp_span(struct gl_context *ctx, SWspan *span,
 #define INTERP_RGB 1
 #define INTERP_ALPHA 1
 #define INTERP_ATTRIBS 1
-#define RENDER_SPAN( span )   _swrast_write_rgba_span(ctx, &span);
+#define SETUP_CODE   _swrast_span_bin_new_triangle(ctx);
+#define RENDER_SPAN( span )   _swrast_bin_rgba_span(ctx, &span);
 #include "s_tritemp.h"
 
 
@@ -46,13 +46,17 @@ struct _mesa_prim {
    GLuint end:1;
    GLuint weak:1;
    GLuint no_current_update:1;
-   GLuint pad:19;
+   GLuint is_indirect:1;
+   GLuint pad:18;
 
    GLuint start;
    GLuint count;
    GLint basevertex;
    GLuint num_instances;
    GLuint base_instance;
+
+   /** Offset of the draw parameters in the indirect buffer, for is_indirect */
+   GLsizeiptr indirect_offset;
 };
 
 /* Would like to call this a "vbo_index_buffer", but this would be
@@ -80,7 +84,8 @@ typedef void (*vbo_draw_func)( struct gl_context *ctx,
 			       GLboolean index_bounds_valid,
 			       GLuint min_index,
 			       GLuint max_index,
-			       struct gl_transform_feedback_object *tfb_vertcount );
+			       struct gl_transform_feedback_object *tfb_vertcount,
+			       struct gl_buffer_object *indirect );
 
 
 
@@ -42,13 +42,13 @@ USE OR OTHER DEALINGS IN THE SOFTWARE.
 /**
  * Max number of primitives (number of glBegin/End pairs) per VBO.
  */
-#define VBO_MAX_PRIM 64
+#define VBO_MAX_PRIM 256
 
 
 /**
  * Size of the VBO to use for glBegin/glVertex/glEnd-style rendering.
  */
-#define VBO_VERT_BUFFER_SIZE (1024*64)	/* bytes */
+#define VBO_VERT_BUFFER_SIZE (1024*256)	/* bytes */
 
 
 /** Current vertex program mode */
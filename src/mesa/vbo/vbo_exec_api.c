@@ -358,6 +358,122 @@ vbo_exec_wrap_upgrade_vertex(struct vbo_exec_context *exec,
 }
 
 
+/**
+ * Grow an attribute without flushing, by re-laying out the vertices
+ * stored so far to the new vertex format in place.
+ *
+ * This is only done when the vertices are kept in user memory.  A mapped
+ * buffer object may be write-combined or uncached, and reading it back
+ * would cost more than the flush does.  Returns GL_FALSE if the caller
+ * has to take the flushing path instead.
+ */
+static GLboolean
+vbo_exec_widen_vertex(struct vbo_exec_context *exec,
+                      GLuint attr, GLuint newSize)
+{
+   struct gl_context *ctx = exec->ctx;
+   struct vbo_context *vbo = vbo_context(ctx);
+   const GLint count = exec->vtx.vert_count;
+   const GLuint oldSize = exec->vtx.attrsz[attr];
+   const GLuint old_vtx_size = exec->vtx.vertex_size;
+   const GLuint new_vtx_size = old_vtx_size + newSize - oldSize;
+   GLint old_offset[VBO_ATTRIB_MAX], new_offset[VBO_ATTRIB_MAX];
+   GLfloat tmp[VBO_ATTRIB_MAX * 4];
+   GLint i, j;
+
+   if (_mesa_is_bufferobj(exec->vtx.bufferobj) || count == 0)
+      return GL_FALSE;
+
+   /* Attributes set outside begin/end after a run of vertices are left
+    * to the heuristic in vbo_exec_wrap_upgrade_vertex(), which keeps them
+    * out of the vertex altogether.
+    */
+   if (!_mesa_inside_begin_end(ctx) && !oldSize && count > 8)
+      return GL_FALSE;
+
+   if ((count + 1) * new_vtx_size * sizeof(GLfloat) >
+       VBO_VERT_BUFFER_SIZE - exec->vtx.buffer_used)
+      return GL_FALSE;
+
+   for (i = 0; i < VBO_ATTRIB_MAX; i++) {
+      if (exec->vtx.attrsz[i])
+         old_offset[i] = exec->vtx.attrptr[i] - exec->vtx.vertex;
+   }
+
+   if (oldSize) {
+      /* Get the old value into the current attribute so that the vertex
+       * can be repopulated below.
+       */
+      vbo_exec_copy_to_current( exec );
+   }
+
+   exec->vtx.attrsz[attr] = newSize;
+   exec->vtx.vertex_size = new_vtx_size;
+   exec->vtx.max_vert = ((VBO_VERT_BUFFER_SIZE - exec->vtx.buffer_used) /
+                         (new_vtx_size * sizeof(GLfloat)));
+
+   if (oldSize) {
+      GLfloat *ptr = exec->vtx.vertex;
+
+      for (i = 0 ; i < VBO_ATTRIB_MAX ; i++) {
+	 if (exec->vtx.attrsz[i]) {
+	    exec->vtx.attrptr[i] = ptr;
+	    ptr += exec->vtx.attrsz[i];
+	 }
+	 else
+	    exec->vtx.attrptr[i] = NULL; /* will not be dereferenced */
+      }
+
+      vbo_exec_copy_from_current( exec );
+   }
+   else {
+      exec->vtx.attrptr[attr] = exec->vtx.vertex + new_vtx_size - newSize;
+   }
+
+   for (i = 0; i < VBO_ATTRIB_MAX; i++) {
+      if (exec->vtx.attrsz[i])
+         new_offset[i] = exec->vtx.attrptr[i] - exec->vtx.vertex;
+   }
+
+   /* Walk the vertices backwards: each one only grows, so the new copy of
+    * a vertex never overlaps the ones that still have to be moved.
+    */
+   for (i = count - 1; i >= 0; i--) {
+      GLfloat *dest = exec->vtx.buffer_map + i * new_vtx_size;
+
+      memcpy(tmp, exec->vtx.buffer_map + i * old_vtx_size,
+             old_vtx_size * sizeof(GLfloat));
+
+      for (j = 0; j < VBO_ATTRIB_MAX; j++) {
+         const GLuint sz = exec->vtx.attrsz[j];
+
+         if (!sz)
+            continue;
+
+         if (j == attr) {
+            if (oldSize) {
+               GLfloat val[4];
+               COPY_CLEAN_4V_TYPE_AS_FLOAT(val, oldSize,
+                                           tmp + old_offset[j],
+                                           exec->vtx.attrtype[j]);
+               COPY_SZ_4V(dest + new_offset[j], newSize, val);
+            }
+            else {
+               const GLfloat *current = (GLfloat *) vbo->currval[j].Ptr;
+               COPY_SZ_4V(dest + new_offset[j], newSize, current);
+            }
+         }
+         else {
+            COPY_SZ_4V(dest + new_offset[j], sz, tmp + old_offset[j]);
+         }
+      }
+   }
+
+   exec->vtx.buffer_ptr = exec->vtx.buffer_map + count * new_vtx_size;
+   return GL_TRUE;
+}
+
+
 /**
  * This is when a vertex attribute transitions to a different size.
  * For example, we saw a bunch of glTexCoord2f() calls and now we got a
@@ -369,10 +485,11 @@ vbo_exec_fixup_vertex(struct gl_context *ctx, GLuint attr, GLuint newSize)
    struct vbo_exec_context *exec = &vbo_context(ctx)->exec;
 
    if (newSize > exec->vtx.attrsz[attr]) {
-      /* New size is larger.  Need to flush existing vertices and get
-       * an enlarged vertex format.
+      /* New size is larger.  Widen the stored vertices if possible,
+       * otherwise flush them and get an enlarged vertex format.
        */
-      vbo_exec_wrap_upgrade_vertex( exec, attr, newSize );
+      if (!vbo_exec_widen_vertex( exec, attr, newSize ))
+         vbo_exec_wrap_upgrade_vertex( exec, attr, newSize );
    }
    else if (newSize < exec->vtx.active_sz[attr]) {
       GLuint i;
@@ -52,7 +52,7 @@ check_buffers_are_unmapped(const struct gl_client_array **inputs)
    for (i = 0; i < VERT_ATTRIB_MAX; i++) {
       if (inputs[i]) {
          struct gl_buffer_object *obj = inputs[i]->BufferObj;
-         assert(!_mesa_bufferobj_mapped(obj));
+         assert(!_mesa_check_disallowed_mapping(obj));
          (void) obj;
       }
    }
@@ -542,7 +542,7 @@ vbo_handle_primitive_restart(struct gl_context *ctx,
    } else {
       /* Call driver directly for draw_prims */
       vbo->draw_prims(ctx, prim, nr_prims, ib,
-                      index_bounds_valid, min_index, max_index, NULL);
+                      index_bounds_valid, min_index, max_index, NULL, NULL);
    }
 }
 
@@ -607,7 +607,7 @@ vbo_draw_arrays(struct gl_context *ctx, GLenum mode, GLint start,
          /* draw one or two prims */
          check_buffers_are_unmapped(exec->array.inputs);
          vbo->draw_prims(ctx, prim, primCount, NULL,
-                         GL_TRUE, start, start + count - 1, NULL);
+                         GL_TRUE, start, start + count - 1, NULL, NULL);
       }
    }
    else {
@@ -618,7 +618,7 @@ vbo_draw_arrays(struct gl_context *ctx, GLenum mode, GLint start,
       check_buffers_are_unmapped(exec->array.inputs);
       vbo->draw_prims(ctx, prim, 1, NULL,
                       GL_TRUE, start, start + count - 1,
-                      NULL);
+                      NULL, NULL);
    }
 
    if (MESA_DEBUG_FLAGS & DEBUG_ALWAYS_FLUSH) {
@@ -1285,7 +1285,7 @@ vbo_draw_transform_feedback(struct gl_context *ctx, GLenum mode,
 
    check_buffers_are_unmapped(exec->array.inputs);
    vbo->draw_prims(ctx, prim, 1, NULL,
-                   GL_TRUE, 0, 0, obj);
+                   GL_TRUE, 0, 0, obj, NULL);
 
    if (MESA_DEBUG_FLAGS & DEBUG_ALWAYS_FLUSH) {
       _mesa_flush(ctx);
@@ -1359,6 +1359,170 @@ vbo_exec_DrawTransformFeedbackStreamInstanced(GLenum mode, GLuint name,
    vbo_draw_transform_feedback(ctx, mode, obj, stream, primcount);
 }
 
+/**
+ * Hand a batch of draws whose parameters live in the bound
+ * GL_DRAW_INDIRECT_BUFFER to the driver in a single draw_prims() call.
+ * \param offset  byte offset of the first draw command
+ * \param stride  byte distance between consecutive draw commands
+ */
+static void
+vbo_validated_drawindirect(struct gl_context *ctx, GLenum mode,
+                           const struct _mesa_index_buffer *ib,
+                           GLintptr offset, GLsizei primcount,
+                           GLsizei stride, const char *name)
+{
+   struct vbo_context *vbo = vbo_context(ctx);
+   struct vbo_exec_context *exec = &vbo->exec;
+   struct _mesa_prim single_prim;
+   struct _mesa_prim *prim;
+   GLsizei i;
+
+   if (primcount == 1) {
+      prim = &single_prim;
+   }
+   else {
+      prim = calloc(1, primcount * sizeof(*prim));
+      if (prim == NULL) {
+         _mesa_error(ctx, GL_OUT_OF_MEMORY, "%s", name);
+         return;
+      }
+   }
+
+   vbo_bind_arrays(ctx);
+
+   memset(prim, 0, primcount * sizeof(*prim));
+   for (i = 0; i < primcount; i++) {
+      prim[i].begin = (i == 0);
+      prim[i].end = (i == primcount - 1);
+      prim[i].mode = mode;
+      prim[i].indexed = ib != NULL;
+      prim[i].is_indirect = 1;
+      prim[i].indirect_offset = offset + i * stride;
+   }
+
+   check_buffers_are_unmapped(exec->array.inputs);
+   vbo->draw_prims(ctx, prim, primcount, ib,
+                   GL_TRUE, 0, ~0, NULL, ctx->DrawIndirectBuffer);
+
+   if (prim != &single_prim)
+      free(prim);
+
+   if (MESA_DEBUG_FLAGS & DEBUG_ALWAYS_FLUSH) {
+      _mesa_flush(ctx);
+   }
+}
+
+static void
+vbo_validated_drawelementsindirect(struct gl_context *ctx, GLenum mode,
+                                   GLenum type, GLintptr offset,
+                                   GLsizei primcount, GLsizei stride,
+                                   const char *name)
+{
+   struct _mesa_index_buffer ib;
+
+   /* The count and first index come from the indirect buffer. */
+   ib.count = 0;
+   ib.type = type;
+   ib.obj = ctx->Array.ArrayObj->ElementArrayBufferObj;
+   ib.ptr = NULL;
+
+   vbo_validated_drawindirect(ctx, mode, &ib, offset, primcount, stride,
+                              name);
+}
+
+/**
+ * Like DrawArrays, but take the parameters from the buffer bound to
+ * GL_DRAW_INDIRECT_BUFFER.
+ * Part of GL_ARB_draw_indirect.
+ */
+static void GLAPIENTRY
+vbo_exec_DrawArraysIndirect(GLenum mode, const GLvoid *indirect)
+{
+   GET_CURRENT_CONTEXT(ctx);
+
+   if (MESA_VERBOSE & VERBOSE_DRAW)
+      _mesa_debug(ctx, "glDrawArraysIndirect(%s, %p)\n",
+                  _mesa_lookup_enum_by_nr(mode), indirect);
+
+   if (!_mesa_validate_DrawArraysIndirect(ctx, mode, indirect))
+      return;
+
+   vbo_validated_drawindirect(ctx, mode, NULL, (GLintptr) indirect, 1, 0,
+                              "glDrawArraysIndirect");
+}
+
+static void GLAPIENTRY
+vbo_exec_DrawElementsIndirect(GLenum mode, GLenum type,
+                              const GLvoid *indirect)
+{
+   GET_CURRENT_CONTEXT(ctx);
+
+   if (MESA_VERBOSE & VERBOSE_DRAW)
+      _mesa_debug(ctx, "glDrawElementsIndirect(%s, %s, %p)\n",
+                  _mesa_lookup_enum_by_nr(mode),
+                  _mesa_lookup_enum_by_nr(type), indirect);
+
+   if (!_mesa_validate_DrawElementsIndirect(ctx, mode, type, indirect))
+      return;
+
+   vbo_validated_drawelementsindirect(ctx, mode, type, (GLintptr) indirect,
+                                      1, 0, "glDrawElementsIndirect");
+}
+
+/**
+ * Part of GL_ARB_multi_draw_indirect.  All the draws go to the driver as
+ * one batch, so state is only validated once.
+ */
+static void GLAPIENTRY
+vbo_exec_MultiDrawArraysIndirect(GLenum mode, const GLvoid *indirect,
+                                 GLsizei primcount, GLsizei stride)
+{
+   GET_CURRENT_CONTEXT(ctx);
+
+   if (MESA_VERBOSE & VERBOSE_DRAW)
+      _mesa_debug(ctx, "glMultiDrawArraysIndirect(%s, %p, %i, %i)\n",
+                  _mesa_lookup_enum_by_nr(mode), indirect,
+                  primcount, stride);
+
+   /* A stride of zero means the commands are tightly packed. */
+   if (stride == 0)
+      stride = 4 * sizeof(GLuint);
+
+   if (!_mesa_validate_MultiDrawArraysIndirect(ctx, mode, indirect,
+                                               primcount, stride))
+      return;
+
+   vbo_validated_drawindirect(ctx, mode, NULL, (GLintptr) indirect,
+                              primcount, stride,
+                              "glMultiDrawArraysIndirect");
+}
+
+static void GLAPIENTRY
+vbo_exec_MultiDrawElementsIndirect(GLenum mode, GLenum type,
+                                   const GLvoid *indirect,
+                                   GLsizei primcount, GLsizei stride)
+{
+   GET_CURRENT_CONTEXT(ctx);
+
+   if (MESA_VERBOSE & VERBOSE_DRAW)
+      _mesa_debug(ctx, "glMultiDrawElementsIndirect(%s, %s, %p, %i, %i)\n",
+                  _mesa_lookup_enum_by_nr(mode),
+                  _mesa_lookup_enum_by_nr(type), indirect,
+                  primcount, stride);
+
+   /* A stride of zero means the commands are tightly packed. */
+   if (stride == 0)
+      stride = 5 * sizeof(GLuint);
+
+   if (!_mesa_validate_MultiDrawElementsIndirect(ctx, mode, type, indirect,
+                                                 primcount, stride))
+      return;
+
+   vbo_validated_drawelementsindirect(ctx, mode, type, (GLintptr) indirect,
+                                      primcount, stride,
+                                      "glMultiDrawElementsIndirect");
+}
+
 /**
  * Plug in the immediate-mode vertex array drawing commands into the
  * givven vbo_exec_context object.
@@ -1386,6 +1550,10 @@ vbo_exec_array_init( struct vbo_exec_context *exec )
          vbo_exec_DrawTransformFeedbackInstanced;
    exec->vtxfmt.DrawTransformFeedbackStreamInstanced =
          vbo_exec_DrawTransformFeedbackStreamInstanced;
+   exec->vtxfmt.DrawArraysIndirect = vbo_exec_DrawArraysIndirect;
+   exec->vtxfmt.DrawElementsIndirect = vbo_exec_DrawElementsIndirect;
+   exec->vtxfmt.MultiDrawArraysIndirect = vbo_exec_MultiDrawArraysIndirect;
+   exec->vtxfmt.MultiDrawElementsIndirect = vbo_exec_MultiDrawElementsIndirect;
 }
 
 
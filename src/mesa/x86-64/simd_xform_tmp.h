@@ -0,0 +1,540 @@
+/*
+ * Mesa 3-D graphics library
+ *
+ * Copyright (C) 2013  VMware, Inc.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/*
+ * Template for the vertex transform, normal transform and cliptest
+ * functions of x86-64.c.
+ *
+ * Vertices are processed VLANES at a time: they are loaded, transposed
+ * so that one vector holds the x (y, z, w) components of all of them,
+ * computed on and transposed back.  Only the terms that the matrix type
+ * doesn't force to zero or one are evaluated, in the same order as in
+ * m_xform_tmp.h.
+ *
+ * The including file must define:
+ *   TAG(x)      - name mangling
+ *   TARGET      - function attributes needed for the instruction set
+ *   VEC, VLANES - vector type and number of floats it holds
+ *   VLOADV(p, s), VSTOREV(p, s, v) - load/store the vertex at p, and the
+ *                 one at p + 4 * s bytes if VLANES == 8
+ *   VLOADN(p)   - load VLANES consecutive floats
+ *   VSTORE_MASK(p, v) - store the low byte of each lane of v to p[]
+ *   VSET1, VSETI, VZERO, VADD, VSUB, VMUL, VDIV, VSQRT, VAND, VANDNOT,
+ *   VOR, VXOR, VCMPLT, VCMPGT, VUNPACKLO, VUNPACKHI, VSHUF
+ */
+
+
+#define TRANSPOSE(r0, r1, r2, r3)                    \
+do {                                                 \
+   const VEC t0 = VUNPACKLO(r0, r1);                 \
+   const VEC t1 = VUNPACKLO(r2, r3);                 \
+   const VEC t2 = VUNPACKHI(r0, r1);                 \
+   const VEC t3 = VUNPACKHI(r2, r3);                 \
+   r0 = VSHUF(t0, t1, 0x44);                         \
+   r1 = VSHUF(t0, t1, 0xee);                         \
+   r2 = VSHUF(t2, t3, 0x44);                         \
+   r3 = VSHUF(t2, t3, 0xee);                         \
+} while (0)
+
+
+/**
+ * Load n <= VLANES vertices of the given size into v[0..3], setting the
+ * missing components to (0, 0, 0, 1).  Unless \p direct is set, the
+ * vertices are copied first so that nothing past the last one is read.
+ */
+static SIMD_INLINE TARGET void
+TAG(load_vertices)(const GLfloat *from, GLuint stride, GLuint size,
+                   GLuint n, GLboolean direct, VEC v[4])
+{
+   GLfloat tmp[VLANES][4];
+   GLuint j, k;
+
+   if (!direct) {
+      for (j = 0; j < VLANES; j++) {
+         /* pad by repeating the last vertex */
+         const GLfloat *f = (const GLfloat *)
+            ((const GLubyte *) from + MIN2(j, n - 1) * stride);
+         for (k = 0; k < 4; k++)
+            tmp[j][k] = k < size ? f[k] : 0.0F;
+      }
+      from = tmp[0];
+      stride = sizeof(tmp[0]);
+   }
+
+   v[0] = VLOADV(from, stride);
+   v[1] = VLOADV((const GLfloat *) ((const GLubyte *) from + stride), stride);
+   v[2] = VLOADV((const GLfloat *) ((const GLubyte *) from + 2 * stride), stride);
+   v[3] = VLOADV((const GLfloat *) ((const GLubyte *) from + 3 * stride), stride);
+   TRANSPOSE(v[0], v[1], v[2], v[3]);
+
+   if (size < 4)
+      v[3] = VSET1(1.0F);
+   if (size < 3)
+      v[2] = VZERO();
+   if (size < 2)
+      v[1] = VZERO();
+}
+
+
+/**
+ * Store n <= VLANES vertices from v[0..3] to the packed array \p to.
+ */
+static SIMD_INLINE TARGET void
+TAG(store_vertices)(GLfloat (*to)[4], GLuint n, VEC v0, VEC v1, VEC v2, VEC v3)
+{
+   GLfloat tmp[VLANES][4];
+   GLfloat (*dst)[4] = n == VLANES ? to : tmp;
+
+   TRANSPOSE(v0, v1, v2, v3);
+   VSTOREV(dst[0], sizeof(dst[0]), v0);
+   VSTOREV(dst[1], sizeof(dst[0]), v1);
+   VSTOREV(dst[2], sizeof(dst[0]), v2);
+   VSTOREV(dst[3], sizeof(dst[0]), v3);
+
+   if (dst == tmp)
+      memcpy(to, tmp, n * sizeof(tmp[0]));
+}
+
+
+/**
+ * Add term k of row r of the product of a matrix of the given type with
+ * the vertex components in[].  Components past size are (0, 0, 0, 1).
+ */
+static SIMD_INLINE TARGET VEC
+TAG(add_term)(VEC sum, GLboolean *empty, const VEC col[16], const VEC in[4],
+              GLuint size, int type, int r, int k)
+{
+   const int e = simd_xform_pattern[type][r * 4 + k];
+   VEC term;
+
+   if (e == XF_NIL || (k < 3 && k >= (int) size))
+      return sum;
+
+   if (k >= (int) size)
+      term = e == XF_VAR ? col[k * 4 + r] : VSET1(e == XF_ONE ? 1.0F : -1.0F);
+   else if (e == XF_VAR)
+      term = VMUL(col[k * 4 + r], in[k]);
+   else if (e == XF_ONE)
+      term = in[k];
+   else
+      term = VXOR(in[k], VSET1(-0.0F));
+
+   if (*empty) {
+      *empty = GL_FALSE;
+      return term;
+   }
+   return VADD(sum, term);
+}
+
+
+static SIMD_INLINE TARGET VEC
+TAG(transform_row)(const VEC col[16], const VEC in[4], GLuint size,
+                   int type, int r)
+{
+   GLboolean empty = GL_TRUE;
+   VEC sum = VZERO();
+
+   sum = TAG(add_term)(sum, &empty, col, in, size, type, r, 0);
+   sum = TAG(add_term)(sum, &empty, col, in, size, type, r, 1);
+   sum = TAG(add_term)(sum, &empty, col, in, size, type, r, 2);
+   sum = TAG(add_term)(sum, &empty, col, in, size, type, r, 3);
+   return sum;
+}
+
+
+/**
+ * Transform a vector of points by a matrix of the given type.  All four
+ * components of the result are written; those beyond the result size
+ * come out as the (0, 0, 0, 1) that the rest of the pipe expects there.
+ */
+static SIMD_INLINE TARGET void
+TAG(transform_points)(GLvector4f *to_vec, const GLfloat m[16],
+                      const GLvector4f *from_vec, GLuint size, int type)
+{
+   const GLuint stride = from_vec->stride;
+   const GLfloat *from = from_vec->start;
+   GLfloat (*to)[4] = (GLfloat (*)[4])to_vec->start;
+   const GLuint count = from_vec->count;
+   const GLuint direct = simd_direct_count(from_vec, size);
+   GLuint outSize = simd_xform_size[size][type];
+   VEC col[16];
+   GLuint i, k;
+
+   for (k = 0; k < 16; k++)
+      col[k] = VSET1(m[k]);
+
+   for (i = 0; i < count; i += VLANES) {
+      const GLuint n = MIN2(VLANES, count - i);
+      VEC in[4];
+
+      TAG(load_vertices)(from, stride, size, n, i + VLANES <= direct, in);
+      TAG(store_vertices)(to + i, n,
+                          TAG(transform_row)(col, in, size, type, 0),
+                          TAG(transform_row)(col, in, size, type, 1),
+                          TAG(transform_row)(col, in, size, type, 2),
+                          TAG(transform_row)(col, in, size, type, 3));
+
+      from = (const GLfloat *) ((const GLubyte *) from + VLANES * stride);
+   }
+
+   /* see transform_points2_3d_no_rot() */
+   if (size == 2 && type == MATRIX_3D_NO_ROT && m[14] != 0.0F)
+      outSize = 3;
+
+   to_vec->size = outSize;
+   to_vec->flags |= simd_size_bits[outSize];
+   to_vec->count = from_vec->count;
+}
+
+
+#define XFORM_FUNC(sz, name, type)                                      \
+static void _XFORMAPI TARGET                                            \
+TAG(transform_points##sz##_##name)(GLvector4f *to_vec,                  \
+                                   const GLfloat m[16],                 \
+                                   const GLvector4f *from_vec)          \
+{                                                                       \
+   TAG(transform_points)(to_vec, m, from_vec, sz, type);                \
+}
+
+#define XFORM_FUNCS(sz)                                                 \
+XFORM_FUNC(sz, general, MATRIX_GENERAL)                                 \
+XFORM_FUNC(sz, 3d_no_rot, MATRIX_3D_NO_ROT)                             \
+XFORM_FUNC(sz, perspective, MATRIX_PERSPECTIVE)                         \
+XFORM_FUNC(sz, 2d, MATRIX_2D)                                           \
+XFORM_FUNC(sz, 2d_no_rot, MATRIX_2D_NO_ROT)                             \
+XFORM_FUNC(sz, 3d, MATRIX_3D)
+
+XFORM_FUNCS(1)
+XFORM_FUNCS(2)
+XFORM_FUNCS(3)
+XFORM_FUNCS(4)
+
+#undef XFORM_FUNCS
+#undef XFORM_FUNC
+
+
+/**
+ * Transform, rescale and/or normalize a vector of normals, as selected
+ * by the NORM_x flags.  See m_norm_tmp.h.
+ */
+static SIMD_INLINE TARGET void
+TAG(normals)(const GLmatrix *mat, GLfloat scale, const GLvector4f *in,
+             const GLfloat *lengths, GLvector4f *dest, GLuint flags)
+{
+   GLfloat (*out)[4] = (GLfloat (*)[4])dest->start;
+   const GLfloat *from = in->start;
+   const GLuint stride = in->stride;
+   const GLuint count = in->count;
+   const GLuint direct = simd_direct_count(in, 3);
+   const GLfloat *m = mat->inv;
+   const GLboolean transform = (flags & (NORM_TRANSFORM |
+                                         NORM_TRANSFORM_NO_ROT)) != 0;
+   GLfloat s = 1.0F;
+   VEC m0, m1, m2, m4, m5, m6, m8, m9, m10;
+   GLuint i;
+
+   /* The matrix absorbs the scale factor where m_norm_tmp.h does so */
+   if ((flags & NORM_RESCALE) ||
+       ((flags & NORM_NORMALIZE) && lengths && scale != 1.0F))
+      s = scale;
+
+   if (transform) {
+      m0 = VSET1(s * m[0]);
+      m5 = VSET1(s * m[5]);
+      m10 = VSET1(s * m[10]);
+      m1 = VSET1(s * m[1]);
+      m2 = VSET1(s * m[2]);
+      m4 = VSET1(s * m[4]);
+      m6 = VSET1(s * m[6]);
+      m8 = VSET1(s * m[8]);
+      m9 = VSET1(s * m[9]);
+   }
+   else {
+      m0 = m1 = m2 = m4 = m5 = m6 = m8 = m9 = m10 = VSET1(scale);
+   }
+
+   for (i = 0; i < count; i += VLANES) {
+      const GLuint n = MIN2(VLANES, count - i);
+      VEC u[4], tx, ty, tz;
+
+      TAG(load_vertices)(from, stride, 3, n, i + VLANES <= direct, u);
+
+      if (flags & NORM_TRANSFORM) {
+         tx = VADD(VADD(VMUL(u[0], m0), VMUL(u[1], m1)), VMUL(u[2], m2));
+         ty = VADD(VADD(VMUL(u[0], m4), VMUL(u[1], m5)), VMUL(u[2], m6));
+         tz = VADD(VADD(VMUL(u[0], m8), VMUL(u[1], m9)), VMUL(u[2], m10));
+      }
+      else if (flags & NORM_TRANSFORM_NO_ROT) {
+         tx = VMUL(u[0], m0);
+         ty = VMUL(u[1], m5);
+         tz = VMUL(u[2], m10);
+      }
+      else if (flags & NORM_RESCALE) {
+         tx = VMUL(u[0], m0);
+         ty = VMUL(u[1], m0);
+         tz = VMUL(u[2], m0);
+      }
+      else {
+         tx = u[0];
+         ty = u[1];
+         tz = u[2];
+      }
+
+      if ((flags & NORM_NORMALIZE) && lengths) {
+         VEC len;
+
+         if (n == VLANES) {
+            len = VLOADN(lengths + i);
+         }
+         else {
+            GLfloat tmp[VLANES];
+            GLuint j;
+            for (j = 0; j < VLANES; j++)
+               tmp[j] = lengths[i + MIN2(j, n - 1)];
+            len = VLOADN(tmp);
+         }
+
+         tx = VMUL(tx, len);
+         ty = VMUL(ty, len);
+         tz = VMUL(tz, len);
+      }
+      else if (flags & NORM_NORMALIZE) {
+         const VEC len = VADD(VADD(VMUL(tx, tx), VMUL(ty, ty)),
+                              VMUL(tz, tz));
+         const VEC inv = VDIV(VSET1(1.0F), VSQRT(len));
+
+         if (transform) {
+            /* zero-length normals become zero */
+            const VEC ok = VCMPGT(len, VSET1(1e-20F));
+            tx = VAND(ok, VMUL(tx, inv));
+            ty = VAND(ok, VMUL(ty, inv));
+            tz = VAND(ok, VMUL(tz, inv));
+         }
+         else {
+            /* zero-length normals are left alone */
+            const VEC ok = VCMPGT(len, VZERO());
+            tx = VOR(VAND(ok, VMUL(tx, inv)), VANDNOT(ok, tx));
+            ty = VOR(VAND(ok, VMUL(ty, inv)), VANDNOT(ok, ty));
+            tz = VOR(VAND(ok, VMUL(tz, inv)), VANDNOT(ok, tz));
+         }
+      }
+
+      TAG(store_vertices)(out + i, n, tx, ty, tz, VZERO());
+
+      from = (const GLfloat *) ((const GLubyte *) from + VLANES * stride);
+   }
+
+   dest->count = in->count;
+}
+
+
+#define NORM_FUNC(name, flags)                                          \
+static void _NORMAPI TARGET                                             \
+TAG(name)(const GLmatrix *mat, GLfloat scale, const GLvector4f *in,     \
+          const GLfloat *lengths, GLvector4f *dest)                     \
+{                                                                       \
+   TAG(normals)(mat, scale, in, lengths, dest, flags);                  \
+}
+
+NORM_FUNC(transform_normals_no_rot, NORM_TRANSFORM_NO_ROT)
+NORM_FUNC(transform_rescale_normals_no_rot,
+          NORM_TRANSFORM_NO_ROT | NORM_RESCALE)
+NORM_FUNC(transform_normalize_normals_no_rot,
+          NORM_TRANSFORM_NO_ROT | NORM_NORMALIZE)
+NORM_FUNC(transform_normals, NORM_TRANSFORM)
+NORM_FUNC(transform_rescale_normals, NORM_TRANSFORM | NORM_RESCALE)
+NORM_FUNC(transform_normalize_normals, NORM_TRANSFORM | NORM_NORMALIZE)
+NORM_FUNC(rescale_normals, NORM_RESCALE)
+NORM_FUNC(normalize_normals, NORM_NORMALIZE)
+
+#undef NORM_FUNC
+
+
+/**
+ * Compute the clip flags of 4-component clip coordinates and, if \p proj
+ * is set, the projected coordinates.  See m_clip_tmp.h.
+ */
+static SIMD_INLINE TARGET GLvector4f *
+TAG(cliptest)(GLvector4f *clip_vec, GLvector4f *proj_vec, GLubyte clipMask[],
+              GLubyte *orMask, GLubyte *andMask, GLboolean viewport_z_clip,
+              GLboolean proj)
+{
+   const GLuint stride = clip_vec->stride;
+   const GLuint count = clip_vec->count;
+   const GLfloat *from = (GLfloat *)clip_vec->start;
+   GLfloat (*vProj)[4] = proj ? (GLfloat (*)[4])proj_vec->start : NULL;
+   const GLuint direct = simd_direct_count(clip_vec, 4);
+   VEC orv = VZERO(), andv = VSETI(0xff);
+   GLubyte tmpOrMask = *orMask;
+   GLubyte tmpAndMask = *andMask;
+   GLubyte bytes[2][VLANES];
+   GLuint i, j;
+
+   for (i = 0; i < count; i += VLANES) {
+      const GLuint n = MIN2(VLANES, count - i);
+      VEC c[4], t, clipped, mask;
+
+      TAG(load_vertices)(from, stride, 4, n, i + VLANES <= direct, c);
+
+      t = VCMPLT(VSUB(c[3], c[0]), VZERO());
+      clipped = t;
+      mask = VAND(t, VSETI(CLIP_RIGHT_BIT));
+      t = VCMPLT(VADD(c[0], c[3]), VZERO());
+      clipped = VOR(clipped, t);
+      mask = VOR(mask, VAND(t, VSETI(CLIP_LEFT_BIT)));
+      t = VCMPLT(VSUB(c[3], c[1]), VZERO());
+      clipped = VOR(clipped, t);
+      mask = VOR(mask, VAND(t, VSETI(CLIP_TOP_BIT)));
+      t = VCMPLT(VADD(c[1], c[3]), VZERO());
+      clipped = VOR(clipped, t);
+      mask = VOR(mask, VAND(t, VSETI(CLIP_BOTTOM_BIT)));
+      if (viewport_z_clip) {
+         t = VCMPLT(VSUB(c[3], c[2]), VZERO());
+         clipped = VOR(clipped, t);
+         mask = VOR(mask, VAND(t, VSETI(CLIP_FAR_BIT)));
+         t = VCMPLT(VADD(c[2], c[3]), VZERO());
+         clipped = VOR(clipped, t);
+         mask = VOR(mask, VAND(t, VSETI(CLIP_NEAR_BIT)));
+      }
+
+      if (n == VLANES) {
+         VSTORE_MASK(clipMask + i, mask);
+         orv = VOR(orv, mask);
+         andv = VAND(andv, mask);
+      }
+      else {
+         VSTORE_MASK(bytes[0], mask);
+         for (j = 0; j < n; j++) {
+            clipMask[i + j] = bytes[0][j];
+            tmpOrMask |= bytes[0][j];
+            tmpAndMask &= bytes[0][j];
+         }
+      }
+
+      if (proj) {
+         /* clipped vertices project to (0, 0, 0, 1) */
+         const VEC oow = VDIV(VSET1(1.0F), c[3]);
+         TAG(store_vertices)(vProj + i, n,
+                             VANDNOT(clipped, VMUL(c[0], oow)),
+                             VANDNOT(clipped, VMUL(c[1], oow)),
+                             VANDNOT(clipped, VMUL(c[2], oow)),
+                             VOR(VAND(clipped, VSET1(1.0F)),
+                                 VANDNOT(clipped, oow)));
+      }
+
+      from = (const GLfloat *) ((const GLubyte *) from + VLANES * stride);
+   }
+
+   VSTORE_MASK(bytes[0], orv);
+   VSTORE_MASK(bytes[1], andv);
+   for (j = 0; j < VLANES; j++) {
+      tmpOrMask |= bytes[0][j];
+      tmpAndMask &= bytes[1][j];
+   }
+
+   /* an unclipped vertex clears the and-mask, as in m_clip_tmp.h */
+   *orMask = tmpOrMask;
+   *andMask = tmpAndMask;
+
+   if (!proj)
+      return clip_vec;
+
+   proj_vec->flags |= VEC_SIZE_4;
+   proj_vec->size = 4;
+   proj_vec->count = clip_vec->count;
+   return proj_vec;
+}
+
+
+static GLvector4f * _XFORMAPI TARGET
+TAG(cliptest_points4)(GLvector4f *clip_vec, GLvector4f *proj_vec,
+                      GLubyte clipMask[], GLubyte *orMask, GLubyte *andMask,
+                      GLboolean viewport_z_clip)
+{
+   return TAG(cliptest)(clip_vec, proj_vec, clipMask, orMask, andMask,
+                        viewport_z_clip, GL_TRUE);
+}
+
+
+static GLvector4f * _XFORMAPI TARGET
+TAG(cliptest_np_points4)(GLvector4f *clip_vec, GLvector4f *proj_vec,
+                         GLubyte clipMask[], GLubyte *orMask,
+                         GLubyte *andMask, GLboolean viewport_z_clip)
+{
+   return TAG(cliptest)(clip_vec, proj_vec, clipMask, orMask, andMask,
+                        viewport_z_clip, GL_FALSE);
+}
+
+
+#define SIMD_XFORM_GROUP(sz)                                          \
+   _mesa_transform_tab[sz][MATRIX_GENERAL] =                            \
+      TAG(transform_points##sz##_general);                              \
+   _mesa_transform_tab[sz][MATRIX_3D_NO_ROT] =                          \
+      TAG(transform_points##sz##_3d_no_rot);                            \
+   _mesa_transform_tab[sz][MATRIX_PERSPECTIVE] =                        \
+      TAG(transform_points##sz##_perspective);                          \
+   _mesa_transform_tab[sz][MATRIX_2D] =                                 \
+      TAG(transform_points##sz##_2d);                                   \
+   _mesa_transform_tab[sz][MATRIX_2D_NO_ROT] =                          \
+      TAG(transform_points##sz##_2d_no_rot);                            \
+   _mesa_transform_tab[sz][MATRIX_3D] =                                 \
+      TAG(transform_points##sz##_3d)
+
+
+/**
+ * Hook the functions above into the math tables.  The identity
+ * transforms and the 2- and 3-component cliptests are left alone.
+ */
+static void
+TAG(init_transformations)(void)
+{
+   SIMD_XFORM_GROUP(1);
+   SIMD_XFORM_GROUP(2);
+   SIMD_XFORM_GROUP(3);
+   SIMD_XFORM_GROUP(4);
+
+   _mesa_normal_tab[NORM_TRANSFORM_NO_ROT] =
+      TAG(transform_normals_no_rot);
+   _mesa_normal_tab[NORM_TRANSFORM_NO_ROT | NORM_RESCALE] =
+      TAG(transform_rescale_normals_no_rot);
+   _mesa_normal_tab[NORM_TRANSFORM_NO_ROT | NORM_NORMALIZE] =
+      TAG(transform_normalize_normals_no_rot);
+   _mesa_normal_tab[NORM_TRANSFORM] =
+      TAG(transform_normals);
+   _mesa_normal_tab[NORM_TRANSFORM | NORM_RESCALE] =
+      TAG(transform_rescale_normals);
+   _mesa_normal_tab[NORM_TRANSFORM | NORM_NORMALIZE] =
+      TAG(transform_normalize_normals);
+   _mesa_normal_tab[NORM_RESCALE] =
+      TAG(rescale_normals);
+   _mesa_normal_tab[NORM_NORMALIZE] =
+      TAG(normalize_normals);
+
+   _mesa_clip_tab[4] = TAG(cliptest_points4);
+   _mesa_clip_np_tab[4] = TAG(cliptest_np_points4);
+}
+
+#undef SIMD_XFORM_GROUP
+#undef TRANSPOSE
@@ -31,8 +31,11 @@
 
 #ifdef USE_X86_64_ASM
 
+#include <emmintrin.h>
+
 #include "main/glheader.h"
 #include "main/context.h"
+#include "main/macros.h"
 #include "math/m_xform.h"
 #include "tnl/t_context.h"
 #include "x86-64.h"
@@ -42,10 +45,16 @@
 #include "math/m_debug.h"
 #endif
 
+/* Functions with other target attributes need gcc 4.9 */
+#if defined(__GNUC__) && !defined(__clang__) && \
+    (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+#include <immintrin.h>
+#define HAVE_AVX_TARGET 1
+#endif
+
 extern void _mesa_x86_64_cpuid(unsigned int *regs);
 
 DECLARE_XFORM_GROUP( x86_64, 4 )
-DECLARE_XFORM_GROUP( 3dnow, 4 )
 
 #else
 /* just to silence warning below */
@@ -69,14 +78,251 @@ static void message( const char *msg )
       _mesa_debug( NULL, "%s", msg );
    }
 }
+
+
+#define SIMD_INLINE inline __attribute__((always_inline))
+
+enum { XF_NIL, XF_ONE, XF_NEG, XF_VAR };
+
+/**
+ * Which matrix elements each matrix type uses, by row, as in
+ * m_debug_xform.c.
+ */
+static const GLubyte simd_xform_pattern[7][16] = {
+   /* MATRIX_GENERAL */
+   { XF_VAR, XF_VAR, XF_VAR, XF_VAR,
+     XF_VAR, XF_VAR, XF_VAR, XF_VAR,
+     XF_VAR, XF_VAR, XF_VAR, XF_VAR,
+     XF_VAR, XF_VAR, XF_VAR, XF_VAR },
+   /* MATRIX_IDENTITY */
+   { XF_ONE, XF_NIL, XF_NIL, XF_NIL,
+     XF_NIL, XF_ONE, XF_NIL, XF_NIL,
+     XF_NIL, XF_NIL, XF_ONE, XF_NIL,
+     XF_NIL, XF_NIL, XF_NIL, XF_ONE },
+   /* MATRIX_3D_NO_ROT */
+   { XF_VAR, XF_NIL, XF_NIL, XF_VAR,
+     XF_NIL, XF_VAR, XF_NIL, XF_VAR,
+     XF_NIL, XF_NIL, XF_VAR, XF_VAR,
+     XF_NIL, XF_NIL, XF_NIL, XF_ONE },
+   /* MATRIX_PERSPECTIVE */
+   { XF_VAR, XF_NIL, XF_VAR, XF_NIL,
+     XF_NIL, XF_VAR, XF_VAR, XF_NIL,
+     XF_NIL, XF_NIL, XF_VAR, XF_VAR,
+     XF_NIL, XF_NIL, XF_NEG, XF_NIL },
+   /* MATRIX_2D */
+   { XF_VAR, XF_VAR, XF_NIL, XF_VAR,
+     XF_VAR, XF_VAR, XF_NIL, XF_VAR,
+     XF_NIL, XF_NIL, XF_ONE, XF_NIL,
+     XF_NIL, XF_NIL, XF_NIL, XF_ONE },
+   /* MATRIX_2D_NO_ROT */
+   { XF_VAR, XF_NIL, XF_NIL, XF_VAR,
+     XF_NIL, XF_VAR, XF_NIL, XF_VAR,
+     XF_NIL, XF_NIL, XF_ONE, XF_NIL,
+     XF_NIL, XF_NIL, XF_NIL, XF_ONE },
+   /* MATRIX_3D */
+   { XF_VAR, XF_VAR, XF_VAR, XF_VAR,
+     XF_VAR, XF_VAR, XF_VAR, XF_VAR,
+     XF_VAR, XF_VAR, XF_VAR, XF_VAR,
+     XF_NIL, XF_NIL, XF_NIL, XF_ONE },
+};
+
+/** Result size by point size and matrix type, as in m_xform_tmp.h */
+static const GLubyte simd_xform_size[5][7] = {
+   { 0, 0, 0, 0, 0, 0, 0 },
+   { 4, 1, 3, 4, 2, 2, 3 },
+   { 4, 2, 2, 4, 2, 2, 3 },
+   { 4, 3, 3, 4, 3, 3, 3 },
+   { 4, 4, 4, 4, 4, 4, 4 },
+};
+
+static const GLubyte simd_size_bits[5] = {
+   0, VEC_SIZE_1, VEC_SIZE_2, VEC_SIZE_3, VEC_SIZE_4
+};
+
+
+/**
+ * Number of leading elements of \p vec that can be read with a 16-byte
+ * load each without going past the end of its last element.
+ */
+static GLuint
+simd_direct_count(const GLvector4f *vec, GLuint size)
+{
+   const GLuint count = vec->count;
+   GLuint end;
+
+   if (size == 4 || count == 0)
+      return count;
+   if (vec->stride == 0)
+      return 0;
+
+   end = (count - 1) * vec->stride + size * sizeof(GLfloat);
+   if (end < 16)
+      return 0;
+   return MIN2(count, (end - 16) / vec->stride + 1);
+}
+
+
+/* SSE2, always available on x86-64 */
+#define TAG(x) sse2_##x
+#define TARGET
+#define VEC __m128
+#define VLANES 4
+#define VLOADV(p, s) _mm_loadu_ps(p)
+#define VSTOREV(p, s, v) _mm_storeu_ps(p, v)
+#define VLOADN(p) _mm_loadu_ps(p)
+#define VSTORE_MASK(p, v)                                               \
+do {                                                                    \
+   __m128i w = _mm_packs_epi32(_mm_castps_si128(v), _mm_castps_si128(v)); \
+   int b = _mm_cvtsi128_si32(_mm_packus_epi16(w, w));                   \
+   memcpy(p, &b, 4);                                                    \
+} while (0)
+#define VSET1(f) _mm_set1_ps(f)
+#define VSETI(i) _mm_castsi128_ps(_mm_set1_epi32(i))
+#define VZERO() _mm_setzero_ps()
+#define VADD(a, b) _mm_add_ps(a, b)
+#define VSUB(a, b) _mm_sub_ps(a, b)
+#define VMUL(a, b) _mm_mul_ps(a, b)
+#define VDIV(a, b) _mm_div_ps(a, b)
+#define VSQRT(a) _mm_sqrt_ps(a)
+#define VAND(a, b) _mm_and_ps(a, b)
+#define VANDNOT(a, b) _mm_andnot_ps(a, b)
+#define VOR(a, b) _mm_or_ps(a, b)
+#define VXOR(a, b) _mm_xor_ps(a, b)
+#define VCMPLT(a, b) _mm_cmplt_ps(a, b)
+#define VCMPGT(a, b) _mm_cmpgt_ps(a, b)
+#define VUNPACKLO(a, b) _mm_unpacklo_ps(a, b)
+#define VUNPACKHI(a, b) _mm_unpackhi_ps(a, b)
+#define VSHUF(a, b, imm) _mm_shuffle_ps(a, b, imm)
+#include "simd_xform_tmp.h"
+#undef TAG
+#undef TARGET
+#undef VEC
+#undef VLANES
+#undef VLOADV
+#undef VSTOREV
+#undef VLOADN
+#undef VSTORE_MASK
+#undef VSET1
+#undef VSETI
+#undef VZERO
+#undef VADD
+#undef VSUB
+#undef VMUL
+#undef VDIV
+#undef VSQRT
+#undef VAND
+#undef VANDNOT
+#undef VOR
+#undef VXOR
+#undef VCMPLT
+#undef VCMPGT
+#undef VUNPACKLO
+#undef VUNPACKHI
+#undef VSHUF
+
+
+#ifdef HAVE_AVX_TARGET
+/* AVX, eight vertices at a time: vertices 0-3 in the low half of each
+ * vector, 4-7 in the high half.
+ */
+#define TAG(x) avx_##x
+#define TARGET __attribute__((target("avx")))
+#define VEC __m256
+#define VLANES 8
+#define VLOADV(p, s)                                                    \
+   _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(p)),        \
+                        _mm_loadu_ps((const GLfloat *)                  \
+                                     ((const GLubyte *) (p) + 4 * (s))), 1)
+#define VSTOREV(p, s, v)                                                \
+do {                                                                    \
+   _mm_storeu_ps(p, _mm256_castps256_ps128(v));                         \
+   _mm_storeu_ps((GLfloat *) ((GLubyte *) (p) + 4 * (s)),               \
+                 _mm256_extractf128_ps(v, 1));                          \
+} while (0)
+#define VLOADN(p) _mm256_loadu_ps(p)
+#define VSTORE_MASK(p, v)                                               \
+do {                                                                    \
+   __m128i w = _mm_packs_epi32(                                         \
+      _mm_castps_si128(_mm256_castps256_ps128(v)),                      \
+      _mm_castps_si128(_mm256_extractf128_ps(v, 1)));                   \
+   _mm_storel_epi64((__m128i *) (p), _mm_packus_epi16(w, w));           \
+} while (0)
+#define VSET1(f) _mm256_set1_ps(f)
+#define VSETI(i) _mm256_castsi256_ps(_mm256_set1_epi32(i))
+#define VZERO() _mm256_setzero_ps()
+#define VADD(a, b) _mm256_add_ps(a, b)
+#define VSUB(a, b) _mm256_sub_ps(a, b)
+#define VMUL(a, b) _mm256_mul_ps(a, b)
+#define VDIV(a, b) _mm256_div_ps(a, b)
+#define VSQRT(a) _mm256_sqrt_ps(a)
+#define VAND(a, b) _mm256_and_ps(a, b)
+#define VANDNOT(a, b) _mm256_andnot_ps(a, b)
+#define VOR(a, b) _mm256_or_ps(a, b)
+#define VXOR(a, b) _mm256_xor_ps(a, b)
+#define VCMPLT(a, b) _mm256_cmp_ps(a, b, _CMP_LT_OQ)
+#define VCMPGT(a, b) _mm256_cmp_ps(a, b, _CMP_GT_OQ)
+#define VUNPACKLO(a, b) _mm256_unpacklo_ps(a, b)
+#define VUNPACKHI(a, b) _mm256_unpackhi_ps(a, b)
+#define VSHUF(a, b, imm) _mm256_shuffle_ps(a, b, imm)
+#include "simd_xform_tmp.h"
+#undef TAG
+#undef TARGET
+#undef VEC
+#undef VLANES
+#undef VLOADV
+#undef VSTOREV
+#undef VLOADN
+#undef VSTORE_MASK
+#undef VSET1
+#undef VSETI
+#undef VZERO
+#undef VADD
+#undef VSUB
+#undef VMUL
+#undef VDIV
+#undef VSQRT
+#undef VAND
+#undef VANDNOT
+#undef VOR
+#undef VXOR
+#undef VCMPLT
+#undef VCMPGT
+#undef VUNPACKLO
+#undef VUNPACKHI
+#undef VSHUF
+
+
+/**
+ * Whether the CPU supports AVX and the OS saves the YMM registers.
+ */
+static GLboolean
+cpu_has_avx(void)
+{
+   unsigned int regs[4];
+   unsigned int xcr0_lo, xcr0_hi;
+
+   regs[0] = 0x00000001;
+   regs[1] = 0x00000000;
+   regs[2] = 0x00000000;
+   regs[3] = 0x00000000;
+   _mesa_x86_64_cpuid(regs);
+
+   /* AVX and OSXSAVE */
+   if ((regs[2] & ((1U << 28) | (1U << 27))) != ((1U << 28) | (1U << 27)))
+      return GL_FALSE;
+
+   /* xgetbv: XMM and YMM state enabled in XCR0 */
+   __asm__ __volatile__(".byte 0x0f, 0x01, 0xd0"
+                        : "=a" (xcr0_lo), "=d" (xcr0_hi) : "c" (0));
+   return (xcr0_lo & 0x6) == 0x6;
+}
+#endif /* HAVE_AVX_TARGET */
 #endif
 
 
 void _mesa_init_all_x86_64_transform_asm(void)
 {
 #ifdef USE_X86_64_ASM
-   unsigned int regs[4];
-
    if ( _mesa_getenv( "MESA_NO_ASM" ) ) {
      return;
    }
@@ -84,32 +330,19 @@ void _mesa_init_all_x86_64_transform_asm(void)
    message("Initializing x86-64 optimizations\n");
 
 
-   _mesa_transform_tab[4][MATRIX_GENERAL] =
-      _mesa_x86_64_transform_points4_general;
    _mesa_transform_tab[4][MATRIX_IDENTITY] =
       _mesa_x86_64_transform_points4_identity;
-   _mesa_transform_tab[4][MATRIX_3D] =
-      _mesa_x86_64_transform_points4_3d;
 
-   regs[0] = 0x80000001;
-   regs[1] = 0x00000000;
-   regs[2] = 0x00000000;
-   regs[3] = 0x00000000;
-   _mesa_x86_64_cpuid(regs);
-   if (regs[3] & (1U << 31)) {
-      message("3Dnow! detected\n");
-      _mesa_transform_tab[4][MATRIX_3D_NO_ROT] =
-	  _mesa_3dnow_transform_points4_3d_no_rot;
-      _mesa_transform_tab[4][MATRIX_PERSPECTIVE] =
-	  _mesa_3dnow_transform_points4_perspective;
-      _mesa_transform_tab[4][MATRIX_2D_NO_ROT] =
-	  _mesa_3dnow_transform_points4_2d_no_rot;
-      _mesa_transform_tab[4][MATRIX_2D] =
-	  _mesa_3dnow_transform_points4_2d;
+   message("Using SSE2 transform functions\n");
+   sse2_init_transformations();
 
+#ifdef HAVE_AVX_TARGET
+   if (cpu_has_avx()) {
+      message("AVX detected\n");
+      avx_init_transformations();
    }
+#endif
 
-   
 #ifdef DEBUG_MATH
    _math_test_all_transform_functions("x86_64");
    _math_test_all_cliptest_functions("x86_64");